@@ -0,0 +1,211 @@
+/**
+ * @file Checksum.cpp
+ * @brief Crc32c class implementation.
+ * @details This file contains the software (slicing-by-8) and SSE4.2 implementations of CRC-32C,
+ *          selected once at runtime based on the CPU features.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "Checksum.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32C_HAS_SSE42 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+    constexpr uint32_t CRC32C_POLY = 0x82F63B78u; // reflected Castagnoli polynomial
+
+    using SliceTable = std::array<std::array<uint32_t, 256>, 8>;
+
+    SliceTable make_tables()
+    {
+        SliceTable tables{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1) ^ ((crc & 1u) ? CRC32C_POLY : 0u);
+            }
+            tables[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            for (size_t t = 1; t < 8; ++t)
+            {
+                tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+            }
+        }
+        return tables;
+    }
+
+    const SliceTable& tables()
+    {
+        static const SliceTable t = make_tables();
+        return t;
+    }
+
+    uint32_t update_software(uint32_t crc, const unsigned char* data, size_t size)
+    {
+        const SliceTable& t = tables();
+
+        while (size >= 8)
+        {
+            uint32_t low = 0;
+            uint32_t high = 0;
+            std::memcpy(&low, data, 4);
+            std::memcpy(&high, data + 4, 4);
+            low ^= crc;
+            crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+                t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+            data += 8;
+            size -= 8;
+        }
+        while (size-- > 0)
+        {
+            crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+        }
+        return crc;
+    }
+
+#ifdef CRC32C_HAS_SSE42
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("sse4.2")))
+#endif
+    uint32_t update_hardware(uint32_t crc, const unsigned char* data, size_t size)
+    {
+        uint64_t crc64 = crc;
+        while (size >= 8)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, data, 8);
+            crc64 = _mm_crc32_u64(crc64, word);
+            data += 8;
+            size -= 8;
+        }
+        crc = static_cast<uint32_t>(crc64);
+        while (size-- > 0)
+        {
+            crc = _mm_crc32_u8(crc, *data++);
+        }
+        return crc;
+    }
+
+    bool cpu_has_sse42()
+    {
+#ifdef _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#else
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    }
+#endif
+
+    using UpdateFn = uint32_t(*)(uint32_t, const unsigned char*, size_t);
+
+    UpdateFn select_update()
+    {
+#ifdef CRC32C_HAS_SSE42
+        if (cpu_has_sse42())
+        {
+            return update_hardware;
+        }
+#endif
+        return update_software;
+    }
+
+    const UpdateFn UPDATE = select_update();
+
+    using Gf2Matrix = std::array<uint32_t, 32>;
+
+    /**
+     * @brief Multiplies a vector by a matrix over GF(2).
+     */
+    uint32_t gf2_times(const Gf2Matrix& matrix, uint32_t vector)
+    {
+        uint32_t sum = 0;
+        for (size_t i = 0; vector != 0; ++i, vector >>= 1)
+        {
+            if (vector & 1u)
+            {
+                sum ^= matrix[i];
+            }
+        }
+        return sum;
+    }
+
+    /**
+     * @brief Squares a matrix over GF(2).
+     */
+    Gf2Matrix gf2_square(const Gf2Matrix& matrix)
+    {
+        Gf2Matrix square{};
+        for (size_t i = 0; i < 32; ++i)
+        {
+            square[i] = gf2_times(matrix, matrix[i]);
+        }
+        return square;
+    }
+}
+
+void Crc32c::update(const unsigned char* data, const size_t size)
+{
+    state_ = UPDATE(state_, data, size);
+}
+
+uint32_t Crc32c::value() const
+{
+    return state_ ^ 0xFFFFFFFFu;
+}
+
+void Crc32c::reset()
+{
+    state_ = 0xFFFFFFFFu;
+}
+
+uint32_t Crc32c::compute(const unsigned char* data, const size_t size)
+{
+    Crc32c crc;
+    crc.update(data, size);
+    return crc.value();
+}
+
+uint32_t Crc32c::combine(uint32_t first, const uint32_t second, uint64_t second_size)
+{
+    // Appending n zero bytes to the first block is a linear operator: apply it by repeated squaring of the one-bit shift
+    Gf2Matrix shift{};
+    shift[0] = CRC32C_POLY;
+    for (size_t i = 1; i < 32; ++i)
+    {
+        shift[i] = 1u << (i - 1);
+    }
+    Gf2Matrix zeros = gf2_square(gf2_square(shift)); // four zero bits
+    for (; second_size != 0; second_size >>= 1)
+    {
+        zeros = gf2_square(zeros); // one zero byte, then two, four...
+        if (second_size & 1u)
+        {
+            first = gf2_times(zeros, first);
+        }
+    }
+    return first ^ second;
+}
+
+bool Crc32c::hardware_accelerated()
+{
+    return UPDATE != update_software;
+}
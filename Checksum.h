@@ -0,0 +1,72 @@
+/**
+ * @file Checksum.h
+ * @brief Crc32c class definition.
+ * @details This header file contains the Crc32c class used to compute CRC-32C (Castagnoli) checksums of file payloads.
+ *          The checksum is updated incrementally, so it can be computed while the data is streamed without an extra pass.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class Crc32c
+ * @brief Incremental CRC-32C calculator.
+ * @details Uses the SSE4.2 crc32 instruction when the CPU supports it (detected once at runtime)
+ *          and falls back to a slicing-by-8 table implementation otherwise.
+ */
+class Crc32c {
+public:
+    /**
+     * @brief Feeds the next chunk of data into the checksum.
+     * @param data The data to add.
+     * @param size The number of bytes to add.
+     */
+    void update(const unsigned char* data, size_t size);
+
+    /**
+     * @brief Returns the checksum of all data fed so far.
+     * @return The CRC-32C value.
+     */
+    uint32_t value() const;
+
+    /**
+     * @brief Resets the calculator to its initial state.
+     */
+    void reset();
+
+    /**
+     * @brief Computes the checksum of a single buffer.
+     * @param data The data to checksum.
+     * @param size The number of bytes.
+     * @return The CRC-32C value.
+     */
+    static uint32_t compute(const unsigned char* data, size_t size);
+
+    /**
+     * @brief Combines the checksums of two consecutive blocks into the checksum of both, without their data.
+     * @param first The checksum of the first block.
+     * @param second The checksum of the second block.
+     * @param second_size The size of the second block in bytes.
+     * @return The checksum of the first block followed by the second.
+     */
+    static uint32_t combine(uint32_t first, uint32_t second, uint64_t second_size);
+
+    /**
+     * @brief Tells whether the hardware accelerated path is in use.
+     * @return True if the SSE4.2 crc32 instruction is used.
+     */
+    static bool hardware_accelerated();
+
+private:
+    /**
+     * @brief The running (inverted) CRC state.
+     */
+    uint32_t state_ = 0xFFFFFFFFu;
+};
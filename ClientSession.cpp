@@ -17,13 +17,145 @@
 #include "Request.h"
 #include "Response.h"
 
+#include <algorithm>
+#include <ctime>
+#include <functional>
 #include <iostream>
 #include <filesystem>
+#include <limits>
+#include <optional>
 #include <thread>
 
-ClientSession::ClientSession(std::shared_ptr<boost::asio::ip::tcp::socket> socket)
-    : socket_(std::move(socket))
+namespace
 {
+    /**
+     * @brief Counts a request as in progress for as long as it is alive.
+     */
+    class ActiveRequestGuard
+    {
+    public:
+        explicit ActiveRequestGuard(std::atomic<size_t>& counter) : counter_(counter) { ++counter_; }
+        ~ActiveRequestGuard() { --counter_; }
+        ActiveRequestGuard(const ActiveRequestGuard&) = delete;
+        ActiveRequestGuard& operator=(const ActiveRequestGuard&) = delete;
+
+    private:
+        std::atomic<size_t>& counter_;
+    };
+
+    /**
+     * @brief Counts a session as open, for draining, for as long as it is alive (no-op without a handoff socket).
+     */
+    class OpenSessionGuard
+    {
+    public:
+        explicit OpenSessionGuard(SessionDrain* drain) : drain_(drain) { if (drain_) drain_->open_session(); }
+        ~OpenSessionGuard() { if (drain_) drain_->close_session(); }
+        OpenSessionGuard(const OpenSessionGuard&) = delete;
+        OpenSessionGuard& operator=(const OpenSessionGuard&) = delete;
+
+    private:
+        SessionDrain* drain_;
+    };
+
+    /**
+     * @brief Ends a request started with SessionDrain::begin_request() when it goes out of scope.
+     */
+    class HeldUserGuard
+    {
+    public:
+        HeldUserGuard(SessionDrain& drain, const uint32_t user_id) : drain_(drain), user_id_(user_id) {}
+        ~HeldUserGuard() { drain_.end_request(user_id_); }
+        HeldUserGuard(const HeldUserGuard&) = delete;
+        HeldUserGuard& operator=(const HeldUserGuard&) = delete;
+
+    private:
+        SessionDrain& drain_;
+        uint32_t user_id_;
+    };
+
+    /**
+     * @brief Tells whether a command works on a user's files (as opposed to administrative commands).
+     */
+    bool is_user_command(const Command op_code)
+    {
+        return op_code == Command::SAVE_FILE || op_code == Command::SAVE_IF_ABSENT || op_code == Command::RESTORE_FILES ||
+            op_code == Command::DELETE_FILE || op_code == Command::LIST_FILES ||
+            op_code == Command::SNAPSHOT_CREATE || op_code == Command::SNAPSHOT_LIST ||
+            op_code == Command::SNAPSHOT_RESTORE || op_code == Command::UPLOAD_INITIATE ||
+            op_code == Command::UPLOAD_PART || op_code == Command::UPLOAD_COMMIT || op_code == Command::UPLOAD_ABORT ||
+            op_code == Command::PROBE_FILES || op_code == Command::GET_USAGE || op_code == Command::LIST_PAGE;
+    }
+
+    /**
+     * @brief Returns the scheduling lane of a user command: metadata operations take the fast lane.
+     */
+    SchedulingLane lane_of(const Command op_code)
+    {
+        return op_code == Command::LIST_FILES || op_code == Command::DELETE_FILE ||
+            op_code == Command::SNAPSHOT_CREATE || op_code == Command::SNAPSHOT_LIST ||
+            op_code == Command::UPLOAD_INITIATE || op_code == Command::UPLOAD_COMMIT ||
+            op_code == Command::UPLOAD_ABORT || op_code == Command::PROBE_FILES ||
+            op_code == Command::GET_USAGE || op_code == Command::LIST_PAGE ? SchedulingLane::FAST : SchedulingLane::NORMAL;
+    }
+
+    /**
+     * @brief Removes any preceding path (up to the last slash or backslash) from a filename.
+     */
+    void strip_path(std::string& filename)
+    {
+        if (const auto last_slash = filename.find_last_of("/\\"); last_slash != std::string::npos)
+        {
+            filename = filename.substr(last_slash + 1);
+        }
+    }
+
+    /**
+     * @brief Parses an upload part number, which must be all digits and fit 32 bits.
+     * @throws std::invalid_argument if it does not.
+     */
+    uint32_t parse_part_number(const std::string& name)
+    {
+        if (name.empty() || name.size() > 10 || name.find_first_not_of("0123456789") != std::string::npos)
+        {
+            throw std::invalid_argument("not a part number");
+        }
+        const unsigned long long part_number = std::stoull(name);
+        if (part_number > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::invalid_argument("not a part number");
+        }
+        return static_cast<uint32_t>(part_number);
+    }
+
+    /**
+     * @brief Names a snapshot after the current UTC time (e.g. "20261018-093015").
+     */
+    std::string timestamp_snapshot_name()
+    {
+        const std::time_t now = std::time(nullptr);
+        std::tm utc{};
+#ifdef _WIN32
+        gmtime_s(&utc, &now);
+#else
+        gmtime_r(&now, &utc);
+#endif
+        char name[32];
+        std::strftime(name, sizeof(name), "%Y%m%d-%H%M%S", &utc);
+        return name;
+    }
+}
+
+ClientSession::ClientSession(std::shared_ptr<Transport> transport,
+                             std::shared_ptr<ServerContext> context)
+    : transport_(std::move(transport)),
+    context_(std::move(context)),
+    parser_(transport_)
+{
+    if (context_->trace)
+    {
+        session_id_ = context_->trace->open_session();
+    }
 }
 
 void ClientSession::start()
@@ -34,28 +166,73 @@ void ClientSession::start()
         }).detach();
 }
 
-void ClientSession::handle_client_requests() const
+void ClientSession::handle_client_requests()
 {
     try
     {
-        // Create a protocol parser on this socket 
-        ProtocolParcer parser(socket_);
+        // Payloads crossing the network count against the user's bandwidth cap
+        const std::function<void(uint32_t, size_t)> throttle_receive = [this](const uint32_t user, const size_t bytes)
+        {
+            context_->scheduler->throttle(user, bytes);
+        };
 
-		// Prepare a response object
-        Response response;
+        // Saves beyond the user's quota are refused from their announced size, before the payload is received
+        // (saves forwarded to another node or to a successor process are checked there)
+        const std::function<std::optional<ServerStatus>(const Request&, uint32_t)> admit_payload =
+            [this](const Request& request, const uint32_t size) -> std::optional<ServerStatus>
+        {
+            if ((request.op_code != Command::SAVE_FILE && request.op_code != Command::SAVE_IF_ABSENT) ||
+                request.filename.find("..") != std::string::npos ||
+                (context_->cluster && !context_->cluster->owns(request.user_id)) ||
+                (context_->drain && !context_->drain->serves(request.user_id)))
+            {
+                return std::nullopt;
+            }
+            if (context_->gate)
+            {
+                context_->gate->wait(request.user_id);
+            }
+            std::string filename = request.filename;
+            strip_path(filename);
+            try
+            {
+                // Loads the user's counters, so the first save after a restart is checked too
+                context_->file_manager->create_user_directory(request.user_id);
+            }
+            catch (const std::filesystem::filesystem_error&)
+            {
+                return std::nullopt; // reported when the request is processed
+            }
+            if (context_->file_manager->fits_quota(request.user_id, filename, size))
+            {
+                return std::nullopt;
+            }
+            return ServerStatus::ERR_QUOTA_EXCEEDED;
+        };
+
+        // A server that may hand over to a successor counts its sessions, to know when they are all done
+        OpenSessionGuard open_session(context_->drain.get());
 
 		// Loop to handle multiple requests from the same client until the client disconnects
 		while (true)
         {
-			if (!this->socket_->is_open())
+			if (!this->transport_->is_open())
 			{
 				std::cout << "Client disconnected.\n";
 				break;
 			}
 
+            // While draining, the connection closes once everything the client asked for has been answered
+            if (context_->drain && !wait_for_request())
+            {
+                std::cout << "Closing the connection: the server is handing over to its successor.\n";
+                transport_->close();
+                break;
+            }
+
             // Read the client's request (blocking call)
 			boost::system::error_code ec;
-            auto [user_id, version, op_code, filename, file_data] = parser.read_request(ec);
+            Request request = parser_.read_request(ec, context_->scheduler ? throttle_receive : nullptr, admit_payload);
 
             // Check for client disconnection
             if (ec == boost::asio::error::eof || ec == boost::asio::error::connection_reset)
@@ -64,6 +241,11 @@ void ClientSession::handle_client_requests() const
                 break;
             }
 
+            // Answer in the client's protocol version, as far as this server supports it
+            Response response;
+            response.version = static_cast<uint8_t>(std::clamp<unsigned short>(request.version, 1, SERVER_VERSION));
+            response.request_id = request.request_id;
+
 			if (ec)
 			{
 				send_error_response(response, "Server Error: Error reading request: " + ec.message());
@@ -71,217 +253,939 @@ void ClientSession::handle_client_requests() const
 			}
 
 			// Basic check for path traversal
-            if (filename.find("..") != std::string::npos)
+            if (request.filename.find("..") != std::string::npos)
             {
                 send_error_response(response,"Server Error: Invalid filename (possible path traversal).");
                 return;
             }
 
-            // Setup a FileManager (responsible for file operations)
-            const FileManager file_manager(STORAGE_FOLDER);
+            // A refused payload is answered at once; one too large to skip leaves the stream unreadable
+            if (request.refusal)
+            {
+                response.status = *request.refusal;
+                response.filename = request.filename;
+                log_error(response, "Error saving file " + request.filename + ": quota exceeded (" +
+                    std::to_string(request.user_id) + ").");
+                send_response(response, request.user_id);
+                if (context_->trace)
+                {
+                    context_->trace->finish(context_->trace->begin(session_id_, request), response);
+                }
+                if (request.payload_unread)
+                {
+                    std::cout << "Closing the connection instead of receiving the refused payload.\n";
+                    break;
+                }
+                continue;
+            }
 
-            // Create the root directory if it doesn't exist
-            try
+            // Version 3 clients may have many requests in flight: each one is answered as soon as it completes
+            if (request.version >= MULTIPLEX_PROTOCOL_VERSION)
             {
-                file_manager.create_root_directory();
+                dispatch_request(std::move(request));
+                continue;
             }
-            catch (const std::filesystem::filesystem_error& error)
+
+			// Background work (e.g. the scrubber) yields while this request is processed
+			ActiveRequestGuard active_request(context_->active_requests);
+
+            // Older clients wait for each response before sending the next request
+            serve_request(request);
+        }
+    }
+    catch (const std::exception& e)
+    {
+		Response response;
+        std::cerr << "[Server][Thread " << std::this_thread::get_id()
+            << "] Exception in handle_client_requests(): " << e.what() << "\n";
+
+		send_error_response(response, "Fatal server error: " + std::string(e.what()));
+    }
+}
+
+bool ClientSession::wait_for_request()
+{
+    while (true)
+    {
+        const bool draining = context_->drain->draining();
+        if (transport_->wait_readable(draining ? std::chrono::milliseconds(0) : DRAIN_POLL_INTERVAL))
+        {
+            return true;
+        }
+        if (draining)
+        {
+            // Requests in flight are answered before the connection closes
+            std::unique_lock lock(in_flight_mutex_);
+            if (in_flight_ == 0)
             {
-				send_error_response(response, "Server Error: Cannot create root directory: " + std::string(error.what()));
-				return;
+                return false;
             }
+            in_flight_cv_.wait_for(lock, DRAIN_POLL_INTERVAL, [this] { return in_flight_ == 0; });
+        }
+    }
+}
+
+void ClientSession::dispatch_request(Request request)
+{
+    {
+        std::unique_lock lock(in_flight_mutex_);
+        in_flight_cv_.wait(lock, [this] { return in_flight_ < MAX_IN_FLIGHT_REQUESTS; });
+        ++in_flight_;
+    }
+
+    std::thread([self = shared_from_this(), request = std::move(request)]() mutable
+    {
+        try
+        {
+            ActiveRequestGuard active_request(self->context_->active_requests);
+            self->serve_request(request);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "[Server][Thread " << std::this_thread::get_id()
+                << "] Exception while processing request " << request.request_id << ": " << e.what() << "\n";
+        }
 
-            // Create a user directory if it doesn't exist
+        {
+            std::lock_guard lock(self->in_flight_mutex_);
+            --self->in_flight_;
+        }
+        self->in_flight_cv_.notify_one();
+    }).detach();
+}
+
+void ClientSession::serve_request(Request& request)
+{
+    // The record is started first: processing strips the filename
+    std::optional<TraceRecord> record;
+    if (context_->trace)
+    {
+        record = context_->trace->begin(session_id_, request);
+    }
+
+    const uint32_t user_id = request.user_id;
+    const Response response = process_request(request);
+    send_response(response, user_id);
+    if (record)
+    {
+        context_->trace->finish(*record, response);
+    }
+}
+
+Response ClientSession::process_request(Request& request)
+{
+    auto& [user_id, version, request_id, op_code, filename, file_data, expected_checksum, payload_checksum, refusal,
+        payload_unread, payload_size, received] = request;
+
+    // Prepare a response object, answering in the client's protocol version as far as this server supports it
+    Response response;
+    response.version = static_cast<uint8_t>(std::clamp<unsigned short>(version, 1, SERVER_VERSION));
+    response.request_id = request_id;
+
+    // In cluster mode only the node owning the user serves it
+    if (context_->cluster && is_user_command(op_code) && !context_->cluster->owns(user_id))
+    {
+        const std::string& owner = context_->cluster->owner(user_id);
+        if (!context_->cluster->proxy())
+        {
+            response.status = ServerStatus::REDIRECT;
+            response.payload.assign(owner.begin(), owner.end());
+            return response;
+        }
+
+        try
+        {
+            Response owner_response = forward_to_owner(owner, request);
+            owner_response.version = response.version;
+            owner_response.request_id = request_id;
+            return owner_response;
+        }
+        catch (const std::exception& e)
+        {
+            log_error(response, "Server Error: Cannot reach " + owner + ": " + e.what());
+            return response;
+        }
+    }
+
+    // After a takeover, users the previous process is still working on wait until it releases them
+    if (context_->gate && is_user_command(op_code))
+    {
+        context_->gate->wait(user_id);
+    }
+
+    // While draining for a successor, only the users with requests still in progress are served here
+    std::optional<HeldUserGuard> held_user;
+    if (context_->drain && is_user_command(op_code))
+    {
+        if (!context_->drain->begin_request(user_id))
+        {
+            const std::string successor = context_->drain->successor();
             try
             {
-                file_manager.create_user_directory(user_id);
+                Response successor_response = forward_to_owner(successor, request);
+                successor_response.version = response.version;
+                successor_response.request_id = request_id;
+                return successor_response;
             }
-            catch (const std::filesystem::filesystem_error& error)
+            catch (const std::exception& e)
             {
-				send_error_response(response, "Server Error: Cannot create user directory: " + std::string(error.what()));
-                return;
+                log_error(response, "Server Error: Cannot reach the successor at " + successor + ": " + e.what());
+                return response;
             }
+        }
+        held_user.emplace(*context_->drain, user_id);
+    }
+
+    // The shared FileManager (responsible for file operations)
+    const FileManager& file_manager = *context_->file_manager;
+
+    // Create the root directory if it doesn't exist
+    try
+    {
+        file_manager.create_root_directory();
+    }
+    catch (const std::filesystem::filesystem_error& error)
+    {
+        log_error(response, "Server Error: Cannot create root directory: " + std::string(error.what()));
+        return response;
+    }
 
+    // Create a user directory if it doesn't exist
+    try
+    {
+        file_manager.create_user_directory(user_id);
+    }
+    catch (const std::filesystem::filesystem_error& error)
+    {
+        log_error(response, "Server Error: Cannot create user directory: " + std::string(error.what()));
+        return response;
+    }
+
+
+    // Snapshot restores name the file as "<snapshot>/<filename>", upload parts as "<upload_id>/<part_number>"
+    std::string snapshot;
+    if (op_code == Command::SNAPSHOT_RESTORE || op_code == Command::UPLOAD_PART)
+    {
+        if (const auto slash = filename.find('/'); slash != std::string::npos)
+        {
+            snapshot = filename.substr(0, slash);
+            filename = filename.substr(slash + 1);
+        }
+    }
 
-			// Remove any preceding slash/backslash from the filename
-            if (const auto last_slash = filename.find_last_of("/\\"); last_slash != std::string::npos)
+    // Remove any preceding slash/backslash from the filename
+    strip_path(filename);
+
+    // File operations wait for their turn at the disk, fairly shared between users
+    std::optional<FairScheduler::Ticket> ticket;
+    std::function<void(size_t)> schedule_chunk;
+    if (context_->scheduler && is_user_command(op_code))
+    {
+        ticket.emplace(*context_->scheduler, user_id, lane_of(op_code));
+        schedule_chunk = [&ticket](const size_t bytes) { ticket->charge(bytes); };
+    }
+
+    // Switch on op_code
+    switch (op_code)
+    {
+    case Command::SAVE_FILE:
+    case Command::SAVE_IF_ABSENT:
+    {
+        try
+        {
+            // Reject a corrupted upload before it replaces the existing backup
+            response.filename = filename;
+            if (expected_checksum && *expected_checksum != payload_checksum)
             {
-                filename = filename.substr(last_slash + 1);
+                response.status = ServerStatus::ERR_CHECKSUM_MISMATCH;
+                log_error(response, "Error saving file: payload does not match its checksum.");
+                break;
             }
 
-            // Switch on op_code
-            switch (op_code)
+            const bool if_absent = op_code == Command::SAVE_IF_ABSENT;
+            if (const bool success = file_manager.save_file(user_id, filename, file_data, payload_checksum, schedule_chunk,
+                                                            if_absent); !success)
             {
-            case Command::SAVE_FILE:
+                log_error(response, "Server Error: Error while the saving file: " + filename);
+                break;
+            }
+
+            response.status = ServerStatus::SUCCESS_NO_PAYLOAD; // 212
+            if (context_->replicator)
             {
-                try
-                {
-                    if (const bool success = file_manager.save_file(user_id, filename, file_data); !success)
-                    {
-                        send_error_response(response, "Server Error: Error while the saving file: " + filename);
-                    }
-                    else
-                    {
-                        response.filename = filename;
-                        response.status = ServerStatus::SUCCESS_NO_PAYLOAD; // 212
-						parser.write_response(response);
-                    }
-                    break;
-                }
-				catch (const std::filesystem::filesystem_error& error)
-				{
-					response.status = ServerStatus::ERR_GENERAL;
-					send_error_response(response, "Server error: " + std::string(error.what()));
-					break;
-				}
-				catch (...)
-				{
-					response.status = ServerStatus::ERR_GENERAL;
-					send_error_response(response, "Server Error: Error processing SAVE_FILE request.");
-                    break;
-				}
+                context_->replicator->record(Command::SAVE_FILE, user_id, filename);
             }
+            break;
+        }
+        catch (const QuotaExceededError& error)
+        {
+            response.status = ServerStatus::ERR_QUOTA_EXCEEDED;
+            log_error(response, "Error saving file: " + std::string(error.what()));
+            break;
+        }
+        catch (const FileExistsError&)
+        {
+            // The user's own copy (or delete) wins over the one offered; not an error worth logging
+            response.status = ServerStatus::ERR_FILE_EXISTS;
+            break;
+        }
+        catch (const std::filesystem::filesystem_error& error)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server error: " + std::string(error.what()));
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing SAVE_FILE request.");
+            break;
+        }
+    }
 
-            case Command::RESTORE_FILES:
+    case Command::RESTORE_FILES:
+    {
+        try
+        {
+            std::vector<unsigned char> data;
+            uint32_t checksum = 0;
+            response.filename = filename;
+
+            if (const bool found = file_manager.read_file(user_id, filename, data, &checksum, schedule_chunk); !found)
             {
-                try
-                {
-	                std::vector<unsigned char> data;
-                    response.filename = filename;
-
-                    if (const bool found = file_manager.read_file(user_id, filename, data); !found)
-                    {
-                        response.status = ServerStatus::ERR_FILE_NOT_FOUND;
-                        send_error_response(response, "Error restoring file: file not found for this user.");
-                    }
-                    else
-                    {
-                        response.status = ServerStatus::SUCCESS_FOUND;
-                        response.payload = std::move(data);
-						parser.write_response(response);
-                    }
-                    break;
-                }
-				catch (const std::filesystem::filesystem_error& error)
-				{
-					response.status = ServerStatus::ERR_GENERAL;
-					send_error_response(response, "Server error: " + std::string(error.what()));
-					break;
-				}
-				catch (...)
-				{
-					response.status = ServerStatus::ERR_GENERAL;
-					send_error_response(response, "Server Error: Error processing RESTORE_FILES request.");
-                    break;
-				}
+                response.status = ServerStatus::ERR_FILE_NOT_FOUND;
+                log_error(response, "Error restoring file: file not found for this user.");
+            }
+            else
+            {
+                response.status = ServerStatus::SUCCESS_FOUND;
+                response.payload = std::move(data);
+                response.checksum = checksum;
             }
+            break;
+        }
+        catch (const ChecksumMismatchError& error)
+        {
+            response.status = ServerStatus::ERR_CHECKSUM_MISMATCH;
+            log_error(response, "Server error: " + std::string(error.what()));
+            break;
+        }
+        catch (const std::filesystem::filesystem_error& error)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server error: " + std::string(error.what()));
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing RESTORE_FILES request.");
+            break;
+        }
+    }
 
-            case Command::DELETE_FILE:
+    case Command::DELETE_FILE:
+    {
+        try
+        {
+            response.filename = filename;
+            if (ticket)
             {
-                try
-                {
-                    response.filename = filename;
+                ticket->charge(METADATA_OPERATION_COST);
+            }
 
-                    if (const bool removed = file_manager.delete_file(user_id, filename); !removed)
-                    {
-						response.status = ServerStatus::ERR_FILE_NOT_FOUND;
-						send_error_response(response,"Error deleting file: file not found for this user.");
-						break;
-                    }
+            // In a cluster, the delete is remembered so a copy still on the user's previous node does not come back
+            if (const bool removed = file_manager.delete_file(user_id, filename, context_->cluster != nullptr); !removed)
+            {
+                response.status = ServerStatus::ERR_FILE_NOT_FOUND;
+                log_error(response, "Error deleting file: file not found for this user.");
+                break;
+            }
 
-                    response.status = ServerStatus::SUCCESS_NO_PAYLOAD;
-					parser.write_response(response);
-                    break;
-				}
-                catch (const std::filesystem::filesystem_error& error)
-                {
-					response.status = ServerStatus::ERR_GENERAL;
-                    send_error_response(response, "Server error: " + std::string(error.what()));
-                    break;
-                }
-                catch (...)
+            response.status = ServerStatus::SUCCESS_NO_PAYLOAD;
+            if (context_->replicator)
+            {
+                context_->replicator->record(Command::DELETE_FILE, user_id, filename);
+            }
+            break;
+        }
+        catch (const std::filesystem::filesystem_error& error)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server error: " + std::string(error.what()));
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing DELETE_FILE request.");
+            break;
+        }
+    }
+
+    case Command::LIST_FILES:
+    {
+        try
+        {
+            if (ticket)
+            {
+                ticket->charge(METADATA_OPERATION_COST);
+            }
+
+            const auto files = file_manager.list_user_files(user_id);
+            if (files.empty())
+            {
+                response.status = ServerStatus::ERR_NO_FILES;
+                log_error(response, "Error listing files: no files found for this user.");
+                break;
+            }
+
+            // create a random txt file containing the list
+            std::string txt_file = file_manager.write_file_list(user_id, files);
+
+            // read that file into 'payload'
+            std::vector<unsigned char> data;
+            if (const bool ok = file_manager.read_file(user_id, txt_file, data); !ok)
+            {
+                response.status = ServerStatus::ERR_GENERAL;
+                log_error(response, "Server Error: Error while reading file list.");
+                break;
+            }
+
+            response.status = ServerStatus::SUCCESS_FILE_LIST;
+            response.filename = txt_file;
+            response.payload = std::move(data);
+            break;
+        }
+        catch (const std::filesystem::filesystem_error& error)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: " + std::string(error.what()));
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing LIST_FILES request.");
+            break;
+        }
+    }
+
+    case Command::SNAPSHOT_CREATE:
+    {
+        try
+        {
+            if (ticket)
+            {
+                ticket->charge(METADATA_OPERATION_COST);
+            }
+
+            const std::string name = filename.empty() ? timestamp_snapshot_name() : filename;
+            response.filename = name;
+            if (!regex_match(name, SNAPSHOT_NAME_PATTERN))
+            {
+                log_error(response, "Error creating snapshot: invalid snapshot name: " + name);
+                break;
+            }
+
+            const auto files = file_manager.create_snapshot(user_id, name);
+            if (!files)
+            {
+                log_error(response, "Error creating snapshot: a snapshot named " + name + " already exists.");
+                break;
+            }
+
+            std::cout << "Snapshot " << name << " of user " << user_id << ": " << *files << " files\n";
+            response.status = ServerStatus::SUCCESS_NO_PAYLOAD;
+            break;
+        }
+        catch (const std::filesystem::filesystem_error& error)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: " + std::string(error.what()));
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing SNAPSHOT_CREATE request.");
+            break;
+        }
+    }
+
+    case Command::SNAPSHOT_LIST:
+    {
+        try
+        {
+            if (ticket)
+            {
+                ticket->charge(METADATA_OPERATION_COST);
+            }
+
+            const auto snapshots = file_manager.list_snapshots(user_id);
+            if (snapshots.empty())
+            {
+                response.status = ServerStatus::ERR_NO_FILES;
+                log_error(response, "Error listing snapshots: no snapshots found for this user.");
+                break;
+            }
+
+            // One line per snapshot: name, creation time (seconds since the epoch) and number of files
+            std::string listing;
+            for (const auto& info : snapshots)
+            {
+                listing += info.name + "\t" + std::to_string(info.created) + "\t" + std::to_string(info.files) + "\n";
+            }
+            response.status = ServerStatus::SUCCESS_FILE_LIST;
+            response.filename = "snapshots.txt";
+            response.payload.assign(listing.begin(), listing.end());
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing SNAPSHOT_LIST request.");
+            break;
+        }
+    }
+
+    case Command::SNAPSHOT_RESTORE:
+    {
+        try
+        {
+            std::vector<unsigned char> data;
+            uint32_t checksum = 0;
+            response.filename = filename;
+
+            if (!regex_match(snapshot, SNAPSHOT_NAME_PATTERN) ||
+                !file_manager.read_snapshot_file(user_id, snapshot, filename, data, &checksum, schedule_chunk))
+            {
+                response.status = ServerStatus::ERR_FILE_NOT_FOUND;
+                log_error(response, "Error restoring file: file not found in snapshot " + snapshot + ".");
+            }
+            else
+            {
+                response.status = ServerStatus::SUCCESS_FOUND;
+                response.payload = std::move(data);
+                response.checksum = checksum;
+            }
+            break;
+        }
+        catch (const ChecksumMismatchError& error)
+        {
+            response.status = ServerStatus::ERR_CHECKSUM_MISMATCH;
+            log_error(response, "Server error: " + std::string(error.what()));
+            break;
+        }
+        catch (const std::filesystem::filesystem_error& error)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server error: " + std::string(error.what()));
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing SNAPSHOT_RESTORE request.");
+            break;
+        }
+    }
+
+    case Command::UPLOAD_INITIATE:
+    {
+        try
+        {
+            if (file_data.size() != UploadInitiateBody::size)
+            {
+                log_error(response, "Error starting upload: expected the total and part sizes.");
+                break;
+            }
+            UploadInitiateBody::Buffer body;
+            std::copy(file_data.begin(), file_data.end(), body.begin());
+            const uint64_t total_size = UploadInitiateBody::get<TotalSizeField>(body);
+
+            // Checked again at commit, as other saves may have used the room meanwhile
+            response.filename = filename;
+            if (!file_manager.fits_quota(user_id, filename, total_size))
+            {
+                response.status = ServerStatus::ERR_QUOTA_EXCEEDED;
+                log_error(response, "Error starting upload of " + filename + ": quota exceeded.");
+                break;
+            }
+
+            const auto upload_id = context_->uploads->initiate(user_id, filename, total_size,
+                UploadInitiateBody::get<PartSizeField>(body));
+            if (!upload_id)
+            {
+                log_error(response, "Error starting upload of " + filename + ": invalid sizes or too many uploads in progress.");
+                break;
+            }
+
+            // The client names the upload by the returned ID from now on
+            response.status = ServerStatus::SUCCESS_NO_PAYLOAD;
+            response.filename = *upload_id;
+            break;
+        }
+        catch (const std::exception& error)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server error: " + std::string(error.what()));
+            break;
+        }
+    }
+
+    case Command::UPLOAD_PART:
+    {
+        const std::string& upload_id = snapshot;
+        try
+        {
+            response.filename = upload_id + "/" + filename;
+            if (expected_checksum && *expected_checksum != payload_checksum)
+            {
+                response.status = ServerStatus::ERR_CHECKSUM_MISMATCH;
+                log_error(response, "Error receiving upload part: payload does not match its checksum.");
+                break;
+            }
+
+            const uint32_t part_number = parse_part_number(filename);
+            switch (context_->uploads->write_part(user_id, upload_id, part_number, file_data,
+                payload_checksum, schedule_chunk))
+            {
+            case UploadResult::OK:
+                response.status = ServerStatus::SUCCESS_NO_PAYLOAD;
+                break;
+            case UploadResult::NOT_FOUND:
+                response.status = ServerStatus::ERR_FILE_NOT_FOUND;
+                log_error(response, "Error receiving upload part: no upload " + upload_id + ".");
+                break;
+            case UploadResult::INVALID:
+                log_error(response, "Error receiving upload part: part " + filename + " does not fit upload " + upload_id + ".");
+                break;
+            default:
+                log_error(response, "Server Error: Error writing part " + filename + " of upload " + upload_id + ".");
+                break;
+            }
+            break;
+        }
+        catch (const std::logic_error&)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Error receiving upload part: invalid part number " + filename + ".");
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing UPLOAD_PART request.");
+            break;
+        }
+    }
+
+    case Command::UPLOAD_COMMIT:
+    {
+        try
+        {
+            // The checksum of the whole file is optional
+            std::optional<uint32_t> file_checksum;
+            if (file_data.size() == UploadCommitBody::size)
+            {
+                UploadCommitBody::Buffer body;
+                std::copy(file_data.begin(), file_data.end(), body.begin());
+                file_checksum = UploadCommitBody::get<ChecksumField>(body);
+            }
+
+            std::string published;
+            response.filename = filename;
+            switch (context_->uploads->commit(user_id, filename, file_checksum, published))
+            {
+            case UploadResult::OK:
+                response.status = ServerStatus::SUCCESS_NO_PAYLOAD;
+                response.filename = published;
+                if (context_->replicator)
                 {
-                    response.status = ServerStatus::ERR_GENERAL;
-					send_error_response(response, "Server Error: Error processing DELETE_FILE request.");
-                    break;
+                    context_->replicator->record(Command::SAVE_FILE, user_id, published);
                 }
+                break;
+            case UploadResult::NOT_FOUND:
+                response.status = ServerStatus::ERR_FILE_NOT_FOUND;
+                log_error(response, "Error committing upload: no upload " + filename + ".");
+                break;
+            case UploadResult::INCOMPLETE:
+                response.status = ServerStatus::ERR_UPLOAD_INCOMPLETE;
+                log_error(response, "Error committing upload " + filename + ": parts are missing.");
+                break;
+            case UploadResult::CHECKSUM_MISMATCH:
+                response.status = ServerStatus::ERR_CHECKSUM_MISMATCH;
+                log_error(response, "Error committing upload " + filename + ": file does not match its checksum.");
+                break;
+            case UploadResult::QUOTA_EXCEEDED:
+                response.status = ServerStatus::ERR_QUOTA_EXCEEDED;
+                log_error(response, "Error committing upload " + filename + ": quota exceeded.");
+                break;
+            default:
+                log_error(response, "Server Error: Error publishing upload " + filename + ".");
+                break;
+            }
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing UPLOAD_COMMIT request.");
+            break;
+        }
+    }
+
+    case Command::UPLOAD_ABORT:
+    {
+        response.filename = filename;
+        if (!context_->uploads->abort(user_id, filename))
+        {
+            response.status = ServerStatus::ERR_FILE_NOT_FOUND;
+            log_error(response, "Error aborting upload: no upload " + filename + ".");
+            break;
+        }
+        response.status = ServerStatus::SUCCESS_NO_PAYLOAD;
+        break;
+    }
+
+    case Command::PROBE_FILES:
+    {
+        try
+        {
+            auto entries = decode_probe_entries(file_data);
+            if (!entries)
+            {
+                log_error(response, "Error probing files: malformed entry list.");
+                break;
+            }
+            if (ticket)
+            {
+                ticket->charge(METADATA_OPERATION_COST * std::max<size_t>(entries->size(), 1));
             }
 
-            case Command::LIST_FILES:
+            // Answered from the sizes and checksums recorded at save time: no file is read
+            response.payload.reserve(entries->size());
+            for (auto& entry : *entries)
             {
-                try
+                strip_path(entry.filename);
+                const auto digest = file_manager.read_digest(user_id, entry.filename);
+                const bool identical = digest && digest->size == entry.size && digest->checksum == entry.checksum;
+                response.payload.push_back(static_cast<unsigned char>(identical ? ProbeVerdict::IDENTICAL
+                                                                                : ProbeVerdict::SEND));
+                if (identical)
                 {
-	                if (const auto files = file_manager.list_user_files(user_id); files.empty())
-                    {
-						response.status = ServerStatus::ERR_NO_FILES;
-						send_error_response(response, "Error listing files: no files found for this user.");
-                        break;
-                    }
-                    else
-                    {
-                        // create a random txt file containing the list
-                        std::string txt_file = file_manager.write_file_list(user_id, files);
-
-                        // read that file into 'payload'
-                        std::vector<unsigned char> data;
-                        if (const bool ok = file_manager.read_file(user_id, txt_file, data); !ok)
-                        {
-							response.status = ServerStatus::ERR_GENERAL;
-							send_error_response(response, "Server Error: Error while reading file list.");
-                            break;
-                        }
-                        
-                        response.status = ServerStatus::SUCCESS_FILE_LIST;
-                    	response.filename = txt_file;
-                    	response.payload = std::move(data);
-						parser.write_response(response);
-						break;
-                    }
+                    ++context_->unchanged_files;
+                    context_->unchanged_bytes += entry.size;
                 }
-				catch (const std::filesystem::filesystem_error& error)
-				{
-					response.status = ServerStatus::ERR_GENERAL;
-					send_error_response(response, "Server Error: " + std::string(error.what()));
-					break;
-				}
-				catch (...)
-				{
-					response.status = ServerStatus::ERR_GENERAL;
-					send_error_response(response, "Server Error: Error processing LIST_FILES request.");
-					break;
-				}
             }
+            context_->probed_files += entries->size();
 
-            default:
-				send_error_response(response, "Server error: the operation [" + std::to_string(static_cast<int>(op_code)) + "] is not supported.");
-                continue;
+            response.status = ServerStatus::SUCCESS_PROBE_RESULT;
+            response.filename = filename;
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing PROBE_FILES request.");
+            break;
+        }
+    }
+
+    case Command::LIST_PAGE:
+    {
+        try
+        {
+            if (ticket)
+            {
+                ticket->charge(METADATA_OPERATION_COST);
             }
 
-			// Clear the response for the next iteration
-			response = Response();
+            // The filename is the prefix; the payload holds the page size, then the cursor (if any)
+            uint32_t page_size = 0;
+            std::string cursor;
+            if (file_data.size() >= ListPageBody::size)
+            {
+                ListPageBody::Buffer body;
+                std::copy_n(file_data.begin(), body.size(), body.begin());
+                page_size = ListPageBody::get<PageSizeField>(body);
+                cursor.assign(file_data.begin() + ListPageBody::size, file_data.end());
+            }
 
+            const FilePage page = file_manager.list_files_page(user_id, filename, cursor, page_size);
+            std::vector<ListEntry> entries;
+            entries.reserve(page.files.size());
+            for (const auto& file : page.files)
+            {
+                entries.push_back({ file.filename, file.stat.size, file.stat.modified });
+            }
+
+            // The next page's cursor takes the filename's place (empty after the last page)
+            response.status = ServerStatus::SUCCESS_FILE_PAGE;
+            response.filename = page.next_cursor;
+            response.payload = encode_list_entries(entries);
+            break;
+        }
+        catch (const std::filesystem::filesystem_error& error)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: " + std::string(error.what()));
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing LIST_PAGE request.");
+            break;
         }
     }
-    catch (const std::exception& e)
+
+    case Command::GET_USAGE:
     {
-		Response response;
-        std::cerr << "[Server][Thread " << std::this_thread::get_id()
-            << "] Exception in handle_client_requests(): " << e.what() << "\n";
+        try
+        {
+            const UserUsage used = file_manager.usage(user_id);
+            const QuotaLimits limits = file_manager.quota(user_id);
+            const auto body = UsageBody::encode(used.bytes, used.files, limits.bytes, limits.files);
+            response.payload.assign(body.begin(), body.end());
+            response.status = ServerStatus::SUCCESS_USAGE;
+            response.filename = filename;
+            break;
+        }
+        catch (...)
+        {
+            response.status = ServerStatus::ERR_GENERAL;
+            log_error(response, "Server Error: Error processing GET_USAGE request.");
+            break;
+        }
+    }
 
-		send_error_response(response, "Fatal server error: " + std::string(e.what()));
+    case Command::SERVER_STATUS:
+    {
+        std::string report = context_->file_manager->storage_report() + context_->file_manager->lock_report() +
+            context_->scrubber->report() + context_->uploads->report() + context_->file_manager->usage_report() +
+            context_->file_manager->index_report() + "probes: " +
+            std::to_string(context_->probed_files.load()) + " files probed, " +
+            std::to_string(context_->unchanged_files.load()) + " unchanged (" +
+            std::to_string(context_->unchanged_bytes.load()) + " bytes not sent again)\n";
+        if (context_->trace)
+        {
+            report += context_->trace->report();
+        }
+        if (context_->drain)
+        {
+            report += context_->drain->report();
+        }
+        if (context_->gate)
+        {
+            report += context_->gate->report();
+        }
+        if (context_->replicator)
+        {
+            report += context_->replicator->report();
+        }
+        if (context_->cluster)
+        {
+            report += context_->cluster->report();
+        }
+        if (context_->scheduler)
+        {
+            report += context_->scheduler->report();
+        }
+        response.status = ServerStatus::SUCCESS_STATUS_REPORT;
+        response.filename = "server_status.txt";
+        response.payload.assign(report.begin(), report.end());
+        break;
+    }
+
+    case Command::SCRUB_STORAGE:
+    {
+        if (!context_->scrubber->start_pass())
+        {
+            std::cout << "Scrub pass already in progress.\n";
+        }
+        response.status = ServerStatus::SUCCESS_NO_PAYLOAD;
+        break;
+    }
+
+    case Command::REBALANCE:
+    {
+        if (!context_->cluster)
+        {
+            log_error(response, "Server error: REBALANCE requires cluster mode.");
+            break;
+        }
+        context_->cluster->start_rebalance();
+        response.status = ServerStatus::SUCCESS_NO_PAYLOAD;
+        break;
     }
+
+    default:
+        log_error(response, "Server error: the operation [" + std::to_string(static_cast<int>(op_code)) + "] is not supported.");
+        break;
+    }
+
+    return response;
+}
+
+void ClientSession::send_response(const Response& response, const uint32_t user_id) const
+{
+    // Sending a restored file only counts against the user's bandwidth; the disk is done with it
+    if (context_->scheduler && response.status == ServerStatus::SUCCESS_FOUND)
+    {
+        parser_.write_response(response, [this, user_id](const size_t bytes)
+        {
+            context_->scheduler->throttle(user_id, bytes);
+        });
+        return;
+    }
+    parser_.write_response(response);
+}
+
+Response ClientSession::forward_to_owner(const std::string& owner, const Request& request)
+{
+    // Requests in flight on this session take turns on its connections to the other nodes
+    std::lock_guard lock(owner_connections_mutex_);
+    auto& connection = owner_connections_[owner];
+    try
+    {
+        if (!connection)
+        {
+            std::string host;
+            unsigned short port = 0;
+            if (!parse_endpoint(owner, host, port))
+            {
+                throw std::invalid_argument("Invalid node address: " + owner);
+            }
+            connection = std::make_unique<PeerClient>(host, port);
+            connection->connect();
+        }
+
+        connection->send_request(request);
+        return connection->read_response();
+    }
+    catch (...)
+    {
+        owner_connections_.erase(owner);
+        throw;
+    }
+}
+
+void ClientSession::log_error(const Response& response, const std::string& message)
+{
+	std::cerr << message << " => returning error " << static_cast<uint16_t>(response.status) << "\n";
 }
 
 void ClientSession::send_error_response(const Response& response, const std::string& message) const
 {
-	std::cerr << " => returning error " << static_cast<uint16_t>(response.status) << "\n";
+	log_error(response, message);
 
     try {
-        ProtocolParcer parser(socket_);
-		parser.write_response(response);
+		parser_.write_response(response);
     }
     catch (...) {
 	    std::cerr << "[Server][Thread " << std::this_thread::get_id()
 			<< "] Error sending error response\n";
     }
-}
\ No newline at end of file
+}
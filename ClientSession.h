@@ -9,26 +9,39 @@
  */
 
 #pragma once
+#include "Request.h"
 #include "Response.h"
+#include "ServerContext.h"
+#include "ProtocolParcer.h"
+#include "PeerClient.h"
+#include "Transport.h"
 
 #include <boost/asio.hpp>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 
-constexpr unsigned short SERVER_VERSION = 1;
-const std::string STORAGE_FOLDER = "c:/backupsvr/";
+constexpr unsigned short SERVER_VERSION = 3;
+constexpr size_t MAX_IN_FLIGHT_REQUESTS = 32; // version 3 requests processed at once per connection
 
 /**
  * @class ClientSession
  * @brief Manages a single client session, handling requests and sending responses.
+ * @details Clients speaking protocol version 1 or 2 send one request at a time and wait for its response.
+ *          Version 3 clients may send up to MAX_IN_FLIGHT_REQUESTS requests ahead; each is processed on its own thread
+ *          and answered as soon as it completes, so a slow RESTORE does not hold up a LIST sent after it.
  */
 class ClientSession : public std::enable_shared_from_this<ClientSession>
 {
 public:
     /**
-     * @brief Constructs a ClientSession with a given socket.
-     * @param socket The socket for communication with the client.
+     * @brief Constructs a ClientSession over a given transport.
+     * @param transport The stream to the client (a TCP socket or an in-process pipe).
+     * @param context The services shared by all sessions.
      */
-    explicit ClientSession(std::shared_ptr<boost::asio::ip::tcp::socket> socket);
+    ClientSession(std::shared_ptr<Transport> transport, std::shared_ptr<ServerContext> context);
 
     /**
      * @brief Starts the client session in a new thread.
@@ -39,21 +52,88 @@ private:
     /**
      * @brief Handles client requests in a loop until the client disconnects.
      * @details This method performs the following steps:
-     * 1. Creates a protocol parser on the socket.
-     * 2. Enters a loop to handle multiple requests from the same client until the client disconnects.
-     * 3. Reads the client's request and checks for disconnection or errors.
-     * 4. Performs a basic check for path traversal in the filename.
-     * 5. Sets up a FileManager for file operations.
-     * 6. Creates the root directory and user directory if they do not exist.
-     * 7. Processes the request based on the operation code (op_code):
-     *    - SAVE_FILE: Saves the file to the user's directory.
-     *    - RESTORE_FILES: Restores the file from the user's directory.
+     * 1. Enters a loop to handle multiple requests from the same client until the client disconnects.
+     * 2. Reads the client's request and checks for disconnection or errors.
+     * 3. Performs a basic check for path traversal in the filename.
+     * 4. Hands version 3 requests to dispatch_request(); processes older ones right away with process_request().
+     * 5. Sends the response to the client.
+     * 6. Handles any exceptions that occur during request processing.
+     */
+	void handle_client_requests();
+
+    /**
+     * @brief Waits for the client's next request, watching for the server to start draining for a successor.
+     * @details Polls every DRAIN_POLL_INTERVAL. Once the server drains, gives up as soon as no request is waiting
+     *          and the requests in flight have been answered.
+     * @return True if a request is waiting; false if the session should close.
+     */
+    bool wait_for_request();
+
+    /**
+     * @brief Processes a version 3 request on its own thread and sends its response when it completes.
+     * @details Blocks while MAX_IN_FLIGHT_REQUESTS requests of this session are already being processed.
+     * @param request The request.
+     */
+    void dispatch_request(Request request);
+
+    /**
+     * @brief Processes a request, sends its response and records both in the trace (if tracing).
+     * @param request The request.
+     */
+    void serve_request(Request& request);
+
+    /**
+     * @brief Processes a single request.
+     * @details This method performs the following steps:
+     * 1. In cluster mode, redirects (or proxies) requests for users owned by another node.
+     *    After a takeover, waits while the previous process still works on the user; while draining for a
+     *    successor, forwards the requests of users handed over to it.
+     * 2. Uses the shared FileManager for file operations.
+     * 3. Creates the root directory and user directory if they do not exist.
+     * 4. Waits for the request's turn at the disk (fair scheduling).
+     * 5. Processes the request based on the operation code (op_code):
+     *    - SAVE_FILE: Verifies the payload checksum (if sent) and saves the file to the user's directory.
+     *    - RESTORE_FILES: Restores the file from the user's directory, verifying it against its stored checksum.
      *    - DELETE_FILE: Deletes the file from the user's directory.
      *    - LIST_FILES: Lists all files in the user's directory.
-     * 8. Sends the appropriate response to the client.
-     * 9. Handles any exceptions that occur during request processing.
+     *    - SERVER_STATUS: Returns a text report of the background activity (e.g. scrubber progress).
+     *    - SCRUB_STORAGE: Starts a storage scrub pass.
+     *    - REBALANCE: Moves the users this node no longer owns to their owners (cluster mode).
+     *    - SNAPSHOT_CREATE: Captures the user's current files in a named snapshot.
+     *    - SNAPSHOT_LIST: Lists the user's snapshots.
+     *    - SNAPSHOT_RESTORE: Restores a file as it was when a snapshot was taken.
+     *    - UPLOAD_INITIATE, UPLOAD_PART, UPLOAD_COMMIT, UPLOAD_ABORT: Receive a large file as numbered parts.
+     *    - PROBE_FILES: Tells, for each file of a batch, whether the stored copy has the same size and checksum.
+     *    - GET_USAGE: Returns the bytes and files the user stores and the user's quota.
+     *    - LIST_PAGE: Lists one page of the user's files in name order, with sizes and modification times.
+     * 6. Records successful saves (including committed uploads) and deletes for replication.
+     * @param request The request (its filename is stripped of any leading path).
+     * @return The response to send.
+     */
+    Response process_request(Request& request);
+
+    /**
+     * @brief Sends a response, pacing restored files by the user's bandwidth cap.
+     * @param response The response.
+     * @param user_id The user the request was made for.
+     */
+    void send_response(const Response& response, uint32_t user_id) const;
+
+    /**
+     * @brief Forwards a request to the node owning its user (or to the successor process) and returns its response.
+     * @param owner The owner's address ("host:port").
+     * @param request The request to forward.
+     * @return The owner's response.
+     * @throws std::exception if the owner cannot be reached.
+     */
+    Response forward_to_owner(const std::string& owner, const Request& request);
+
+    /**
+     * @brief Logs an error response.
+     * @param response The response object containing the error status.
+     * @param message The error message.
      */
-	void handle_client_requests() const;
+    static void log_error(const Response& response, const std::string& message);
 
     /**
      * @brief Sends an error response to the client.
@@ -63,7 +143,47 @@ private:
 	void send_error_response(const Response& response, const std::string& message) const;
 
 	/**
-	 * @brief The socket for communication with the client.
+	 * @brief The stream to the client.
 	 */
-    std::shared_ptr<boost::asio::ip::tcp::socket> socket_;
-};
\ No newline at end of file
+    std::shared_ptr<Transport> transport_;
+
+	/**
+	 * @brief The services shared by all sessions.
+	 */
+    std::shared_ptr<ServerContext> context_;
+
+    /**
+     * @brief The protocol parser on the transport, shared by all requests in flight.
+     */
+    ProtocolParcer parser_;
+
+    /**
+     * @brief Guards 'owner_connections_'.
+     */
+    std::mutex owner_connections_mutex_;
+
+    /**
+     * @brief Connections to the other cluster nodes, used in proxy mode (by address).
+     */
+    std::map<std::string, std::unique_ptr<PeerClient>> owner_connections_;
+
+    /**
+     * @brief Guards 'in_flight_'.
+     */
+    std::mutex in_flight_mutex_;
+
+    /**
+     * @brief Signaled when a version 3 request completes.
+     */
+    std::condition_variable in_flight_cv_;
+
+    /**
+     * @brief Version 3 requests being processed.
+     */
+    size_t in_flight_ = 0;
+
+    /**
+     * @brief The session's number in the trace (0 when not tracing).
+     */
+    uint32_t session_id_ = 0;
+};
@@ -0,0 +1,243 @@
+/**
+ * @file Cluster.cpp
+ * @brief Cluster class implementation.
+ * @details This file contains the implementation of user ownership and rebalancing in cluster mode.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "Cluster.h"
+#include "Checksum.h"
+#include "PeerClient.h"
+#include "WireFormat.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+Cluster::Cluster(std::shared_ptr<FileManager> file_manager, std::string self, const std::vector<std::string>& nodes,
+                 const bool proxy, std::shared_ptr<Replicator> replicator)
+    : file_manager_(std::move(file_manager)),
+    replicator_(std::move(replicator)),
+    self_(std::move(self)),
+    ring_(nodes),
+    proxy_(proxy)
+{
+}
+
+Cluster::~Cluster()
+{
+    stopping_ = true;
+    std::lock_guard lock(mutex_);
+    if (rebalancer_.joinable())
+    {
+        rebalancer_.join();
+    }
+}
+
+const std::string& Cluster::owner(const uint32_t user_id) const
+{
+    return ring_.owner(user_id);
+}
+
+bool Cluster::owns(const uint32_t user_id) const
+{
+    return ring_.owner(user_id) == self_;
+}
+
+bool Cluster::proxy() const
+{
+    return proxy_;
+}
+
+bool Cluster::start_rebalance()
+{
+    std::lock_guard lock(mutex_);
+    if (rebalancing_)
+    {
+        return false;
+    }
+    if (rebalancer_.joinable())
+    {
+        rebalancer_.join();
+    }
+
+    rebalancing_ = true;
+    rebalancer_ = std::thread([this]
+    {
+        rebalance();
+        rebalancing_ = false;
+    });
+    return true;
+}
+
+std::string Cluster::report() const
+{
+    std::ostringstream out;
+    out << "cluster: node " << self_ << " of " << ring_.nodes().size() << " (" << (proxy_ ? "proxy" : "redirect")
+        << " mode), rebalance " << (rebalancing_ ? "running" : "idle") << "\n"
+        << "  moved " << users_moved_ << " users, " << files_moved_ << " files (" << files_kept_
+        << " not sent: their owner held them or had saved or deleted them since)\n";
+    return out.str();
+}
+
+void Cluster::rebalance()
+{
+    try
+    {
+        for (const uint32_t user_id : file_manager_->list_users())
+        {
+            if (stopping_)
+            {
+                break;
+            }
+            if (owns(user_id))
+            {
+                continue;
+            }
+
+            try
+            {
+                const uint64_t files = move_user(user_id);
+                ++users_moved_;
+                std::cout << "Rebalance moved " << files << " files of user " << user_id << " to " << owner(user_id) << "\n";
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Rebalance of user " << user_id << " to " << owner(user_id) << " failed: " << e.what() << "\n";
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Rebalance failed: " << e.what() << "\n";
+    }
+}
+
+uint64_t Cluster::move_user(const uint32_t user_id)
+{
+    std::string host;
+    unsigned short port = 0;
+    if (!parse_endpoint(owner(user_id), host, port))
+    {
+        throw std::invalid_argument("Invalid node address: " + owner(user_id));
+    }
+
+    PeerClient peer(host, port);
+    peer.connect();
+
+    const std::vector<std::string> files = file_manager_->list_user_files(user_id);
+    uint64_t moved = 0;
+
+    // A local copy the owner does not need (it holds the same file, or its own newer copy or delete) is dropped here
+    const auto drop = [this, user_id](const std::string& filename)
+    {
+        file_manager_->delete_file(user_id, filename);
+        if (replicator_)
+        {
+            replicator_->record(Command::DELETE_FILE, user_id, filename);
+        }
+        ++files_kept_;
+    };
+
+    for (size_t start = 0; start < files.size() && !stopping_; start += REBALANCE_BATCH_SIZE)
+    {
+        const size_t end = std::min(files.size(), start + REBALANCE_BATCH_SIZE);
+
+        // One probe per batch finds the files the owner already holds unchanged, which need not be sent at all
+        std::vector<std::string> to_send;
+        std::vector<ProbeEntry> probed;
+        for (size_t i = start; i < end; ++i)
+        {
+            if (const auto digest = file_manager_->read_digest(user_id, files[i]))
+            {
+                probed.push_back({ files[i], digest->size, digest->checksum });
+            }
+            else
+            {
+                to_send.push_back(files[i]);
+            }
+        }
+        if (!probed.empty())
+        {
+            Request probe;
+            probe.user_id = user_id;
+            probe.op_code = Command::PROBE_FILES;
+            probe.file_data = encode_probe_entries(probed);
+            probe.payload_checksum = Crc32c::compute(probe.file_data.data(), probe.file_data.size());
+            peer.send_request(probe);
+            const Response response = peer.read_response();
+            if (response.status != ServerStatus::SUCCESS_PROBE_RESULT || response.payload.size() != probed.size())
+            {
+                throw std::runtime_error(peer.address() + " cannot probe the files of user " + std::to_string(user_id) +
+                    " (status " + std::to_string(static_cast<uint16_t>(response.status)) + ")");
+            }
+            for (size_t i = 0; i < probed.size(); ++i)
+            {
+                if (static_cast<ProbeVerdict>(response.payload[i]) == ProbeVerdict::IDENTICAL)
+                {
+                    drop(probed[i].filename);
+                }
+                else
+                {
+                    to_send.push_back(probed[i].filename);
+                }
+            }
+        }
+
+        // Pipeline the saves; each only lands if the owner has neither the file nor a delete of it since the ring
+        // changed, a condition it checks atomically with the save, so a copy or delete made there always wins
+        std::vector<std::string> sent;
+        for (const auto& filename : to_send)
+        {
+            Request request;
+            request.user_id = user_id;
+            request.op_code = Command::SAVE_IF_ABSENT;
+            request.filename = filename;
+            try
+            {
+                if (!file_manager_->read_file(user_id, filename, request.file_data, &request.payload_checksum))
+                {
+                    continue;
+                }
+            }
+            catch (const std::exception& e)
+            {
+                // A damaged file stays here for the scrubber instead of spreading to the new owner
+                std::cerr << "Rebalance skipped " << filename << " of user " << user_id << ": " << e.what() << "\n";
+                continue;
+            }
+            peer.send_request(request);
+            sent.push_back(filename);
+        }
+
+        for (const auto& filename : sent)
+        {
+            const Response response = peer.read_response();
+            if (response.status == ServerStatus::ERR_FILE_EXISTS)
+            {
+                drop(filename);
+                continue;
+            }
+            if (response.status != ServerStatus::SUCCESS_NO_PAYLOAD)
+            {
+                std::cerr << "Rebalance: " << peer.address() << " rejected " << filename << " of user " << user_id
+                    << " with status " << static_cast<uint16_t>(response.status) << "\n";
+                continue;
+            }
+            file_manager_->delete_file(user_id, filename);
+            if (replicator_)
+            {
+                replicator_->record(Command::DELETE_FILE, user_id, filename);
+            }
+            ++moved;
+            ++files_moved_;
+        }
+    }
+    return moved;
+}
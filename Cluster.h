@@ -0,0 +1,148 @@
+/**
+ * @file Cluster.h
+ * @brief Cluster class definition.
+ * @details This header file contains the Cluster class, which decides which node of a cluster owns a user
+ *          and moves the users this node no longer owns to their new owner.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "FileManager.h"
+#include "HashRing.h"
+#include "Replicator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr size_t REBALANCE_BATCH_SIZE = 64; // files sent to the new owner before waiting for its responses
+
+/**
+ * @class Cluster
+ * @brief Cluster membership of this node: user ownership through a consistent hashing ring, and rebalancing.
+ * @details Every node is started with the same list of nodes. Requests for users owned by another node are either
+ *          answered with ServerStatus::REDIRECT naming the owner, or proxied to it.
+ *          When nodes are added, each node is restarted with the new list and rebalances: it streams the files of every
+ *          user it no longer owns to the new owner (pipelined SAVE_IF_ABSENT requests with checksums) and then deletes
+ *          them locally. The new owner serves the user from the moment the ring changed, so a file it holds, or that the
+ *          user deleted there (remembered for DELETE_MEMORY), is newer than this node's copy: the owner refuses the
+ *          save, checking atomically with it, and the stale copy is dropped.
+ */
+class Cluster {
+public:
+    /**
+     * @brief Constructs the cluster membership.
+     * @param file_manager The file manager holding this node's users.
+     * @param self This node's address ("host:port"), as listed in 'nodes'.
+     * @param nodes The addresses of all nodes of the cluster.
+     * @param proxy Whether requests for other nodes' users are proxied instead of redirected.
+     * @param replicator Records the files deleted once moved, so the replication peer drops them too (null: none).
+     */
+    Cluster(std::shared_ptr<FileManager> file_manager, std::string self, const std::vector<std::string>& nodes, bool proxy,
+            std::shared_ptr<Replicator> replicator = nullptr);
+
+    /**
+     * @brief Waits for a running rebalance to stop.
+     */
+    ~Cluster();
+
+    Cluster(const Cluster&) = delete;
+    Cluster& operator=(const Cluster&) = delete;
+
+    /**
+     * @brief Returns the node owning a user.
+     * @param user_id The user ID.
+     * @return The owner's address ("host:port").
+     */
+    const std::string& owner(uint32_t user_id) const;
+
+    /**
+     * @brief Tells whether this node owns a user.
+     * @param user_id The user ID.
+     * @return True if this node owns the user.
+     */
+    bool owns(uint32_t user_id) const;
+
+    /**
+     * @brief Tells whether requests for other nodes' users are proxied instead of redirected.
+     * @return True in proxy mode.
+     */
+    bool proxy() const;
+
+    /**
+     * @brief Starts moving the users this node does not own to their owners, in the background.
+     * @return True if a rebalance was started; false if one is already running.
+     */
+    bool start_rebalance();
+
+    /**
+     * @brief Formats the cluster state and rebalance progress as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @brief Moves every local user this node does not own to its owner.
+     */
+    void rebalance();
+
+    /**
+     * @brief Streams one user's files to its owner and deletes them locally once acknowledged.
+     * @details Each batch starts with one PROBE_FILES request: files the owner holds unchanged are not sent. The
+     *          others are sent with SAVE_IF_ABSENT; local copies the owner refuses as superseded are deleted too.
+     * @param user_id The user ID.
+     * @return The number of files moved.
+     */
+    uint64_t move_user(uint32_t user_id);
+
+    /**
+     * @brief The file manager holding this node's users.
+     */
+    std::shared_ptr<FileManager> file_manager_;
+
+    /**
+     * @brief Records the local deletes for the replication peer (null without one).
+     */
+    std::shared_ptr<Replicator> replicator_;
+
+    /**
+     * @brief This node's address.
+     */
+    std::string self_;
+
+    /**
+     * @brief The ring of all nodes.
+     */
+    HashRing ring_;
+
+    /**
+     * @brief Whether requests for other nodes' users are proxied.
+     */
+    bool proxy_;
+
+    /**
+     * @brief Guards 'rebalancer_'.
+     */
+    std::mutex mutex_;
+
+    /**
+     * @brief The rebalance thread.
+     */
+    std::thread rebalancer_;
+
+    std::atomic<bool> rebalancing_{ false };   ///< Whether a rebalance is running.
+    std::atomic<bool> stopping_{ false };      ///< Set when the node is shutting down.
+    std::atomic<uint64_t> users_moved_{ 0 };   ///< Users moved to another node since startup.
+    std::atomic<uint64_t> files_moved_{ 0 };   ///< Files moved to another node since startup.
+    std::atomic<uint64_t> files_kept_{ 0 };    ///< Local copies dropped because the owner held the file or superseded it.
+};
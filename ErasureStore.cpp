@@ -0,0 +1,607 @@
+/**
+ * @file ErasureStore.cpp
+ * @brief ErasureStore class implementation.
+ * @details This file contains the implementation of the erasure-coded file storage: shard placement, encoding,
+ *          parallel and degraded reads, shard repair and snapshots.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "ErasureStore.h"
+#include "Checksum.h"
+#include "ReedSolomon.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    const std::string SHARD_SNAPSHOTS_FOLDER = ".snapshots/";  // per-user shard folder holding the links of snapshots
+    const std::string MANIFEST_TEMP_FOLDER = ".tmp/";          // where manifests are written before being renamed
+
+    /**
+     * @brief Returns the number of stripes of a file.
+     */
+    uint64_t stripe_count(const ErasureManifest& manifest)
+    {
+        const uint64_t stripe_size = static_cast<uint64_t>(manifest.data_shards) * ERASURE_BLOCK_SIZE;
+        return (manifest.size + stripe_size - 1) / stripe_size;
+    }
+
+    /**
+     * @brief Tells whether a manifest lists one path and one checksum per shard of a valid code.
+     */
+    bool well_formed(const ErasureManifest& manifest)
+    {
+        const size_t total = static_cast<size_t>(manifest.data_shards) + manifest.parity_shards;
+        return manifest.data_shards > 0 && manifest.parity_shards > 0 && total <= MAX_TOTAL_SHARDS &&
+            manifest.shard_paths.size() == total && manifest.shard_checksums.size() == total;
+    }
+
+    /**
+     * @brief Reads every block of a shard to where 'block' says and checks the shard against its checksum.
+     * @return False if the shard is missing, short, too long or damaged.
+     */
+    bool read_shard(const std::string& path, const uint32_t expected, const uint64_t stripes,
+                    const std::function<unsigned char*(uint64_t)>& block)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open())
+        {
+            return false;
+        }
+        Crc32c crc;
+        for (uint64_t s = 0; s < stripes; ++s)
+        {
+            unsigned char* data = block(s);
+            if (!in.read(reinterpret_cast<char*>(data), ERASURE_BLOCK_SIZE))
+            {
+                return false;
+            }
+            crc.update(data, ERASURE_BLOCK_SIZE);
+        }
+        return in.peek() == std::ifstream::traits_type::eof() && crc.value() == expected;
+    }
+
+    /**
+     * @brief Runs 'task' for every index in [first, last), each on its own thread but the first.
+     */
+    void run_parallel(const unsigned first, const unsigned last, const std::function<void(unsigned)>& task)
+    {
+        std::vector<std::thread> threads;
+        for (unsigned i = first + 1; i < last; ++i)
+        {
+            threads.emplace_back(task, i);
+        }
+        if (first < last)
+        {
+            task(first);
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+ErasureStore::ErasureStore(std::shared_ptr<StorageRoots> roots, const ErasureConfig& config)
+    : roots_(std::move(roots)), config_(config)
+{
+    if (!enabled())
+    {
+        return;
+    }
+    ReedSolomon code(config.data_shards, config.parity_shards);
+    if (roots_->paths().size() < config.data_shards + config.parity_shards)
+    {
+        throw std::invalid_argument("Erasure coding " + std::to_string(config.data_shards) + "+" +
+            std::to_string(config.parity_shards) + " needs as many storage roots, got " +
+            std::to_string(roots_->paths().size()));
+    }
+}
+
+bool ErasureStore::enabled() const
+{
+    return config_.data_shards > 0;
+}
+
+std::optional<ErasureManifest> ErasureStore::write(const uint32_t user_id, const std::string& filename, const uint64_t size,
+                                                   const uint32_t checksum, const ReadFn& read,
+                                                   const std::function<void(size_t)>& before_chunk)
+{
+    const unsigned k = config_.data_shards;
+    const unsigned total = k + config_.parity_shards;
+    const ReedSolomon code(k, config_.parity_shards);
+
+    ErasureManifest manifest;
+    manifest.data_shards = k;
+    manifest.parity_shards = config_.parity_shards;
+    manifest.size = size;
+    manifest.checksum = checksum;
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    manifest.written = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(now).count());
+
+    // A new generation never collides with the shards of the version readers may still be using
+    const std::string generation = std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(now).count()) +
+        "-" + std::to_string(++generation_);
+    const auto roots = place(user_id, filename);
+    std::vector<std::ofstream> shards(total);
+    bool ok = true;
+    for (unsigned i = 0; i < total; ++i)
+    {
+        const std::string folder = roots[i] + SHARDS_FOLDER + std::to_string(user_id) + "/";
+        std::error_code ec;
+        std::filesystem::create_directories(folder, ec);
+        manifest.shard_paths.push_back(folder + filename + "." + generation + "." + std::to_string(i));
+        shards[i].open(manifest.shard_paths.back(), std::ios::binary | std::ios::trunc);
+        ok = ok && shards[i].is_open();
+    }
+
+    std::vector<unsigned char> stripe(static_cast<size_t>(total) * ERASURE_BLOCK_SIZE);
+    std::vector<const unsigned char*> data;
+    std::vector<unsigned char*> parity;
+    for (unsigned i = 0; i < total; ++i)
+    {
+        unsigned char* block = stripe.data() + static_cast<size_t>(i) * ERASURE_BLOCK_SIZE;
+        i < k ? data.push_back(block) : parity.push_back(block);
+    }
+
+    std::vector<Crc32c> crcs(total);
+    const size_t stripe_data = static_cast<size_t>(k) * ERASURE_BLOCK_SIZE;
+    for (uint64_t done = 0; ok && done < size;)
+    {
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(stripe_data, size - done));
+        if (before_chunk)
+        {
+            before_chunk(stripe.size());
+        }
+        if (!read(stripe.data(), length))
+        {
+            ok = false;
+            break;
+        }
+
+        // The last stripe is padded with zeros, which the manifest's size cuts off again on reading
+        std::memset(stripe.data() + length, 0, stripe_data - length);
+        code.encode(data.data(), parity.data(), ERASURE_BLOCK_SIZE);
+        for (unsigned i = 0; i < total && ok; ++i)
+        {
+            const unsigned char* block = stripe.data() + static_cast<size_t>(i) * ERASURE_BLOCK_SIZE;
+            crcs[i].update(block, ERASURE_BLOCK_SIZE);
+            ok = static_cast<bool>(shards[i].write(reinterpret_cast<const char*>(block), ERASURE_BLOCK_SIZE));
+        }
+        done += length;
+    }
+    for (unsigned i = 0; i < total; ++i)
+    {
+        shards[i].close();
+        ok = ok && !shards[i].fail();
+        manifest.shard_checksums.push_back(crcs[i].value());
+    }
+
+    if (!ok)
+    {
+        discard(manifest);
+        return std::nullopt;
+    }
+    return manifest;
+}
+
+bool ErasureStore::commit(const uint32_t user_id, const std::string& filename, const ErasureManifest& manifest)
+{
+    const std::string path = manifest_path(user_id, filename);
+    const auto previous = read_manifest(path);
+    if (!write_manifest(path, manifest))
+    {
+        return false;
+    }
+    ++files_written_;
+
+    // Readers of the old version opened its shards already; snapshots hold links of their own
+    if (previous)
+    {
+        discard(*previous);
+    }
+    return true;
+}
+
+void ErasureStore::discard(const ErasureManifest& manifest)
+{
+    for (const auto& path : manifest.shard_paths)
+    {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+}
+
+std::optional<ErasureManifest> ErasureStore::find(const uint32_t user_id, const std::string& filename) const
+{
+    return read_manifest(manifest_path(user_id, filename));
+}
+
+bool ErasureStore::read(const ErasureManifest& manifest, std::vector<unsigned char>& out_data)
+{
+    ++reads_;
+    if (!well_formed(manifest))
+    {
+        ++failed_reads_;
+        return false;
+    }
+    const unsigned k = manifest.data_shards;
+    const unsigned total = k + manifest.parity_shards;
+    const uint64_t stripes = stripe_count(manifest);
+    out_data.resize(static_cast<size_t>(stripes * k * ERASURE_BLOCK_SIZE));
+
+    // Each data shard lands in its blocks of the output, from its own thread (the shards are on different disks)
+    std::vector<unsigned char> intact(total, 0);
+    std::vector<std::vector<unsigned char>> parity(manifest.parity_shards);
+    const auto fetch = [&](const unsigned i)
+    {
+        const auto block = [&](const uint64_t s)
+        {
+            return i < k ? out_data.data() + static_cast<size_t>((s * k + i) * ERASURE_BLOCK_SIZE)
+                         : parity[i - k].data() + static_cast<size_t>(s * ERASURE_BLOCK_SIZE);
+        };
+        intact[i] = read_shard(manifest.shard_paths[i], manifest.shard_checksums[i], stripes, block) ? 1 : 0;
+    };
+    run_parallel(0, k, fetch);
+
+    auto available = static_cast<unsigned>(std::count(intact.begin(), intact.begin() + k, 1));
+    if (available == k)
+    {
+        out_data.resize(static_cast<size_t>(manifest.size));
+        return true;
+    }
+
+    // Read just as many parity shards as there are data shards to rebuild, more if some of those are damaged too
+    ++degraded_reads_;
+    for (unsigned next = k; available < k && next < total;)
+    {
+        const unsigned last = std::min(total, next + (k - available));
+        for (unsigned i = next; i < last; ++i)
+        {
+            parity[i - k].resize(static_cast<size_t>(stripes * ERASURE_BLOCK_SIZE));
+        }
+        run_parallel(next, last, fetch);
+        available = static_cast<unsigned>(std::count(intact.begin(), intact.end(), 1));
+        next = last;
+    }
+    if (available < k)
+    {
+        ++failed_reads_;
+        return false;
+    }
+
+    const ReedSolomon code(k, manifest.parity_shards);
+    const std::vector<bool> present(intact.begin(), intact.end());
+    std::vector<unsigned char*> shards(total, nullptr);
+    for (uint64_t s = 0; s < stripes; ++s)
+    {
+        for (unsigned i = 0; i < total; ++i)
+        {
+            if (i < k)
+            {
+                shards[i] = out_data.data() + static_cast<size_t>((s * k + i) * ERASURE_BLOCK_SIZE);
+            }
+            else if (intact[i])
+            {
+                shards[i] = parity[i - k].data() + static_cast<size_t>(s * ERASURE_BLOCK_SIZE);
+            }
+        }
+        code.reconstruct(shards.data(), present, ERASURE_BLOCK_SIZE, true);
+    }
+
+    // Rebuilt data is checked end to end, not just shard by shard
+    out_data.resize(static_cast<size_t>(manifest.size));
+    if (Crc32c::compute(out_data.data(), out_data.size()) != manifest.checksum)
+    {
+        ++failed_reads_;
+        return false;
+    }
+    return true;
+}
+
+bool ErasureStore::remove(const uint32_t user_id, const std::string& filename) const
+{
+    const auto manifest = find(user_id, filename);
+    std::error_code ec;
+    if (!manifest || !std::filesystem::remove(manifest_path(user_id, filename), ec))
+    {
+        return false;
+    }
+    discard(*manifest);
+    return true;
+}
+
+bool ErasureStore::detach(const uint32_t user_id, const std::string& filename, const std::string& target) const
+{
+    std::error_code ec;
+    std::filesystem::rename(manifest_path(user_id, filename), target, ec);
+    return !ec;
+}
+
+std::vector<std::string> ErasureStore::list(const uint32_t user_id) const
+{
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& p : std::filesystem::directory_iterator(manifest_path(user_id, ""), ec))
+    {
+        std::error_code entry_ec;
+        if (p.is_regular_file(entry_ec))
+        {
+            files.push_back(p.path().filename().string());
+        }
+    }
+    return files;
+}
+
+ShardCheck ErasureStore::check(const uint32_t user_id, const std::string& filename,
+                               const std::function<void(size_t)>& before_chunk)
+{
+    const auto manifest = find(user_id, filename);
+    if (!manifest)
+    {
+        return ShardCheck::MISSING;
+    }
+    if (!well_formed(*manifest))
+    {
+        return ShardCheck::LOST;
+    }
+    const unsigned total = manifest->data_shards + manifest->parity_shards;
+    const uint64_t stripes = stripe_count(*manifest);
+
+    // One stripe at a time, so checking a large file takes no more memory than k + m blocks
+    std::vector<std::ifstream> shards(total);
+    std::vector<Crc32c> crcs(total);
+    std::vector<bool> readable(total);
+    for (unsigned i = 0; i < total; ++i)
+    {
+        shards[i].open(manifest->shard_paths[i], std::ios::binary);
+        readable[i] = shards[i].is_open();
+    }
+    std::vector<unsigned char> block(ERASURE_BLOCK_SIZE);
+    for (uint64_t s = 0; s < stripes; ++s)
+    {
+        if (before_chunk)
+        {
+            before_chunk(static_cast<size_t>(total) * ERASURE_BLOCK_SIZE);
+        }
+        for (unsigned i = 0; i < total; ++i)
+        {
+            if (readable[i] && shards[i].read(reinterpret_cast<char*>(block.data()), ERASURE_BLOCK_SIZE))
+            {
+                crcs[i].update(block.data(), ERASURE_BLOCK_SIZE);
+            }
+            else
+            {
+                readable[i] = false;
+            }
+        }
+    }
+
+    std::vector<bool> intact(total);
+    unsigned count = 0;
+    for (unsigned i = 0; i < total; ++i)
+    {
+        intact[i] = readable[i] && shards[i].peek() == std::ifstream::traits_type::eof() &&
+            crcs[i].value() == manifest->shard_checksums[i];
+        count += intact[i] ? 1 : 0;
+    }
+    shards.clear();
+
+    if (count == total)
+    {
+        return ShardCheck::INTACT;
+    }
+    if (count < manifest->data_shards)
+    {
+        return ShardCheck::LOST;
+    }
+    return rebuild(*manifest, intact, before_chunk) ? ShardCheck::REPAIRED : ShardCheck::DEGRADED;
+}
+
+bool ErasureStore::rebuild(const ErasureManifest& manifest, const std::vector<bool>& intact,
+                           const std::function<void(size_t)>& before_chunk)
+{
+    const unsigned k = manifest.data_shards;
+    const unsigned total = k + manifest.parity_shards;
+    const uint64_t stripes = stripe_count(manifest);
+    const ReedSolomon code(k, manifest.parity_shards);
+
+    // Rebuilt shards are written next to the damaged ones and renamed over them once they match their checksums
+    std::vector<std::ifstream> sources(total);
+    std::vector<std::ofstream> targets(total);
+    std::vector<Crc32c> crcs(total);
+    bool ok = true;
+    for (unsigned i = 0; i < total; ++i)
+    {
+        if (intact[i])
+        {
+            sources[i].open(manifest.shard_paths[i], std::ios::binary);
+            ok = ok && sources[i].is_open();
+            continue;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(manifest.shard_paths[i]).parent_path(), ec);
+        targets[i].open(manifest.shard_paths[i] + ".repair", std::ios::binary | std::ios::trunc);
+        ok = ok && targets[i].is_open();
+    }
+
+    std::vector<unsigned char> stripe(static_cast<size_t>(total) * ERASURE_BLOCK_SIZE);
+    std::vector<unsigned char*> shards;
+    for (unsigned i = 0; i < total; ++i)
+    {
+        shards.push_back(stripe.data() + static_cast<size_t>(i) * ERASURE_BLOCK_SIZE);
+    }
+    for (uint64_t s = 0; ok && s < stripes; ++s)
+    {
+        if (before_chunk)
+        {
+            before_chunk(stripe.size());
+        }
+        for (unsigned i = 0; i < total && ok; ++i)
+        {
+            ok = !intact[i] || static_cast<bool>(sources[i].read(reinterpret_cast<char*>(shards[i]), ERASURE_BLOCK_SIZE));
+        }
+        ok = ok && code.reconstruct(shards.data(), intact, ERASURE_BLOCK_SIZE);
+        for (unsigned i = 0; i < total && ok; ++i)
+        {
+            if (!intact[i])
+            {
+                crcs[i].update(shards[i], ERASURE_BLOCK_SIZE);
+                ok = static_cast<bool>(targets[i].write(reinterpret_cast<const char*>(shards[i]), ERASURE_BLOCK_SIZE));
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < total; ++i)
+    {
+        if (intact[i])
+        {
+            continue;
+        }
+        targets[i].close();
+        std::error_code ec;
+        if (ok && !targets[i].fail() && crcs[i].value() == manifest.shard_checksums[i])
+        {
+            std::filesystem::rename(manifest.shard_paths[i] + ".repair", manifest.shard_paths[i], ec);
+            if (!ec)
+            {
+                ++shards_repaired_;
+                continue;
+            }
+        }
+        ok = false;
+        std::filesystem::remove(manifest.shard_paths[i] + ".repair", ec);
+    }
+    return ok;
+}
+
+bool ErasureStore::snapshot(const uint32_t user_id, const std::string& filename, const std::string& snapshot,
+                            const std::string& manifest_path) const
+{
+    auto manifest = find(user_id, filename);
+    if (!manifest)
+    {
+        return false;
+    }
+
+    // Shards are only ever replaced by new generations, never rewritten, so a link keeps this version alive
+    for (auto& path : manifest->shard_paths)
+    {
+        const std::filesystem::path shard(path);
+        const std::filesystem::path folder = shard.parent_path() / SHARD_SNAPSHOTS_FOLDER / snapshot;
+        std::filesystem::create_directories(folder);
+        const std::string link = (folder / shard.filename()).string();
+        std::error_code ec;
+        std::filesystem::create_hard_link(shard, link, ec);
+        if (ec)
+        {
+            std::filesystem::copy_file(shard, link);
+        }
+        path = link;
+    }
+    if (!write_manifest(manifest_path, *manifest))
+    {
+        throw std::filesystem::filesystem_error("Error while writing the snapshot's erasure manifest", manifest_path,
+            std::make_error_code(std::errc::io_error));
+    }
+    return true;
+}
+
+std::optional<ErasureManifest> ErasureStore::read_manifest(const std::string& path)
+{
+    std::ifstream ifs(path);
+    ErasureManifest manifest;
+    if (!(ifs >> manifest.data_shards >> manifest.parity_shards >> manifest.size >> manifest.checksum >> manifest.written))
+    {
+        return std::nullopt;
+    }
+
+    // One line per shard: its checksum, then its path (which may hold spaces)
+    uint32_t crc = 0;
+    for (std::string shard_path; ifs >> crc && std::getline(ifs >> std::ws, shard_path);)
+    {
+        manifest.shard_checksums.push_back(crc);
+        manifest.shard_paths.push_back(shard_path);
+    }
+    if (!well_formed(manifest))
+    {
+        return std::nullopt;
+    }
+    return manifest;
+}
+
+bool ErasureStore::write_manifest(const std::string& path, const ErasureManifest& manifest)
+{
+    const std::filesystem::path target(path);
+    const std::filesystem::path temp_folder = target.parent_path() / MANIFEST_TEMP_FOLDER;
+    const std::string tmp_path = (temp_folder / target.filename()).string();
+    std::error_code ec;
+    std::filesystem::create_directories(temp_folder, ec);
+    {
+        std::ofstream ofs(tmp_path, std::ios::trunc);
+        ofs << manifest.data_shards << " " << manifest.parity_shards << " " << manifest.size << " " << manifest.checksum
+            << " " << manifest.written << "\n";
+        for (size_t i = 0; i < manifest.shard_paths.size(); ++i)
+        {
+            ofs << manifest.shard_checksums[i] << " " << manifest.shard_paths[i] << "\n";
+        }
+        if (!ofs.flush())
+        {
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp_path, target, ec);
+    return !ec;
+}
+
+std::string ErasureStore::manifest_path(const uint32_t user_id, const std::string& filename) const
+{
+    return roots_->user_root(user_id) + std::to_string(user_id) + "/" + ERASURE_FOLDER + filename;
+}
+
+std::vector<std::string> ErasureStore::place(const uint32_t user_id, const std::string& filename) const
+{
+    const std::string key = std::to_string(user_id) + "/" + filename;
+    std::vector<std::pair<size_t, std::string>> scored;
+    for (const auto& root : roots_->paths())
+    {
+        scored.emplace_back(std::hash<std::string>{}(key + "@" + root), root);
+    }
+    std::sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<std::string> roots;
+    for (size_t i = 0; i < config_.data_shards + config_.parity_shards; ++i)
+    {
+        roots.push_back(scored[i].second);
+    }
+    return roots;
+}
+
+std::string ErasureStore::report() const
+{
+    std::ostringstream out;
+    out << "erasure: ";
+    if (enabled())
+    {
+        out << config_.data_shards << "+" << config_.parity_shards << " on " << gf_fastest_kernel().name << ", ";
+    }
+    else
+    {
+        out << "off (existing files readable), ";
+    }
+    out << files_written_.load() << " files written, " << reads_.load() << " reads (" << degraded_reads_.load()
+        << " rebuilt from parity, " << failed_reads_.load() << " failed), " << shards_repaired_.load()
+        << " shards repaired\n";
+    return out.str();
+}
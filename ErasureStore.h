@@ -0,0 +1,254 @@
+/**
+ * @file ErasureStore.h
+ * @brief ErasureStore class definition.
+ * @details This header file contains the ErasureStore class, which stores large files as k data and m parity shards
+ *          (see ReedSolomon) spread over as many storage roots, so a file survives the loss of any m roots for a
+ *          fraction of the space a full copy would take.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "StorageRoots.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+const std::string SHARDS_FOLDER = ".shards/";       // root folder holding the users' shards, on every root
+const std::string ERASURE_FOLDER = ".erasure/";     // per-user folder holding the manifest of each erasure-coded file
+constexpr size_t ERASURE_BLOCK_SIZE = 64 * 1024;    // bytes of a file given to each data shard in turn
+
+/**
+ * @struct ErasureConfig
+ * @brief How new files are erasure-coded.
+ */
+struct ErasureConfig {
+    unsigned data_shards = 0;       ///< Data shards per file (k; 0: files are stored whole).
+    unsigned parity_shards = 0;     ///< Parity shards per file (m): the number of roots that may be lost.
+};
+
+/**
+ * @struct ErasureManifest
+ * @brief Where the shards of an erasure-coded file are and what they must contain.
+ */
+struct ErasureManifest {
+    unsigned data_shards = 0;               ///< k.
+    unsigned parity_shards = 0;             ///< m.
+    uint64_t size = 0;                      ///< The size of the file.
+    uint32_t checksum = 0;                  ///< The CRC-32C of the file.
+    uint64_t written = 0;                   ///< When the file was saved, in seconds since the epoch.
+    std::vector<std::string> shard_paths;   ///< The k data shards, then the m parity shards.
+    std::vector<uint32_t> shard_checksums;  ///< The CRC-32C of each shard.
+};
+
+/**
+ * @enum ShardCheck
+ * @brief The outcome of checking the shards of an erasure-coded file.
+ */
+enum class ShardCheck {
+    INTACT,     ///< Every shard matches its checksum.
+    REPAIRED,   ///< Damaged or missing shards were rebuilt from the others.
+    DEGRADED,   ///< Shards are damaged or missing but could not be rewritten; the file can still be read.
+    LOST,       ///< Fewer than k shards are intact: the file cannot be read.
+    MISSING     ///< The file is not erasure-coded (or no longer exists).
+};
+
+/**
+ * @class ErasureStore
+ * @brief Splits files into Reed-Solomon shards on distinct storage roots and puts them back together.
+ * @details A file is cut into stripes of k ERASURE_BLOCK_SIZE blocks; block i of every stripe goes to data shard i
+ *          and the m parity blocks computed from the stripe to the parity shards, so each shard is one file holding
+ *          1/k of the data. The k + m roots of a file are chosen by rendezvous hashing of (user, filename, root),
+ *          spreading the files of a user over all the roots. Shard names carry a generation, so a new version is
+ *          written next to the old one and replaces it when its manifest (a small text file in the user's
+ *          ERASURE_FOLDER) is renamed into place; the old shards are removed afterwards. Reads fetch the k data
+ *          shards in parallel and verify each against its checksum; if some are missing or damaged, enough parity
+ *          shards are read to rebuild them on the fly. Manifests record their own k and m, so files stay readable
+ *          when the configuration changes or erasure coding is turned off.
+ */
+class ErasureStore {
+public:
+    /**
+     * @brief Fills a buffer with the next bytes of the file being written.
+     */
+    using ReadFn = std::function<bool(unsigned char* buffer, size_t size)>;
+
+    /**
+     * @brief Constructs the store.
+     * @param roots The storage roots receiving the shards.
+     * @param config The code of new files (k = 0 leaves new files whole, while existing ones stay readable).
+     * @throws std::invalid_argument if the code is invalid or there are fewer roots than k + m.
+     */
+    ErasureStore(std::shared_ptr<StorageRoots> roots, const ErasureConfig& config);
+
+    /**
+     * @brief Tells whether new files are erasure-coded.
+     * @return True if a code is configured.
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Encodes a file into a new generation of shards, without making it visible.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param size The size of the file.
+     * @param checksum The CRC-32C of the file.
+     * @param read Supplies the file's bytes in order.
+     * @param before_chunk Called before each stripe is written, with the bytes about to be written (may be empty).
+     * @return The manifest to commit(), or nothing on error (the shards written are removed).
+     */
+    std::optional<ErasureManifest> write(uint32_t user_id, const std::string& filename, uint64_t size, uint32_t checksum,
+                                         const ReadFn& read, const std::function<void(size_t)>& before_chunk);
+
+    /**
+     * @brief Makes written shards the file's current version and removes the shards of the previous one.
+     * @details The caller holds the file's exclusive lock.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param manifest The manifest returned by write().
+     * @return True on success; false on error (the caller discards the shards).
+     */
+    bool commit(uint32_t user_id, const std::string& filename, const ErasureManifest& manifest);
+
+    /**
+     * @brief Removes the shards of a manifest that was not committed.
+     * @param manifest The manifest.
+     */
+    static void discard(const ErasureManifest& manifest);
+
+    /**
+     * @brief Reads the manifest of an erasure-coded file.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return The manifest, or nothing if the file is not erasure-coded.
+     */
+    std::optional<ErasureManifest> find(uint32_t user_id, const std::string& filename) const;
+
+    /**
+     * @brief Reads a file back from its shards, rebuilding missing or damaged data shards from parity.
+     * @param manifest The file's manifest.
+     * @param out_data Receives the file.
+     * @return True on success; false if fewer than k shards are intact.
+     */
+    bool read(const ErasureManifest& manifest, std::vector<unsigned char>& out_data);
+
+    /**
+     * @brief Removes an erasure-coded file: its manifest, then its shards.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return True if the file existed.
+     */
+    bool remove(uint32_t user_id, const std::string& filename) const;
+
+    /**
+     * @brief Moves the manifest of a file elsewhere, leaving the shards it lists in place.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param target The new path of the manifest.
+     * @return True if the manifest was moved.
+     */
+    bool detach(uint32_t user_id, const std::string& filename, const std::string& target) const;
+
+    /**
+     * @brief Lists a user's erasure-coded files.
+     * @param user_id The user ID.
+     * @return The filenames.
+     */
+    std::vector<std::string> list(uint32_t user_id) const;
+
+    /**
+     * @brief Verifies every shard of a file and rebuilds the damaged or missing ones.
+     * @details The caller holds the file's lock, so the file is not replaced meanwhile.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param before_chunk Called before each stripe is read or rewritten, with the bytes involved.
+     * @return The outcome.
+     */
+    ShardCheck check(uint32_t user_id, const std::string& filename, const std::function<void(size_t)>& before_chunk);
+
+    /**
+     * @brief Captures a file in a snapshot by hard-linking its shards and writing a manifest listing the links.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param snapshot The snapshot's name.
+     * @param manifest_path Where to write the snapshot's manifest of the file.
+     * @return True if the file was captured; false if it does not exist.
+     * @throws std::filesystem::filesystem_error if the shards cannot be linked or the manifest written.
+     */
+    bool snapshot(uint32_t user_id, const std::string& filename, const std::string& snapshot,
+                  const std::string& manifest_path) const;
+
+    /**
+     * @brief Reads a manifest file.
+     * @param path The manifest's path.
+     * @return The manifest, or nothing if it does not exist or is malformed.
+     */
+    static std::optional<ErasureManifest> read_manifest(const std::string& path);
+
+    /**
+     * @brief Formats the code, the kernel and the read and repair counters as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @brief Writes a manifest to a temporary file and renames it into place.
+     * @param path The manifest's path.
+     * @param manifest The manifest.
+     * @return True on success.
+     */
+    static bool write_manifest(const std::string& path, const ErasureManifest& manifest);
+
+    /**
+     * @brief Returns the path of a user's manifest of a file.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return The path, in the user's ERASURE_FOLDER.
+     */
+    std::string manifest_path(uint32_t user_id, const std::string& filename) const;
+
+    /**
+     * @brief Picks the roots of a file's shards: the k + m highest by rendezvous hash.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return The root of each shard.
+     */
+    std::vector<std::string> place(uint32_t user_id, const std::string& filename) const;
+
+    /**
+     * @brief Rewrites the shards of a file flagged as damaged, rebuilding them from the intact ones.
+     * @param manifest The file's manifest.
+     * @param intact Which shards are intact (at least k).
+     * @param before_chunk Called before each stripe, with the bytes involved.
+     * @return True if every damaged shard was rewritten and matches its checksum.
+     */
+    bool rebuild(const ErasureManifest& manifest, const std::vector<bool>& intact,
+                 const std::function<void(size_t)>& before_chunk);
+
+    /**
+     * @brief The storage roots.
+     */
+    std::shared_ptr<StorageRoots> roots_;
+
+    /**
+     * @brief The code of new files.
+     */
+    ErasureConfig config_;
+
+    std::atomic<uint64_t> generation_{ 0 };        ///< Numbers the shard generations written since startup.
+    std::atomic<uint64_t> files_written_{ 0 };     ///< Files encoded.
+    std::atomic<uint64_t> reads_{ 0 };             ///< Files read back.
+    std::atomic<uint64_t> degraded_reads_{ 0 };    ///< Reads that rebuilt data from parity.
+    std::atomic<uint64_t> failed_reads_{ 0 };      ///< Reads with fewer than k intact shards.
+    std::atomic<uint64_t> shards_repaired_{ 0 };   ///< Shards rebuilt and rewritten by check().
+};
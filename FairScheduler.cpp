@@ -0,0 +1,231 @@
+/**
+ * @file FairScheduler.cpp
+ * @brief FairScheduler class implementation.
+ * @details This file contains the implementation of the weighted fair scheduling of file operations across users.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "FairScheduler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+using std::chrono::steady_clock;
+
+namespace
+{
+    constexpr size_t MAX_IDLE_TAGS = 4096; // finish tags kept before tags of idle users are dropped
+
+    /**
+     * @brief Returns the given percentile of a set of samples.
+     */
+    uint64_t percentile(std::vector<uint64_t> samples, const double fraction)
+    {
+        if (samples.empty())
+        {
+            return 0;
+        }
+        const auto nth = samples.begin() + static_cast<std::ptrdiff_t>(fraction * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), nth, samples.end());
+        return *nth;
+    }
+}
+
+FairScheduler::Ticket::Ticket(FairScheduler& scheduler, const uint32_t user_id, const SchedulingLane lane)
+    : scheduler_(scheduler), user_id_(user_id), lane_(lane)
+{
+}
+
+FairScheduler::Ticket::~Ticket()
+{
+    if (holding_)
+    {
+        scheduler_.release();
+    }
+}
+
+void FairScheduler::Ticket::charge(const size_t bytes)
+{
+    const auto wait = scheduler_.reserve_bandwidth(user_id_, bytes);
+
+    // Let others use the disk while this user sleeps off its cap or after it has had a quantum
+    if (holding_ && (wait > steady_clock::duration::zero() || used_ >= SCHEDULER_QUANTUM))
+    {
+        scheduler_.release();
+        holding_ = false;
+    }
+    if (wait > steady_clock::duration::zero())
+    {
+        std::this_thread::sleep_for(wait);
+    }
+
+    if (holding_)
+    {
+        scheduler_.account(user_id_, bytes);
+    }
+    else
+    {
+        scheduler_.acquire(user_id_, bytes, lane_);
+        holding_ = true;
+        used_ = 0;
+    }
+    used_ += bytes;
+}
+
+FairScheduler::FairScheduler(const uint64_t user_bytes_per_second, const std::map<uint32_t, double>& weights)
+    : weights_(weights), user_bytes_per_second_(user_bytes_per_second)
+{
+}
+
+void FairScheduler::throttle(const uint32_t user_id, const size_t bytes)
+{
+    if (const auto wait = reserve_bandwidth(user_id, bytes); wait > steady_clock::duration::zero())
+    {
+        std::this_thread::sleep_for(wait);
+    }
+}
+
+std::string FairScheduler::report() const
+{
+    std::lock_guard lock(mutex_);
+
+    std::ostringstream out;
+    out << "scheduler: " << busy_slots_ << "/" << SCHEDULER_DISK_SLOTS << " slots busy, " << queue_.size()
+        << " transfers and " << fast_lane_.size() << " metadata operations waiting\n"
+        << "  granted " << granted_ << " transfer slots, " << fast_granted_ << " fast lane slots";
+    if (user_bytes_per_second_ > 0)
+    {
+        out << ", cap " << user_bytes_per_second_ << " bytes/s per user";
+    }
+    out << "\n  queueing delay p50/p99: transfers "
+        << percentile(wait_samples_[static_cast<size_t>(SchedulingLane::NORMAL)], 0.5) << "/"
+        << percentile(wait_samples_[static_cast<size_t>(SchedulingLane::NORMAL)], 0.99) << " us, fast lane "
+        << percentile(wait_samples_[static_cast<size_t>(SchedulingLane::FAST)], 0.5) << "/"
+        << percentile(wait_samples_[static_cast<size_t>(SchedulingLane::FAST)], 0.99) << " us\n";
+    return out.str();
+}
+
+void FairScheduler::acquire(const uint32_t user_id, const uint64_t cost, const SchedulingLane lane)
+{
+    const auto arrived = steady_clock::now();
+    Waiter waiter;
+
+    std::unique_lock lock(mutex_);
+    if (lane == SchedulingLane::FAST)
+    {
+        fast_lane_.push_back(&waiter);
+    }
+    else
+    {
+        // Start where the user's previous work finished, but never before the present: idle users get no credit
+        double& finish = finish_tags_[user_id];
+        const double start = std::max(virtual_time_, finish);
+        finish = start + static_cast<double>(cost) / weight(user_id);
+        queue_.emplace(std::make_pair(start, arrivals_++), &waiter);
+    }
+
+    dispatch();
+    waiter.cv.wait(lock, [&waiter] { return waiter.granted; });
+    record_wait(lane, steady_clock::now() - arrived);
+}
+
+void FairScheduler::account(const uint32_t user_id, const uint64_t bytes)
+{
+    std::lock_guard lock(mutex_);
+    finish_tags_[user_id] += static_cast<double>(bytes) / weight(user_id);
+}
+
+void FairScheduler::release()
+{
+    std::lock_guard lock(mutex_);
+    --busy_slots_;
+    dispatch();
+}
+
+steady_clock::duration FairScheduler::reserve_bandwidth(const uint32_t user_id, const size_t bytes)
+{
+    if (user_bytes_per_second_ == 0)
+    {
+        return steady_clock::duration::zero();
+    }
+
+    TokenBucket* cap;
+    {
+        std::lock_guard lock(caps_mutex_);
+        auto& bucket = caps_[user_id];
+        if (!bucket)
+        {
+            // One second of burst, so short requests of a capped user are not delayed
+            bucket = std::make_unique<TokenBucket>(user_bytes_per_second_, user_bytes_per_second_);
+        }
+        cap = bucket.get();
+    }
+    return cap->reserve(bytes);
+}
+
+void FairScheduler::dispatch()
+{
+    while (true)
+    {
+        Waiter* next = nullptr;
+        if (!fast_lane_.empty() && busy_slots_ < SCHEDULER_DISK_SLOTS + SCHEDULER_FAST_LANE_SLOTS)
+        {
+            next = fast_lane_.front();
+            fast_lane_.pop_front();
+            ++fast_granted_;
+        }
+        else if (!queue_.empty() && busy_slots_ < SCHEDULER_DISK_SLOTS)
+        {
+            const auto first = queue_.begin();
+            virtual_time_ = first->first.first;
+            next = first->second;
+            queue_.erase(first);
+            ++granted_;
+        }
+        else
+        {
+            break;
+        }
+
+        ++busy_slots_;
+        next->granted = true;
+        next->cv.notify_one();
+    }
+
+    // Users whose work finished in the past start at the virtual time anyway, so their tags can go
+    if (finish_tags_.size() > MAX_IDLE_TAGS)
+    {
+        for (auto it = finish_tags_.begin(); it != finish_tags_.end();)
+        {
+            it = it->second <= virtual_time_ ? finish_tags_.erase(it) : std::next(it);
+        }
+    }
+}
+
+double FairScheduler::weight(const uint32_t user_id) const
+{
+    const auto it = weights_.find(user_id);
+    return it != weights_.end() ? it->second : 1.0;
+}
+
+void FairScheduler::record_wait(const SchedulingLane lane, const steady_clock::duration wait)
+{
+    const auto index = static_cast<size_t>(lane);
+    const auto micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(wait).count());
+
+    auto& samples = wait_samples_[index];
+    if (samples.size() < SCHEDULER_WAIT_SAMPLES)
+    {
+        samples.push_back(micros);
+    }
+    else
+    {
+        samples[next_sample_[index]] = micros;
+    }
+    next_sample_[index] = (next_sample_[index] + 1) % SCHEDULER_WAIT_SAMPLES;
+}
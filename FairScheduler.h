@@ -0,0 +1,238 @@
+/**
+ * @file FairScheduler.h
+ * @brief FairScheduler class definition.
+ * @details This header file contains the FairScheduler class, which shares the disk between users with weighted fair
+ *          queuing and caps each user's bandwidth, so that one user's large transfers cannot starve everybody else.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "TokenBucket.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr unsigned SCHEDULER_DISK_SLOTS = 4;                 // file operations running at once
+constexpr unsigned SCHEDULER_FAST_LANE_SLOTS = 2;            // extra slots only metadata operations may use
+constexpr size_t SCHEDULER_QUANTUM = 256 * 1024;             // bytes a transfer moves before it queues again
+constexpr uint64_t METADATA_OPERATION_COST = 4096;           // cost charged for a LIST_FILES or DELETE_FILE
+constexpr size_t SCHEDULER_WAIT_SAMPLES = 1024;              // recent waits kept per lane for the status report
+
+/**
+ * @enum SchedulingLane
+ * @brief The queue an operation waits in.
+ */
+enum class SchedulingLane {
+    FAST,     ///< Metadata operations (LIST_FILES, DELETE_FILE): served before any queued transfer.
+    NORMAL    ///< Data transfers (SAVE_FILE, RESTORE_FILES): served in weighted fair order.
+};
+
+/**
+ * @class FairScheduler
+ * @brief Weighted fair queuing of file operations across users, plus per-user bandwidth caps.
+ * @details At most SCHEDULER_DISK_SLOTS operations touch the disk at once. Waiting operations are served in
+ *          start-time fair queuing order: each user's work is tagged by the bytes it already moved divided by the
+ *          user's weight, so a user streaming a huge file gets its share but small requests of other users
+ *          overtake its queued chunks. Large transfers give their slot back every SCHEDULER_QUANTUM bytes.
+ *          Metadata operations use a fast lane that is served first and has SCHEDULER_FAST_LANE_SLOTS slots of its own.
+ */
+class FairScheduler {
+public:
+    /**
+     * @class Ticket
+     * @brief One operation's access to the disk; the slot it holds is released when the ticket is destroyed.
+     */
+    class Ticket {
+    public:
+        /**
+         * @brief Opens a ticket (no slot is taken until the first charge).
+         * @param scheduler The scheduler.
+         * @param user_id The user the operation works for.
+         * @param lane The lane the operation waits in.
+         */
+        Ticket(FairScheduler& scheduler, uint32_t user_id, SchedulingLane lane);
+
+        /**
+         * @brief Releases the slot held by the ticket, if any.
+         */
+        ~Ticket();
+
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+
+        /**
+         * @brief Waits until the next 'bytes' of the operation may be moved.
+         * @details Sleeps while the user is over its bandwidth cap (without holding a slot) and queues again
+         *          once the current slot has moved a quantum.
+         * @param bytes The number of bytes about to be read or written.
+         */
+        void charge(size_t bytes);
+
+    private:
+        FairScheduler& scheduler_;   ///< The scheduler.
+        uint32_t user_id_;           ///< The user the operation works for.
+        SchedulingLane lane_;        ///< The lane the operation waits in.
+        bool holding_ = false;       ///< Whether the ticket holds a slot.
+        size_t used_ = 0;            ///< Bytes moved since the slot was granted.
+    };
+
+    /**
+     * @brief Constructs a FairScheduler.
+     * @param user_bytes_per_second Bandwidth cap of each user (0 means unlimited).
+     * @param weights Per-user weights (users not listed have weight 1).
+     */
+    FairScheduler(uint64_t user_bytes_per_second, const std::map<uint32_t, double>& weights);
+
+    /**
+     * @brief Charges network bytes against a user's bandwidth cap, sleeping while the user is over it.
+     * @param user_id The user.
+     * @param bytes The number of bytes about to be sent or received.
+     */
+    void throttle(uint32_t user_id, size_t bytes);
+
+    /**
+     * @brief Formats the scheduler's load and recent queueing delays as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @struct Waiter
+     * @brief An operation waiting for a slot.
+     */
+    struct Waiter {
+        bool granted = false;           ///< Set when the operation may proceed.
+        std::condition_variable cv;     ///< Signaled when 'granted' is set.
+    };
+
+    /**
+     * @brief Blocks until a slot is granted.
+     * @param user_id The user.
+     * @param cost The bytes the operation will move first.
+     * @param lane The lane to wait in.
+     */
+    void acquire(uint32_t user_id, uint64_t cost, SchedulingLane lane);
+
+    /**
+     * @brief Adds bytes moved under an already granted slot to the user's tag.
+     * @param user_id The user.
+     * @param bytes The bytes moved.
+     */
+    void account(uint32_t user_id, uint64_t bytes);
+
+    /**
+     * @brief Releases a slot and hands it to the next waiter.
+     */
+    void release();
+
+    /**
+     * @brief Takes bandwidth from a user's cap.
+     * @param user_id The user.
+     * @param bytes The number of bytes.
+     * @return How long the user has to wait before moving them.
+     */
+    std::chrono::steady_clock::duration reserve_bandwidth(uint32_t user_id, size_t bytes);
+
+    /**
+     * @brief Grants free slots to waiters, fast lane first. Must be called with 'mutex_' held.
+     */
+    void dispatch();
+
+    /**
+     * @brief Returns a user's weight.
+     * @param user_id The user.
+     * @return The weight (1 if none was configured).
+     */
+    double weight(uint32_t user_id) const;
+
+    /**
+     * @brief Records how long an operation waited for its slot. Must be called with 'mutex_' held.
+     * @param lane The lane it waited in.
+     * @param wait The time it waited.
+     */
+    void record_wait(SchedulingLane lane, std::chrono::steady_clock::duration wait);
+
+    /**
+     * @brief Guards the queues, tags and statistics.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief Slots currently granted.
+     */
+    unsigned busy_slots_ = 0;
+
+    /**
+     * @brief The start tag of the most recently granted transfer (the scheduler's virtual time).
+     */
+    double virtual_time_ = 0;
+
+    /**
+     * @brief Metadata operations waiting for a slot, in arrival order.
+     */
+    std::deque<Waiter*> fast_lane_;
+
+    /**
+     * @brief Transfers waiting for a slot, by (start tag, arrival number).
+     */
+    std::map<std::pair<double, uint64_t>, Waiter*> queue_;
+
+    /**
+     * @brief Counts arrivals, breaking ties between equal start tags.
+     */
+    uint64_t arrivals_ = 0;
+
+    /**
+     * @brief The finish tag of each user's most recent work.
+     */
+    std::unordered_map<uint32_t, double> finish_tags_;
+
+    /**
+     * @brief Per-user weights.
+     */
+    std::map<uint32_t, double> weights_;
+
+    /**
+     * @brief Bandwidth cap of each user (0 means unlimited).
+     */
+    uint64_t user_bytes_per_second_;
+
+    /**
+     * @brief Guards 'caps_'.
+     */
+    std::mutex caps_mutex_;
+
+    /**
+     * @brief Each user's bandwidth cap, created on first use.
+     */
+    std::unordered_map<uint32_t, std::unique_ptr<TokenBucket>> caps_;
+
+    uint64_t granted_ = 0;          ///< Transfer slots granted since startup.
+    uint64_t fast_granted_ = 0;     ///< Fast lane slots granted since startup.
+
+    /**
+     * @brief The most recent queueing delays of each lane (in microseconds), as ring buffers.
+     */
+    std::array<std::vector<uint64_t>, 2> wait_samples_;
+
+    /**
+     * @brief The next position written in each lane's ring buffer.
+     */
+    std::array<size_t, 2> next_sample_{};
+};
@@ -0,0 +1,117 @@
+/**
+ * @file FileIndex.cpp
+ * @brief FileIndex class implementation.
+ * @details This file contains the implementation of the name-ordered file indexes serving paginated listings.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "FileIndex.h"
+
+#include <algorithm>
+#include <sstream>
+
+bool FileIndex::loaded(const uint32_t user_id) const
+{
+    std::lock_guard lock(mutex_);
+    return users_.count(user_id) > 0;
+}
+
+std::vector<uint32_t> FileIndex::users() const
+{
+    std::lock_guard lock(mutex_);
+    std::vector<uint32_t> user_ids;
+    user_ids.reserve(users_.size());
+    for (const auto& [user_id, index] : users_)
+    {
+        user_ids.push_back(user_id);
+    }
+    return user_ids;
+}
+
+void FileIndex::load(const uint32_t user_id, const std::function<std::map<std::string, FileStat>()>& scan)
+{
+    // Scan without the lock: other users' saves and listings go on meanwhile
+    auto files = scan();
+    ++builds_;
+
+    std::lock_guard lock(mutex_);
+    if (users_.size() >= MAX_INDEXED_USERS && users_.count(user_id) == 0)
+    {
+        const auto oldest = std::min_element(users_.begin(), users_.end(),
+            [](const auto& a, const auto& b) { return a.second.last_used < b.second.last_used; });
+        users_.erase(oldest);
+    }
+    UserIndex& index = users_[user_id];
+    index.files = std::move(files);
+    index.last_used = ++clock_;
+}
+
+void FileIndex::put(const uint32_t user_id, const std::string& filename, const FileStat& stat)
+{
+    std::lock_guard lock(mutex_);
+    if (const auto it = users_.find(user_id); it != users_.end())
+    {
+        it->second.files[filename] = stat;
+    }
+}
+
+void FileIndex::erase(const uint32_t user_id, const std::string& filename)
+{
+    std::lock_guard lock(mutex_);
+    if (const auto it = users_.find(user_id); it != users_.end())
+    {
+        it->second.files.erase(filename);
+    }
+}
+
+FilePage FileIndex::page(const uint32_t user_id, const std::string& prefix, const std::string& cursor, const size_t limit)
+{
+    FilePage page;
+    ++pages_;
+
+    std::lock_guard lock(mutex_);
+    const auto user = users_.find(user_id);
+    if (user == users_.end())
+    {
+        return page;
+    }
+    user->second.last_used = ++clock_;
+
+    // Resume after the cursor, or start at the first name carrying the prefix
+    const auto& files = user->second.files;
+    auto it = !cursor.empty() && cursor >= prefix ? files.upper_bound(cursor) : files.lower_bound(prefix);
+    const auto has_prefix = [&prefix](const std::string& name) { return name.compare(0, prefix.size(), prefix) == 0; };
+
+    page.files.reserve(std::min(limit, files.size()));
+    for (; it != files.end() && page.files.size() < limit && has_prefix(it->first); ++it)
+    {
+        page.files.push_back({ it->first, it->second });
+    }
+    if (it != files.end() && has_prefix(it->first) && !page.files.empty())
+    {
+        page.next_cursor = page.files.back().filename;
+    }
+    return page;
+}
+
+std::string FileIndex::report() const
+{
+    size_t users;
+    size_t files = 0;
+    {
+        std::lock_guard lock(mutex_);
+        users = users_.size();
+        for (const auto& [user_id, index] : users_)
+        {
+            files += index.files.size();
+        }
+    }
+    std::ostringstream out;
+    out << "listing index: " << users << " users (" << files << " files) in memory, " << builds_.load()
+        << " built, " << pages_.load() << " pages served\n";
+    return out.str();
+}
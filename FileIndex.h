@@ -0,0 +1,145 @@
+/**
+ * @file FileIndex.h
+ * @brief FileIndex class definition.
+ * @details This header file contains the FileIndex class, which keeps the files of recently listed users sorted by
+ *          name in memory, so a listing can be served one page at a time without scanning the user's folder again.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+constexpr size_t MAX_INDEXED_USERS = 256;       // users whose index is kept; the least recently listed go first
+constexpr uint32_t DEFAULT_LIST_PAGE_SIZE = 1000; // entries per page when the client does not say
+constexpr uint32_t MAX_LIST_PAGE_SIZE = 10000;  // larger pages are cut to this size
+
+/**
+ * @struct FileStat
+ * @brief What a listing tells about a file.
+ */
+struct FileStat {
+    uint64_t size = 0;      ///< The file's size.
+    uint64_t modified = 0;  ///< When the file was last written, in seconds since the epoch.
+};
+
+/**
+ * @struct IndexedFile
+ * @brief One entry of a listing page.
+ */
+struct IndexedFile {
+    std::string filename;   ///< The filename.
+    FileStat stat;          ///< The file's size and modification time.
+};
+
+/**
+ * @struct FilePage
+ * @brief One page of a user's files, in name order.
+ */
+struct FilePage {
+    std::vector<IndexedFile> files; ///< The files of the page.
+    std::string next_cursor;        ///< The cursor of the next page, or empty if this is the last one.
+};
+
+/**
+ * @class FileIndex
+ * @brief Per-user, name-ordered indexes of the stored files, kept up to date by saves and deletes.
+ * @details A user's index is built by one scan of their folder the first time the user is listed, then updated
+ *          under one mutex by every save, replacement and delete, so a page is a range of an ordered map: fetching
+ *          page N costs the same as fetching the first page. The cursor is the last name of the previous page, so
+ *          files saved or deleted between two pages neither shift nor repeat the entries that follow. Indexes live
+ *          in memory only; at most MAX_INDEXED_USERS are kept, and a dropped one is rebuilt by the next listing.
+ */
+class FileIndex {
+public:
+    /**
+     * @brief Tells whether a user's index is in memory.
+     * @param user_id The user ID.
+     * @return True if the index is loaded.
+     */
+    bool loaded(uint32_t user_id) const;
+
+    /**
+     * @brief Lists the users whose index is in memory.
+     * @return The user IDs.
+     */
+    std::vector<uint32_t> users() const;
+
+    /**
+     * @brief Builds a user's index (dropping the least recently listed user's if too many are kept).
+     * @details The caller must keep the user's files from changing meanwhile.
+     * @param user_id The user ID.
+     * @param scan Returns the user's files with their sizes and modification times.
+     */
+    void load(uint32_t user_id, const std::function<std::map<std::string, FileStat>()>& scan);
+
+    /**
+     * @brief Records a saved or replaced file (ignored if the user's index is not loaded).
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param stat The file's size and modification time.
+     */
+    void put(uint32_t user_id, const std::string& filename, const FileStat& stat);
+
+    /**
+     * @brief Records a deleted file (ignored if the user's index is not loaded).
+     * @param user_id The user ID.
+     * @param filename The filename.
+     */
+    void erase(uint32_t user_id, const std::string& filename);
+
+    /**
+     * @brief Returns a page of a user's files whose names start with a prefix.
+     * @param user_id The user ID (whose index must be loaded).
+     * @param prefix Only names starting with this are listed (empty: all).
+     * @param cursor The next_cursor of the previous page, or empty for the first page.
+     * @param limit The most files the page holds (at least 1).
+     * @return The page.
+     */
+    FilePage page(uint32_t user_id, const std::string& prefix, const std::string& cursor, size_t limit);
+
+    /**
+     * @brief Formats the number of indexed users and files as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @struct UserIndex
+     * @brief The index of one user.
+     */
+    struct UserIndex {
+        std::map<std::string, FileStat> files;  ///< The user's files, by name.
+        uint64_t last_used = 0;                 ///< When the index was last listed, on the 'clock_' scale.
+    };
+
+    /**
+     * @brief Guards the members below.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief The loaded indexes, by user.
+     */
+    std::unordered_map<uint32_t, UserIndex> users_;
+
+    /**
+     * @brief Counts listings, to find the least recently listed user.
+     */
+    uint64_t clock_ = 0;
+
+    std::atomic<uint64_t> builds_{ 0 };     ///< Indexes built by scanning a folder.
+    std::atomic<uint64_t> pages_{ 0 };      ///< Pages served.
+};
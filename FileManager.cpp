@@ -10,84 +10,682 @@
  */
 
 #include "FileManager.h"
+#include "Checksum.h"
+#include "utility.h"
 
 #include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <sstream>
 #include <system_error>
 #include <random>
 #include <regex>
 
-FileManager::FileManager(const std::string& root_folder)
-    : root_folder_(root_folder){}
+using std::chrono::steady_clock;
+
+namespace
+{
+    /**
+     * @brief Hard-links a file, falling back to a copy where links are not possible (e.g. too many links).
+     * @return False if the source does not exist.
+     */
+    bool link_or_copy(const std::string& from, const std::string& to)
+    {
+        std::error_code ec;
+        std::filesystem::create_hard_link(from, to, ec);
+        if (ec == std::errc::no_such_file_or_directory)
+        {
+            return false;
+        }
+        if (ec)
+        {
+            return std::filesystem::copy_file(from, to);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Returns the change in bytes from replacing a file of size 'previous' (if any) with one of size 'size'.
+     */
+    int64_t size_change(const std::optional<uint64_t>& previous, const uint64_t size)
+    {
+        return static_cast<int64_t>(size) - static_cast<int64_t>(previous.value_or(0));
+    }
+
+    /**
+     * @brief Converts a time on the system clock to seconds since the epoch.
+     */
+    uint64_t epoch_seconds(const std::chrono::system_clock::time_point time)
+    {
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+        return seconds > 0 ? static_cast<uint64_t>(seconds) : 0;
+    }
+
+    /**
+     * @brief Converts a file time to seconds since the epoch (C++17 has no conversion between the two clocks).
+     */
+    uint64_t epoch_seconds(const std::filesystem::file_time_type time)
+    {
+        const auto offset = time - std::filesystem::file_time_type::clock::now();
+        return epoch_seconds(std::chrono::system_clock::now() +
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(offset));
+    }
+
+    /**
+     * @brief Writes a file to a temporary path and renames it into place, so readers and links never see it change.
+     */
+    bool write_and_rename(const std::string& tmp_path, const std::string& path, const std::vector<unsigned char>& data)
+    {
+        {
+            std::ofstream ofs(tmp_path, std::ios::binary);
+            if (!ofs.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())) ||
+                !ofs.flush())
+            {
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, path, ec);
+        return !ec;
+    }
+}
+
+FileManager::FileManager(const std::vector<std::string>& root_folders, const uint32_t small_file_threshold,
+                         const IoPolicyConfig& io_config, const QuotaConfig& quota, const ErasureConfig& erasure)
+    : roots_(std::make_shared<StorageRoots>(root_folders)),
+    small_file_threshold_(small_file_threshold),
+    segments_(std::make_unique<SegmentStore>(roots_)),
+    io_policy_(io_config),
+    usage_(std::make_unique<UsageTracker>(quota, [this](const uint32_t user_id) { return user_folder_path(user_id); })),
+    index_(std::make_unique<FileIndex>()),
+    erasure_(std::make_unique<ErasureStore>(roots_, erasure)){}
 
 void FileManager::create_root_directory() const
 {
-	std::filesystem::create_directories(root_folder_);
+	roots_->create_directories();
 }
 
 void FileManager::create_user_directory(const uint32_t user_id) const
 {
     const std::string user_path = user_folder_path(user_id);
-    std::filesystem::create_directories(user_path);
+    std::filesystem::create_directories(user_path + META_FOLDER);
+    std::filesystem::create_directories(user_path + TEMP_FOLDER);
+    std::filesystem::create_directories(user_path + UPLOADS_FOLDER);
+
+    // Bring the user's counters into memory once, while none of the user's files can change
+    if (!usage_->loaded(user_id))
+    {
+        const auto lock = locks_.lock_user(user_id, LockMode::EXCLUSIVE);
+        usage_->load(user_id, [this, user_id] { return count_usage(user_id); });
+        forget_old_deletes(user_id);
+    }
 }
 
 bool FileManager::save_file(const uint32_t user_id, const std::string& filename,
-    const std::vector<unsigned char>& data) const
+    const std::vector<unsigned char>& data, const uint32_t checksum,
+    const std::function<void(size_t)>& before_chunk, const bool if_absent) const
 {
     const std::string file_path = user_folder_path(user_id) + filename;
-    std::ofstream ofs(file_path, std::ios::binary);
-    if (!ofs.is_open())
+    std::error_code ec;
+
+    // Do not write what cannot be kept
+    if (!fits_quota(user_id, filename, data.size()))
+    {
+        throw QuotaExceededError("Quota exceeded saving " + filename);
+    }
+    if (if_absent)
+    {
+        const auto file_lock = locks_.lock_file(user_id, filename, LockMode::SHARED);
+        if (!absent(user_id, filename))
+        {
+            throw FileExistsError(filename + " exists or was deleted");
+        }
+    }
+
+    if (data.size() < small_file_threshold_)
+    {
+        if (before_chunk)
+        {
+            before_chunk(data.size());
+        }
+        const auto user_lock = locks_.lock_user(user_id, LockMode::SHARED);
+        const auto file_lock = locks_.lock_file(user_id, filename, LockMode::EXCLUSIVE);
+        if (if_absent && !absent(user_id, filename))
+        {
+            throw FileExistsError(filename + " exists or was deleted");
+        }
+        const auto previous = stored_size(user_id, filename);
+        const int64_t bytes = size_change(previous, data.size());
+        const int64_t files = previous ? 0 : 1;
+        if (!usage_->reserve(user_id, bytes, files))
+        {
+            throw QuotaExceededError("Quota exceeded saving " + filename);
+        }
+        const auto started = steady_clock::now();
+        if (!segments_->put(user_id, filename, data, checksum))
+        {
+            usage_->adjust(user_id, -bytes, -files);
+            return false;
+        }
+        roots_->record_io(user_id, data.size(), steady_clock::now() - started);
+        index_->put(user_id, filename, { data.size(), epoch_seconds(std::chrono::system_clock::now()) });
+
+        // Drop the standalone or erasure-coded copy of an earlier, larger version
+        std::filesystem::remove(file_path, ec);
+        std::filesystem::remove(meta_file_path(user_id, filename), ec);
+        erasure_->remove(user_id, filename);
+        return true;
+    }
+
+    if (erasure_->enabled())
+    {
+        size_t offset = 0;
+        return save_erasure(user_id, filename, data.size(), checksum,
+            [&data, &offset](unsigned char* buffer, const size_t size)
+            {
+                std::copy_n(data.data() + offset, size, buffer);
+                offset += size;
+                return true;
+            }, before_chunk, if_absent);
+    }
+
+    // Write a new file and rename it over the old one: a snapshot may hold a hard link to the old one.
+    // The file is created exclusively, so a name drawn twice never writes over another save's data
+    std::string tmp_path;
+    std::optional<OutputFile> out;
+    for (unsigned attempt = 0; attempt < TEMP_FILE_ATTEMPTS && !(out && out->is_open()); ++attempt)
+    {
+        tmp_path = user_folder_path(user_id) + TEMP_FOLDER + generate_random_filename();
+        out.emplace(io_policy_, tmp_path, data.size(), true);
+    }
+    if (!out->is_open())
+    {
+        return false;
+    }
+
+    // Only the time spent writing counts towards the root's latency, not the time waiting for a turn
+    steady_clock::duration io_time{};
+    for (size_t written = 0; written < data.size();)
+    {
+        const size_t to_write = std::min(IO_CHUNK_SIZE, data.size() - written);
+        if (before_chunk)
+        {
+            before_chunk(to_write);
+        }
+        const auto started = steady_clock::now();
+        if (!out->write(data.data() + written, to_write))
+        {
+            out->close();
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+        io_time += steady_clock::now() - started;
+        written += to_write;
+    }
+    const auto started = steady_clock::now();
+    if (!out->close())
+    {
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    roots_->record_io(user_id, data.size(), io_time + (steady_clock::now() - started));
+
+    return publish_file(user_id, filename, tmp_path, checksum, if_absent);
+}
+
+bool FileManager::publish_file(const uint32_t user_id, const std::string& filename, const std::string& path,
+                               const uint32_t checksum, const bool if_absent) const
+{
+    if (erasure_->enabled())
+    {
+        std::error_code ec;
+        const uint64_t size = std::filesystem::file_size(path, ec);
+        std::ifstream in(path, std::ios::binary);
+        bool saved = false;
+        try
+        {
+            saved = !ec && in.is_open() && save_erasure(user_id, filename, size, checksum,
+                [&in](unsigned char* buffer, const size_t length)
+                {
+                    return static_cast<bool>(in.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(length)));
+                }, nullptr, if_absent);
+        }
+        catch (...)
+        {
+            in.close();
+            std::filesystem::remove(path, ec);
+            throw;
+        }
+        in.close();
+        std::filesystem::remove(path, ec);
+        return saved;
+    }
+
+    std::vector<unsigned char> meta;
+    write_uint32_le(meta, checksum);
+    const std::string meta_tmp_path = user_folder_path(user_id) + TEMP_FOLDER + generate_random_filename() + ".crc";
+    std::error_code ec;
+
+    // The file and its checksum change together, so readers and snapshots see either both old or both new
+    const auto user_lock = locks_.lock_user(user_id, LockMode::SHARED);
+    const auto file_lock = locks_.lock_file(user_id, filename, LockMode::EXCLUSIVE);
+
+    if (if_absent && !absent(user_id, filename))
+    {
+        std::filesystem::remove(path, ec);
+        throw FileExistsError(filename + " exists or was deleted");
+    }
+
+    // The quota is checked and charged atomically with the replacement, so concurrent saves cannot overshoot it
+    const auto previous = stored_size(user_id, filename);
+    const uint64_t length = std::filesystem::file_size(path, ec);
+    const uint64_t size = ec ? 0 : length;
+    const int64_t bytes = size_change(previous, size);
+    const int64_t files = previous ? 0 : 1;
+    if (!usage_->reserve(user_id, bytes, files))
+    {
+        std::filesystem::remove(path, ec);
+        throw QuotaExceededError("Quota exceeded saving " + filename);
+    }
+
+    // The checksum goes first; if the data cannot follow, the earlier checksum is put back
+    const std::string meta_path = meta_file_path(user_id, filename);
+    const auto previous_checksum = read_meta(meta_path);
+    if (!write_and_rename(meta_tmp_path, meta_path, meta))
+    {
+        std::filesystem::remove(path, ec);
+        std::filesystem::remove(meta_tmp_path, ec);
+        usage_->adjust(user_id, -bytes, -files);
+        return false;
+    }
+    std::filesystem::rename(path, user_folder_path(user_id) + filename, ec);
+    if (ec)
+    {
+        std::filesystem::remove(path, ec);
+        std::vector<unsigned char> previous_meta;
+        if (previous_checksum)
+        {
+            write_uint32_le(previous_meta, *previous_checksum);
+        }
+        if (!previous_checksum || !write_and_rename(meta_tmp_path, meta_path, previous_meta))
+        {
+            // Without a checksum the earlier version reads as unverifiable rather than corrupt
+            std::filesystem::remove(meta_tmp_path, ec);
+            std::filesystem::remove(meta_path, ec);
+        }
+        usage_->adjust(user_id, -bytes, -files);
+        return false;
+    }
+
+    index_->put(user_id, filename, { size, epoch_seconds(std::chrono::system_clock::now()) });
+
+    // Drop the segment or erasure-coded copy of an earlier version
+    segments_->remove(user_id, filename);
+    erasure_->remove(user_id, filename);
+    return true;
+}
+
+bool FileManager::save_erasure(const uint32_t user_id, const std::string& filename, const uint64_t size,
+                               const uint32_t checksum, const ErasureStore::ReadFn& read,
+                               const std::function<void(size_t)>& before_chunk, const bool if_absent) const
+{
+    // Encode and write the shards without any lock; only the manifest's rename replaces the file
+    const auto manifest = erasure_->write(user_id, filename, size, checksum, read, before_chunk);
+    if (!manifest)
+    {
+        return false;
+    }
+
+    const auto user_lock = locks_.lock_user(user_id, LockMode::SHARED);
+    const auto file_lock = locks_.lock_file(user_id, filename, LockMode::EXCLUSIVE);
+    if (if_absent && !absent(user_id, filename))
+    {
+        ErasureStore::discard(*manifest);
+        throw FileExistsError(filename + " exists or was deleted");
+    }
+    const auto previous = stored_size(user_id, filename);
+    const int64_t bytes = size_change(previous, size);
+    const int64_t files = previous ? 0 : 1;
+    if (!usage_->reserve(user_id, bytes, files))
     {
+        ErasureStore::discard(*manifest);
+        throw QuotaExceededError("Quota exceeded saving " + filename);
+    }
+    if (!erasure_->commit(user_id, filename, *manifest))
+    {
+        ErasureStore::discard(*manifest);
+        usage_->adjust(user_id, -bytes, -files);
         return false;
     }
-    ofs.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    index_->put(user_id, filename, { size, manifest->written });
+
+    // Drop the copy of an earlier version stored another way
+    segments_->remove(user_id, filename);
+    std::error_code ec;
+    std::filesystem::remove(user_folder_path(user_id) + filename, ec);
+    std::filesystem::remove(meta_file_path(user_id, filename), ec);
     return true;
 }
 
+std::string FileManager::upload_file_path(const uint32_t user_id, const std::string& upload_id) const
+{
+    return user_folder_path(user_id) + UPLOADS_FOLDER + upload_id;
+}
+
+const IoPolicy& FileManager::io_policy() const
+{
+    return io_policy_;
+}
+
 bool FileManager::read_file(const uint32_t user_id, const std::string& filename,
-                            std::vector<unsigned char>& out_data) const
+                            std::vector<unsigned char>& out_data, uint32_t* out_checksum,
+                            const std::function<void(size_t)>& before_chunk) const
 {
-    const std::string file_path = user_folder_path(user_id) + filename;
-    std::ifstream ifs(file_path, std::ios::binary | std::ios::ate);
-    if (!ifs.is_open())
+    // Wait for the disk before taking the lock, so a queued restore does not hold up saves of the file
+    if (const auto entry = segments_->find(user_id, filename); entry && before_chunk)
+    {
+        before_chunk(entry->length);
+    }
+    else if (const auto manifest = before_chunk ? erasure_->find(user_id, filename) : std::nullopt)
+    {
+        before_chunk(manifest->size);
+    }
+
+    auto lock = locks_.lock_file(user_id, filename, LockMode::SHARED);
+    if (uint32_t stored = 0; segments_->get(user_id, filename, out_data, &stored))
+    {
+        lock.release();
+        if (out_checksum != nullptr)
+        {
+            *out_checksum = Crc32c::compute(out_data.data(), out_data.size());
+            if (*out_checksum != stored)
+            {
+                throw ChecksumMismatchError("Stored data does not match its checksum: " + filename);
+            }
+        }
+        return true;
+    }
+
+    // The lock is held throughout: replacing the file removes the shards being read
+    if (const auto manifest = erasure_->find(user_id, filename))
+    {
+        read_erasure(*manifest, filename, out_data, out_checksum);
+        return true;
+    }
+
+    return read_standalone(user_id, user_folder_path(user_id) + filename, meta_file_path(user_id, filename),
+                           std::move(lock), out_data, out_checksum, before_chunk);
+}
+
+void FileManager::read_erasure(const ErasureManifest& manifest, const std::string& filename,
+                               std::vector<unsigned char>& out_data, uint32_t* out_checksum) const
+{
+    // Every shard is checked against its own checksum while it is read, which covers the whole file
+    if (!erasure_->read(manifest, out_data))
+    {
+        throw ChecksumMismatchError("Too few intact shards to rebuild " + filename);
+    }
+    if (out_checksum != nullptr)
+    {
+        *out_checksum = manifest.checksum;
+    }
+}
+
+bool FileManager::read_standalone(const uint32_t user_id, const std::string& file_path, const std::string& meta_path,
+                                  LockTable::Guard lock, std::vector<unsigned char>& out_data, uint32_t* out_checksum,
+                                  const std::function<void(size_t)>& before_chunk) const
+{
+    InputFile in(io_policy_, file_path);
+    if (!in.is_open())
     {
         return false;
     }
 
-    const auto file_size = ifs.tellg();
-    ifs.seekg(0, std::ios::beg);
+    // Once open, the file stays the same even if a save renames a new version over it
+    const auto stored = out_checksum != nullptr ? read_meta(meta_path) : std::nullopt;
+    lock.release();
+
+    const auto file_size = static_cast<size_t>(in.size());
 
+    // Checksum each chunk right after reading it, so verification costs no extra pass over the data
     out_data.resize(file_size);
-    ifs.read(reinterpret_cast<char*>(out_data.data()), file_size);
+    Crc32c crc;
+    size_t total_read = 0;
+    steady_clock::duration io_time{};
+    while (total_read < file_size)
+    {
+        const size_t to_read = std::min(IO_CHUNK_SIZE, file_size - total_read);
+        if (before_chunk)
+        {
+            before_chunk(to_read);
+        }
+        const auto started = steady_clock::now();
+        if (!in.read(out_data.data() + total_read, to_read))
+        {
+            throw std::filesystem::filesystem_error("Error while reading the file",
+                std::make_error_code(std::errc::io_error));
+        }
+        io_time += steady_clock::now() - started;
+        if (out_checksum != nullptr)
+        {
+            crc.update(out_data.data() + total_read, to_read);
+        }
+        total_read += to_read;
+    }
+    roots_->record_io(user_id, file_size, io_time);
+    if (out_checksum == nullptr)
+    {
+        return true;
+    }
+    *out_checksum = crc.value();
+
+    if (stored && *stored != *out_checksum)
+    {
+        throw ChecksumMismatchError("Stored data does not match its checksum: " + file_path);
+    }
     return true;
 }
 
-bool FileManager::delete_file(const uint32_t user_id, const std::string& filename) const
+std::optional<uint32_t> FileManager::read_checksum(const uint32_t user_id, const std::string& filename) const
 {
+    const auto lock = locks_.lock_file(user_id, filename, LockMode::SHARED);
+    if (const auto entry = segments_->find(user_id, filename))
+    {
+        return entry->checksum;
+    }
+    if (const auto manifest = erasure_->find(user_id, filename))
+    {
+        return manifest->checksum;
+    }
+
+    return read_meta(meta_file_path(user_id, filename));
+}
+
+std::optional<FileDigest> FileManager::read_digest(const uint32_t user_id, const std::string& filename) const
+{
+    const auto lock = locks_.lock_file(user_id, filename, LockMode::SHARED);
+    if (const auto entry = segments_->find(user_id, filename))
+    {
+        return FileDigest{ entry->length, entry->checksum };
+    }
+    if (const auto manifest = erasure_->find(user_id, filename))
+    {
+        return FileDigest{ manifest->size, manifest->checksum };
+    }
+
+    // The size comes from the directory entry and the checksum from the one recorded at save time
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(user_folder_path(user_id) + filename, ec);
+    const auto checksum = ec ? std::nullopt : read_meta(meta_file_path(user_id, filename));
+    if (!checksum)
+    {
+        return std::nullopt;
+    }
+    return FileDigest{ size, *checksum };
+}
+
+bool FileManager::fits_quota(const uint32_t user_id, const std::string& filename, const uint64_t size) const
+{
+    std::optional<uint64_t> previous;
+    {
+        const auto lock = locks_.lock_file(user_id, filename, LockMode::SHARED);
+        previous = stored_size(user_id, filename);
+    }
+    return usage_->fits(user_id, size_change(previous, size), previous ? 0 : 1);
+}
+
+UserUsage FileManager::usage(const uint32_t user_id) const
+{
+    return usage_->usage(user_id);
+}
+
+QuotaLimits FileManager::quota(const uint32_t user_id) const
+{
+    return usage_->limits(user_id);
+}
+
+std::string FileManager::usage_report() const
+{
+    return usage_->report();
+}
+
+std::optional<uint64_t> FileManager::stored_size(const uint32_t user_id, const std::string& filename) const
+{
+    if (const auto entry = segments_->find(user_id, filename))
+    {
+        return entry->length;
+    }
+    if (const auto manifest = erasure_->find(user_id, filename))
+    {
+        return manifest->size;
+    }
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(user_folder_path(user_id) + filename, ec);
+    return ec ? std::nullopt : std::optional<uint64_t>(size);
+}
+
+bool FileManager::absent(const uint32_t user_id, const std::string& filename) const
+{
+    if (stored_size(user_id, filename))
+    {
+        return false;
+    }
+    std::error_code ec;
+    const auto deleted = std::filesystem::last_write_time(user_folder_path(user_id) + DELETED_FOLDER + filename, ec);
+    return ec || std::filesystem::file_time_type::clock::now() - deleted >= DELETE_MEMORY;
+}
+
+void FileManager::forget_old_deletes(const uint32_t user_id) const
+{
+    std::error_code ec;
+    const auto now = std::filesystem::file_time_type::clock::now();
+    for (const auto& p : std::filesystem::directory_iterator(user_folder_path(user_id) + DELETED_FOLDER, ec))
+    {
+        std::error_code entry_ec;
+        if (const auto deleted = p.last_write_time(entry_ec); !entry_ec && now - deleted >= DELETE_MEMORY)
+        {
+            std::filesystem::remove(p.path(), entry_ec);
+        }
+    }
+}
+
+UserUsage FileManager::count_usage(const uint32_t user_id) const
+{
+    UserUsage usage;
+    for (const auto& filename : segments_->list(user_id))
+    {
+        if (const auto entry = segments_->find(user_id, filename))
+        {
+            usage.bytes += entry->length;
+            ++usage.files;
+        }
+    }
+    for (const auto& filename : erasure_->list(user_id))
+    {
+        if (const auto manifest = erasure_->find(user_id, filename))
+        {
+            usage.bytes += manifest->size;
+            ++usage.files;
+        }
+    }
+
+    // Standalone files, without the folders and the file list left by LIST_FILES
+    std::error_code ec;
+    for (const auto& p : std::filesystem::directory_iterator(user_folder_path(user_id), ec))
+    {
+        std::error_code entry_ec;
+        if (p.is_regular_file(entry_ec) && !regex_match(p.path().filename().string(), RANDOM_FILENAME_PATTERN))
+        {
+            usage.bytes += p.file_size(entry_ec);
+            ++usage.files;
+        }
+    }
+    return usage;
+}
+
+std::optional<uint32_t> FileManager::read_meta(const std::string& meta_path)
+{
+    std::ifstream ifs(meta_path, std::ios::binary);
+    unsigned char meta[4];
+    if (!ifs.is_open() || !ifs.read(reinterpret_cast<char*>(meta), sizeof(meta)))
+    {
+        return std::nullopt;
+    }
+    return read_uint_32_le(meta);
+}
+
+bool FileManager::delete_file(const uint32_t user_id, const std::string& filename, const bool remember) const
+{
+    const auto user_lock = locks_.lock_user(user_id, LockMode::SHARED);
+    const auto file_lock = locks_.lock_file(user_id, filename, LockMode::EXCLUSIVE);
+    const auto previous = stored_size(user_id, filename);
+    const bool removed_from_segment = segments_->remove(user_id, filename);
+    const bool removed_from_erasure = erasure_->remove(user_id, filename);
+
     const std::string file_path = user_folder_path(user_id) + filename;
     std::error_code ec;
     const bool removed = std::filesystem::remove(file_path, ec);
+    if (removed || removed_from_segment || removed_from_erasure)
+    {
+        usage_->adjust(user_id, -static_cast<int64_t>(previous.value_or(0)), -1);
+        index_->erase(user_id, filename);
+    }
 
 	if (ec)
 	{
 		throw std::filesystem::filesystem_error("Error while deleting the file", ec);
 	}
 
-	return removed;
+	// The stored checksum is meaningless without the file
+	std::filesystem::remove(meta_file_path(user_id, filename), ec);
+
+    // Recorded under the file's lock, so a conditional save sees either the file or its delete
+    if (remember)
+    {
+        const std::string deleted_path = user_folder_path(user_id) + DELETED_FOLDER;
+        std::filesystem::create_directories(deleted_path, ec);
+        std::ofstream(deleted_path + filename, std::ios::binary | std::ios::trunc);
+    }
+
+	return removed || removed_from_segment || removed_from_erasure;
 }
 
 std::vector<std::string> FileManager::list_user_files(const uint32_t user_id) const
 {
-	std::vector<std::string> files;
-    boost::system::error_code ec;
+    const auto lock = locks_.lock_user(user_id, LockMode::EXCLUSIVE);
+	std::vector<std::string> files = segments_->list(user_id);
+    const auto erasure_coded = erasure_->list(user_id);
+    files.insert(files.end(), erasure_coded.begin(), erasure_coded.end());
+    std::error_code ec;
 
     const std::string user_path = user_folder_path(user_id);
 
 
     for (auto& p : std::filesystem::directory_iterator(user_path, ec))
     {
-        if (is_regular_file(p.path(), ec))
+        if (std::filesystem::is_regular_file(p.path(), ec))
         {
 			const std::string filename = p.path().filename().string();
 
@@ -109,6 +707,285 @@ std::vector<std::string> FileManager::list_user_files(const uint32_t user_id) co
     return files;
 }
 
+FilePage FileManager::list_files_page(const uint32_t user_id, const std::string& prefix, const std::string& cursor,
+                                      const uint32_t limit) const
+{
+    load_index(user_id);
+    return index_->page(user_id, prefix, cursor, limit == 0 ? DEFAULT_LIST_PAGE_SIZE : std::min(limit, MAX_LIST_PAGE_SIZE));
+}
+
+std::string FileManager::index_report() const
+{
+    return index_->report();
+}
+
+std::vector<std::pair<uint32_t, bool>> FileManager::cached_users() const
+{
+    std::map<uint32_t, bool> users;
+    for (const uint32_t user_id : usage_->users())
+    {
+        users[user_id] = false;
+    }
+    for (const uint32_t user_id : index_->users())
+    {
+        users[user_id] = true;
+    }
+    return { users.begin(), users.end() };
+}
+
+void FileManager::warm_up(const uint32_t user_id, const bool with_index) const
+{
+    create_user_directory(user_id);
+    segments_->list(user_id);
+    if (with_index)
+    {
+        load_index(user_id);
+    }
+}
+
+void FileManager::flush_usage() const
+{
+    usage_->flush();
+}
+
+void FileManager::stop_maintenance() const
+{
+    segments_->stop_compaction();
+}
+
+void FileManager::resume_maintenance() const
+{
+    segments_->resume_compaction();
+}
+
+void FileManager::load_index(const uint32_t user_id) const
+{
+    // Build the index once, while none of the user's files can change
+    if (!index_->loaded(user_id))
+    {
+        const auto lock = locks_.lock_user(user_id, LockMode::EXCLUSIVE);
+        if (!index_->loaded(user_id))
+        {
+            index_->load(user_id, [this, user_id] { return scan_files(user_id); });
+        }
+    }
+}
+
+std::map<std::string, FileStat> FileManager::scan_files(const uint32_t user_id) const
+{
+    std::map<std::string, FileStat> files;
+    std::map<uint32_t, uint64_t> segment_times;
+    for (const auto& filename : segments_->list(user_id))
+    {
+        if (const auto entry = segments_->find(user_id, filename))
+        {
+            auto [time, inserted] = segment_times.emplace(entry->segment_id, 0);
+            if (inserted)
+            {
+                const auto written = segments_->segment_write_time(user_id, entry->segment_id);
+                time->second = written ? epoch_seconds(*written) : 0;
+            }
+            files[filename] = { entry->length, time->second };
+        }
+    }
+    for (const auto& filename : erasure_->list(user_id))
+    {
+        if (const auto manifest = erasure_->find(user_id, filename))
+        {
+            files[filename] = { manifest->size, manifest->written };
+        }
+    }
+
+    // Standalone files, without the folders and the file list left by LIST_FILES
+    std::error_code ec;
+    for (const auto& p : std::filesystem::directory_iterator(user_folder_path(user_id), ec))
+    {
+        std::error_code entry_ec;
+        if (const std::string filename = p.path().filename().string();
+            p.is_regular_file(entry_ec) && !regex_match(filename, RANDOM_FILENAME_PATTERN))
+        {
+            const uint64_t size = p.file_size(entry_ec);
+            const auto written = p.last_write_time(entry_ec);
+            files[filename] = { size, entry_ec ? 0 : epoch_seconds(written) };
+        }
+    }
+    if (ec)
+    {
+        throw std::filesystem::filesystem_error("Error listing files", ec);
+    }
+    return files;
+}
+
+std::vector<uint32_t> FileManager::list_users() const
+{
+    std::vector<uint32_t> users;
+
+    for (const auto& root : roots_->paths())
+    {
+        // A root not created yet holds no users
+        std::error_code ec;
+        if (!std::filesystem::exists(root, ec) && !ec)
+        {
+            continue;
+        }
+        for (auto& p : std::filesystem::directory_iterator(root, ec))
+        {
+            const std::string name = p.path().filename().string();
+            if (p.is_directory(ec) && !name.empty() && name.size() <= 10 &&
+                name.find_first_not_of("0123456789") == std::string::npos)
+            {
+                users.push_back(static_cast<uint32_t>(std::stoull(name)));
+            }
+        }
+
+        if (ec)
+        {
+            throw std::filesystem::filesystem_error("Error listing users", root, ec);
+        }
+    }
+
+    // A user's folder lives on a single root, but be safe against leftovers of manual moves
+    std::sort(users.begin(), users.end());
+    users.erase(std::unique(users.begin(), users.end()), users.end());
+    return users;
+}
+
+VerifyResult FileManager::verify_file(const uint32_t user_id, const std::string& filename,
+                                      const std::function<void(size_t)>& before_chunk) const
+{
+    if (const auto entry = segments_->find(user_id, filename))
+    {
+        before_chunk(entry->length);
+
+        std::vector<unsigned char> data;
+        uint32_t stored = 0;
+        try
+        {
+            if (!segments_->get(user_id, filename, data, &stored))
+            {
+                return VerifyResult::MISSING;
+            }
+        }
+        catch (const std::filesystem::filesystem_error&)
+        {
+            return VerifyResult::CORRUPT;
+        }
+        return Crc32c::compute(data.data(), data.size()) == stored ? VerifyResult::VALID : VerifyResult::CORRUPT;
+    }
+
+    if (erasure_->find(user_id, filename))
+    {
+        // Held while the shards are checked and rewritten, so the file is not replaced under the repair
+        const auto lock = locks_.lock_file(user_id, filename, LockMode::SHARED);
+        switch (erasure_->check(user_id, filename, before_chunk))
+        {
+        case ShardCheck::LOST:
+            return VerifyResult::CORRUPT;
+        case ShardCheck::MISSING:
+            return VerifyResult::MISSING;
+        default:
+            // Damaged shards were rebuilt from the others, or still can be on every read
+            return VerifyResult::VALID;
+        }
+    }
+
+    // Only the standalone file's own metadata counts here; a segment entry may have vanished since the lookup
+    auto lock = locks_.lock_file(user_id, filename, LockMode::SHARED);
+    std::ifstream meta_ifs(meta_file_path(user_id, filename), std::ios::binary);
+    unsigned char meta[4];
+    if (!meta_ifs.is_open() || !meta_ifs.read(reinterpret_cast<char*>(meta), sizeof(meta)))
+    {
+        return std::filesystem::exists(user_folder_path(user_id) + filename) ? VerifyResult::UNVERIFIABLE
+                                                                             : VerifyResult::MISSING;
+    }
+    const uint32_t stored = read_uint_32_le(meta);
+
+    InputFile in(io_policy_, user_folder_path(user_id) + filename);
+    lock.release();
+    if (!in.is_open())
+    {
+        return VerifyResult::MISSING;
+    }
+
+    size_t remaining = static_cast<size_t>(in.size());
+
+    std::vector<unsigned char> buffer(IO_CHUNK_SIZE);
+    Crc32c crc;
+    while (remaining > 0)
+    {
+        const size_t to_read = std::min(IO_CHUNK_SIZE, remaining);
+        before_chunk(to_read);
+        if (!in.read(buffer.data(), to_read))
+        {
+            return VerifyResult::CORRUPT;
+        }
+        crc.update(buffer.data(), to_read);
+        remaining -= to_read;
+    }
+
+    return crc.value() == stored ? VerifyResult::VALID : VerifyResult::CORRUPT;
+}
+
+bool FileManager::quarantine_file(const uint32_t user_id, const std::string& filename) const
+{
+    const std::string quarantine_path = roots_->user_root(user_id) + QUARANTINE_FOLDER + std::to_string(user_id) + "/";
+    std::filesystem::create_directories(quarantine_path);
+
+    // Keep every damaged version apart by suffixing the time it was quarantined
+    const auto stamp = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const std::string target = quarantine_path + filename + "." + std::to_string(stamp);
+
+    const auto user_lock = locks_.lock_user(user_id, LockMode::SHARED);
+    const auto file_lock = locks_.lock_file(user_id, filename, LockMode::EXCLUSIVE);
+    // A quarantined file no longer counts against the user's quota
+    const auto previous = stored_size(user_id, filename);
+    if (segments_->find(user_id, filename))
+    {
+        std::vector<unsigned char> data;
+        try
+        {
+            segments_->get(user_id, filename, data);
+        }
+        catch (const std::filesystem::filesystem_error&)
+        {
+            // Unreadable: nothing to preserve, but the entry still has to go
+        }
+        std::ofstream ofs(target, std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!segments_->remove(user_id, filename))
+        {
+            return false;
+        }
+        usage_->adjust(user_id, -static_cast<int64_t>(previous.value_or(0)), -1);
+        index_->erase(user_id, filename);
+        return true;
+    }
+
+    // Too few shards survive to rebuild the file: keep them, listed by the quarantined manifest, for salvage
+    if (erasure_->find(user_id, filename))
+    {
+        if (!erasure_->detach(user_id, filename, target + ".erasure"))
+        {
+            return false;
+        }
+        usage_->adjust(user_id, -static_cast<int64_t>(previous.value_or(0)), -1);
+        index_->erase(user_id, filename);
+        return true;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(user_folder_path(user_id) + filename, target, ec);
+    if (ec)
+    {
+        return false;
+    }
+    usage_->adjust(user_id, -static_cast<int64_t>(previous.value_or(0)), -1);
+    index_->erase(user_id, filename);
+    std::filesystem::rename(meta_file_path(user_id, filename), target + ".crc", ec);
+    return true;
+}
+
 std::string FileManager::write_file_list(const uint32_t user_id, const std::vector<std::string>& files) const
 {
 	// Remove any existing list file for this user (if any) before creating a new one
@@ -136,17 +1013,161 @@ std::string FileManager::write_file_list(const uint32_t user_id, const std::vect
     return random_txt;
 }
 
+std::optional<uint64_t> FileManager::create_snapshot(const uint32_t user_id, const std::string& name) const
+{
+    const std::string user_path = user_folder_path(user_id);
+    const std::string snapshot_path = snapshot_folder_path(user_id, name);
+
+    // Creating the folder claims the name, so two snapshots with the same name cannot interleave
+    std::filesystem::create_directories(user_path + SNAPSHOTS_FOLDER);
+    if (!std::filesystem::create_directory(snapshot_path))
+    {
+        return std::nullopt;
+    }
+
+    try
+    {
+        std::filesystem::create_directory(snapshot_path + META_FOLDER);
+        uint64_t files = segments_->snapshot(user_id, snapshot_path + SEGMENTS_FOLDER);
+        for (const auto& filename : erasure_->list(user_id))
+        {
+            const auto lock = locks_.lock_file(user_id, filename, LockMode::SHARED);
+            if (erasure_->snapshot(user_id, filename, name, snapshot_path + ERASURE_FOLDER + filename))
+            {
+                ++files;
+            }
+        }
+
+        for (const auto& p : std::filesystem::directory_iterator(user_path))
+        {
+            const std::string filename = p.path().filename().string();
+            if (!p.is_regular_file() || regex_match(filename, RANDOM_FILENAME_PATTERN))
+            {
+                continue;
+            }
+
+            // A file deleted since the listing is simply not part of the snapshot
+            const auto lock = locks_.lock_file(user_id, filename, LockMode::SHARED);
+            if (link_or_copy(p.path().string(), snapshot_path + filename))
+            {
+                link_or_copy(meta_file_path(user_id, filename), snapshot_path + META_FOLDER + filename);
+                ++files;
+            }
+        }
+
+        const auto created = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        std::ofstream ofs(snapshot_path + SNAPSHOT_MANIFEST);
+        if (!(ofs << created << " " << files << "\n") || !ofs.flush())
+        {
+            throw std::filesystem::filesystem_error("Error while writing the snapshot manifest",
+                snapshot_path + SNAPSHOT_MANIFEST, std::make_error_code(std::errc::io_error));
+        }
+        return files;
+    }
+    catch (...)
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(snapshot_path, ec);
+        throw;
+    }
+}
+
+std::vector<SnapshotInfo> FileManager::list_snapshots(const uint32_t user_id) const
+{
+    std::vector<SnapshotInfo> snapshots;
+    std::error_code ec;
+    for (const auto& p : std::filesystem::directory_iterator(user_folder_path(user_id) + SNAPSHOTS_FOLDER, ec))
+    {
+        // Snapshots without a manifest were interrupted while being taken
+        SnapshotInfo info;
+        info.name = p.path().filename().string();
+        if (std::ifstream ifs(p.path().string() + "/" + SNAPSHOT_MANIFEST); ifs >> info.created >> info.files)
+        {
+            snapshots.push_back(std::move(info));
+        }
+    }
+
+    std::sort(snapshots.begin(), snapshots.end(), [](const SnapshotInfo& a, const SnapshotInfo& b)
+    {
+        return a.created != b.created ? a.created < b.created : a.name < b.name;
+    });
+    return snapshots;
+}
+
+bool FileManager::read_snapshot_file(const uint32_t user_id, const std::string& snapshot, const std::string& filename,
+                                     std::vector<unsigned char>& out_data, uint32_t* out_checksum,
+                                     const std::function<void(size_t)>& before_chunk) const
+{
+    const std::string snapshot_path = snapshot_folder_path(user_id, snapshot);
+    if (!std::filesystem::exists(snapshot_path + SNAPSHOT_MANIFEST))
+    {
+        return false;
+    }
+
+    if (uint32_t stored = 0; SegmentStore::get_from_snapshot(snapshot_path + SEGMENTS_FOLDER, filename, out_data, &stored))
+    {
+        if (before_chunk)
+        {
+            before_chunk(out_data.size());
+        }
+        if (out_checksum != nullptr)
+        {
+            *out_checksum = Crc32c::compute(out_data.data(), out_data.size());
+            if (*out_checksum != stored)
+            {
+                throw ChecksumMismatchError("Stored data does not match its checksum: " + filename);
+            }
+        }
+        return true;
+    }
+
+    if (const auto manifest = ErasureStore::read_manifest(snapshot_path + ERASURE_FOLDER + filename))
+    {
+        if (before_chunk)
+        {
+            before_chunk(manifest->size);
+        }
+        read_erasure(*manifest, filename, out_data, out_checksum);
+        return true;
+    }
+
+    return read_standalone(user_id, snapshot_path + filename, snapshot_path + META_FOLDER + filename,
+                           LockTable::Guard(), out_data, out_checksum, before_chunk);
+}
+
+std::string FileManager::storage_report() const
+{
+    return roots_->report() + "  io: " + io_policy_.describe() + "\n" + erasure_->report();
+}
+
+std::string FileManager::lock_report() const
+{
+    return locks_.report();
+}
+
 std::string FileManager::user_folder_path(const uint32_t user_id) const
 {
-    return root_folder_ + std::to_string(user_id) + "/";
+    return roots_->user_root(user_id) + std::to_string(user_id) + "/";
+}
+
+std::string FileManager::snapshot_folder_path(const uint32_t user_id, const std::string& name) const
+{
+    return user_folder_path(user_id) + SNAPSHOTS_FOLDER + name + "/";
+}
+
+std::string FileManager::meta_file_path(const uint32_t user_id, const std::string& filename) const
+{
+    return user_folder_path(user_id) + META_FOLDER + filename;
 }
 
 std::string FileManager::generate_random_filename()
 {
     static constexpr  char chars[] =
         "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
-    static std::mt19937 rng(std::random_device{}());
-    static std::uniform_int_distribution<size_t> dist(0, sizeof(chars) - 2);
+    // One generator per thread: sessions save concurrently, and a shared engine is a data race
+    thread_local std::mt19937 rng(std::random_device{}());
+    std::uniform_int_distribution<size_t> dist(0, sizeof(chars) - 2);
 
     std::string result;
     result.reserve(32);
@@ -11,72 +11,337 @@
 
 #pragma once
 
+#include "ErasureStore.h"
+#include "FileIndex.h"
+#include "IoPolicy.h"
+#include "LockTable.h"
+#include "SegmentStore.h"
+#include "StorageRoots.h"
+#include "UsageTracker.h"
+
 #include <string>
 #include <vector>
+#include <chrono>
 #include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
 #include <regex>
+#include <stdexcept>
 
 const std::regex RANDOM_FILENAME_PATTERN("^[A-Za-z0-9]{32}$");
+const std::string META_FOLDER = ".meta/"; // per-user folder holding the checksum stored alongside each file
+const std::string QUARANTINE_FOLDER = ".quarantine/"; // root folder receiving damaged files found by the scrubber
+constexpr uint32_t SMALL_FILE_THRESHOLD = 64 * 1024; // files below this size are packed into segments (0 disables)
+constexpr size_t IO_CHUNK_SIZE = 64 * 1024; // bytes read or written at a time for standalone files
+constexpr unsigned TEMP_FILE_ATTEMPTS = 3; // random names tried for a save's temporary file before giving up
+const std::string TEMP_FOLDER = ".tmp/"; // per-user folder where standalone files are written before being renamed into place
+const std::string SNAPSHOTS_FOLDER = ".snapshots/"; // per-user folder holding the user's snapshots
+const std::string SNAPSHOT_MANIFEST = ".manifest"; // written last in a snapshot folder: creation time and number of files
+const std::string DELETED_FOLDER = ".deleted/"; // per-user folder remembering deletes (cluster mode), so a rebalance does not bring the files back
+constexpr std::chrono::hours DELETE_MEMORY{ 24 * 30 }; // how long a remembered delete keeps a rebalanced copy out
+const std::string UPLOADS_FOLDER = ".uploads/"; // per-user folder holding the files of multipart uploads in progress
+const std::regex SNAPSHOT_NAME_PATTERN("^[A-Za-z0-9_-][A-Za-z0-9_.-]{0,63}$");
+
+/**
+ * @class ChecksumMismatchError
+ * @brief Thrown when stored data does not match the checksum recorded when it was saved.
+ */
+class ChecksumMismatchError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @class QuotaExceededError
+ * @brief Thrown when a save would take a user beyond their quota.
+ */
+class QuotaExceededError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @class FileExistsError
+ * @brief Thrown when a save that must not replace anything finds the file, or finds it was deleted meanwhile.
+ */
+class FileExistsError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @enum VerifyResult
+ * @brief The outcome of verifying a stored file against its checksum.
+ */
+enum class VerifyResult {
+    VALID,         ///< The data matches the stored checksum.
+    CORRUPT,       ///< The data does not match the stored checksum or cannot be read completely.
+    UNVERIFIABLE,  ///< The file was saved without a checksum.
+    MISSING        ///< The file no longer exists.
+};
+
+/**
+ * @struct SnapshotInfo
+ * @brief Describes one snapshot of a user's files.
+ */
+struct SnapshotInfo {
+    std::string name;       ///< The snapshot's name.
+    int64_t created = 0;    ///< When the snapshot was taken, in seconds since the epoch.
+    uint64_t files = 0;     ///< Number of files captured.
+};
+
+/**
+ * @struct FileDigest
+ * @brief The size and checksum recorded for a stored file when it was saved.
+ */
+struct FileDigest {
+    uint64_t size = 0;      ///< The size of the file.
+    uint32_t checksum = 0;  ///< The CRC-32C of the file.
+};
 
 /**
  * @class FileManager
  * @brief Manages all file-related operations: creating directories, saving, reading, deleting, listing, etc.
+ * @details Concurrent operations on the same file are coordinated by a LockTable. Saves write their data without any
+ *          lock and only take the file's exclusive lock to rename it into place, so restores (which hold the shared
+ *          lock just while opening the file and reading its checksum) never see a torn or mismatched version.
  */
 class FileManager {
 public:
     /**
-     * @brief Constructs a FileManager with a given root folder.
-     * @param root_folder The root folder for file operations.
+     * @brief Constructs a FileManager over the given root folders.
+     * @details A single FileManager is shared by all sessions, since it owns the in-memory segment index.
+     *          Each user's folder is placed on one of the roots (see StorageRoots).
+     * @param root_folders The root folders for file operations (typically one per disk).
+     * @param small_file_threshold Files smaller than this are stored in segments instead of standalone files.
+     * @param io_config The preallocation, page cache and direct I/O settings of standalone files.
+     * @param quota The users' quotas.
+     * @param erasure The erasure code of large files (none by default: they are stored whole).
+     * @throws std::invalid_argument if the erasure code needs more roots than given.
      */
-    explicit FileManager(const std::string& root_folder);
+    explicit FileManager(const std::vector<std::string>& root_folders, uint32_t small_file_threshold = SMALL_FILE_THRESHOLD,
+                         const IoPolicyConfig& io_config = {}, const QuotaConfig& quota = {},
+                         const ErasureConfig& erasure = {});
 
     /**
-     * @brief Creates the root directory if it doesn't exist.
+     * @brief Creates the root directories if they don't exist.
      */
 	void create_root_directory() const;
 
 
     /**
-     * @brief Ensures the user's subfolder exists.
+     * @brief Ensures the user's subfolder (and its metadata folder) exists, and loads the user's usage counters.
      * @param user_id The user ID for the directory.
      */
     void create_user_directory(uint32_t user_id) const;
 
     /**
-     * @brief Saves file data to the user's directory.
+     * @brief Saves file data to the user's directory and records its checksum alongside it.
+     * @details Small files are appended to the user's segments; larger ones are written as standalone files, or as
+     *          shards on several roots when erasure coding is on.
      * @param user_id The user ID.
      * @param filename The filename to save.
      * @param data The file data to save.
+     * @param checksum The CRC-32C of 'data' (computed while it was received).
+     * @param before_chunk Optional callback invoked with the size of each chunk before it is written (e.g. to schedule the I/O).
+     * @param if_absent Save only if the user has no file by that name and has not deleted one lately (rebalancing).
      * @return True on success; false on error.
+     * @throws QuotaExceededError if the file would take the user beyond their quota.
+     * @throws FileExistsError if 'if_absent' is set and the file exists or was deleted within DELETE_MEMORY.
      */
     bool save_file(uint32_t user_id, const std::string& filename,
-        const std::vector<unsigned char>& data) const;
+        const std::vector<unsigned char>& data, uint32_t checksum,
+        const std::function<void(size_t)>& before_chunk = nullptr, bool if_absent = false) const;
+
+    /**
+     * @brief Publishes a fully written standalone file under a name, replacing any earlier version.
+     * @details The file is renamed into place together with its checksum, so readers and snapshots see either both
+     *          old or both new. It must be in the user's folder tree (e.g. its TEMP_FOLDER or UPLOADS_FOLDER).
+     *          When erasure coding is on, the file is encoded into shards instead and then removed.
+     * @param user_id The user ID.
+     * @param filename The filename to publish as.
+     * @param path The path of the written file.
+     * @param checksum The CRC-32C of the file.
+     * @param if_absent Publish only if the user has no file by that name and has not deleted one lately.
+     * @return True on success; false on error (the written file is removed).
+     * @throws QuotaExceededError if the file would take the user beyond their quota (the written file is removed).
+     * @throws FileExistsError if 'if_absent' is set and the file exists or was deleted lately (the written file is removed).
+     */
+    bool publish_file(uint32_t user_id, const std::string& filename, const std::string& path, uint32_t checksum,
+                      bool if_absent = false) const;
+
+    /**
+     * @brief Returns the path of the file receiving a multipart upload's parts.
+     * @param user_id The user ID.
+     * @param upload_id The upload ID.
+     * @return The path, in the user's UPLOADS_FOLDER.
+     */
+    std::string upload_file_path(uint32_t user_id, const std::string& upload_id) const;
+
+    /**
+     * @brief Returns how standalone files are written and read.
+     * @return The I/O policy.
+     */
+    const IoPolicy& io_policy() const;
 
     /**
      * @brief Reads file data into 'out_data'.
+     * @details If 'out_checksum' is given, the CRC-32C is computed while the file is read
+     *          and compared with the checksum stored when the file was saved (if any).
      * @param user_id The user ID.
      * @param filename The filename to read.
      * @param out_data The vector to store the file data.
+     * @param out_checksum Optional output for the CRC-32C of the data read.
+     * @param before_chunk Optional callback invoked with the size of each chunk before it is read (e.g. to schedule the I/O).
      * @return True if the file exists; false otherwise.
+     * @throws ChecksumMismatchError if the data does not match the stored checksum.
      */
     bool read_file(uint32_t user_id, const std::string& filename,
-                   std::vector<unsigned char>& out_data) const;
+                   std::vector<unsigned char>& out_data, uint32_t* out_checksum = nullptr,
+                   const std::function<void(size_t)>& before_chunk = nullptr) const;
+
+    /**
+     * @brief Reads the checksum stored for a file when it was saved.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return The stored CRC-32C, or nothing for files saved without one.
+     */
+    std::optional<uint32_t> read_checksum(uint32_t user_id, const std::string& filename) const;
+
+    /**
+     * @brief Reads the size and checksum of a stored file without reading its data.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return The digest, or nothing if the file does not exist or was saved without a checksum.
+     */
+    std::optional<FileDigest> read_digest(uint32_t user_id, const std::string& filename) const;
+
+    /**
+     * @brief Tells whether saving a file of the given size would keep the user within their quota.
+     * @details Replacing a file only counts the difference in size. The answer is advisory: the quota is enforced
+     *          again, atomically, when the file is put in place.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param size The size of the new version.
+     * @return True if the save fits.
+     */
+    bool fits_quota(uint32_t user_id, const std::string& filename, uint64_t size) const;
+
+    /**
+     * @brief Returns what a user stores.
+     * @param user_id The user ID.
+     * @return The user's byte and file counters.
+     */
+    UserUsage usage(uint32_t user_id) const;
+
+    /**
+     * @brief Returns a user's quota.
+     * @param user_id The user ID.
+     * @return The limits (0 means unlimited).
+     */
+    QuotaLimits quota(uint32_t user_id) const;
+
+    /**
+     * @brief Formats the usage counters' state as text.
+     * @return The report.
+     */
+    std::string usage_report() const;
+
+    /**
+     * @brief Lists a page of the user's files in name order, with their sizes and modification times.
+     * @details Served from the user's FileIndex, built by one scan of the user's folder the first time the user is
+     *          listed. Small files kept in segments report when their segment was last written until they are saved
+     *          again.
+     * @param user_id The user ID.
+     * @param prefix Only names starting with this are listed (empty: all).
+     * @param cursor The next_cursor of the previous page, or empty for the first page.
+     * @param limit The most files the page holds (0: DEFAULT_LIST_PAGE_SIZE; at most MAX_LIST_PAGE_SIZE).
+     * @return The page.
+     */
+    FilePage list_files_page(uint32_t user_id, const std::string& prefix, const std::string& cursor, uint32_t limit) const;
+
+    /**
+     * @brief Formats the listing index's state as text.
+     * @return The report.
+     */
+    std::string index_report() const;
+
+    /**
+     * @brief Lists the users whose state is in memory, so a successor process can load the same users ahead of
+     *        their requests.
+     * @return Each user, and whether their listing index is loaded too.
+     */
+    std::vector<std::pair<uint32_t, bool>> cached_users() const;
+
+    /**
+     * @brief Loads a user's usage counters and segment index (and optionally listing index) before they are needed.
+     * @param user_id The user ID.
+     * @param with_index Build the user's listing index too.
+     */
+    void warm_up(uint32_t user_id, bool with_index) const;
+
+    /**
+     * @brief Writes the changed usage counters to disk now, so another process loading them sees the current values.
+     */
+    void flush_usage() const;
+
+    /**
+     * @brief Stops the background segment compaction, which works on every user's files, before a successor
+     *        process takes over the storage.
+     */
+    void stop_maintenance() const;
+
+    /**
+     * @brief Starts the background segment compaction again after stop_maintenance() (the handoff failed).
+     */
+    void resume_maintenance() const;
 
     /**
      * @brief Deletes a file.
      * @param user_id The user ID.
      * @param filename The filename to delete.
+     * @param remember Whether to remember the delete (even of a file not held here) for DELETE_MEMORY, so a copy
+     *                 rebalanced from another node does not bring the file back.
      * @return True if the file was removed; false if not found or error.
      */
-    bool delete_file(uint32_t user_id, const std::string& filename) const;
+    bool delete_file(uint32_t user_id, const std::string& filename, bool remember = false) const;
 
     /**
      * @brief Lists files in the user's folder.
+     * @details The user's namespace lock is held exclusively meanwhile, so no name is added or removed half-way
+     *          through; saves keep writing their data and only wait to rename it into place.
      * @param user_id The user ID.
      * @return The list of filenames.
      */
     std::vector<std::string> list_user_files(const uint32_t user_id) const;
 
+    /**
+     * @brief Lists the users that have a folder under the root folder.
+     * @details A root that does not exist yet holds no users.
+     * @return The list of user IDs.
+     */
+    std::vector<uint32_t> list_users() const;
+
+    /**
+     * @brief Re-reads a stored file and compares it with the checksum recorded when it was saved.
+     * @param user_id The user ID.
+     * @param filename The filename to verify.
+     * @param before_chunk Called with the size of each chunk before it is read (used for throttling).
+     * @return The verification result.
+     */
+    VerifyResult verify_file(uint32_t user_id, const std::string& filename,
+                             const std::function<void(size_t)>& before_chunk) const;
+
+    /**
+     * @brief Moves a damaged file out of the user's folder into the quarantine folder.
+     * @param user_id The user ID.
+     * @param filename The filename to quarantine.
+     * @return True if the file was moved; false otherwise.
+     */
+    bool quarantine_file(uint32_t user_id, const std::string& filename) const;
+
     /**
      * @brief Writes a text file listing all 'files'.
      * @param user_id The user ID.
@@ -86,16 +351,200 @@ public:
     std::string write_file_list(uint32_t user_id, const std::vector<std::string>& files) const;
 
     /**
-     * @brief Generates a random filename (32 alphanumeric characters).
+     * @brief Captures the user's current files in a named snapshot.
+     * @details No data is copied: standalone files and their checksums are hard-linked (they are only ever replaced
+     *          by rename, never rewritten), so are the shards of erasure-coded files (see ErasureStore::snapshot()),
+     *          and the segment index is captured by SegmentStore::snapshot(). Saves of the
+     *          user go on meanwhile; each file is captured either before or after a concurrent save, never half-way.
+     * @param user_id The user ID.
+     * @param name The snapshot name (must match SNAPSHOT_NAME_PATTERN).
+     * @return The number of files captured, or nothing if a snapshot with that name already exists.
+     * @throws std::filesystem::filesystem_error if the snapshot cannot be written (the partial snapshot is removed).
+     */
+    std::optional<uint64_t> create_snapshot(uint32_t user_id, const std::string& name) const;
+
+    /**
+     * @brief Lists the user's snapshots, oldest first.
+     * @param user_id The user ID.
+     * @return The complete snapshots.
+     */
+    std::vector<SnapshotInfo> list_snapshots(uint32_t user_id) const;
+
+    /**
+     * @brief Reads a file as it was when a snapshot was taken.
+     * @param user_id The user ID.
+     * @param snapshot The snapshot name.
+     * @param filename The filename to read.
+     * @param out_data The vector to store the file data.
+     * @param out_checksum Optional output for the CRC-32C of the data read.
+     * @param before_chunk Optional callback invoked with the size of each chunk before it is read (e.g. to schedule the I/O).
+     * @return True if the snapshot exists and holds the file; false otherwise.
+     * @throws ChecksumMismatchError if the data does not match the stored checksum.
+     */
+    bool read_snapshot_file(uint32_t user_id, const std::string& snapshot, const std::string& filename,
+                            std::vector<unsigned char>& out_data, uint32_t* out_checksum = nullptr,
+                            const std::function<void(size_t)>& before_chunk = nullptr) const;
+
+    /**
+     * @brief Formats the storage roots' free space, latency and number of users, and the I/O policy, as text.
+     * @return The report.
+     */
+    std::string storage_report() const;
+
+    /**
+     * @brief Formats the file lock counters as text.
+     * @return The report.
+     */
+    std::string lock_report() const;
+
+    /**
+     * @brief Generates a random filename (32 alphanumeric characters); safe to call from several threads.
      * @return The generated random filename.
      */
     static std::string generate_random_filename();
 
 private:
     /**
-	 * @brief The root folder for file operations.
+	 * @brief The root folders for file operations, and the placement of users on them.
+     */
+    std::shared_ptr<StorageRoots> roots_;
+
+    /**
+     * @brief Files smaller than this are stored in segments.
+     */
+    uint32_t small_file_threshold_;
+
+    /**
+     * @brief The segment storage holding the small files.
+     */
+    std::unique_ptr<SegmentStore> segments_;
+
+    /**
+     * @brief How standalone files are written and read.
+     */
+    IoPolicy io_policy_;
+
+    /**
+     * @brief Per-file and per-user reader/writer locks.
+     */
+    mutable LockTable locks_;
+
+    /**
+     * @brief The users' byte and file counters and quotas.
+     */
+    std::unique_ptr<UsageTracker> usage_;
+
+    /**
+     * @brief The name-ordered indexes of recently listed users.
+     */
+    std::unique_ptr<FileIndex> index_;
+
+    /**
+     * @brief The erasure-coded large files, spread over the roots as shards.
+     */
+    std::unique_ptr<ErasureStore> erasure_;
+
+    /**
+     * @brief Encodes a file into shards and makes it the file's current version.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param size The size of the file.
+     * @param checksum The CRC-32C of the file.
+     * @param read Supplies the file's bytes in order.
+     * @param before_chunk Optional callback invoked with the size of each stripe before it is written.
+     * @param if_absent Save only if the user has no file by that name and has not deleted one lately.
+     * @return True on success; false on error.
+     * @throws QuotaExceededError if the file would take the user beyond their quota.
+     * @throws FileExistsError if 'if_absent' is set and the file exists or was deleted lately.
+     */
+    bool save_erasure(uint32_t user_id, const std::string& filename, uint64_t size, uint32_t checksum,
+                      const ErasureStore::ReadFn& read, const std::function<void(size_t)>& before_chunk,
+                      bool if_absent = false) const;
+
+    /**
+     * @brief Reads an erasure-coded file, rebuilding it from parity if shards are missing or damaged.
+     * @param manifest The file's manifest.
+     * @param filename The filename (for the error message).
+     * @param out_data The vector to store the file data.
+     * @param out_checksum Optional output for the CRC-32C of the data read.
+     * @throws ChecksumMismatchError if too few shards are intact to rebuild the file.
+     */
+    void read_erasure(const ErasureManifest& manifest, const std::string& filename, std::vector<unsigned char>& out_data,
+                      uint32_t* out_checksum) const;
+
+    /**
+     * @brief Returns the size of the stored version of a file (the caller holds the file's lock).
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return The size, or nothing if the file does not exist.
      */
-    std::string root_folder_;
+    std::optional<uint64_t> stored_size(uint32_t user_id, const std::string& filename) const;
+
+    /**
+     * @brief Tells whether a user has no file by a name and has not deleted one within DELETE_MEMORY (the caller
+     *        holds the file's lock).
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return True if a save under that name replaces nothing the user has seen.
+     */
+    bool absent(uint32_t user_id, const std::string& filename) const;
+
+    /**
+     * @brief Removes the user's remembered deletes older than DELETE_MEMORY.
+     * @param user_id The user ID.
+     */
+    void forget_old_deletes(uint32_t user_id) const;
+
+    /**
+     * @brief Builds a user's listing index if it is not loaded, while none of the user's files can change.
+     * @param user_id The user ID.
+     */
+    void load_index(uint32_t user_id) const;
+
+    /**
+     * @brief Counts a user's files and their total size by walking the user's folder and segments.
+     * @param user_id The user ID.
+     * @return The usage.
+     */
+    UserUsage count_usage(uint32_t user_id) const;
+
+    /**
+     * @brief Collects a user's files with their sizes and modification times by walking the user's folder and segments.
+     * @param user_id The user ID.
+     * @return The files, by name.
+     */
+    std::map<std::string, FileStat> scan_files(uint32_t user_id) const;
+
+    /**
+     * @brief Reads a standalone file in chunks, checking it against its checksum file.
+     * @param user_id The user whose root's latency is recorded.
+     * @param file_path The file path.
+     * @param meta_path The path of the file's checksum.
+     * @param lock The file's shared lock (if any), released once the file is open and its checksum read.
+     * @param out_data The vector to store the file data.
+     * @param out_checksum Optional output for the CRC-32C of the data read.
+     * @param before_chunk Optional callback invoked with the size of each chunk before it is read.
+     * @return True if the file exists; false otherwise.
+     * @throws ChecksumMismatchError if the data does not match the stored checksum.
+     */
+    bool read_standalone(uint32_t user_id, const std::string& file_path, const std::string& meta_path,
+                         LockTable::Guard lock, std::vector<unsigned char>& out_data, uint32_t* out_checksum,
+                         const std::function<void(size_t)>& before_chunk) const;
+
+    /**
+     * @brief Reads a checksum file.
+     * @param meta_path The path of the checksum file.
+     * @return The stored CRC-32C, or nothing if there is none.
+     */
+    static std::optional<uint32_t> read_meta(const std::string& meta_path);
+
+    /**
+     * @brief Helper function to get the path of a snapshot's folder.
+     * @param user_id The user ID.
+     * @param name The snapshot name.
+     * @return The snapshot folder path.
+     */
+    std::string snapshot_folder_path(uint32_t user_id, const std::string& name) const;
 
     /**
      * @brief Helper function to get the user's folder path.
@@ -103,4 +552,12 @@ private:
      * @return The user's folder path.
      */
     std::string user_folder_path(uint32_t user_id) const;
+
+    /**
+     * @brief Helper function to get the path of the metadata file stored alongside a file.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return The metadata file path.
+     */
+    std::string meta_file_path(uint32_t user_id, const std::string& filename) const;
 };
\ No newline at end of file
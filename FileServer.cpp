@@ -0,0 +1,75 @@
+/**
+ * @file FileServer.cpp
+ * @brief FileServer class implementation.
+ * @details This file contains the implementation of the embeddable server core serving clients over any transport.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "FileServer.h"
+#include "ClientSession.h"
+
+FileServer::FileServer(const ServerConfig& config)
+    : context_(std::make_shared<ServerContext>())
+{
+    context_->file_manager = std::make_shared<FileManager>(config.storage_folders, SMALL_FILE_THRESHOLD, config.io_policy,
+        config.quota, config.erasure);
+
+    // The scrubber backs off whenever a client request is in progress
+    const ServerContext* context = context_.get();
+    context_->scrubber = std::make_shared<StorageScrubber>(context_->file_manager,
+        [context] { return context->active_requests.load(); });
+
+    context_->uploads = std::make_shared<UploadManager>(context_->file_manager, config.upload_timeout);
+
+    if (!config.trace_path.empty())
+    {
+        context_->trace = std::make_shared<TraceRecorder>(config.trace_path);
+    }
+
+    if (!config.handoff_socket.empty())
+    {
+        context_->drain = std::make_shared<SessionDrain>();
+    }
+
+    if (config.fair_scheduling)
+    {
+        context_->scheduler = std::make_shared<FairScheduler>(config.user_bytes_per_second, config.user_weights);
+    }
+
+    if (!config.replication_peer_host.empty())
+    {
+        context_->replicator = std::make_shared<Replicator>(context_->file_manager, config.storage_folders.front(),
+            config.replication_peer_host, config.replication_peer_port);
+    }
+
+    if (!config.cluster_nodes.empty())
+    {
+        context_->cluster = std::make_shared<Cluster>(context_->file_manager, config.cluster_self,
+            config.cluster_nodes, config.cluster_proxy, context_->replicator);
+
+        // Hand over the users this node no longer owns (e.g. after nodes were added)
+        context_->cluster->start_rebalance();
+    }
+}
+
+void FileServer::serve(std::shared_ptr<Transport> transport) const
+{
+    const auto session = std::make_shared<ClientSession>(std::move(transport), context_);
+    session->start();
+}
+
+std::shared_ptr<Transport> FileServer::connect(const size_t capacity) const
+{
+    auto [client_end, server_end] = MemoryTransport::make_pipe(capacity);
+    serve(std::move(server_end));
+    return client_end;
+}
+
+const std::shared_ptr<ServerContext>& FileServer::context() const
+{
+    return context_;
+}
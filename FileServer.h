@@ -0,0 +1,66 @@
+/**
+ * @file FileServer.h
+ * @brief FileServer class definition.
+ * @details This header file contains the FileServer class, the embeddable core of the server: storage, background
+ *          services and request handling, serving clients over any Transport. The TCP Server is built on it, and a
+ *          host process can link it directly and talk to it over in-process pipes.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "ServerConfig.h"
+#include "ServerContext.h"
+#include "Transport.h"
+
+#include <memory>
+
+/**
+ * @class FileServer
+ * @brief The server without its listener: serves the protocol to clients connected over any transport.
+ * @details Every client gets its own session thread, exactly as with TCP connections. The network settings of the
+ *          configuration ('port') are not used here. Sessions keep the shared services alive, so they may outlive
+ *          the FileServer that started them.
+ */
+class FileServer
+{
+public:
+    /**
+     * @brief Opens the storage and starts the background services (scrubber, replication, cluster rebalancing).
+     * @param config The server's settings.
+     */
+    explicit FileServer(const ServerConfig& config);
+
+    FileServer(const FileServer&) = delete;
+    FileServer& operator=(const FileServer&) = delete;
+
+    /**
+     * @brief Serves a connected client until it disconnects (on a session thread of its own).
+     * @param transport The stream to the client.
+     */
+    void serve(std::shared_ptr<Transport> transport) const;
+
+    /**
+     * @brief Connects an in-process client.
+     * @details The returned end speaks the protocol exactly as a TCP client would; closing or destroying it ends the session.
+     * @param capacity The number of bytes buffered in each direction.
+     * @return The client's end of the connection.
+     */
+    std::shared_ptr<Transport> connect(size_t capacity = MEMORY_PIPE_CAPACITY) const;
+
+    /**
+     * @brief Returns the services shared by the sessions.
+     * @return The context.
+     */
+    const std::shared_ptr<ServerContext>& context() const;
+
+private:
+	/**
+    * @brief The services shared by all client sessions.
+    */
+    std::shared_ptr<ServerContext> context_;
+};
@@ -0,0 +1,520 @@
+/**
+ * @file Handoff.cpp
+ * @brief HandoffChannel and HandoffListener class implementation.
+ * @details This file contains the implementation of the handoff messages and of passing the listening socket
+ *          between processes over a Unix domain socket.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "Handoff.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const std::string UNSUPPORTED = "Socket handoff needs Unix domain sockets, which this platform lacks";
+
+    /**
+     * @brief Escapes backslashes and newlines, so a filename cannot end its line early.
+     */
+    std::string escape(const std::string& text)
+    {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (const char c : text)
+        {
+            if (c == '\\') escaped += "\\\\";
+            else if (c == '\n') escaped += "\\n";
+            else escaped += c;
+        }
+        return escaped;
+    }
+
+    /**
+     * @brief Reverses escape().
+     */
+    std::string unescape(const std::string& text)
+    {
+        std::string unescaped;
+        unescaped.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == '\\' && i + 1 < text.size())
+            {
+                unescaped += text[++i] == 'n' ? '\n' : text[i];
+            }
+            else
+            {
+                unescaped += text[i];
+            }
+        }
+        return unescaped;
+    }
+
+    /**
+     * @brief Returns what follows the single space after the fields already extracted from a line.
+     */
+    std::string rest_of_line(std::istringstream& in)
+    {
+        in.get();
+        std::string rest;
+        std::getline(in, rest);
+        return rest;
+    }
+
+    /**
+     * @brief Describes the last system error.
+     */
+    std::runtime_error system_error(const std::string& what)
+    {
+        return std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+#ifndef _WIN32
+    /**
+     * @brief Builds the address of a Unix domain socket.
+     */
+    sockaddr_un socket_address(const std::string& path)
+    {
+        sockaddr_un address{};
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            throw std::runtime_error("Invalid handoff socket path: " + path);
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return address;
+    }
+#endif
+}
+
+HandoffChannel::HandoffChannel(const int descriptor)
+    : descriptor_(descriptor)
+{
+}
+
+HandoffChannel::~HandoffChannel()
+{
+#ifndef _WIN32
+    ::close(descriptor_);
+    if (passed_ >= 0)
+    {
+        ::close(passed_);
+    }
+#endif
+}
+
+std::shared_ptr<HandoffChannel> HandoffChannel::connect(const std::string& path)
+{
+#ifdef _WIN32
+    throw std::runtime_error(UNSUPPORTED);
+#else
+    const sockaddr_un address = socket_address(path);
+    const int descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor < 0)
+    {
+        throw system_error("Cannot create a socket");
+    }
+    if (::connect(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        const auto error = system_error("Cannot connect to the running server at " + path);
+        ::close(descriptor);
+        throw error;
+    }
+    return std::make_shared<HandoffChannel>(descriptor);
+#endif
+}
+
+HandoffState HandoffChannel::take_over()
+{
+    send_lines("takeover " + std::to_string(HANDOFF_PROTOCOL_VERSION) + "\n");
+    const auto greeting = receive_line();
+    if (!greeting || *greeting != "handoff " + std::to_string(HANDOFF_PROTOCOL_VERSION) || passed_ < 0)
+    {
+        throw std::runtime_error("The running server refused to hand over");
+    }
+
+    HandoffState state;
+    state.listener = passed_;
+    passed_ = -1;
+    try
+    {
+        while (true)
+        {
+            const auto line = receive_line();
+            if (!line)
+            {
+                throw std::runtime_error("The running server closed the handoff before it was complete");
+            }
+
+            std::istringstream in(*line);
+            std::string keyword;
+            in >> keyword;
+            if (keyword == "start")
+            {
+                return state;
+            }
+
+            bool valid = false;
+            if (keyword == "hold")
+            {
+                uint32_t user_id = 0;
+                valid = static_cast<bool>(in >> user_id);
+                state.held_users.push_back(user_id);
+            }
+            else if (keyword == "warm")
+            {
+                uint32_t user_id = 0;
+                int indexed = 0;
+                valid = static_cast<bool>(in >> user_id >> indexed);
+                state.warm_users.emplace_back(user_id, indexed != 0);
+            }
+            else if (keyword == "upload")
+            {
+                if (auto upload = parse_upload(rest_of_line(in)))
+                {
+                    state.uploads.push_back(std::move(*upload));
+                    valid = true;
+                }
+            }
+            if (!valid)
+            {
+                throw std::runtime_error("Malformed handoff message: " + *line);
+            }
+        }
+    }
+    catch (...)
+    {
+#ifndef _WIN32
+        ::close(state.listener);
+#endif
+        throw;
+    }
+}
+
+std::optional<HandoffUpdate> HandoffChannel::receive_update()
+{
+    try
+    {
+        while (const auto line = receive_line())
+        {
+            std::istringstream in(*line);
+            std::string keyword;
+            in >> keyword;
+
+            HandoffUpdate update;
+            if (keyword == "release" && in >> update.user_id)
+            {
+                update.type = HandoffUpdate::Type::RELEASE;
+                return update;
+            }
+            if (keyword == "upload")
+            {
+                if (auto upload = parse_upload(rest_of_line(in)))
+                {
+                    update.type = HandoffUpdate::Type::UPLOAD;
+                    update.user_id = upload->user_id;
+                    update.upload = std::move(*upload);
+                    return update;
+                }
+            }
+            unsigned op_code = 0;
+            if (keyword == "replicate" && in >> op_code >> update.user_id)
+            {
+                update.type = HandoffUpdate::Type::REPLICATE;
+                update.op_code = static_cast<Command>(op_code);
+                update.filename = unescape(rest_of_line(in));
+                return update;
+            }
+            if (keyword == "done")
+            {
+                update.type = HandoffUpdate::Type::DONE;
+                return update;
+            }
+            std::cerr << "Ignoring malformed handoff message: " << *line << "\n";
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Handoff connection failed: " << e.what() << "\n";
+    }
+    return std::nullopt;
+}
+
+void HandoffChannel::accept_successor()
+{
+    const auto greeting = receive_line();
+    if (!greeting || *greeting != "takeover " + std::to_string(HANDOFF_PROTOCOL_VERSION))
+    {
+        throw std::runtime_error("Not a successor speaking handoff version " + std::to_string(HANDOFF_PROTOCOL_VERSION));
+    }
+}
+
+void HandoffChannel::send_state(const HandoffState& state)
+{
+    std::ostringstream out;
+    out << "handoff " << HANDOFF_PROTOCOL_VERSION << "\n";
+    for (const uint32_t user_id : state.held_users)
+    {
+        out << "hold " << user_id << "\n";
+    }
+    for (const auto& [user_id, indexed] : state.warm_users)
+    {
+        out << "warm " << user_id << " " << (indexed ? 1 : 0) << "\n";
+    }
+    for (const auto& upload : state.uploads)
+    {
+        out << format_upload(upload) << "\n";
+    }
+    out << "start\n";
+    send_lines(out.str(), state.listener);
+}
+
+void HandoffChannel::send_release(const uint32_t user_id, const std::vector<UploadState>& uploads)
+{
+    std::ostringstream out;
+    for (const auto& upload : uploads)
+    {
+        out << format_upload(upload) << "\n";
+    }
+    out << "release " << user_id << "\n";
+    send_lines(out.str());
+}
+
+void HandoffChannel::send_replication(const Command op_code, const uint32_t user_id, const std::string& filename)
+{
+    send_lines("replicate " + std::to_string(static_cast<unsigned>(op_code)) + " " + std::to_string(user_id) + " " +
+        escape(filename) + "\n");
+}
+
+void HandoffChannel::send_done()
+{
+    send_lines("done\n");
+}
+
+void HandoffChannel::send_lines(const std::string& lines, int passed)
+{
+#ifdef _WIN32
+    throw std::runtime_error(UNSUPPORTED);
+#else
+    std::lock_guard lock(send_mutex_);
+    for (size_t sent = 0; sent < lines.size();)
+    {
+        iovec data{ const_cast<char*>(lines.data() + sent), lines.size() - sent };
+        msghdr header{};
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+
+        // The descriptor travels with the first bytes
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        if (passed >= 0)
+        {
+            header.msg_control = control;
+            header.msg_controllen = sizeof(control);
+            cmsghdr* message = CMSG_FIRSTHDR(&header);
+            message->cmsg_level = SOL_SOCKET;
+            message->cmsg_type = SCM_RIGHTS;
+            message->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(message), &passed, sizeof(int));
+        }
+
+#ifdef MSG_NOSIGNAL
+        const ssize_t n = ::sendmsg(descriptor_, &header, MSG_NOSIGNAL);
+#else
+        const ssize_t n = ::sendmsg(descriptor_, &header, 0);
+#endif
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            throw system_error("Cannot send to the handoff socket");
+        }
+        sent += static_cast<size_t>(n);
+        passed = -1;
+    }
+#endif
+}
+
+std::optional<std::string> HandoffChannel::receive_line()
+{
+#ifdef _WIN32
+    throw std::runtime_error(UNSUPPORTED);
+#else
+    while (true)
+    {
+        if (const size_t end = received_.find('\n'); end != std::string::npos)
+        {
+            std::string line = received_.substr(0, end);
+            received_.erase(0, end + 1);
+            return line;
+        }
+
+        char buffer[4096];
+        iovec data{ buffer, sizeof(buffer) };
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        msghdr header{};
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+
+        const ssize_t n = ::recvmsg(descriptor_, &header, 0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0)
+        {
+            throw system_error("Cannot receive from the handoff socket");
+        }
+        for (cmsghdr* message = CMSG_FIRSTHDR(&header); message; message = CMSG_NXTHDR(&header, message))
+        {
+            if (message->cmsg_level == SOL_SOCKET && message->cmsg_type == SCM_RIGHTS)
+            {
+                if (passed_ >= 0)
+                {
+                    ::close(passed_);
+                }
+                std::memcpy(&passed_, CMSG_DATA(message), sizeof(int));
+            }
+        }
+        if (n == 0)
+        {
+            return std::nullopt;
+        }
+        received_.append(buffer, static_cast<size_t>(n));
+    }
+#endif
+}
+
+std::string HandoffChannel::format_upload(const UploadState& upload)
+{
+    std::ostringstream out;
+    out << "upload " << upload.user_id << " " << upload.upload_id << " " << upload.total_size << " " << upload.part_size
+        << " ";
+    for (size_t part = 0; part < upload.part_checksums.size(); ++part)
+    {
+        if (part > 0)
+        {
+            out << ",";
+        }
+        if (upload.part_checksums[part])
+        {
+            out << *upload.part_checksums[part];
+        }
+        else
+        {
+            out << "-";
+        }
+    }
+    out << " " << escape(upload.filename);
+    return out.str();
+}
+
+std::optional<UploadState> HandoffChannel::parse_upload(const std::string& fields)
+{
+    std::istringstream in(fields);
+    UploadState upload;
+    std::string checksums;
+    if (!(in >> upload.user_id >> upload.upload_id >> upload.total_size >> upload.part_size >> checksums))
+    {
+        return std::nullopt;
+    }
+    upload.filename = unescape(rest_of_line(in));
+
+    try
+    {
+        std::istringstream parts(checksums);
+        for (std::string part; std::getline(parts, part, ',');)
+        {
+            upload.part_checksums.push_back(part == "-" ? std::nullopt
+                : std::optional<uint32_t>(static_cast<uint32_t>(std::stoul(part))));
+        }
+    }
+    catch (const std::exception&)
+    {
+        return std::nullopt;
+    }
+    return upload;
+}
+
+HandoffListener::HandoffListener(std::string path)
+    : path_(std::move(path))
+{
+#ifdef _WIN32
+    throw std::runtime_error(UNSUPPORTED);
+#else
+    const sockaddr_un address = socket_address(path_);
+    const int descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor < 0)
+    {
+        throw system_error("Cannot create the handoff socket");
+    }
+
+    // A socket left behind by the process this one replaced, or by one that crashed
+    ::unlink(path_.c_str());
+    const mode_t mask = ::umask(0077);
+    const bool bound = ::bind(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    ::umask(mask);
+    if (!bound || ::listen(descriptor, 1) != 0)
+    {
+        const auto error = system_error("Cannot listen on " + path_);
+        ::close(descriptor);
+        throw error;
+    }
+    descriptor_ = descriptor;
+#endif
+}
+
+HandoffListener::~HandoffListener()
+{
+    close();
+}
+
+std::shared_ptr<HandoffChannel> HandoffListener::accept()
+{
+#ifndef _WIN32
+    while (descriptor_ >= 0)
+    {
+        const int descriptor = ::accept(descriptor_, nullptr, nullptr);
+        if (descriptor >= 0)
+        {
+            return std::make_shared<HandoffChannel>(descriptor);
+        }
+        if (errno != EINTR)
+        {
+            break;
+        }
+    }
+#endif
+    return nullptr;
+}
+
+void HandoffListener::close()
+{
+#ifndef _WIN32
+    if (const int descriptor = descriptor_.exchange(-1); descriptor >= 0)
+    {
+        // Wakes accept() before the descriptor goes away
+        ::shutdown(descriptor, SHUT_RDWR);
+        ::close(descriptor);
+    }
+#endif
+}
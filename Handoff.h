@@ -0,0 +1,218 @@
+/**
+ * @file Handoff.h
+ * @brief HandoffChannel and HandoffListener class definitions.
+ * @details This header file contains the Unix domain socket connection over which a running server hands its
+ *          listening socket, the users it is still busy with, its multipart uploads and the users it had in memory
+ *          to a new server process replacing it, so a restart refuses no connection and starts warm.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "protocols.h"
+#include "UploadManager.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr unsigned HANDOFF_PROTOCOL_VERSION = 1;    // version of the messages exchanged on the handoff socket
+
+/**
+ * @struct HandoffState
+ * @brief What a draining server hands its successor before the successor starts accepting connections.
+ */
+struct HandoffState {
+    int listener = -1;                                  ///< The listening socket (a descriptor of the receiving process).
+    std::vector<uint32_t> held_users;                   ///< Users with requests still in progress at the predecessor.
+    std::vector<std::pair<uint32_t, bool>> warm_users;  ///< Users the predecessor had in memory, and whether their listing index too.
+    std::vector<UploadState> uploads;                   ///< Multipart uploads in progress of the users not held.
+};
+
+/**
+ * @struct HandoffUpdate
+ * @brief A message from the draining server after the initial state.
+ */
+struct HandoffUpdate {
+    /**
+     * @enum Type
+     * @brief What the message says.
+     */
+    enum class Type {
+        RELEASE,    ///< The predecessor is done with a held user.
+        UPLOAD,     ///< A multipart upload of a user about to be released.
+        REPLICATE,  ///< A save or delete the predecessor made, to be replicated by the successor.
+        DONE        ///< The predecessor has drained and exits.
+    };
+
+    Type type = Type::DONE;                     ///< What the message says.
+    uint32_t user_id = 0;                       ///< The user released, or whose file was saved or deleted.
+    UploadState upload;                         ///< The upload (UPLOAD only).
+    Command op_code = Command::SAVE_FILE;       ///< SAVE_FILE or DELETE_FILE (REPLICATE only).
+    std::string filename;                       ///< The file saved or deleted (REPLICATE only).
+};
+
+/**
+ * @class HandoffChannel
+ * @brief One end of the connection between a draining server (the predecessor) and the process replacing it.
+ * @details Messages are text lines. The successor opens with "takeover <version>"; the predecessor answers
+ *          "handoff <version>" carrying the listening socket as SCM_RIGHTS ancillary data, then "hold", "warm" and
+ *          "upload" lines and "start". From then on it sends "replicate", "upload" and "release" lines as its
+ *          requests finish, and "done" once drained; the connection closing means the same. Filenames end their
+ *          line, with backslashes and newlines escaped. Only available where Unix domain sockets are (not Windows).
+ */
+class HandoffChannel {
+public:
+    /**
+     * @brief Wraps a connected Unix domain socket.
+     * @param descriptor The socket, closed with the channel.
+     */
+    explicit HandoffChannel(int descriptor);
+
+    /**
+     * @brief Closes the socket.
+     */
+    ~HandoffChannel();
+
+    HandoffChannel(const HandoffChannel&) = delete;
+    HandoffChannel& operator=(const HandoffChannel&) = delete;
+
+    /**
+     * @brief Connects to a running server's handoff socket.
+     * @param path The socket's path.
+     * @return The channel.
+     * @throws std::runtime_error if the server cannot be reached.
+     */
+    static std::shared_ptr<HandoffChannel> connect(const std::string& path);
+
+    /**
+     * @brief Asks the predecessor to hand over and receives its state (successor side).
+     * @return The state, with the listening socket.
+     * @throws std::runtime_error if the predecessor refuses or the messages are malformed.
+     */
+    HandoffState take_over();
+
+    /**
+     * @brief Receives the next message after the state (successor side).
+     * @return The message, or nothing once the predecessor closed the connection.
+     */
+    std::optional<HandoffUpdate> receive_update();
+
+    /**
+     * @brief Reads the successor's opening message (predecessor side).
+     * @throws std::runtime_error if the peer is not a successor speaking this version.
+     */
+    void accept_successor();
+
+    /**
+     * @brief Sends the state and the listening socket (predecessor side).
+     * @param state The state.
+     * @throws std::runtime_error if the successor is gone.
+     */
+    void send_state(const HandoffState& state);
+
+    /**
+     * @brief Tells the successor a held user is released, with the user's multipart uploads (predecessor side).
+     * @param user_id The user ID.
+     * @param uploads The user's uploads in progress.
+     * @throws std::runtime_error if the successor is gone.
+     */
+    void send_release(uint32_t user_id, const std::vector<UploadState>& uploads);
+
+    /**
+     * @brief Passes a save or delete to the successor's replication (predecessor side).
+     * @param op_code SAVE_FILE or DELETE_FILE.
+     * @param user_id The user owning the file.
+     * @param filename The file.
+     * @throws std::runtime_error if the successor is gone.
+     */
+    void send_replication(Command op_code, uint32_t user_id, const std::string& filename);
+
+    /**
+     * @brief Tells the successor the predecessor has drained (predecessor side).
+     * @throws std::runtime_error if the successor is gone.
+     */
+    void send_done();
+
+private:
+    /**
+     * @brief Sends lines in one piece, so lines sent from other threads cannot come between them.
+     * @param lines The lines, each ending with a newline.
+     * @param passed A descriptor to pass along (-1: none).
+     * @throws std::runtime_error on error.
+     */
+    void send_lines(const std::string& lines, int passed = -1);
+
+    /**
+     * @brief Receives one line, keeping any descriptor passed along in 'passed_'.
+     * @return The line without its newline, or nothing once the connection closed.
+     * @throws std::runtime_error on error.
+     */
+    std::optional<std::string> receive_line();
+
+    /**
+     * @brief Formats an upload as an "upload" line.
+     * @param upload The upload.
+     * @return The line.
+     */
+    static std::string format_upload(const UploadState& upload);
+
+    /**
+     * @brief Parses the fields of an "upload" line following the keyword.
+     * @param fields The rest of the line.
+     * @return The upload, or nothing if malformed.
+     */
+    static std::optional<UploadState> parse_upload(const std::string& fields);
+
+    int descriptor_;                ///< The connected socket.
+    int passed_ = -1;               ///< The descriptor received last (taken over by take_over()).
+    std::string received_;          ///< Bytes received past the last complete line.
+    std::mutex send_mutex_;         ///< Keeps the lines sent from several threads whole.
+};
+
+/**
+ * @class HandoffListener
+ * @brief The Unix domain socket a running server waits on for the process replacing it.
+ * @details Whoever connects takes the server over, so the socket is accessible to the server's own user only.
+ */
+class HandoffListener {
+public:
+    /**
+     * @brief Listens on a path, replacing the socket a previous process left there.
+     * @param path The socket's path.
+     * @throws std::runtime_error if the socket cannot be created.
+     */
+    explicit HandoffListener(std::string path);
+
+    /**
+     * @brief Stops listening (the path is left to the successor, which binds it again).
+     */
+    ~HandoffListener();
+
+    HandoffListener(const HandoffListener&) = delete;
+    HandoffListener& operator=(const HandoffListener&) = delete;
+
+    /**
+     * @brief Waits for a successor to connect.
+     * @return The connection, or null if the listener failed or was closed.
+     */
+    std::shared_ptr<HandoffChannel> accept();
+
+    /**
+     * @brief Stops listening, waking a thread waiting in accept().
+     */
+    void close();
+
+private:
+    std::string path_;                      ///< The socket's path.
+    std::atomic<int> descriptor_{ -1 };     ///< The listening socket (-1 once closed).
+};
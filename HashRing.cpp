@@ -0,0 +1,79 @@
+/**
+ * @file HashRing.cpp
+ * @brief HashRing class implementation.
+ * @details This file contains the implementation of the consistent hashing ring.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "HashRing.h"
+
+namespace
+{
+    const std::string NO_OWNER;
+}
+
+HashRing::HashRing(const std::vector<std::string>& nodes)
+{
+    for (const auto& node : nodes)
+    {
+        add_node(node);
+    }
+}
+
+void HashRing::add_node(const std::string& node)
+{
+    nodes_.push_back(node);
+    for (unsigned i = 0; i < VIRTUAL_NODES_PER_NODE; ++i)
+    {
+        const std::string point = node + "#" + std::to_string(i);
+        ring_.emplace(hash(point.data(), point.size()), nodes_.size() - 1);
+    }
+}
+
+const std::string& HashRing::owner(const uint32_t user_id) const
+{
+    if (ring_.empty())
+    {
+        return NO_OWNER;
+    }
+
+    // The first ring point at or after the user's position owns it (wrapping around); hashed as little-endian
+    // bytes so every node computes the same owner
+    const unsigned char key[4] = {
+        static_cast<unsigned char>(user_id), static_cast<unsigned char>(user_id >> 8),
+        static_cast<unsigned char>(user_id >> 16), static_cast<unsigned char>(user_id >> 24)
+    };
+    auto it = ring_.lower_bound(hash(key, sizeof(key)));
+    if (it == ring_.end())
+    {
+        it = ring_.begin();
+    }
+    return nodes_[it->second];
+}
+
+const std::vector<std::string>& HashRing::nodes() const
+{
+    return nodes_;
+}
+
+uint64_t HashRing::hash(const void* data, const size_t size)
+{
+    // FNV-1a followed by a 64-bit finalizer, so that consecutive user IDs spread over the whole ring
+    uint64_t h = 14695981039346656037ull;
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb3f97a56e3fbull;
+    h ^= h >> 33;
+    return h;
+}
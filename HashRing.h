@@ -0,0 +1,71 @@
+/**
+ * @file HashRing.h
+ * @brief HashRing class definition.
+ * @details This header file contains the HashRing class, a consistent hashing ring mapping user IDs to cluster nodes.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+constexpr unsigned VIRTUAL_NODES_PER_NODE = 128; // ring points per node, evening out the share each node owns
+
+/**
+ * @class HashRing
+ * @brief Consistent hashing ring: each node owns the ranges of hashed user IDs preceding its virtual points.
+ * @details Adding a node only moves the users that fall into the new node's ranges; all other users keep their owner.
+ */
+class HashRing {
+public:
+    /**
+     * @brief Constructs a ring over the given nodes.
+     * @param nodes The node addresses ("host:port").
+     */
+    explicit HashRing(const std::vector<std::string>& nodes = {});
+
+    /**
+     * @brief Adds a node to the ring.
+     * @param node The node address ("host:port").
+     */
+    void add_node(const std::string& node);
+
+    /**
+     * @brief Returns the node owning a user.
+     * @param user_id The user ID.
+     * @return The owner's address, or an empty string if the ring is empty.
+     */
+    const std::string& owner(uint32_t user_id) const;
+
+    /**
+     * @brief Returns the nodes in the ring.
+     * @return The node addresses.
+     */
+    const std::vector<std::string>& nodes() const;
+
+private:
+    /**
+     * @brief Hashes a key onto the ring.
+     * @param data The key.
+     * @param size The key length.
+     * @return The ring position.
+     */
+    static uint64_t hash(const void* data, size_t size);
+
+    /**
+     * @brief The node addresses.
+     */
+    std::vector<std::string> nodes_;
+
+    /**
+     * @brief Ring position -> index into 'nodes_'.
+     */
+    std::map<uint64_t, size_t> ring_;
+};
@@ -0,0 +1,637 @@
+/**
+ * @file IoPolicy.cpp
+ * @brief IoPolicy, OutputFile and InputFile class implementation.
+ * @details This file contains the implementation of preallocation, page cache hints, direct I/O and sparse writes
+ *          for standalone files.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "IoPolicy.h"
+#include "ZeroBlocks.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <tuple>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifndef _WIN32
+    /**
+     * @brief Rounds a size up to the direct I/O alignment.
+     */
+    size_t align_up(const size_t size)
+    {
+        return (size + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    }
+
+    /**
+     * @brief Makes sure 'buffer' is an aligned buffer of at least 'size' bytes.
+     */
+    bool reserve_aligned(std::unique_ptr<unsigned char, void (*)(void*)>& buffer, size_t& capacity, const size_t size)
+    {
+        if (buffer && capacity >= size)
+        {
+            return true;
+        }
+        void* memory = nullptr;
+        if (posix_memalign(&memory, DIRECT_IO_ALIGNMENT, align_up(size)) != 0)
+        {
+            return false;
+        }
+        buffer.reset(static_cast<unsigned char*>(memory));
+        capacity = align_up(size);
+        return true;
+    }
+
+    /**
+     * @brief Opens a file, with O_DIRECT if requested and supported (e.g. tmpfs refuses it).
+     * @return The descriptor (-1 on error) and whether O_DIRECT is in effect.
+     */
+    std::pair<int, bool> open_file(const std::string& path, const int flags, const bool direct)
+    {
+#ifdef O_DIRECT
+        if (direct)
+        {
+            if (const int fd = ::open(path.c_str(), flags | O_DIRECT, 0644); fd >= 0)
+            {
+                return { fd, true };
+            }
+        }
+#endif
+        return { ::open(path.c_str(), flags, 0644), false };
+    }
+
+    /**
+     * @brief Turns O_DIRECT off for the rest of a transfer (for an unaligned tail).
+     */
+    void stop_direct_io(const int fd, bool& direct)
+    {
+#ifdef O_DIRECT
+        if (direct)
+        {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+        }
+#endif
+        direct = false;
+    }
+
+    /**
+     * @brief Starts writing a range of a file to disk, and waits for it if 'wait' is set.
+     */
+    void flush_range(const int fd, const uint64_t offset, const uint64_t length, const bool wait)
+    {
+#ifdef __linux__
+        sync_file_range(fd, static_cast<off_t>(offset), static_cast<off_t>(length),
+            wait ? SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER
+                 : SYNC_FILE_RANGE_WRITE);
+#else
+        if (wait)
+        {
+            fsync(fd);
+        }
+#endif
+    }
+
+    /**
+     * @brief Drops the clean pages of a range of a file from the page cache (length 0 means up to the end).
+     */
+    void drop_range(const int fd, const uint64_t offset, const uint64_t length)
+    {
+#ifdef POSIX_FADV_DONTNEED
+        posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_DONTNEED);
+#endif
+    }
+
+    /**
+     * @brief Deallocates a range of a file, which then reads as zeros, without changing its size.
+     * @return True if the filesystem punched the hole.
+     */
+    bool punch_hole(const int fd, const uint64_t offset, const uint64_t length)
+    {
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+        return fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+            static_cast<off_t>(length)) == 0;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Measures the run of blocks at the start of 'data' that are all zeros, or that all hold data.
+     * @details Blocks follow the file's SPARSE_BLOCK_SIZE boundaries from 'offset'; a partial block always holds data.
+     * @param data The data.
+     * @param size The number of bytes.
+     * @param offset The offset of 'data' in the file.
+     * @param zeros Set to whether the run is made of zero blocks.
+     * @return The length of the run in bytes.
+     */
+    size_t block_run(const unsigned char* data, const size_t size, const uint64_t offset, bool& zeros)
+    {
+        size_t run = 0;
+        while (run < size)
+        {
+            const size_t block = std::min<size_t>(SPARSE_BLOCK_SIZE - (offset + run) % SPARSE_BLOCK_SIZE, size - run);
+            const bool zero = block == SPARSE_BLOCK_SIZE && is_zero_block(data + run, block);
+            if (run == 0)
+            {
+                zeros = zero;
+            }
+            else if (zero != zeros)
+            {
+                break;
+            }
+            run += block;
+        }
+        return run;
+    }
+#endif
+}
+
+IoPolicy::IoPolicy(const IoPolicyConfig& config)
+    : config_(config)
+{
+}
+
+const IoPolicyConfig& IoPolicy::config() const
+{
+    return config_;
+}
+
+std::string IoPolicy::describe() const
+{
+    std::ostringstream out;
+    out << "preallocation " << (config_.preallocate ? "on" : "off") << ", fadvise " << (config_.fadvise ? "on" : "off")
+        << ", direct I/O ";
+    if (config_.direct_io_threshold > 0)
+    {
+        out << "from " << config_.direct_io_threshold << " bytes";
+    }
+    else
+    {
+        out << "off";
+    }
+    out << ", sparse " << (config_.sparse ? "on" : "off") << " (" << hole_bytes_.load() / (1024 * 1024)
+        << " MB of zero blocks not written)";
+    return out.str();
+}
+
+void IoPolicy::record_hole(const uint64_t bytes) const
+{
+    hole_bytes_ += bytes;
+}
+
+uint64_t IoPolicy::hole_bytes() const
+{
+    return hole_bytes_.load();
+}
+
+#ifdef _WIN32
+
+OutputFile::OutputFile(const IoPolicy& policy, const std::string& path, const uint64_t expected_size,
+                       const bool exclusive)
+    : policy_(policy), expected_size_(expected_size)
+{
+    // std::ofstream cannot create exclusively; checking first leaves only a narrow window
+    if (std::error_code ec; !exclusive || !std::filesystem::exists(path, ec))
+    {
+        ofs_.open(path, std::ios::binary);
+    }
+}
+
+OutputFile::~OutputFile() = default;
+
+bool OutputFile::is_open() const
+{
+    return ofs_.is_open();
+}
+
+bool OutputFile::write(const unsigned char* data, const size_t size)
+{
+    failed_ = failed_ || !ofs_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    written_ += size;
+    return !failed_;
+}
+
+bool OutputFile::close()
+{
+    ofs_.close();
+    return !failed_ && static_cast<bool>(ofs_);
+}
+
+RandomAccessFile::RandomAccessFile(const IoPolicy& policy, const std::string& path, const uint64_t size,
+                                   const bool reopen)
+    : policy_(policy), size_(size),
+    fs_(path, reopen ? std::ios::binary | std::ios::in | std::ios::out
+                     : std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc)
+{
+}
+
+RandomAccessFile::~RandomAccessFile() = default;
+
+bool RandomAccessFile::is_open() const
+{
+    return fs_.is_open();
+}
+
+bool RandomAccessFile::write_at(const uint64_t offset, const unsigned char* data, const size_t size)
+{
+    std::lock_guard lock(mutex_);
+    fs_.seekp(static_cast<std::streamoff>(offset));
+    return static_cast<bool>(fs_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size)));
+}
+
+bool RandomAccessFile::close()
+{
+    std::lock_guard lock(mutex_);
+    fs_.close();
+    return static_cast<bool>(fs_);
+}
+
+InputFile::InputFile(const IoPolicy& policy, const std::string& path)
+    : policy_(policy), ifs_(path, std::ios::binary | std::ios::ate)
+{
+    if (ifs_.is_open())
+    {
+        size_ = static_cast<uint64_t>(ifs_.tellg());
+        ifs_.seekg(0, std::ios::beg);
+    }
+}
+
+InputFile::~InputFile() = default;
+
+bool InputFile::is_open() const
+{
+    return ifs_.is_open();
+}
+
+uint64_t InputFile::size() const
+{
+    return size_;
+}
+
+bool InputFile::read(unsigned char* out, const size_t size)
+{
+    read_ += size;
+    return static_cast<bool>(ifs_.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(size)));
+}
+
+#else
+
+OutputFile::OutputFile(const IoPolicy& policy, const std::string& path, const uint64_t expected_size,
+                       const bool exclusive)
+    : policy_(policy), expected_size_(expected_size), bounce_(nullptr, std::free)
+{
+    const IoPolicyConfig& config = policy_.config();
+    const bool direct = config.direct_io_threshold > 0 && expected_size >= config.direct_io_threshold;
+    std::tie(fd_, direct_) = open_file(path, O_WRONLY | O_CREAT | (exclusive ? O_EXCL : O_TRUNC), direct);
+    if (fd_ < 0)
+    {
+        return;
+    }
+
+#ifdef __linux__
+    // Reserve the extents up front; filesystems without fallocate just allocate as the data arrives
+    if (config.preallocate && expected_size > 0)
+    {
+        preallocated_ = fallocate(fd_, 0, 0, static_cast<off_t>(expected_size)) == 0;
+    }
+#endif
+}
+
+OutputFile::~OutputFile()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+}
+
+bool OutputFile::is_open() const
+{
+    return fd_ >= 0;
+}
+
+bool OutputFile::write(const unsigned char* data, const size_t size)
+{
+    if (failed_)
+    {
+        return false;
+    }
+
+    // The file starts out empty, so zero blocks are simply skipped: they read back as zeros
+    for (size_t done = 0; done < size;)
+    {
+        bool zeros = false;
+        const size_t run = policy_.config().sparse ? block_run(data + done, size - done, written_, zeros) : size - done;
+        if (zeros)
+        {
+            // A file with holes cannot stay preallocated: give back the rest of the reservation in one go
+            if (preallocated_)
+            {
+                punch_hole(fd_, written_, expected_size_ > written_ ? expected_size_ - written_ : run);
+                preallocated_ = false;
+            }
+            policy_.record_hole(run);
+            written_ += run;
+        }
+        else if (!write_data(data + done, run))
+        {
+            return false;
+        }
+        ends_in_hole_ = zeros;
+        done += run;
+    }
+
+    // Stream large files through the cache: flush and drop the window before last, keeping the disk busy meanwhile
+    if (!direct_ && policy_.config().fadvise && expected_size_ >= STREAMING_THRESHOLD &&
+        written_ >= dropped_ + 2 * WRITEBACK_WINDOW)
+    {
+        flush_range(fd_, dropped_ + WRITEBACK_WINDOW, WRITEBACK_WINDOW, false);
+        flush_range(fd_, dropped_, WRITEBACK_WINDOW, true);
+        drop_range(fd_, dropped_, WRITEBACK_WINDOW);
+        dropped_ += WRITEBACK_WINDOW;
+    }
+    return true;
+}
+
+bool OutputFile::write_data(const unsigned char* data, const size_t size)
+{
+    // Direct writes need an aligned buffer and length; an unaligned tail goes through the page cache
+    const unsigned char* source = data;
+    if (direct_)
+    {
+        if (size % DIRECT_IO_ALIGNMENT != 0 || written_ % DIRECT_IO_ALIGNMENT != 0 ||
+            !reserve_aligned(bounce_, bounce_size_, size))
+        {
+            stop_direct_io(fd_, direct_);
+        }
+        else
+        {
+            std::memcpy(bounce_.get(), data, size);
+            source = bounce_.get();
+        }
+    }
+
+    for (size_t done = 0; done < size;)
+    {
+        const ssize_t n = ::pwrite(fd_, source + done, size - done, static_cast<off_t>(written_ + done));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            failed_ = true;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    written_ += size;
+    return true;
+}
+
+bool OutputFile::close()
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+
+    // Give back whatever was preallocated beyond the data actually written, and extend a file ending in a hole
+    if (((policy_.config().preallocate && written_ < expected_size_) || ends_in_hole_) &&
+        ftruncate(fd_, static_cast<off_t>(written_)) != 0)
+    {
+        failed_ = true;
+    }
+
+    // Start writing the rest without waiting for it; whatever is already clean leaves the cache now
+    if (!direct_ && policy_.config().fadvise && expected_size_ >= STREAMING_THRESHOLD)
+    {
+        flush_range(fd_, dropped_, written_ - dropped_, false);
+        drop_range(fd_, dropped_, written_ - dropped_);
+    }
+
+    const bool closed = ::close(fd_) == 0;
+    fd_ = -1;
+    return closed && !failed_;
+}
+
+InputFile::InputFile(const IoPolicy& policy, const std::string& path)
+    : policy_(policy), bounce_(nullptr, std::free)
+{
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0)
+    {
+        return;
+    }
+    size_ = static_cast<uint64_t>(st.st_size);
+
+    const IoPolicyConfig& config = policy_.config();
+    const bool direct = config.direct_io_threshold > 0 && size_ >= config.direct_io_threshold;
+    std::tie(fd_, direct_) = open_file(path, O_RDONLY, direct);
+
+    // Fewer blocks than the size calls for means holes, which need not be read at all
+    sparse_ = !direct_ && static_cast<uint64_t>(st.st_blocks) * 512 < size_;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (fd_ >= 0 && !direct_ && config.fadvise)
+    {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+}
+
+InputFile::~InputFile()
+{
+    if (fd_ < 0)
+    {
+        return;
+    }
+    if (!direct_ && policy_.config().fadvise && size_ >= STREAMING_THRESHOLD)
+    {
+        drop_range(fd_, dropped_, 0);
+    }
+    ::close(fd_);
+}
+
+bool InputFile::is_open() const
+{
+    return fd_ >= 0;
+}
+
+uint64_t InputFile::size() const
+{
+    return size_;
+}
+
+bool InputFile::read(unsigned char* out, const size_t size)
+{
+    // Direct reads go through an aligned buffer; the kernel stops them at the end of the file
+    if (direct_ && (read_ % DIRECT_IO_ALIGNMENT != 0 || !reserve_aligned(bounce_, bounce_size_, size)))
+    {
+        stop_direct_io(fd_, direct_);
+    }
+    unsigned char* target = direct_ ? bounce_.get() : out;
+    const size_t request = direct_ ? align_up(size) : size;
+
+    size_t done = 0;
+    while (done < size)
+    {
+        // Fill the holes of a sparse file with zeros instead of reading zero pages into the cache
+        const uint64_t offset = read_ + done;
+        if (sparse_ && offset >= data_end_)
+        {
+            locate_data(offset);
+        }
+        if (sparse_ && offset < data_start_)
+        {
+            const size_t zeros = static_cast<size_t>(std::min<uint64_t>(size - done, data_start_ - offset));
+            std::memset(out + done, 0, zeros);
+            done += zeros;
+            continue;
+        }
+        const size_t limit = sparse_ && offset < data_end_
+            ? static_cast<size_t>(std::min<uint64_t>(request - done, data_end_ - offset)) : request - done;
+
+        const ssize_t n = ::pread(fd_, target + done, limit, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    if (direct_)
+    {
+        std::memcpy(out, bounce_.get(), size);
+    }
+    read_ += size;
+
+    // A large file read once should not push the hot small files out of the cache
+    if (!direct_ && policy_.config().fadvise && size_ >= STREAMING_THRESHOLD && read_ >= dropped_ + WRITEBACK_WINDOW)
+    {
+        drop_range(fd_, dropped_, read_ - dropped_);
+        dropped_ = read_;
+    }
+    return true;
+}
+
+void InputFile::locate_data(const uint64_t offset)
+{
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    // Without more data the rest of the file is a hole; filesystems without hole support report the file as data
+    const off_t start = lseek(fd_, static_cast<off_t>(offset), SEEK_DATA);
+    const off_t end = start >= 0 ? lseek(fd_, start, SEEK_HOLE) : -1;
+    data_start_ = start >= 0 ? static_cast<uint64_t>(start) : size_;
+    data_end_ = end >= 0 ? static_cast<uint64_t>(end) : size_;
+#else
+    data_start_ = offset;
+    data_end_ = size_;
+#endif
+}
+
+RandomAccessFile::RandomAccessFile(const IoPolicy& policy, const std::string& path, const uint64_t size,
+                                   const bool reopen)
+    : policy_(policy), size_(size)
+{
+    fd_ = ::open(path.c_str(), reopen ? O_RDWR : O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0 || reopen)
+    {
+        return;
+    }
+
+    // Parts arrive out of order; reserving the extents up front keeps the file contiguous anyway
+    if (ftruncate(fd_, static_cast<off_t>(size)) != 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return;
+    }
+#ifdef __linux__
+    if (policy_.config().preallocate && size > 0)
+    {
+        fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+    }
+#endif
+}
+
+RandomAccessFile::~RandomAccessFile()
+{
+    close();
+}
+
+bool RandomAccessFile::is_open() const
+{
+    return fd_ >= 0;
+}
+
+bool RandomAccessFile::write_at(const uint64_t offset, const unsigned char* data, const size_t size)
+{
+    for (size_t done = 0; done < size;)
+    {
+        // A part sent again may overwrite data, so zero blocks are punched out rather than skipped; written if that fails
+        bool zeros = false;
+        const size_t run = policy_.config().sparse ? block_run(data + done, size - done, offset + done, zeros) : size - done;
+        if (zeros && punch_hole(fd_, offset + done, run))
+        {
+            policy_.record_hole(run);
+            done += run;
+            continue;
+        }
+
+        for (const size_t end = done + run; done < end;)
+        {
+            const ssize_t n = ::pwrite(fd_, data + done, end - done, static_cast<off_t>(offset + done));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+    }
+
+    // Start writing the part to disk now, so closing a large upload does not leave gigabytes of dirty pages
+    if (policy_.config().fadvise && size_ >= STREAMING_THRESHOLD)
+    {
+        flush_range(fd_, offset, size, false);
+    }
+    return true;
+}
+
+bool RandomAccessFile::close()
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    if (policy_.config().fadvise && size_ >= STREAMING_THRESHOLD)
+    {
+        drop_range(fd_, 0, 0);
+    }
+    const bool closed = ::close(fd_) == 0;
+    fd_ = -1;
+    return closed;
+}
+
+#endif
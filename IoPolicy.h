@@ -0,0 +1,284 @@
+/**
+ * @file IoPolicy.h
+ * @brief IoPolicy, OutputFile and InputFile class definitions.
+ * @details This header file contains the I/O policy applied to standalone files: preallocation of files whose size is
+ *          known up front, page cache hints for large one-time transfers, and optional direct I/O for very large files.
+ *          Files are written sequentially (OutputFile) or, for multipart uploads, at arbitrary offsets (RandomAccessFile).
+ *          All-zero blocks are left as holes rather than written, and read back without touching the disk.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+constexpr uint64_t STREAMING_THRESHOLD = 8 * 1024 * 1024;   // files at least this large are kept out of the page cache
+constexpr uint64_t WRITEBACK_WINDOW = 8 * 1024 * 1024;      // large writes are flushed and dropped from the cache in windows of this size
+constexpr size_t DIRECT_IO_ALIGNMENT = 4096;                // buffer, offset and length alignment required by O_DIRECT
+constexpr size_t SPARSE_BLOCK_SIZE = 4096;                  // all-zero blocks of this size (at aligned offsets) are left as holes
+
+/**
+ * @struct IoPolicyConfig
+ * @brief Which I/O optimizations are applied to standalone files.
+ */
+struct IoPolicyConfig {
+    bool preallocate = true;            ///< Reserve a file's full size before writing it, so large backups are not fragmented.
+    bool fadvise = true;                ///< Hint sequential access, and drop files of STREAMING_THRESHOLD or more from the page cache.
+    uint64_t direct_io_threshold = 0;   ///< Files at least this large bypass the page cache with O_DIRECT (0 disables).
+    bool sparse = true;                 ///< Leave holes instead of writing all-zero blocks.
+};
+
+/**
+ * @class IoPolicy
+ * @brief The I/O optimizations applied to standalone files.
+ * @details Large backups are written once and rarely read, so letting them through the page cache only evicts the
+ *          small files that are read often. The policy keeps them out of it: either with direct I/O, or by flushing
+ *          and dropping them window by window as they are written and read. Backups of VM images and databases are
+ *          mostly zeros: those blocks are not written at all but punched out as holes. Each optimization can be turned
+ *          off and is skipped silently where the platform or filesystem does not support it.
+ */
+class IoPolicy {
+public:
+    /**
+     * @brief Constructs an IoPolicy.
+     * @param config The optimizations to apply.
+     */
+    explicit IoPolicy(const IoPolicyConfig& config = {});
+
+    /**
+     * @brief Returns the optimizations applied.
+     * @return The configuration.
+     */
+    const IoPolicyConfig& config() const;
+
+    /**
+     * @brief Describes the optimizations applied, and the zero bytes not written, as text.
+     * @return The description.
+     */
+    std::string describe() const;
+
+    /**
+     * @brief Counts zero bytes left as holes instead of being written.
+     * @param bytes The number of bytes.
+     */
+    void record_hole(uint64_t bytes) const;
+
+    /**
+     * @brief Returns the number of zero bytes left as holes so far.
+     * @return The number of bytes.
+     */
+    uint64_t hole_bytes() const;
+
+private:
+    /**
+     * @brief The optimizations applied.
+     */
+    IoPolicyConfig config_;
+
+    /**
+     * @brief Zero bytes left as holes so far.
+     */
+    mutable std::atomic<uint64_t> hole_bytes_{ 0 };
+};
+
+/**
+ * @class OutputFile
+ * @brief A file being written sequentially under an IoPolicy.
+ */
+class OutputFile {
+public:
+    /**
+     * @brief Creates (or truncates) a file and preallocates its expected size.
+     * @param policy The I/O policy.
+     * @param path The file path.
+     * @param expected_size The number of bytes that will be written.
+     * @param exclusive Fail (is_open() false) if the file exists instead of truncating it.
+     */
+    OutputFile(const IoPolicy& policy, const std::string& path, uint64_t expected_size, bool exclusive = false);
+
+    /**
+     * @brief Closes the file if close() was not called.
+     */
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    /**
+     * @brief Tells whether the file was opened.
+     * @return True if the file is open.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Appends data to the file; all-zero blocks are skipped, leaving holes, if the policy is sparse.
+     * @param data The data.
+     * @param size The number of bytes.
+     * @return True on success; false on error.
+     */
+    bool write(const unsigned char* data, size_t size);
+
+    /**
+     * @brief Closes the file, releasing any preallocated space that was not written.
+     * @return True if every write and the close succeeded.
+     */
+    bool close();
+
+private:
+    /**
+     * @brief Writes data at the end of the file.
+     * @param data The data.
+     * @param size The number of bytes.
+     * @return True on success; false on error.
+     */
+    bool write_data(const unsigned char* data, size_t size);
+
+    const IoPolicy& policy_;            ///< The I/O policy.
+    uint64_t expected_size_;            ///< The size announced when the file was created.
+    uint64_t written_ = 0;              ///< Bytes written so far.
+    uint64_t dropped_ = 0;              ///< Bytes already flushed and dropped from the page cache.
+    bool failed_ = false;               ///< Set when a write failed.
+#ifdef _WIN32
+    std::ofstream ofs_;                 ///< The file (no hints are available on this platform).
+#else
+    bool preallocated_ = false;         ///< Whether the rest of the file is still reserved (released at the first hole).
+    bool ends_in_hole_ = false;         ///< Whether the last bytes were skipped zeros, so the file must be extended.
+    int fd_ = -1;                       ///< The file descriptor.
+    bool direct_ = false;               ///< Whether the file is currently written with O_DIRECT.
+    std::unique_ptr<unsigned char, void (*)(void*)> bounce_; ///< Aligned buffer for direct writes.
+    size_t bounce_size_ = 0;            ///< Capacity of the bounce buffer.
+#endif
+};
+
+/**
+ * @class InputFile
+ * @brief A file being read sequentially under an IoPolicy.
+ */
+class InputFile {
+public:
+    /**
+     * @brief Opens a file and announces a sequential read.
+     * @param policy The I/O policy.
+     * @param path The file path.
+     */
+    InputFile(const IoPolicy& policy, const std::string& path);
+
+    /**
+     * @brief Closes the file, dropping it from the page cache if it is large.
+     */
+    ~InputFile();
+
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+
+    /**
+     * @brief Tells whether the file was opened.
+     * @return True if the file is open.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Returns the size of the file.
+     * @return The size in bytes.
+     */
+    uint64_t size() const;
+
+    /**
+     * @brief Reads the next bytes of the file; the holes of a sparse file are filled with zeros without reading them.
+     * @param out The buffer receiving the data.
+     * @param size The number of bytes to read.
+     * @return True if 'size' bytes were read; false on error or end of file.
+     */
+    bool read(unsigned char* out, size_t size);
+
+private:
+#ifndef _WIN32
+    /**
+     * @brief Finds the data extent at or after an offset (SEEK_DATA/SEEK_HOLE) and stores it in 'data_start_' and 'data_end_'.
+     * @param offset The offset.
+     */
+    void locate_data(uint64_t offset);
+#endif
+
+    const IoPolicy& policy_;            ///< The I/O policy.
+    uint64_t size_ = 0;                 ///< The size of the file.
+    uint64_t read_ = 0;                 ///< Bytes read so far.
+    uint64_t dropped_ = 0;              ///< Bytes already dropped from the page cache.
+#ifdef _WIN32
+    std::ifstream ifs_;                 ///< The file (no hints are available on this platform).
+#else
+    int fd_ = -1;                       ///< The file descriptor.
+    bool direct_ = false;               ///< Whether the file is read with O_DIRECT.
+    std::unique_ptr<unsigned char, void (*)(void*)> bounce_; ///< Aligned buffer for direct reads.
+    size_t bounce_size_ = 0;            ///< Capacity of the bounce buffer.
+    bool sparse_ = false;               ///< Whether the file has holes (fewer blocks allocated than its size).
+    uint64_t data_start_ = 0;           ///< Start of the current data extent of a sparse file.
+    uint64_t data_end_ = 0;             ///< End of the current data extent of a sparse file.
+#endif
+};
+
+/**
+ * @class RandomAccessFile
+ * @brief A preallocated file written at arbitrary offsets, possibly by several threads at once (multipart uploads).
+ * @details Writes of large files start their writeback right away, and the file is dropped from the page cache when it
+ *          is closed. All-zero blocks are punched out as holes. Direct I/O is not used: parts may end anywhere.
+ */
+class RandomAccessFile {
+public:
+    /**
+     * @brief Creates (or truncates) a file and preallocates its size, or reopens one created earlier.
+     * @param policy The I/O policy.
+     * @param path The file path.
+     * @param size The final size of the file.
+     * @param reopen Open the existing file as it is (e.g. an upload taken over from a previous process).
+     */
+    RandomAccessFile(const IoPolicy& policy, const std::string& path, uint64_t size, bool reopen = false);
+
+    /**
+     * @brief Closes the file if close() was not called.
+     */
+    ~RandomAccessFile();
+
+    RandomAccessFile(const RandomAccessFile&) = delete;
+    RandomAccessFile& operator=(const RandomAccessFile&) = delete;
+
+    /**
+     * @brief Tells whether the file was opened.
+     * @return True if the file is open.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Writes data at an offset; safe to call from several threads for different ranges.
+     * @param offset The offset in the file.
+     * @param data The data.
+     * @param size The number of bytes.
+     * @return True on success; false on error.
+     */
+    bool write_at(uint64_t offset, const unsigned char* data, size_t size);
+
+    /**
+     * @brief Closes the file.
+     * @return True if the close succeeded.
+     */
+    bool close();
+
+private:
+    const IoPolicy& policy_;            ///< The I/O policy.
+    uint64_t size_;                     ///< The final size of the file.
+#ifdef _WIN32
+    std::mutex mutex_;                  ///< Serializes seeks and writes.
+    std::fstream fs_;                   ///< The file (no hints are available on this platform).
+#else
+    int fd_ = -1;                       ///< The file descriptor.
+#endif
+};
@@ -0,0 +1,157 @@
+/**
+ * @file LockTable.cpp
+ * @brief LockTable class implementation.
+ * @details This file contains the implementation of the reader/writer lock manager keyed by user and filename.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "LockTable.h"
+
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <utility>
+
+using std::chrono::steady_clock;
+
+namespace
+{
+    /**
+     * @brief Formats the counters of one kind of lock.
+     */
+    template <typename Counters>
+    void report_counters(std::ostringstream& out, const char* kind, const Counters& counters)
+    {
+        out << "  " << kind << ":";
+        for (const auto mode : { LockMode::SHARED, LockMode::EXCLUSIVE })
+        {
+            const auto& c = counters[static_cast<size_t>(mode)];
+            out << (mode == LockMode::SHARED ? " shared " : ", exclusive ") << c.acquired.load() << " ("
+                << c.contended.load() << " waited, " << c.wait_us.load() / 1000 << " ms)";
+        }
+        out << "\n";
+    }
+}
+
+LockTable::Guard::Guard(LockTable* table, std::string key, Entry* entry, const LockMode mode)
+    : table_(table), key_(std::move(key)), entry_(entry), mode_(mode)
+{
+}
+
+LockTable::Guard::~Guard()
+{
+    release();
+}
+
+LockTable::Guard::Guard(Guard&& other) noexcept
+    : table_(other.table_), key_(std::move(other.key_)), entry_(other.entry_), mode_(other.mode_)
+{
+    other.entry_ = nullptr;
+}
+
+LockTable::Guard& LockTable::Guard::operator=(Guard&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        table_ = other.table_;
+        key_ = std::move(other.key_);
+        entry_ = other.entry_;
+        mode_ = other.mode_;
+        other.entry_ = nullptr;
+    }
+    return *this;
+}
+
+void LockTable::Guard::release()
+{
+    if (entry_ != nullptr)
+    {
+        table_->release(key_, entry_, mode_);
+        entry_ = nullptr;
+    }
+}
+
+LockTable::Guard LockTable::lock_file(const uint32_t user_id, const std::string& filename, const LockMode mode)
+{
+    return acquire("f" + std::to_string(user_id) + "/" + filename, mode, file_counters_);
+}
+
+LockTable::Guard LockTable::lock_user(const uint32_t user_id, const LockMode mode)
+{
+    return acquire("u" + std::to_string(user_id), mode, user_counters_);
+}
+
+std::string LockTable::report() const
+{
+    std::ostringstream out;
+    out << "locks:\n";
+    report_counters(out, "files", file_counters_);
+    report_counters(out, "namespaces", user_counters_);
+    return out.str();
+}
+
+LockTable::Guard LockTable::acquire(std::string key, const LockMode mode, std::array<Counters, 2>& counters)
+{
+    Entry* entry;
+    {
+        Bucket& b = bucket(key);
+        std::lock_guard lock(b.mutex);
+        auto& slot = b.entries[key];
+        if (!slot)
+        {
+            slot = std::make_unique<Entry>();
+        }
+        entry = slot.get();
+        ++entry->references;
+    }
+
+    // Only locks that are actually held by someone else count as contended
+    Counters& c = counters[static_cast<size_t>(mode)];
+    const bool acquired = mode == LockMode::SHARED ? entry->mutex.try_lock_shared() : entry->mutex.try_lock();
+    if (!acquired)
+    {
+        const auto started = steady_clock::now();
+        if (mode == LockMode::SHARED)
+        {
+            entry->mutex.lock_shared();
+        }
+        else
+        {
+            entry->mutex.lock();
+        }
+        ++c.contended;
+        c.wait_us += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - started).count());
+    }
+    ++c.acquired;
+    return Guard(this, std::move(key), entry, mode);
+}
+
+void LockTable::release(const std::string& key, Entry* entry, const LockMode mode)
+{
+    if (mode == LockMode::SHARED)
+    {
+        entry->mutex.unlock_shared();
+    }
+    else
+    {
+        entry->mutex.unlock();
+    }
+
+    Bucket& b = bucket(key);
+    std::lock_guard lock(b.mutex);
+    if (--entry->references == 0)
+    {
+        b.entries.erase(key);
+    }
+}
+
+LockTable::Bucket& LockTable::bucket(const std::string& key)
+{
+    return buckets_[std::hash<std::string>{}(key) % LOCK_TABLE_BUCKETS];
+}
@@ -0,0 +1,182 @@
+/**
+ * @file LockTable.h
+ * @brief LockTable class definition.
+ * @details This header file contains the LockTable class, a reader/writer lock manager keyed by user and filename
+ *          that coordinates concurrent saves, restores and deletes of the same file.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+constexpr size_t LOCK_TABLE_BUCKETS = 256; // hash buckets of the lock table, each guarded by its own mutex
+
+/**
+ * @enum LockMode
+ * @brief How a lock is held.
+ */
+enum class LockMode {
+    SHARED,     ///< Many holders at once (restores, snapshots, verification).
+    EXCLUSIVE   ///< A single holder (saves, deletes, quarantine; listing for a user's namespace).
+};
+
+/**
+ * @class LockTable
+ * @brief Reader/writer locks on individual files and on users' namespaces, created on demand.
+ * @details A lock exists only while someone holds or waits for it: the table hashes the key to a bucket, and the
+ *          bucket's mutex is held just long enough to find or create the entry, never while waiting for the lock
+ *          itself. Keys are exact, so operations on different files (or different users) never wait for each other.
+ *          A user's namespace lock is held shared by operations that add or remove a name, and exclusively while
+ *          the user's files are listed; it is always taken before a file lock.
+ */
+class LockTable {
+    struct Entry;
+
+public:
+    /**
+     * @class Guard
+     * @brief A held lock; released when the guard is destroyed.
+     */
+    class Guard {
+    public:
+        /**
+         * @brief Constructs a guard holding nothing.
+         */
+        Guard() = default;
+
+        /**
+         * @brief Releases the lock.
+         */
+        ~Guard();
+
+        Guard(Guard&& other) noexcept;
+        Guard& operator=(Guard&& other) noexcept;
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        /**
+         * @brief Releases the lock before the guard goes out of scope.
+         */
+        void release();
+
+    private:
+        friend class LockTable;
+
+        /**
+         * @brief Constructs a guard over a held entry.
+         */
+        Guard(LockTable* table, std::string key, Entry* entry, LockMode mode);
+
+        LockTable* table_ = nullptr;     ///< The table the entry belongs to.
+        std::string key_;                ///< The entry's key.
+        Entry* entry_ = nullptr;         ///< The held entry (nullptr once released).
+        LockMode mode_ = LockMode::SHARED; ///< How the entry is held.
+    };
+
+    LockTable() = default;
+    LockTable(const LockTable&) = delete;
+    LockTable& operator=(const LockTable&) = delete;
+
+    /**
+     * @brief Locks a single file of a user.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param mode Shared or exclusive.
+     * @return The held lock.
+     */
+    Guard lock_file(uint32_t user_id, const std::string& filename, LockMode mode);
+
+    /**
+     * @brief Locks a user's namespace (the set of filenames).
+     * @param user_id The user ID.
+     * @param mode Shared for adding or removing a name, exclusive for a consistent listing.
+     * @return The held lock.
+     */
+    Guard lock_user(uint32_t user_id, LockMode mode);
+
+    /**
+     * @brief Formats the acquisition and contention counters as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @struct Entry
+     * @brief One lock and the number of guards holding or waiting for it.
+     */
+    struct Entry {
+        std::shared_mutex mutex;    ///< The lock.
+        size_t references = 0;      ///< Holders and waiters (guarded by the bucket's mutex).
+    };
+
+    /**
+     * @struct Bucket
+     * @brief The entries whose keys hash to the same bucket.
+     */
+    struct Bucket {
+        std::mutex mutex;                                                ///< Guards 'entries'.
+        std::unordered_map<std::string, std::unique_ptr<Entry>> entries; ///< Live entries by key.
+    };
+
+    /**
+     * @struct Counters
+     * @brief Statistics of one lock mode.
+     */
+    struct Counters {
+        std::atomic<uint64_t> acquired{ 0 };    ///< Locks granted.
+        std::atomic<uint64_t> contended{ 0 };   ///< Locks that had to wait.
+        std::atomic<uint64_t> wait_us{ 0 };     ///< Total time spent waiting, in microseconds.
+    };
+
+    /**
+     * @brief Finds or creates an entry, acquires it and wraps it in a guard.
+     * @param key The key.
+     * @param mode Shared or exclusive.
+     * @param counters The counters to update.
+     * @return The held lock.
+     */
+    Guard acquire(std::string key, LockMode mode, std::array<Counters, 2>& counters);
+
+    /**
+     * @brief Unlocks an entry and drops it once nobody references it.
+     * @param key The entry's key.
+     * @param entry The entry.
+     * @param mode How the entry was held.
+     */
+    void release(const std::string& key, Entry* entry, LockMode mode);
+
+    /**
+     * @brief Returns the bucket of a key.
+     * @param key The key.
+     * @return The bucket.
+     */
+    Bucket& bucket(const std::string& key);
+
+    /**
+     * @brief The hash buckets.
+     */
+    std::array<Bucket, LOCK_TABLE_BUCKETS> buckets_;
+
+    /**
+     * @brief Counters of shared and exclusive file locks.
+     */
+    std::array<Counters, 2> file_counters_;
+
+    /**
+     * @brief Counters of shared and exclusive namespace locks.
+     */
+    std::array<Counters, 2> user_counters_;
+};
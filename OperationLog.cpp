@@ -0,0 +1,168 @@
+/**
+ * @file OperationLog.cpp
+ * @brief OperationLog class implementation.
+ * @details This file contains the implementation of the append-only operation log used for replication.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "OperationLog.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+
+namespace
+{
+    constexpr size_t RECORD_FIXED_SIZE = 8 + 8 + 1 + 4 + 2; // sequence + timestamp + op_code + user_id + name_len
+
+    const std::string LOG_FILE = "oplog.bin";
+    const std::string ACK_FILE = "acknowledged";
+}
+
+OperationLog::OperationLog(const std::string& root_folder)
+    : log_path_(root_folder + OPLOG_FOLDER + LOG_FILE),
+    ack_path_(root_folder + OPLOG_FOLDER + ACK_FILE)
+{
+    std::filesystem::create_directories(root_folder + OPLOG_FOLDER);
+    load();
+    log_out_.open(log_path_, std::ios::binary | std::ios::app);
+}
+
+uint64_t OperationLog::append(const Command op_code, const uint32_t user_id, const std::string& filename)
+{
+    OperationRecord record;
+    record.timestamp_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    record.op_code = op_code;
+    record.user_id = user_id;
+    record.filename = filename;
+
+    std::lock_guard lock(mutex_);
+    record.sequence = ++last_sequence_;
+
+    std::vector<unsigned char> buffer;
+    buffer.reserve(RECORD_FIXED_SIZE + filename.size());
+    write_uint64_le(buffer, record.sequence);
+    write_uint64_le(buffer, record.timestamp_ms);
+    write_uint8(buffer, static_cast<uint8_t>(op_code));
+    write_uint32_le(buffer, user_id);
+    write_uint16_le(buffer, static_cast<uint16_t>(filename.size()));
+    buffer.insert(buffer.end(), filename.begin(), filename.end());
+
+    log_out_.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    log_out_.flush();
+
+    pending_.push_back(std::move(record));
+    return last_sequence_;
+}
+
+std::vector<OperationRecord> OperationLog::pending(const size_t max_records) const
+{
+    std::lock_guard lock(mutex_);
+    const size_t count = std::min(max_records, pending_.size());
+    return { pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(count) };
+}
+
+void OperationLog::acknowledge(const uint64_t sequence)
+{
+    std::lock_guard lock(mutex_);
+    if (sequence <= acknowledged_)
+    {
+        return;
+    }
+
+    while (!pending_.empty() && pending_.front().sequence <= sequence)
+    {
+        pending_.pop_front();
+    }
+    acknowledged_ = sequence;
+
+    // Persist the acknowledgment atomically
+    std::vector<unsigned char> buffer;
+    write_uint64_le(buffer, acknowledged_);
+    {
+        std::ofstream ofs(ack_path_ + ".tmp", std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    }
+    std::error_code ec;
+    std::filesystem::rename(ack_path_ + ".tmp", ack_path_, ec);
+
+    // Once the peer has caught up, the log can start over
+    if (pending_.empty() && !ec)
+    {
+        log_out_.close();
+        log_out_.open(log_path_, std::ios::binary | std::ios::trunc);
+    }
+}
+
+uint64_t OperationLog::last_sequence() const
+{
+    std::lock_guard lock(mutex_);
+    return last_sequence_;
+}
+
+uint64_t OperationLog::acknowledged_sequence() const
+{
+    std::lock_guard lock(mutex_);
+    return acknowledged_;
+}
+
+uint64_t OperationLog::oldest_pending_timestamp() const
+{
+    std::lock_guard lock(mutex_);
+    return pending_.empty() ? 0 : pending_.front().timestamp_ms;
+}
+
+void OperationLog::load()
+{
+    if (std::ifstream ack_ifs(ack_path_, std::ios::binary); ack_ifs.is_open())
+    {
+        unsigned char buffer[8];
+        if (ack_ifs.read(reinterpret_cast<char*>(buffer), sizeof(buffer)))
+        {
+            acknowledged_ = read_uint_64_le(buffer);
+        }
+    }
+    last_sequence_ = acknowledged_;
+
+    std::ifstream ifs(log_path_, std::ios::binary);
+    const std::vector<unsigned char> log((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    // Replay up to a torn trailing record
+    size_t pos = 0;
+    while (pos + RECORD_FIXED_SIZE <= log.size())
+    {
+        const unsigned char* fields = log.data() + pos;
+        const uint16_t name_len = read_uint_16_le(fields, 21, 22);
+        if (pos + RECORD_FIXED_SIZE + name_len > log.size())
+        {
+            break;
+        }
+
+        OperationRecord record;
+        record.sequence = read_uint_64_le(fields);
+        record.timestamp_ms = read_uint_64_le(fields + 8);
+        record.op_code = static_cast<Command>(fields[16]);
+        record.user_id = read_uint_32_le(fields + 17);
+        record.filename.assign(reinterpret_cast<const char*>(fields + RECORD_FIXED_SIZE), name_len);
+        pos += RECORD_FIXED_SIZE + name_len;
+
+        last_sequence_ = std::max(last_sequence_, record.sequence);
+        if (record.sequence > acknowledged_)
+        {
+            pending_.push_back(std::move(record));
+        }
+    }
+
+    // Drop a torn tail so new records are not appended after garbage
+    if (pos < log.size())
+    {
+        std::filesystem::resize_file(log_path_, pos);
+    }
+}
@@ -0,0 +1,133 @@
+/**
+ * @file OperationLog.h
+ * @brief OperationLog class definition.
+ * @details This header file contains the OperationLog class, an append-only on-disk log of the SAVE_FILE and
+ *          DELETE_FILE mutations that still have to be replicated, together with the sequence number the peer acknowledged.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "protocols.h"
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+const std::string OPLOG_FOLDER = ".oplog/";  // root folder holding the operation log and the acknowledged sequence number
+
+/**
+ * @struct OperationRecord
+ * @brief A single logged mutation.
+ */
+struct OperationRecord {
+    uint64_t sequence = 0;                        ///< Monotonic sequence number.
+    uint64_t timestamp_ms = 0;                    ///< Wall-clock time of the mutation (milliseconds since the epoch).
+    Command op_code = Command::SAVE_FILE;         ///< SAVE_FILE or DELETE_FILE.
+    uint32_t user_id = 0;                         ///< The user owning the file.
+    std::string filename;                         ///< The file that was saved or deleted.
+};
+
+/**
+ * @class OperationLog
+ * @brief Thread-safe append-only log of mutations, truncated once the peer has acknowledged all of them.
+ * @details The records not yet acknowledged are also kept in memory, so reading a batch never touches the disk.
+ *          On startup the log is replayed past the persisted acknowledgment, which lets replication catch up
+ *          with everything that happened while the peer (or this server) was down.
+ */
+class OperationLog {
+public:
+    /**
+     * @brief Opens (or creates) the operation log under the given root folder.
+     * @param root_folder The storage root folder.
+     */
+    explicit OperationLog(const std::string& root_folder);
+
+    /**
+     * @brief Appends a mutation to the log.
+     * @param op_code SAVE_FILE or DELETE_FILE.
+     * @param user_id The user owning the file.
+     * @param filename The file that was saved or deleted.
+     * @return The sequence number of the new record.
+     */
+    uint64_t append(Command op_code, uint32_t user_id, const std::string& filename);
+
+    /**
+     * @brief Returns the oldest records not yet acknowledged.
+     * @param max_records The maximum number of records to return.
+     * @return The records, oldest first.
+     */
+    std::vector<OperationRecord> pending(size_t max_records) const;
+
+    /**
+     * @brief Marks every record up to 'sequence' as replicated.
+     * @param sequence The last replicated sequence number.
+     */
+    void acknowledge(uint64_t sequence);
+
+    /**
+     * @brief Returns the sequence number of the newest record.
+     * @return The last sequence number (0 if nothing was ever logged).
+     */
+    uint64_t last_sequence() const;
+
+    /**
+     * @brief Returns the sequence number the peer acknowledged last.
+     * @return The acknowledged sequence number.
+     */
+    uint64_t acknowledged_sequence() const;
+
+    /**
+     * @brief Returns the timestamp of the oldest record not yet acknowledged.
+     * @return The timestamp in milliseconds since the epoch, or 0 if everything is replicated.
+     */
+    uint64_t oldest_pending_timestamp() const;
+
+private:
+    /**
+     * @brief Replays the log file past the acknowledged sequence number.
+     */
+    void load();
+
+    /**
+     * @brief The operation log file path.
+     */
+    std::string log_path_;
+
+    /**
+     * @brief The acknowledged sequence number file path.
+     */
+    std::string ack_path_;
+
+    /**
+     * @brief Guards all members below.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief The log file, kept open for appending.
+     */
+    std::ofstream log_out_;
+
+    /**
+     * @brief The records not yet acknowledged.
+     */
+    std::deque<OperationRecord> pending_;
+
+    /**
+     * @brief The sequence number of the newest record.
+     */
+    uint64_t last_sequence_ = 0;
+
+    /**
+     * @brief The sequence number the peer acknowledged last.
+     */
+    uint64_t acknowledged_ = 0;
+};
@@ -0,0 +1,252 @@
+/**
+ * @file PeerClient.cpp
+ * @brief PeerClient class implementation.
+ * @details This file contains the implementation of the blocking client used to talk to a peer server.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "PeerClient.h"
+#include "ProtocolParcer.h"
+
+#include <algorithm>
+
+using boost::asio::ip::tcp;
+
+PeerClient::PeerClient(std::string host, const unsigned short port, const uint8_t version)
+    : host_(std::move(host)), port_(port), version_(version)
+{
+}
+
+PeerClient::PeerClient(std::shared_ptr<Transport> transport, const uint8_t version)
+    : port_(0), version_(version), transport_(std::move(transport))
+{
+}
+
+void PeerClient::connect()
+{
+    if (host_.empty())
+    {
+        return;
+    }
+
+    close();
+    partial_.clear();
+    auto socket = std::make_shared<tcp::socket>(io_context_);
+    tcp::resolver resolver(io_context_);
+    boost::asio::connect(*socket, resolver.resolve(host_, std::to_string(port_)));
+    socket->set_option(tcp::no_delay(true));
+    transport_ = std::make_shared<TcpTransport>(std::move(socket));
+}
+
+void PeerClient::close()
+{
+    if (transport_)
+    {
+        transport_->close();
+    }
+}
+
+bool PeerClient::is_connected() const
+{
+    return transport_ && transport_->is_open();
+}
+
+void PeerClient::send_request(const Request& request)
+{
+    if (version_ >= MULTIPLEX_PROTOCOL_VERSION)
+    {
+        send_request_as<LATEST_PROTOCOL_VERSION>(request);
+    }
+    else if (version_ >= CHECKSUM_PROTOCOL_VERSION)
+    {
+        send_request_as<CHECKSUM_PROTOCOL_VERSION>(request);
+    }
+    else
+    {
+        send_request_as<1>(request);
+    }
+}
+
+template <uint8_t Version>
+void PeerClient::send_request_as(const Request& request)
+{
+    using Schema = ProtocolSchema<Version>;
+
+    std::vector<unsigned char> header;
+    header.reserve(RequestHeader::size + Schema::RequestPrefix::size + request.filename.size() + Schema::RequestTrailer::size);
+    const auto fixed = RequestHeader::encode(request.user_id, version_, request.op_code,
+        static_cast<uint16_t>(request.filename.size()));
+    header.insert(header.end(), fixed.begin(), fixed.end());
+    if constexpr (Schema::is_multiplexed)
+    {
+        const auto prefix = Schema::RequestPrefix::encode(request.request_id);
+        header.insert(header.end(), prefix.begin(), prefix.end());
+    }
+    header.insert(header.end(), request.filename.begin(), request.filename.end());
+
+    if (request_has_payload(request.op_code))
+    {
+        typename Schema::RequestTrailer::Buffer trailer{};
+        Schema::RequestTrailer::template put<PayloadSizeField>(trailer, static_cast<uint32_t>(request.file_data.size()));
+        if constexpr (Schema::has_checksum)
+        {
+            Schema::RequestTrailer::template put<ChecksumField>(trailer, request.payload_checksum);
+        }
+        header.insert(header.end(), trailer.begin(), trailer.end());
+    }
+
+    // Gather-write the header and the payload without copying the payload
+    std::vector<boost::asio::const_buffer> buffers = { boost::asio::buffer(header) };
+    if (request_has_payload(request.op_code))
+    {
+        buffers.push_back(boost::asio::buffer(request.file_data));
+    }
+    if (boost::system::error_code ec; !is_connected() || !transport_->write_all(buffers, ec))
+    {
+        throw boost::system::system_error(ec ? ec : boost::asio::error::not_connected);
+    }
+}
+
+Response PeerClient::read_response()
+{
+    if (version_ >= MULTIPLEX_PROTOCOL_VERSION)
+    {
+        return read_multiplexed_response();
+    }
+    if (version_ >= CHECKSUM_PROTOCOL_VERSION)
+    {
+        return read_lockstep_response<CHECKSUM_PROTOCOL_VERSION>();
+    }
+    return read_lockstep_response<1>();
+}
+
+template <uint8_t Version>
+Response PeerClient::read_lockstep_response()
+{
+    using Schema = ProtocolSchema<Version>;
+    Response response;
+
+    ResponseHeader::Buffer header;
+    read_exact(header.data(), header.size());
+    response.version = ResponseHeader::get<VersionField>(header);
+    response.status = ResponseHeader::get<StatusField>(header);
+
+    if (const uint16_t name_len = ResponseHeader::get<NameLengthField>(header); name_len > 0)
+    {
+        response.filename.resize(name_len);
+        read_exact(response.filename.data(), name_len);
+    }
+
+    if (response.status == ServerStatus::SUCCESS_FOUND)
+    {
+        typename Schema::FoundTrailer::Buffer trailer;
+        read_exact(trailer.data(), trailer.size());
+        if constexpr (Schema::has_checksum)
+        {
+            response.checksum = Schema::FoundTrailer::template get<ChecksumField>(trailer);
+        }
+        response.payload.resize(Schema::FoundTrailer::template get<PayloadSizeField>(trailer));
+        read_exact(response.payload.data(), response.payload.size());
+    }
+    else if (response_has_payload(response.status))
+    {
+        typename Schema::PayloadTrailer::Buffer trailer;
+        read_exact(trailer.data(), trailer.size());
+        response.payload.resize(Schema::PayloadTrailer::template get<PayloadSizeField>(trailer));
+        read_exact(response.payload.data(), response.payload.size());
+    }
+    return response;
+}
+
+Response PeerClient::read_multiplexed_response()
+{
+    using Schema = ProtocolSchema<LATEST_PROTOCOL_VERSION>;
+
+    while (true)
+    {
+        FrameHeader::Buffer frame;
+        read_exact(frame.data(), frame.size());
+        const uint32_t request_id = FrameHeader::get<RequestIdField>(frame);
+        const FrameType type = FrameHeader::get<FrameTypeField>(frame);
+        std::vector<unsigned char> body(FrameHeader::get<BodyLengthField>(frame));
+        read_exact(body.data(), body.size());
+
+        if (type == FrameType::RESPONSE_HEADER)
+        {
+            if (body.size() < FramedResponseHeader::size)
+            {
+                throw std::runtime_error("Malformed response header frame");
+            }
+
+            PartialResponse partial{ Response(), 0 };
+            Response& response = partial.response;
+            FramedResponseHeader::Buffer fixed;
+            std::copy_n(body.begin(), fixed.size(), fixed.begin());
+            response.version = FrameHeader::get<VersionField>(frame);
+            response.request_id = request_id;
+            response.status = FramedResponseHeader::get<StatusField>(fixed);
+            const uint16_t name_len = FramedResponseHeader::get<NameLengthField>(fixed);
+            const size_t trailer_size = !response_has_payload(response.status) ? 0
+                : response.status == ServerStatus::SUCCESS_FOUND ? Schema::FoundTrailer::size : Schema::PayloadTrailer::size;
+            if (body.size() != fixed.size() + name_len + trailer_size)
+            {
+                throw std::runtime_error("Malformed response header frame");
+            }
+            const auto trailer_start = body.begin() + static_cast<std::ptrdiff_t>(fixed.size() + name_len);
+            response.filename.assign(body.begin() + static_cast<std::ptrdiff_t>(fixed.size()), trailer_start);
+
+            if (response.status == ServerStatus::SUCCESS_FOUND)
+            {
+                Schema::FoundTrailer::Buffer trailer;
+                std::copy_n(trailer_start, trailer.size(), trailer.begin());
+                partial.payload_size = Schema::FoundTrailer::get<PayloadSizeField>(trailer);
+                response.checksum = Schema::FoundTrailer::get<ChecksumField>(trailer);
+            }
+            else if (trailer_size > 0)
+            {
+                Schema::PayloadTrailer::Buffer trailer;
+                std::copy_n(trailer_start, trailer.size(), trailer.begin());
+                partial.payload_size = Schema::PayloadTrailer::get<PayloadSizeField>(trailer);
+            }
+            if (partial.payload_size == 0)
+            {
+                return response;
+            }
+            response.payload.reserve(partial.payload_size);
+            partial_[request_id] = std::move(partial);
+            continue;
+        }
+
+        // A data frame continues a response whose header arrived earlier
+        const auto it = partial_.find(request_id);
+        if (it == partial_.end() || it->second.response.payload.size() + body.size() > it->second.payload_size)
+        {
+            throw std::runtime_error("Unexpected data frame for request " + std::to_string(request_id));
+        }
+        auto& payload = it->second.response.payload;
+        payload.insert(payload.end(), body.begin(), body.end());
+        if (payload.size() == it->second.payload_size)
+        {
+            Response response = std::move(it->second.response);
+            partial_.erase(it);
+            return response;
+        }
+    }
+}
+
+std::string PeerClient::address() const
+{
+    return host_.empty() ? transport_->describe() : host_ + ":" + std::to_string(port_);
+}
+
+void PeerClient::read_exact(void* buffer, const size_t size)
+{
+    if (boost::system::error_code ec; !is_connected() || !transport_->read_exact(buffer, size, ec))
+    {
+        throw boost::system::system_error(ec ? ec : boost::asio::error::not_connected);
+    }
+}
@@ -0,0 +1,156 @@
+/**
+ * @file PeerClient.h
+ * @brief PeerClient class definition.
+ * @details This header file contains the PeerClient class, a blocking client speaking this server's own protocol,
+ *          used to forward requests to another instance of the server.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "Request.h"
+#include "Response.h"
+#include "Transport.h"
+
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * @class PeerClient
+ * @brief Sends requests to a peer server and reads its responses over one connection.
+ * @details Requests are written in protocol version 2 (with a checksum for SAVE_FILE), so the peer verifies every
+ *          payload it receives. Several requests may be written before their responses are read (pipelining).
+ *          In protocol version 3 the responses come back in completion order with their chunks interleaved;
+ *          read_response() reassembles them and returns each one as soon as it is complete.
+ */
+class PeerClient {
+public:
+    /**
+     * @brief Constructs a PeerClient for the given address (does not connect yet).
+     * @param host The peer's host name or IP address.
+     * @param port The peer's port.
+     * @param version The protocol version to speak (2, or 3 for multiplexed requests identified by 'request_id').
+     */
+    PeerClient(std::string host, unsigned short port, uint8_t version = 2);
+
+    /**
+     * @brief Constructs a PeerClient over an established connection (e.g. FileServer::connect()).
+     * @param transport The connection; connect() cannot reopen it once closed.
+     * @param version The protocol version to speak.
+     */
+    explicit PeerClient(std::shared_ptr<Transport> transport, uint8_t version = 2);
+
+    /**
+     * @brief Connects to the peer (closing any previous connection); does nothing for a client built on a transport.
+     * @throws boost::system::system_error if the connection fails.
+     */
+    void connect();
+
+    /**
+     * @brief Closes the connection.
+     */
+    void close();
+
+    /**
+     * @brief Tells whether the connection is open.
+     * @return True if connected.
+     */
+    bool is_connected() const;
+
+    /**
+     * @brief Writes a request to the peer (blocking write).
+     * @param request The request to send; 'payload_checksum' is sent as the SAVE_FILE checksum.
+     * @throws boost::system::system_error if the write fails.
+     */
+    void send_request(const Request& request);
+
+    /**
+     * @brief Reads the next response from the peer (blocking read).
+     * @details In version 3 this is the next response to complete, whichever request it answers ('request_id').
+     * @return The response.
+     * @throws boost::system::system_error if the read fails.
+     */
+    Response read_response();
+
+    /**
+     * @brief Returns the peer's address as "host:port" (or the transport's description).
+     * @return The address.
+     */
+    std::string address() const;
+
+private:
+    /**
+     * @brief Writes a request using the layouts of one protocol version.
+     * @param request The request to send.
+     */
+    template <uint8_t Version>
+    void send_request_as(const Request& request);
+
+    /**
+     * @brief Reads a version 1 or 2 response.
+     * @return The response.
+     */
+    template <uint8_t Version>
+    Response read_lockstep_response();
+
+    /**
+     * @brief Reads frames until a version 3 response is complete.
+     * @return The completed response.
+     * @throws boost::system::system_error if the read fails; std::runtime_error if a frame is malformed.
+     */
+    Response read_multiplexed_response();
+
+    /**
+     * @brief The peer's host name or IP address.
+     */
+    std::string host_;
+
+    /**
+     * @brief The peer's port.
+     */
+    unsigned short port_;
+
+    /**
+     * @brief The protocol version spoken.
+     */
+    uint8_t version_;
+
+    /**
+     * @struct PartialResponse
+     * @brief A version 3 response whose payload is still arriving.
+     */
+    struct PartialResponse {
+        Response response;      ///< The response, with the payload received so far.
+        size_t payload_size;    ///< The full payload size.
+    };
+
+    /**
+     * @brief Version 3 responses still arriving, by request ID.
+     */
+    std::map<uint32_t, PartialResponse> partial_;
+
+    /**
+     * @brief Reads exactly 'size' bytes from the connection.
+     * @param buffer The buffer to read into.
+     * @param size The number of bytes.
+     * @throws boost::system::system_error if the read fails.
+     */
+    void read_exact(void* buffer, size_t size);
+
+    /**
+     * @brief The io_context driving the TCP connections.
+     */
+    boost::asio::io_context io_context_;
+
+    /**
+     * @brief The connection to the peer (null before connect()).
+     */
+    std::shared_ptr<Transport> transport_;
+};
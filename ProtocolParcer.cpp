@@ -10,107 +10,195 @@
  */
 
 #include "ProtocolParcer.h"
-#include "utility.h"
+#include "Checksum.h"
 
+#include <chrono>
 #include <iostream>
 
-ProtocolParcer::ProtocolParcer(std::shared_ptr<boost::asio::ip::tcp::socket> socket)
-    : socket_(std::move(socket)){}
+ProtocolParcer::ProtocolParcer(std::shared_ptr<Transport> transport)
+    : transport_(std::move(transport)){}
 
-Request ProtocolParcer::read_request(boost::system::error_code& ec) const
+Request ProtocolParcer::read_request(boost::system::error_code& ec,
+                                     const std::function<void(uint32_t, size_t)>& before_payload_chunk,
+                                     const std::function<std::optional<ServerStatus>(const Request&, uint32_t)>& admit_payload) const
 {
-    Request request;
 	ec.clear();
 
     // Read the main 8-byte header
-    unsigned char header[REQUEST_HEADER_SIZE];
-    if (!read_exact(header, REQUEST_HEADER_SIZE, ec))
-    {
-		if (!ec)
-		{
-            ec = boost::asio::error::operation_aborted;
-		}
+    RequestHeader::Buffer header;
+    read_or_throw(header.data(), header.size(), ec, "Error reading header");
+    const auto received = std::chrono::steady_clock::now();
 
-		throw std::runtime_error("Error reading header");
-    }
+    // The version selects the layouts of the rest of the request; this is the only place it is tested
+    const uint8_t version = RequestHeader::get<VersionField>(header);
+    Request request = version >= MULTIPLEX_PROTOCOL_VERSION
+        ? read_request_body<LATEST_PROTOCOL_VERSION>(header, ec, before_payload_chunk, admit_payload)
+        : version >= CHECKSUM_PROTOCOL_VERSION
+        ? read_request_body<CHECKSUM_PROTOCOL_VERSION>(header, ec, before_payload_chunk, admit_payload)
+        : read_request_body<1>(header, ec, before_payload_chunk, admit_payload);
+
+    // Latencies (e.g. in traces) are measured from the arrival of the header, before the payload is received
+    request.received = received;
+    return request;
+}
+
+template <uint8_t Version>
+Request ProtocolParcer::read_request_body(const RequestHeader::Buffer& header, boost::system::error_code& ec,
+                                          const std::function<void(uint32_t, size_t)>& before_payload_chunk,
+                                          const std::function<std::optional<ServerStatus>(const Request&, uint32_t)>& admit_payload) const
+{
+    using Schema = ProtocolSchema<Version>;
+    Request request;
 
 	// Parse the header
-    request.user_id = read_uint_32_le(header);       // [0..3] user_id
-    request.version = header[4];                    // [4]    version
-    request.op_code = static_cast<Command>(header[5]); // [5] op_code
+    request.user_id = RequestHeader::get<UserIdField>(header);
+    request.version = RequestHeader::get<VersionField>(header);
+    request.op_code = RequestHeader::get<OpCodeField>(header);
 
-    // Read filename
-    if (const uint16_t name_len = read_uint_16_le(header, 6, 7); name_len > 0)
+    // Version 3 clients number their requests, so that responses can come back in any order
+    if constexpr (Schema::is_multiplexed)
     {
-	    std::vector<unsigned char> name_buf(name_len, 0);
-        if (!read_exact(name_buf.data(), name_len, ec))
-        {
-			if (!ec)
-			{
-				ec = boost::asio::error::operation_aborted;
-			}
+        typename Schema::RequestPrefix::Buffer prefix;
+        read_or_throw(prefix.data(), prefix.size(), ec, "Error reading request_id");
+        request.request_id = Schema::RequestPrefix::template get<RequestIdField>(prefix);
+    }
 
-			throw std::runtime_error("Error reading filename");
-        }
-        request.filename.assign(reinterpret_cast<const char*>(name_buf.data()), name_len);
+    // Read filename
+    if (const uint16_t name_len = RequestHeader::get<NameLengthField>(header); name_len > 0)
+    {
+        request.filename.resize(name_len);
+        read_or_throw(request.filename.data(), name_len, ec, "Error reading filename");
     }
 
-    // If this is SAVE_FILE (op_code=100), read 4 more bytes => file_size, then read file_data
-    if (request.op_code == Command::SAVE_FILE)
+    // If this is SAVE_FILE (op_code=100) or an upload command, read the payload size (and, from version 2, its checksum), then the payload
+    if (request_has_payload(request.op_code))
     {
-        unsigned char size_buf[PAYLOAD_FILE_SIZE];
-        if (!read_exact(size_buf, PAYLOAD_FILE_SIZE, ec))
+        typename Schema::RequestTrailer::Buffer trailer;
+        read_or_throw(trailer.data(), trailer.size(), ec, "Error reading file_size");
+        const uint32_t file_size = Schema::RequestTrailer::template get<PayloadSizeField>(trailer);
+        request.payload_size = file_size;
+        if constexpr (Schema::has_checksum)
+        {
+            request.expected_checksum = Schema::RequestTrailer::template get<ChecksumField>(trailer);
+        }
+
+        // Refuse the payload from its announced size rather than after receiving it
+        if (admit_payload)
+        {
+            request.refusal = admit_payload(request, file_size);
+        }
+        if (request.refusal)
         {
-            if (!ec)
+            if (file_size > REFUSED_PAYLOAD_DISCARD_LIMIT)
             {
-				ec = boost::asio::error::operation_aborted;
+                request.payload_unread = true;
+                return request;
             }
-
-			throw std::runtime_error("Error reading file_size");
+            unsigned char discarded[MAX_BUFFER_SIZE];
+            for (size_t total_read = 0; total_read < file_size;)
+            {
+                const size_t to_read = std::min(sizeof(discarded), file_size - total_read);
+                read_or_throw(discarded, to_read, ec, "Error reading file data");
+                total_read += to_read;
+            }
+            return request;
         }
-        const uint32_t file_size = read_uint_32_le(size_buf);
 
-        // Now read 'file_size' bytes in chunks
+        // Now read 'file_size' bytes in chunks, updating the checksum while the chunk is still hot in cache
         request.file_data.resize(file_size);
+        Crc32c crc;
         size_t total_read = 0;
         while (total_read < file_size)
         {
             const size_t to_read = std::min(static_cast<size_t>(MAX_BUFFER_SIZE), file_size - total_read);
-
-            if (!read_exact(request.file_data.data() + total_read, to_read, ec))
+            if (before_payload_chunk)
             {
-                if (!ec)
-                {
-                    ec = boost::asio::error::operation_aborted;
-                }
-
-                throw std::runtime_error("Error reading file data");
+                before_payload_chunk(request.user_id, to_read);
             }
+
+            read_or_throw(request.file_data.data() + total_read, to_read, ec, "Error reading file data");
+            crc.update(request.file_data.data() + total_read, to_read);
 			total_read += to_read;
         }
+        request.payload_checksum = crc.value();
     }
 
     return request;
 }
 
-void ProtocolParcer::write_response(const Response& resp) const
+void ProtocolParcer::write_response(const Response& resp, const std::function<void(size_t)>& before_payload_chunk) const
 {
-	std::vector<unsigned char> buffer;
-
-    write_uint8(buffer, resp.version);
-
-    const uint16_t status = static_cast<uint16_t>(resp.status);
-    write_uint16_le(buffer, status);
+    if (resp.version >= MULTIPLEX_PROTOCOL_VERSION)
+    {
+        write_framed_response(resp, before_payload_chunk);
+    }
+    else if (resp.version >= CHECKSUM_PROTOCOL_VERSION)
+    {
+        write_lockstep_response<CHECKSUM_PROTOCOL_VERSION>(resp, before_payload_chunk);
+    }
+    else
+    {
+        write_lockstep_response<1>(resp, before_payload_chunk);
+    }
+}
 
-    const uint16_t name_len = static_cast<uint16_t>(resp.filename.size());
-    write_uint16_le(buffer, name_len);
+template <uint8_t Version>
+void ProtocolParcer::write_lockstep_response(const Response& resp,
+                                             const std::function<void(size_t)>& before_payload_chunk) const
+{
+    using Schema = ProtocolSchema<Version>;
+    const auto name_len = static_cast<uint16_t>(resp.filename.size());
+    const auto payload_size = static_cast<uint32_t>(resp.payload.size());
+    const bool has_payload = response_has_payload(resp.status);
 
+    // Header, filename and payload size go out together; so does the payload unless it is paced
+	std::vector<unsigned char> buffer;
+    buffer.reserve(ResponseHeader::size + name_len + Schema::FoundTrailer::size +
+        (has_payload && !before_payload_chunk ? resp.payload.size() : 0));
+    const auto header = ResponseHeader::encode(resp.version, resp.status, name_len);
+    buffer.insert(buffer.end(), header.begin(), header.end());
     buffer.insert(buffer.end(), resp.filename.begin(), resp.filename.end());
 
-    if (status == 210 || status == 211)
+    std::lock_guard lock(write_mutex_);
+    if (has_payload)
     {
-        const uint32_t p_size = static_cast<uint32_t>(resp.payload.size());
-        write_uint32_le(buffer, p_size);
+        if (resp.status == ServerStatus::SUCCESS_FOUND)
+        {
+            typename Schema::FoundTrailer::Buffer trailer{};
+            Schema::FoundTrailer::template put<PayloadSizeField>(trailer, payload_size);
+            if constexpr (Schema::has_checksum)
+            {
+                Schema::FoundTrailer::template put<ChecksumField>(trailer, resp.checksum.value_or(0));
+            }
+            buffer.insert(buffer.end(), trailer.begin(), trailer.end());
+        }
+        else
+        {
+            const auto trailer = Schema::PayloadTrailer::encode(payload_size);
+            buffer.insert(buffer.end(), trailer.begin(), trailer.end());
+        }
+
+        // Paced payloads are sent in chunks after the header; otherwise everything goes out in one write
+        if (before_payload_chunk)
+        {
+            if (!write_exact(buffer.data(), buffer.size()))
+            {
+                std::cerr << "Error sending response\n";
+                return;
+            }
+            for (size_t sent = 0; sent < resp.payload.size();)
+            {
+                const size_t to_send = std::min(RESPONSE_CHUNK_SIZE, resp.payload.size() - sent);
+                before_payload_chunk(to_send);
+                if (!write_exact(resp.payload.data() + sent, to_send))
+                {
+                    std::cerr << "Error sending response\n";
+                    return;
+                }
+                sent += to_send;
+            }
+            return;
+        }
 
         buffer.insert(buffer.end(), resp.payload.begin(), resp.payload.end());
     }
@@ -121,39 +209,76 @@ void ProtocolParcer::write_response(const Response& resp) const
     }
 }
 
-bool ProtocolParcer::read_exact(void* buffer, const size_t size, boost::system::error_code& ec) const
+void ProtocolParcer::write_framed_response(const Response& resp,
+                                           const std::function<void(size_t)>& before_payload_chunk) const
 {
-    size_t total_read = 0;
-    auto* out = static_cast<unsigned char*>(buffer);
+    using Schema = ProtocolSchema<LATEST_PROTOCOL_VERSION>;
+    const auto name_len = static_cast<uint16_t>(resp.filename.size());
+    const auto payload_size = static_cast<uint32_t>(resp.payload.size());
+    const bool has_payload = response_has_payload(resp.status);
 
-    while (total_read < size)
+    // Header frame, then the payload in data frames; other responses' frames may go out in between
+	std::vector<unsigned char> buffer;
+    buffer.reserve(FramedResponseHeader::size + name_len + Schema::FoundTrailer::size);
+    const auto header = FramedResponseHeader::encode(resp.status, name_len);
+    buffer.insert(buffer.end(), header.begin(), header.end());
+    buffer.insert(buffer.end(), resp.filename.begin(), resp.filename.end());
+    if (has_payload && resp.status == ServerStatus::SUCCESS_FOUND)
+    {
+        const auto trailer = Schema::FoundTrailer::encode(payload_size, resp.checksum.value_or(0));
+        buffer.insert(buffer.end(), trailer.begin(), trailer.end());
+    }
+    else if (has_payload)
     {
-        boost::system::error_code error;
-        const size_t chunk = socket_->read_some(boost::asio::buffer(out + total_read, size - total_read), ec);
-        if (error)
+        const auto trailer = Schema::PayloadTrailer::encode(payload_size);
+        buffer.insert(buffer.end(), trailer.begin(), trailer.end());
+    }
+    if (!write_frame(resp.version, resp.request_id, FrameType::RESPONSE_HEADER, buffer.data(), buffer.size()))
+    {
+        std::cerr << "Error sending response\n";
+        return;
+    }
+
+    for (size_t sent = 0; has_payload && sent < resp.payload.size();)
+    {
+        const size_t to_send = std::min(RESPONSE_CHUNK_SIZE, resp.payload.size() - sent);
+        if (before_payload_chunk)
+        {
+            before_payload_chunk(to_send);
+        }
+        if (!write_frame(resp.version, resp.request_id, FrameType::RESPONSE_DATA, resp.payload.data() + sent, to_send))
         {
-			ec = error;
-            return false;
+            std::cerr << "Error sending response\n";
+            return;
         }
-        total_read += chunk;
+        sent += to_send;
     }
-    return true;
 }
 
-bool ProtocolParcer::write_exact(const void* buffer, const std::size_t size) const
+bool ProtocolParcer::write_frame(const uint8_t version, const uint32_t request_id, const FrameType type,
+                                 const void* body, const size_t size) const
 {
-    size_t total_written = 0;
-    auto* in = static_cast<const unsigned char*>(buffer);
+    const auto header = FrameHeader::encode(version, request_id, type, static_cast<uint32_t>(size));
 
-    while (total_written < size)
+    std::lock_guard lock(write_mutex_);
+    return write_exact(header.data(), header.size()) && write_exact(body, size);
+}
+
+void ProtocolParcer::read_or_throw(void* buffer, const size_t size, boost::system::error_code& ec, const char* what) const
+{
+    if (!transport_->read_exact(buffer, size, ec))
     {
-        boost::system::error_code ec;
-        const size_t chunk = socket_->write_some(boost::asio::buffer(in + total_written, size - total_written), ec);
-        if (ec)
+        if (!ec)
         {
-            return false;
+            ec = boost::asio::error::operation_aborted;
         }
-        total_written += chunk;
+
+        throw std::runtime_error(what);
     }
-    return true;
-}
\ No newline at end of file
+}
+
+bool ProtocolParcer::write_exact(const void* buffer, const std::size_t size) const
+{
+    boost::system::error_code ec;
+    return transport_->write_exact(buffer, size, ec);
+}
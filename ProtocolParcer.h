@@ -11,11 +11,41 @@
 #pragma once
 #include "Request.h"
 #include "Response.h"
+#include "WireFormat.h"
+#include "Transport.h"
 #include <boost/asio.hpp>
+#include <functional>
+#include <mutex>
+#include <optional>
 
 constexpr short MAX_BUFFER_SIZE = 4096; // 4KB 
-constexpr short REQUEST_HEADER_SIZE = 8; // 4(user_id) + 1(version) + 1(op_code) + 2(name_len)
-constexpr short PAYLOAD_FILE_SIZE = 4; // file_size (4 bytes)
+constexpr size_t RESPONSE_CHUNK_SIZE = 64 * 1024; // payload bytes sent at a time when the response is paced or framed
+constexpr uint32_t REFUSED_PAYLOAD_DISCARD_LIMIT = 1024 * 1024; // refused payloads up to this size are skipped; larger ones end the connection
+
+/**
+ * @brief Tells whether requests with the given command carry a payload.
+ * @param op_code The command.
+ * @return True for SAVE_FILE, SAVE_IF_ABSENT, PROBE_FILES, LIST_PAGE and the multipart upload commands that carry data
+ *         or parameters.
+ */
+inline bool request_has_payload(const Command op_code)
+{
+    return op_code == Command::SAVE_FILE || op_code == Command::SAVE_IF_ABSENT || op_code == Command::UPLOAD_INITIATE || op_code == Command::UPLOAD_PART ||
+        op_code == Command::UPLOAD_COMMIT || op_code == Command::PROBE_FILES || op_code == Command::LIST_PAGE;
+}
+
+/**
+ * @brief Tells whether responses with the given status carry a payload.
+ * @param status The response status.
+ * @return True for statuses 210, 211, 213, 214, 215, 216 and 300.
+ */
+inline bool response_has_payload(const ServerStatus status)
+{
+    return status == ServerStatus::SUCCESS_FOUND || status == ServerStatus::SUCCESS_FILE_LIST ||
+        status == ServerStatus::SUCCESS_STATUS_REPORT || status == ServerStatus::SUCCESS_PROBE_RESULT ||
+        status == ServerStatus::SUCCESS_USAGE || status == ServerStatus::SUCCESS_FILE_PAGE ||
+        status == ServerStatus::REDIRECT;
+}
 
 /**
  * @class ProtocolParcer
@@ -24,18 +54,29 @@ constexpr short PAYLOAD_FILE_SIZE = 4; // file_size (4 bytes)
 class ProtocolParcer {
 public:
     /**
-     * @brief Constructs a ProtocolParcer with a given socket.
-     * @param socket The socket for communication with the client.
+     * @brief Constructs a ProtocolParcer over a given transport.
+     * @param transport The stream to the client (a TCP socket or an in-process pipe).
      */
-    ProtocolParcer(std::shared_ptr<boost::asio::ip::tcp::socket> socket);
+    ProtocolParcer(std::shared_ptr<Transport> transport);
 
     /**
      * @brief Reads a single request from the client (blocking read).
+     * @details For requests carrying a payload (see request_has_payload()) the CRC-32C of the payload is computed
+     *          chunk by chunk as it is received.
+     *          Version 2 requests carry the client's checksum (4 bytes, little-endian) right after file_size.
+     *          Version 3 requests carry the client's request ID (4 bytes, little-endian) right after name_len.
      * @param ec The error code to set if an error occurs.
+     * @param before_payload_chunk Optional callback invoked with the user ID and the size of each payload chunk
+     *        before it is received (e.g. to enforce the user's bandwidth cap).
+     * @param admit_payload Optional callback invoked with the request (without its payload) and the announced payload
+     *        size; a status it returns refuses the payload, which is then skipped (up to REFUSED_PAYLOAD_DISCARD_LIMIT)
+     *        or left unread (see Request::refusal).
      * @return The parsed request.
      * @throws std::runtime_error if an error occurs during reading.
      */
-    Request read_request(boost::system::error_code& ec) const;
+    Request read_request(boost::system::error_code& ec,
+                         const std::function<void(uint32_t, size_t)>& before_payload_chunk = nullptr,
+                         const std::function<std::optional<ServerStatus>(const Request&, uint32_t)>& admit_payload = nullptr) const;
 
     /**
      * @brief Writes the given Response to the client (blocking write).
@@ -44,29 +85,83 @@ public:
 	 *   status  (2 bytes, little-endian)
 	 *   name_len(2 bytes, little-endian)
      *   filename (name_len bytes)
-     *   if status=210 or 211 => 4-byte payload size + payload
+     *   if status=210, 211, 213 or 300 => 4-byte payload size + payload
+     *   (version 2 and status=210 => 4-byte crc32c between the payload size and the payload)
+     *
+     * Version 3 responses are split into frames, each starting with
+     *   version (1 byte), request_id (4 bytes, little-endian), frame type (1 byte), body length (4 bytes, little-endian):
+     *   one RESPONSE_HEADER frame, then RESPONSE_DATA frames of up to RESPONSE_CHUNK_SIZE bytes until the payload is complete.
+     * Each frame is written atomically, so responses written by several threads interleave frame by frame.
      * @param resp The response to write.
+     * @param before_payload_chunk Optional callback invoked with the size of each payload chunk before it is sent
+     *        (e.g. to enforce the user's bandwidth cap).
      * @throws std::runtime_error if an error occurs during writing.
      */
-    void write_response(const Response& resp) const;
+    void write_response(const Response& resp, const std::function<void(size_t)>& before_payload_chunk = nullptr) const;
 
 private:
 	/**
-	 * @brief The socket for communication with the client.
+	 * @brief The stream to the client.
 	 */
-    std::shared_ptr<boost::asio::basic_stream_socket<boost::asio::ip::tcp>> socket_;
+    std::shared_ptr<Transport> transport_;
 
     /**
-     * @brief Reads exactly the specified number of bytes from the socket.
+     * @brief Reads exactly the specified number of bytes from the client, or fails the request.
      * @param buffer The buffer to read into.
      * @param size The number of bytes to read.
      * @param ec The error code to set if an error occurs.
-     * @return True if the read was successful, false otherwise.
+     * @param what The error message.
+     * @throws std::runtime_error if the read fails.
+     */
+    void read_or_throw(void* buffer, size_t size, boost::system::error_code& ec, const char* what) const;
+
+    /**
+     * @brief Reads the rest of a request whose header has been read, using the layouts of one protocol version.
+     * @param header The request header.
+     * @param ec The error code to set if an error occurs.
+     * @param before_payload_chunk See read_request().
+     * @param admit_payload See read_request().
+     * @return The parsed request.
+     * @throws std::runtime_error if an error occurs during reading.
+     */
+    template <uint8_t Version>
+    Request read_request_body(const RequestHeader::Buffer& header, boost::system::error_code& ec,
+                              const std::function<void(uint32_t, size_t)>& before_payload_chunk,
+                              const std::function<std::optional<ServerStatus>(const Request&, uint32_t)>& admit_payload) const;
+
+    /**
+     * @brief Writes a version 1 or 2 response, in one piece or paced.
+     * @param resp The response to write.
+     * @param before_payload_chunk See write_response().
+     */
+    template <uint8_t Version>
+    void write_lockstep_response(const Response& resp, const std::function<void(size_t)>& before_payload_chunk) const;
+
+    /**
+     * @brief Writes a version 3 response as a header frame followed by data frames.
+     * @param resp The response to write.
+     * @param before_payload_chunk See write_response().
+     */
+    void write_framed_response(const Response& resp, const std::function<void(size_t)>& before_payload_chunk) const;
+
+    /**
+     * @brief Writes one version 3 frame.
+     * @param version The protocol version.
+     * @param request_id The ID of the request answered.
+     * @param type The frame type.
+     * @param body The frame body.
+     * @param size The body length.
+     * @return True if the write was successful, false otherwise.
+     */
+    bool write_frame(uint8_t version, uint32_t request_id, FrameType type, const void* body, size_t size) const;
+
+    /**
+     * @brief Serializes writes, so that frames of concurrently written responses do not mix.
      */
-    bool read_exact(void* buffer, size_t size, boost::system::error_code& ec) const;
+    mutable std::mutex write_mutex_;
 
     /**
-     * @brief Writes exactly the specified number of bytes to the socket.
+     * @brief Writes exactly the specified number of bytes to the client.
      * @param buffer The buffer to write from.
      * @param size The number of bytes to write.
      * @return True if the write was successful, false otherwise.
@@ -0,0 +1,382 @@
+/**
+ * @file ReedSolomon.cpp
+ * @brief ReedSolomon class implementation.
+ * @details This file contains the GF(2^8) arithmetic, the portable, SSSE3 and AVX2 multiply-and-add kernels (the
+ *          fastest one the CPU supports is selected once at runtime) and the encoding and reconstruction of shards.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "ReedSolomon.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define REED_SOLOMON_HAS_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+    constexpr unsigned GF_POLYNOMIAL = 0x11d; // x^8 + x^4 + x^3 + x^2 + 1, with 2 as a generator
+
+    /**
+     * @struct GfTables
+     * @brief The logarithm, exponent and product tables of GF(2^8).
+     */
+    struct GfTables {
+        uint8_t exp[512] = {};      ///< 2^i, repeated so exp[log a + log b] needs no modulo.
+        uint8_t log[256] = {};      ///< log2 of each non-zero element.
+        uint8_t mul[256][256] = {}; ///< mul[a][b] = a * b.
+        uint8_t low[256][16] = {};  ///< low[a][n] = a * n: products of the low nibble of a byte.
+        uint8_t high[256][16] = {}; ///< high[a][n] = a * (n << 4): products of the high nibble of a byte.
+    };
+
+    GfTables build_tables()
+    {
+        GfTables t;
+        unsigned x = 1;
+        for (unsigned i = 0; i < 255; ++i)
+        {
+            t.exp[i] = t.exp[i + 255] = static_cast<uint8_t>(x);
+            t.log[x] = static_cast<uint8_t>(i);
+            x <<= 1;
+            if (x & 0x100)
+            {
+                x ^= GF_POLYNOMIAL;
+            }
+        }
+        for (unsigned a = 1; a < 256; ++a)
+        {
+            for (unsigned b = 1; b < 256; ++b)
+            {
+                t.mul[a][b] = t.exp[t.log[a] + t.log[b]];
+            }
+            for (unsigned n = 0; n < 16; ++n)
+            {
+                t.low[a][n] = t.mul[a][n];
+                t.high[a][n] = t.mul[a][n << 4];
+            }
+        }
+        return t;
+    }
+
+    const GfTables& tables()
+    {
+        static const GfTables TABLES = build_tables();
+        return TABLES;
+    }
+
+    uint8_t gf_inverse(const uint8_t a)
+    {
+        return tables().exp[255 - tables().log[a]];
+    }
+
+    void multiply_add_portable(unsigned char* dst, const unsigned char* src, const uint8_t factor, const size_t size)
+    {
+        const uint8_t* row = tables().mul[factor];
+        for (size_t i = 0; i < size; ++i)
+        {
+            dst[i] ^= row[src[i]];
+        }
+    }
+
+#ifdef REED_SOLOMON_HAS_SIMD
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("ssse3")))
+#endif
+    void multiply_add_ssse3(unsigned char* dst, const unsigned char* src, const uint8_t factor, size_t size)
+    {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables().low[factor]));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables().high[factor]));
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        for (; size >= 16; dst += 16, src += 16, size -= 16)
+        {
+            const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            const __m128i product = _mm_xor_si128(_mm_shuffle_epi8(low, _mm_and_si128(in, mask)),
+                                                  _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi64(in, 4), mask)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                             _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst)), product));
+        }
+        multiply_add_portable(dst, src, factor, size);
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("avx2")))
+#endif
+    void multiply_add_avx2(unsigned char* dst, const unsigned char* src, const uint8_t factor, size_t size)
+    {
+        const __m256i low = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables().low[factor])));
+        const __m256i high = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables().high[factor])));
+        const __m256i mask = _mm256_set1_epi8(0x0f);
+        for (; size >= 32; dst += 32, src += 32, size -= 32)
+        {
+            const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+            const __m256i product = _mm256_xor_si256(
+                _mm256_shuffle_epi8(low, _mm256_and_si256(in, mask)),
+                _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi64(in, 4), mask)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                                _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst)), product));
+        }
+        multiply_add_portable(dst, src, factor, size);
+    }
+
+    bool cpu_has_ssse3()
+    {
+#ifdef _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+
+    bool cpu_has_avx2()
+    {
+#ifdef _MSC_VER
+        int info[4] = {};
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    std::vector<GfKernel> detect_kernels()
+    {
+        std::vector<GfKernel> kernels = { { "portable", multiply_add_portable } };
+#ifdef REED_SOLOMON_HAS_SIMD
+        if (cpu_has_ssse3())
+        {
+            kernels.push_back({ "ssse3", multiply_add_ssse3 });
+        }
+        if (cpu_has_avx2())
+        {
+            kernels.push_back({ "avx2", multiply_add_avx2 });
+        }
+#endif
+        return kernels;
+    }
+
+    const std::vector<GfKernel> KERNELS = detect_kernels();
+
+    /**
+     * @brief Inverts a square matrix in place by Gauss-Jordan elimination.
+     * @return False if the matrix is singular.
+     */
+    bool invert(std::vector<uint8_t>& matrix, const unsigned n)
+    {
+        std::vector<uint8_t> inverse(n * n, 0);
+        for (unsigned i = 0; i < n; ++i)
+        {
+            inverse[i * n + i] = 1;
+        }
+        for (unsigned column = 0; column < n; ++column)
+        {
+            unsigned pivot = column;
+            while (pivot < n && matrix[pivot * n + column] == 0)
+            {
+                ++pivot;
+            }
+            if (pivot == n)
+            {
+                return false;
+            }
+            if (pivot != column)
+            {
+                std::swap_ranges(matrix.begin() + pivot * n, matrix.begin() + (pivot + 1) * n, matrix.begin() + column * n);
+                std::swap_ranges(inverse.begin() + pivot * n, inverse.begin() + (pivot + 1) * n, inverse.begin() + column * n);
+            }
+
+            // Scale the pivot row to 1, then clear the column from every other row
+            const uint8_t scale = gf_inverse(matrix[column * n + column]);
+            for (unsigned j = 0; j < n; ++j)
+            {
+                matrix[column * n + j] = gf_multiply(matrix[column * n + j], scale);
+                inverse[column * n + j] = gf_multiply(inverse[column * n + j], scale);
+            }
+            for (unsigned row = 0; row < n; ++row)
+            {
+                const uint8_t factor = matrix[row * n + column];
+                if (row == column || factor == 0)
+                {
+                    continue;
+                }
+                for (unsigned j = 0; j < n; ++j)
+                {
+                    matrix[row * n + j] ^= gf_multiply(factor, matrix[column * n + j]);
+                    inverse[row * n + j] ^= gf_multiply(factor, inverse[column * n + j]);
+                }
+            }
+        }
+        matrix.swap(inverse);
+        return true;
+    }
+}
+
+std::vector<GfKernel> gf_kernels()
+{
+    return KERNELS;
+}
+
+const GfKernel& gf_fastest_kernel()
+{
+    return KERNELS.back();
+}
+
+uint8_t gf_multiply(const uint8_t a, const uint8_t b)
+{
+    return tables().mul[a][b];
+}
+
+ReedSolomon::ReedSolomon(const unsigned data_shards, const unsigned parity_shards, const GfKernel& kernel)
+    : data_shards_(data_shards), parity_shards_(parity_shards), multiply_add_(kernel.multiply_add)
+{
+    if (data_shards == 0 || parity_shards == 0 || data_shards + parity_shards > MAX_TOTAL_SHARDS)
+    {
+        throw std::invalid_argument("Invalid Reed-Solomon code: " + std::to_string(data_shards) + "+" +
+            std::to_string(parity_shards));
+    }
+
+    // Cauchy matrix 1 / (x_i + y_j) with x_i = k + i and y_j = j: all distinct, so every square submatrix is invertible
+    parity_matrix_.resize(parity_shards * data_shards);
+    for (unsigned i = 0; i < parity_shards; ++i)
+    {
+        for (unsigned j = 0; j < data_shards; ++j)
+        {
+            parity_matrix_[i * data_shards + j] = gf_inverse(static_cast<uint8_t>((data_shards + i) ^ j));
+        }
+    }
+}
+
+unsigned ReedSolomon::data_shards() const
+{
+    return data_shards_;
+}
+
+unsigned ReedSolomon::parity_shards() const
+{
+    return parity_shards_;
+}
+
+void ReedSolomon::encode(const unsigned char* const* data, unsigned char* const* parity, const size_t size) const
+{
+    multiply(parity_matrix_, std::vector<const unsigned char*>(data, data + data_shards_),
+             std::vector<unsigned char*>(parity, parity + parity_shards_), size);
+}
+
+bool ReedSolomon::reconstruct(unsigned char* const* shards, const std::vector<bool>& present, const size_t size,
+                              const bool data_only) const
+{
+    const unsigned total = data_shards_ + parity_shards_;
+    std::vector<unsigned> sources;
+    std::vector<unsigned> missing_data;
+    for (unsigned i = 0; i < total; ++i)
+    {
+        if (present[i] && sources.size() < data_shards_)
+        {
+            sources.push_back(i);
+        }
+        if (!present[i] && i < data_shards_)
+        {
+            missing_data.push_back(i);
+        }
+    }
+    if (sources.size() < data_shards_)
+    {
+        return false;
+    }
+
+    if (!missing_data.empty())
+    {
+        // The rows of the encoding matrix that produced the surviving shards, inverted, map them back to the data
+        std::vector<uint8_t> matrix(data_shards_ * data_shards_, 0);
+        for (unsigned r = 0; r < data_shards_; ++r)
+        {
+            if (sources[r] < data_shards_)
+            {
+                matrix[r * data_shards_ + sources[r]] = 1;
+            }
+            else
+            {
+                std::copy_n(parity_matrix_.begin() + (sources[r] - data_shards_) * data_shards_, data_shards_,
+                            matrix.begin() + r * data_shards_);
+            }
+        }
+        if (!invert(matrix, data_shards_))
+        {
+            return false;
+        }
+
+        std::vector<uint8_t> coefficients;
+        std::vector<const unsigned char*> inputs;
+        std::vector<unsigned char*> outputs;
+        for (const unsigned d : missing_data)
+        {
+            coefficients.insert(coefficients.end(), matrix.begin() + d * data_shards_,
+                                matrix.begin() + (d + 1) * data_shards_);
+            outputs.push_back(shards[d]);
+        }
+        for (const unsigned s : sources)
+        {
+            inputs.push_back(shards[s]);
+        }
+        multiply(coefficients, inputs, outputs, size);
+    }
+
+    if (data_only)
+    {
+        return true;
+    }
+
+    // With the data complete, lost parity is simply encoded again
+    std::vector<uint8_t> coefficients;
+    std::vector<unsigned char*> outputs;
+    for (unsigned p = 0; p < parity_shards_; ++p)
+    {
+        if (!present[data_shards_ + p])
+        {
+            coefficients.insert(coefficients.end(), parity_matrix_.begin() + p * data_shards_,
+                                parity_matrix_.begin() + (p + 1) * data_shards_);
+            outputs.push_back(shards[data_shards_ + p]);
+        }
+    }
+    if (!outputs.empty())
+    {
+        multiply(coefficients, std::vector<const unsigned char*>(shards, shards + data_shards_), outputs, size);
+    }
+    return true;
+}
+
+void ReedSolomon::multiply(const std::vector<uint8_t>& coefficients, const std::vector<const unsigned char*>& sources,
+                           const std::vector<unsigned char*>& outputs, const size_t size) const
+{
+    for (size_t offset = 0; offset < size; offset += RS_SLICE_SIZE)
+    {
+        const size_t length = std::min(RS_SLICE_SIZE, size - offset);
+        for (size_t o = 0; o < outputs.size(); ++o)
+        {
+            std::memset(outputs[o] + offset, 0, length);
+            for (size_t s = 0; s < sources.size(); ++s)
+            {
+                if (const uint8_t factor = coefficients[o * sources.size() + s]; factor != 0)
+                {
+                    multiply_add_(outputs[o] + offset, sources[s] + offset, factor, length);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,130 @@
+/**
+ * @file ReedSolomon.h
+ * @brief ReedSolomon class definition.
+ * @details This header file contains the ReedSolomon class, a systematic Reed-Solomon erasure code over GF(2^8)
+ *          computing parity shards from data shards and rebuilding lost shards from any surviving ones, and the
+ *          vectorized GF(2^8) multiply-and-add kernels it runs on.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr unsigned MAX_TOTAL_SHARDS = 255;      // data + parity shards of a code (the field has 256 elements)
+constexpr size_t RS_SLICE_SIZE = 16 * 1024;     // bytes of every shard processed per pass, so the sources stay in cache
+
+/**
+ * @brief Multiplies 'size' bytes of 'src' by 'factor' in GF(2^8) and adds (XORs) the products into 'dst'.
+ */
+using GfMultiplyAddFn = void(*)(unsigned char* dst, const unsigned char* src, uint8_t factor, size_t size);
+
+/**
+ * @struct GfKernel
+ * @brief One implementation of the GF(2^8) multiply-and-add.
+ */
+struct GfKernel {
+    const char* name = "";                      ///< The instruction set it uses ("portable", "ssse3", "avx2").
+    GfMultiplyAddFn multiply_add = nullptr;     ///< The function.
+};
+
+/**
+ * @brief Lists the kernels this CPU can run, slowest first.
+ * @details The portable kernel looks each byte up in a 256-entry product table. The SSSE3 and AVX2 kernels split
+ *          every byte into its two nibbles and look both up in 16-entry product tables with one shuffle instruction
+ *          per 16 or 32 bytes.
+ * @return The kernels.
+ */
+std::vector<GfKernel> gf_kernels();
+
+/**
+ * @brief Returns the fastest kernel this CPU can run (detected once at runtime).
+ * @return The kernel.
+ */
+const GfKernel& gf_fastest_kernel();
+
+/**
+ * @brief Multiplies two elements of GF(2^8).
+ * @param a The first element.
+ * @param b The second element.
+ * @return The product.
+ */
+uint8_t gf_multiply(uint8_t a, uint8_t b);
+
+/**
+ * @class ReedSolomon
+ * @brief A systematic (k + m) Reed-Solomon code: k data shards are stored as they are, m parity shards are computed
+ *        from them, and any k of the k + m shards are enough to rebuild the others.
+ * @details The encoding matrix is the k x k identity on top of an m x k Cauchy matrix, each of whose square
+ *          submatrices is invertible, so every choice of k surviving shards gives an invertible system. Shards are
+ *          processed RS_SLICE_SIZE bytes at a time, so each slice of the sources is read from memory once and then
+ *          served from the cache to every output.
+ */
+class ReedSolomon {
+public:
+    /**
+     * @brief Constructs the code.
+     * @param data_shards The number of data shards (k, at least 1).
+     * @param parity_shards The number of parity shards (m, at least 1).
+     * @param kernel The multiply-and-add implementation to run on.
+     * @throws std::invalid_argument if k or m is 0 or k + m exceeds MAX_TOTAL_SHARDS.
+     */
+    ReedSolomon(unsigned data_shards, unsigned parity_shards, const GfKernel& kernel = gf_fastest_kernel());
+
+    /**
+     * @brief Returns the number of data shards.
+     * @return k.
+     */
+    unsigned data_shards() const;
+
+    /**
+     * @brief Returns the number of parity shards.
+     * @return m.
+     */
+    unsigned parity_shards() const;
+
+    /**
+     * @brief Computes the parity shards of a stripe.
+     * @param data The k data shards.
+     * @param parity The m parity shards, overwritten.
+     * @param size The size of every shard.
+     */
+    void encode(const unsigned char* const* data, unsigned char* const* parity, size_t size) const;
+
+    /**
+     * @brief Rebuilds the missing shards of a stripe from the present ones.
+     * @param shards The k + m shards: data shards first, then parity shards. Missing ones are overwritten.
+     * @param present Which shards hold valid data.
+     * @param size The size of every shard.
+     * @param data_only Rebuild the missing data shards only, leaving missing parity shards as they are.
+     * @return True if the shards were rebuilt; false if fewer than k are present.
+     */
+    bool reconstruct(unsigned char* const* shards, const std::vector<bool>& present, size_t size,
+                     bool data_only = false) const;
+
+private:
+    /**
+     * @brief Multiplies 'size' bytes of several sources by a matrix and stores the products in the outputs.
+     * @param coefficients One row of 'sources.size()' factors per output.
+     * @param sources The source shards.
+     * @param outputs The output shards, overwritten.
+     * @param size The size of every shard.
+     */
+    void multiply(const std::vector<uint8_t>& coefficients, const std::vector<const unsigned char*>& sources,
+                  const std::vector<unsigned char*>& outputs, size_t size) const;
+
+    unsigned data_shards_;          ///< k.
+    unsigned parity_shards_;        ///< m.
+    GfMultiplyAddFn multiply_add_;  ///< The kernel.
+
+    /**
+     * @brief The parity rows of the encoding matrix: m rows of k factors.
+     */
+    std::vector<uint8_t> parity_matrix_;
+};
@@ -0,0 +1,313 @@
+/**
+ * @file Replicator.cpp
+ * @brief Replicator class implementation.
+ * @details This file contains the implementation of the asynchronous, batched replication of saves and deletes.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "Replicator.h"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    uint64_t now_ms()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * @brief Tells whether the peer would refuse a replicated operation again however often it is sent.
+     * @details Only errors of the moment (a failed write, data changed while being read) are worth retrying;
+     *          quotas, redirects and invalid requests would stall the log behind the operation for good.
+     */
+    bool is_permanent_refusal(const ServerStatus status)
+    {
+        return status != ServerStatus::ERR_GENERAL && status != ServerStatus::ERR_CHECKSUM_MISMATCH;
+    }
+}
+
+Replicator::Replicator(std::shared_ptr<FileManager> file_manager, const std::string& root_folder,
+                       std::string peer_host, const unsigned short peer_port)
+    : file_manager_(std::move(file_manager)),
+    log_(root_folder),
+    peer_(std::move(peer_host), peer_port),
+    worker_(&Replicator::replication_loop, this)
+{
+}
+
+Replicator::~Replicator()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+}
+
+void Replicator::record(const Command op_code, const uint32_t user_id, const std::string& filename)
+{
+    {
+        // Appended under the lock, so no record reaches the log once it was handed over
+        std::lock_guard lock(mutex_);
+        if (forward_)
+        {
+            forward_(op_code, user_id, filename);
+            return;
+        }
+        if (handed_over_)
+        {
+            kept_.push_back({ op_code, user_id, filename });
+            return;
+        }
+        log_.append(op_code, user_id, filename);
+    }
+    wake_cv_.notify_one();
+}
+
+void Replicator::hand_over()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+        handed_over_ = true;
+    }
+    wake_cv_.notify_all();
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+}
+
+void Replicator::forward_to(ForwardFn forward)
+{
+    std::lock_guard lock(mutex_);
+    for (const KeptMutation& mutation : kept_)
+    {
+        forward(mutation.op_code, mutation.user_id, mutation.filename);
+    }
+    kept_.clear();
+    forward_ = std::move(forward);
+}
+
+void Replicator::resume()
+{
+    {
+        // Appended under the lock, so the kept mutations stay ahead of any recorded concurrently
+        std::lock_guard lock(mutex_);
+        if (!handed_over_ || worker_.joinable())
+        {
+            return;
+        }
+        for (const KeptMutation& mutation : kept_)
+        {
+            log_.append(mutation.op_code, mutation.user_id, mutation.filename);
+        }
+        kept_.clear();
+        forward_ = nullptr;
+        handed_over_ = false;
+        stopping_ = false;
+        worker_ = std::thread(&Replicator::replication_loop, this);
+    }
+    wake_cv_.notify_one();
+}
+
+ReplicationLag Replicator::lag() const
+{
+    ReplicationLag lag;
+    lag.operations = log_.last_sequence() - log_.acknowledged_sequence();
+    if (const uint64_t oldest = log_.oldest_pending_timestamp(); oldest > 0)
+    {
+        lag.seconds = (now_ms() - std::min(now_ms(), oldest)) / 1000;
+    }
+    lag.connected = connected_;
+    return lag;
+}
+
+std::string Replicator::report() const
+{
+    const ReplicationLag l = lag();
+
+    std::ostringstream out;
+    out << "replication: peer " << peer_.address() << (l.connected ? " connected" : " disconnected")
+        << ", replicated " << replicated_ << " operations, " << dropped_ << " refused by the peer and dropped\n"
+        << "  lag " << l.operations << " operations, " << l.seconds << " seconds"
+        << (l.operations > REPLICATION_LAG_WARNING_OPS ? " (over the warning bound)" : "") << "\n";
+    return out.str();
+}
+
+void Replicator::replication_loop()
+{
+    bool warned_lag = false;
+
+    while (!stopping_)
+    {
+        {
+            std::unique_lock lock(mutex_);
+            wake_cv_.wait(lock, [this] { return stopping_ || log_.last_sequence() > log_.acknowledged_sequence(); });
+        }
+        if (stopping_)
+        {
+            break;
+        }
+
+        try
+        {
+            if (!peer_.is_connected())
+            {
+                peer_.connect();
+                connected_ = true;
+                std::cout << "Replication connected to " << peer_.address() << ", catching up from operation "
+                    << log_.acknowledged_sequence() + 1 << "\n";
+            }
+            if (!replicate_batch())
+            {
+                // Give the peer time to recover before the refused operation is sent again
+                std::unique_lock lock(mutex_);
+                wake_cv_.wait_for(lock, std::chrono::seconds(REPLICATION_RETRY_SECONDS), [this] { return stopping_.load(); });
+            }
+        }
+        catch (const std::exception& e)
+        {
+            if (connected_)
+            {
+                std::cerr << "Replication to " << peer_.address() << " failed: " << e.what() << "\n";
+            }
+            peer_.close();
+            connected_ = false;
+
+            std::unique_lock lock(mutex_);
+            wake_cv_.wait_for(lock, std::chrono::seconds(REPLICATION_RETRY_SECONDS), [this] { return stopping_.load(); });
+        }
+
+        // Warn once each time the lag crosses the bound
+        if (const uint64_t behind = log_.last_sequence() - log_.acknowledged_sequence(); behind > REPLICATION_LAG_WARNING_OPS)
+        {
+            if (!warned_lag)
+            {
+                std::cerr << "Replication lag is " << behind << " operations\n";
+                warned_lag = true;
+            }
+        }
+        else
+        {
+            warned_lag = false;
+        }
+    }
+}
+
+bool Replicator::replicate_batch()
+{
+    const std::vector<OperationRecord> records = log_.pending(REPLICATION_BATCH_SIZE);
+    if (records.empty())
+    {
+        return true;
+    }
+
+    // Only the last operation on a file matters, since it is replicated with the file's current content
+    std::map<std::pair<uint32_t, std::string>, uint64_t> last_sequence;
+    for (const auto& record : records)
+    {
+        last_sequence[{ record.user_id, record.filename }] = record.sequence;
+    }
+
+    std::vector<Request> batch;
+    std::vector<uint64_t> sequences;
+    uint64_t batch_bytes = 0;
+    uint64_t acknowledge_up_to = records.back().sequence;
+
+    for (const auto& record : records)
+    {
+        if (last_sequence[{ record.user_id, record.filename }] != record.sequence)
+        {
+            continue;
+        }
+
+        Request request;
+        request.user_id = record.user_id;
+        request.op_code = record.op_code;
+        request.filename = record.filename;
+
+        if (record.op_code == Command::SAVE_FILE)
+        {
+            try
+            {
+                // A file that is gone was deleted (or quarantined) later; that operation is logged separately
+                if (!file_manager_->read_file(record.user_id, record.filename, request.file_data, &request.payload_checksum))
+                {
+                    continue;
+                }
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Replication skipped " << record.filename << " of user " << record.user_id << ": "
+                    << e.what() << "\n";
+                continue;
+            }
+
+            // Keep the batch's memory bounded; the rest goes with the next batch
+            if (!batch.empty() && batch_bytes + request.file_data.size() > REPLICATION_BATCH_BYTES)
+            {
+                acknowledge_up_to = record.sequence - 1;
+                break;
+            }
+            batch_bytes += request.file_data.size();
+        }
+
+        batch.push_back(std::move(request));
+        sequences.push_back(record.sequence);
+    }
+
+    // Pipeline the whole batch, then collect the responses
+    for (const auto& request : batch)
+    {
+        peer_.send_request(request);
+    }
+    // Every response is read to keep the connection in step; the log is acknowledged up to the first refusal for now
+    bool refused = false;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        const Request& request = batch[i];
+        const Response response = peer_.read_response();
+        const bool ok = response.status == ServerStatus::SUCCESS_NO_PAYLOAD ||
+            (request.op_code == Command::DELETE_FILE && response.status == ServerStatus::ERR_FILE_NOT_FOUND);
+        if (refused)
+        {
+            continue;
+        }
+        if (ok)
+        {
+            ++replicated_;
+            continue;
+        }
+
+        std::cerr << "Peer rejected replicated " << request.filename << " of user " << request.user_id
+            << " with status " << static_cast<uint16_t>(response.status);
+        if (is_permanent_refusal(response.status))
+        {
+            std::cerr << "; dropping it\n";
+            ++dropped_;
+            continue;
+        }
+        std::cerr << "; retrying in " << REPLICATION_RETRY_SECONDS << " seconds\n";
+        acknowledge_up_to = sequences[i] - 1;
+        refused = true;
+    }
+
+    log_.acknowledge(acknowledge_up_to);
+    return !refused;
+}
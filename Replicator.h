@@ -0,0 +1,206 @@
+/**
+ * @file Replicator.h
+ * @brief Replicator class definition.
+ * @details This header file contains the Replicator class, which records every SAVE_FILE and DELETE_FILE in an
+ *          operation log and streams them asynchronously, in batches, to a peer instance of this server.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "FileManager.h"
+#include "OperationLog.h"
+#include "PeerClient.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr size_t REPLICATION_BATCH_SIZE = 64;                        // operations sent before waiting for responses
+constexpr uint64_t REPLICATION_BATCH_BYTES = 64ull * 1024 * 1024;     // payload bytes sent before waiting for responses
+constexpr uint64_t REPLICATION_LAG_WARNING_OPS = 10000;              // lag (in operations) above which a warning is logged
+constexpr unsigned REPLICATION_RETRY_SECONDS = 5;                    // delay between reconnection attempts
+
+/**
+ * @struct ReplicationLag
+ * @brief How far the peer is behind this server.
+ */
+struct ReplicationLag {
+    uint64_t operations = 0;   ///< Logged operations the peer has not acknowledged yet.
+    uint64_t seconds = 0;      ///< Age of the oldest operation the peer has not acknowledged yet.
+    bool connected = false;    ///< Whether the peer connection is currently up.
+};
+
+/**
+ * @class Replicator
+ * @brief Asynchronously replicates saves and deletes to a peer server.
+ * @details Client sessions only append a small record to the operation log, so a slow or unreachable peer never
+ *          adds latency to client requests. A background thread reads batches of pending records, coalesces repeated
+ *          operations on the same file, sends the current content of each file (pipelined, with its checksum) and
+ *          acknowledges the batch once the peer has answered every request. After a disconnection it reconnects and
+ *          resumes from the last acknowledged record. An operation the peer refuses for now (e.g. a write error) is
+ *          not acknowledged and is sent again after a delay; one it can never accept (e.g. over its quota) is dropped
+ *          and counted.
+ *          Replication is one-way: two servers must not be configured as each other's peer.
+ */
+class Replicator {
+public:
+    /**
+     * @brief Takes the mutations recorded after forward_to().
+     */
+    using ForwardFn = std::function<void(Command op_code, uint32_t user_id, const std::string& filename)>;
+
+    /**
+     * @brief Constructs a Replicator and starts its background thread.
+     * @param file_manager The file manager the replicated files are read from.
+     * @param root_folder The (first) storage root folder, holding the operation log.
+     * @param peer_host The peer's host name or IP address.
+     * @param peer_port The peer's port.
+     */
+    Replicator(std::shared_ptr<FileManager> file_manager, const std::string& root_folder,
+               std::string peer_host, unsigned short peer_port);
+
+    /**
+     * @brief Stops the background thread (pending operations stay in the log).
+     */
+    ~Replicator();
+
+    Replicator(const Replicator&) = delete;
+    Replicator& operator=(const Replicator&) = delete;
+
+    /**
+     * @brief Records a mutation to be replicated.
+     * @param op_code SAVE_FILE or DELETE_FILE.
+     * @param user_id The user owning the file.
+     * @param filename The file that was saved or deleted.
+     */
+    void record(Command op_code, uint32_t user_id, const std::string& filename);
+
+    /**
+     * @brief Stops replicating and keeps the mutations recorded from now on in memory instead of the operation log.
+     * @details Used when a successor process takes over: it replays the operation log, which this process no
+     *          longer writes, and then takes the kept mutations through forward_to().
+     */
+    void hand_over();
+
+    /**
+     * @brief Passes the mutations kept since hand_over(), then each one recorded from now on, to another process.
+     * @param forward Takes each mutation, in the order they were recorded.
+     */
+    void forward_to(ForwardFn forward);
+
+    /**
+     * @brief Appends the mutations kept since hand_over() to the operation log and replicates again (the handoff
+     *        failed).
+     */
+    void resume();
+
+    /**
+     * @brief Returns how far the peer is behind.
+     * @return The replication lag.
+     */
+    ReplicationLag lag() const;
+
+    /**
+     * @brief Formats the replication state as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @brief Background loop: connects to the peer and replicates batches while operations are pending.
+     */
+    void replication_loop();
+
+    /**
+     * @brief Sends one batch of pending operations and acknowledges it, up to the first one the peer refused for now.
+     * @return False if the peer refused an operation for now (it is sent again after a delay).
+     * @throws boost::system::system_error if the connection to the peer fails.
+     */
+    bool replicate_batch();
+
+    /**
+     * @brief The file manager the replicated files are read from.
+     */
+    std::shared_ptr<FileManager> file_manager_;
+
+    /**
+     * @brief The operations waiting to be replicated.
+     */
+    OperationLog log_;
+
+    /**
+     * @brief The connection to the peer (only used by the background thread).
+     */
+    PeerClient peer_;
+
+    /**
+     * @brief A mutation kept in memory between hand_over() and forward_to() or resume().
+     */
+    struct KeptMutation {
+        Command op_code;        ///< SAVE_FILE or DELETE_FILE.
+        uint32_t user_id;       ///< The user owning the file.
+        std::string filename;   ///< The file that was saved or deleted.
+    };
+
+    /**
+     * @brief Guards the wake-up condition, 'handed_over_', 'kept_' and 'forward_'.
+     */
+    std::mutex mutex_;
+
+    /**
+     * @brief Set by hand_over(): mutations no longer reach the operation log.
+     */
+    bool handed_over_ = false;
+
+    /**
+     * @brief The mutations recorded after hand_over(), until forward_to() or resume().
+     */
+    std::vector<KeptMutation> kept_;
+
+    /**
+     * @brief Takes the mutations recorded after forward_to() (empty until then).
+     */
+    ForwardFn forward_;
+
+    /**
+     * @brief Wakes the background thread when an operation is recorded or on shutdown.
+     */
+    std::condition_variable wake_cv_;
+
+    /**
+     * @brief Set when the replicator is shutting down.
+     */
+    std::atomic<bool> stopping_{ false };
+
+    /**
+     * @brief Whether the peer connection is currently up.
+     */
+    std::atomic<bool> connected_{ false };
+
+    /**
+     * @brief Operations the peer has acknowledged since startup.
+     */
+    std::atomic<uint64_t> replicated_{ 0 };
+
+    /**
+     * @brief Operations the peer refused for good, dropped since startup.
+     */
+    std::atomic<uint64_t> dropped_{ 0 };
+
+    /**
+     * @brief The background thread.
+     */
+    std::thread worker_;
+};
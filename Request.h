@@ -13,6 +13,8 @@
 
 #include "protocols.h"
 
+#include <chrono>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -23,7 +25,14 @@
 struct Request {
     uint32_t user_id = 0;                       ///< The user ID associated with the request.
     uint8_t version = 0;                        ///< The protocol version of the request.
+    uint32_t request_id = 0;                    ///< The client's ID for the request (version 3 and above only).
     Command op_code = static_cast<Command>(0);  ///< The operation code indicating the type of request.
     std::string filename;                       ///< The filename sent by the client (possibly empty for some operations).
     std::vector<unsigned char> file_data;       ///< The file data for SAVE_FILE operations (not used for DELETE/RESTORE/LIST).
+    std::optional<uint32_t> expected_checksum;  ///< The CRC-32C the client sent with SAVE_FILE (version 2 and above only).
+    uint32_t payload_checksum = 0;              ///< The CRC-32C computed by the parser while receiving file_data.
+    std::optional<ServerStatus> refusal;        ///< Set when the payload was refused from its announced size: the request is answered with this status, unprocessed.
+    bool payload_unread = false;                ///< The refused payload was too large to skip, so no further request can be read.
+    uint32_t payload_size = 0;                  ///< The payload size announced by the client (also when the payload was refused).
+    std::chrono::steady_clock::time_point received; ///< When the request's header arrived (set by the parser).
 };
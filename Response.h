@@ -13,6 +13,7 @@
 
 #include "protocols.h"
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -22,7 +23,9 @@
   */
 struct Response {
     uint8_t version = 1;                              ///< Server version.
+    uint32_t request_id = 0;                          ///< The ID of the request answered (version 3 and above only).
     ServerStatus status = ServerStatus::ERR_GENERAL;  ///< Status of the response.
     std::string filename;                             ///< The filename returned to the client (may be empty if not relevant).
 	std::vector<unsigned char> payload;               ///< The payload if status is 210 (file found) or 211 (list).
+    std::optional<uint32_t> checksum;                 ///< The CRC-32C of the payload, sent with status 210 to version 2 clients.
 };
\ No newline at end of file
@@ -0,0 +1,570 @@
+/**
+ * @file SegmentStore.cpp
+ * @brief SegmentStore class implementation.
+ * @details This file contains the implementation of the log-structured segment storage used for small files,
+ *          including index replay, appends, positioned reads and background compaction.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "SegmentStore.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <system_error>
+
+namespace
+{
+    constexpr uint8_t RECORD_PUT = 1;     // index record: filename stored at (segment, offset, length, checksum)
+    constexpr uint8_t RECORD_REMOVE = 2;  // index record: filename removed
+    constexpr size_t RECORD_FIXED_SIZE = 1 + 2 + 4 + 8 + 4 + 4; // type + name_len + segment + offset + length + checksum
+
+    const std::string INDEX_FILE = "index.log";
+    const std::string SEGMENT_EXTENSION = ".seg";
+
+    std::vector<unsigned char> encode_record(const std::string& filename, const std::optional<SegmentEntry>& entry)
+    {
+        std::vector<unsigned char> record;
+        record.reserve(RECORD_FIXED_SIZE + filename.size());
+
+        const SegmentEntry e = entry.value_or(SegmentEntry{});
+        write_uint8(record, entry ? RECORD_PUT : RECORD_REMOVE);
+        write_uint16_le(record, static_cast<uint16_t>(filename.size()));
+        record.insert(record.end(), filename.begin(), filename.end());
+        write_uint32_le(record, e.segment_id);
+        write_uint64_le(record, e.offset);
+        write_uint32_le(record, e.length);
+        write_uint32_le(record, e.checksum);
+        return record;
+    }
+
+    /**
+     * @brief Parses a segment file's stem as its ID.
+     * @return The segment ID, or std::nullopt if the stem is not a number that fits one.
+     */
+    std::optional<uint32_t> parse_segment_id(const std::string& stem)
+    {
+        if (stem.empty() || stem.size() > 10 || stem.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return std::nullopt;
+        }
+        const unsigned long long id = std::stoull(stem);
+        if (id > std::numeric_limits<uint32_t>::max())
+        {
+            return std::nullopt;
+        }
+        return static_cast<uint32_t>(id);
+    }
+
+    /**
+     * @brief Replays an index log into the live entries it describes, stopping at a torn trailing record.
+     */
+    std::unordered_map<std::string, SegmentEntry> read_index(const std::string& path)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        const std::vector<unsigned char> log((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+        std::unordered_map<std::string, SegmentEntry> index;
+        size_t pos = 0;
+        while (pos + RECORD_FIXED_SIZE <= log.size())
+        {
+            const uint8_t type = log[pos];
+            const uint16_t name_len = read_uint_16_le(log.data() + pos + 1);
+            if (pos + RECORD_FIXED_SIZE + name_len > log.size())
+            {
+                break;
+            }
+
+            const unsigned char* fields = log.data() + pos + 3 + name_len;
+            std::string filename(reinterpret_cast<const char*>(log.data() + pos + 3), name_len);
+            pos += RECORD_FIXED_SIZE + name_len;
+
+            if (type == RECORD_PUT)
+            {
+                SegmentEntry entry;
+                entry.segment_id = read_uint_32_le(fields);
+                entry.offset = read_uint_64_le(fields + 4);
+                entry.length = read_uint_32_le(fields + 12);
+                entry.checksum = read_uint_32_le(fields + 16);
+                index[std::move(filename)] = entry;
+            }
+            else
+            {
+                index.erase(filename);
+            }
+        }
+        return index;
+    }
+
+    /**
+     * @brief Returns the name of a segment file.
+     */
+    std::string segment_file_name(const uint32_t segment_id)
+    {
+        char name[16];
+        std::snprintf(name, sizeof(name), "%08u", segment_id);
+        return name + SEGMENT_EXTENSION;
+    }
+
+    /**
+     * @brief Reads an entry's bytes from its segment file.
+     */
+    void read_entry(const std::string& path, const SegmentEntry& entry, std::vector<unsigned char>& out_data)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        out_data.resize(entry.length);
+        if (!ifs.is_open() || !ifs.seekg(static_cast<std::streamoff>(entry.offset)) ||
+            !ifs.read(reinterpret_cast<char*>(out_data.data()), entry.length))
+        {
+            throw std::filesystem::filesystem_error("Error while reading the segment", path,
+                std::make_error_code(std::errc::io_error));
+        }
+    }
+}
+
+SegmentStore::SegmentStore(std::shared_ptr<StorageRoots> roots)
+    : roots_(std::move(roots)),
+    compactor_(&SegmentStore::compaction_loop, this)
+{
+}
+
+SegmentStore::~SegmentStore()
+{
+    stop_compaction();
+}
+
+void SegmentStore::stop_compaction()
+{
+    {
+        std::lock_guard lock(users_mutex_);
+        stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    if (compactor_.joinable())
+    {
+        compactor_.join();
+    }
+}
+
+void SegmentStore::resume_compaction()
+{
+    std::lock_guard lock(users_mutex_);
+    if (!stopping_ || compactor_.joinable())
+    {
+        return;
+    }
+    stopping_ = false;
+    compactor_ = std::thread(&SegmentStore::compaction_loop, this);
+}
+
+bool SegmentStore::put(const uint32_t user_id, const std::string& filename, const std::vector<unsigned char>& data,
+                       const uint32_t checksum)
+{
+    const auto segments = user_segments(user_id);
+    std::unique_lock lock(segments->mutex);
+
+    const auto entry = append(user_id, *segments, data.data(), static_cast<uint32_t>(data.size()), checksum);
+    if (!entry || !log_record(user_id, *segments, filename, entry))
+    {
+        return false;
+    }
+
+    if (const auto it = segments->index.find(filename); it != segments->index.end())
+    {
+        release(*segments, it->second);
+    }
+    segments->index[filename] = *entry;
+    return true;
+}
+
+bool SegmentStore::get(const uint32_t user_id, const std::string& filename, std::vector<unsigned char>& out_data,
+                       uint32_t* out_checksum)
+{
+    const auto segments = user_segments(user_id);
+    std::shared_lock lock(segments->mutex);
+
+    const auto it = segments->index.find(filename);
+    if (it == segments->index.end())
+    {
+        return false;
+    }
+    const SegmentEntry& entry = it->second;
+
+    // Positioned read of just this entry; the shared lock keeps compaction from deleting the segment meanwhile
+    read_entry(segment_file_path(user_id, entry.segment_id), entry, out_data);
+
+    if (out_checksum != nullptr)
+    {
+        *out_checksum = entry.checksum;
+    }
+    return true;
+}
+
+std::optional<SegmentEntry> SegmentStore::find(const uint32_t user_id, const std::string& filename)
+{
+    const auto segments = user_segments(user_id);
+    std::shared_lock lock(segments->mutex);
+
+    if (const auto it = segments->index.find(filename); it != segments->index.end())
+    {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+bool SegmentStore::remove(const uint32_t user_id, const std::string& filename)
+{
+    const auto segments = user_segments(user_id);
+    std::unique_lock lock(segments->mutex);
+
+    const auto it = segments->index.find(filename);
+    if (it == segments->index.end())
+    {
+        return false;
+    }
+
+    if (!log_record(user_id, *segments, filename, std::nullopt))
+    {
+        throw std::filesystem::filesystem_error("Error while writing the segment index",
+            index_file_path(user_id), std::make_error_code(std::errc::io_error));
+    }
+    release(*segments, it->second);
+    segments->index.erase(it);
+    return true;
+}
+
+std::vector<std::string> SegmentStore::list(const uint32_t user_id)
+{
+    const auto segments = user_segments(user_id);
+    std::shared_lock lock(segments->mutex);
+
+    std::vector<std::string> files;
+    files.reserve(segments->index.size());
+    for (const auto& [filename, entry] : segments->index)
+    {
+        files.push_back(filename);
+    }
+    return files;
+}
+
+std::optional<std::filesystem::file_time_type> SegmentStore::segment_write_time(const uint32_t user_id,
+                                                                                const uint32_t segment_id) const
+{
+    std::error_code ec;
+    const auto time = std::filesystem::last_write_time(segment_file_path(user_id, segment_id), ec);
+    return ec ? std::nullopt : std::optional(time);
+}
+
+uint64_t SegmentStore::compact(const uint32_t user_id)
+{
+    const auto segments = user_segments(user_id);
+    std::unique_lock lock(segments->mutex);
+
+    // Pick the sealed segments that are mostly dead
+    std::vector<uint32_t> victims;
+    for (const auto& [segment_id, usage] : segments->usage)
+    {
+        if (segment_id != segments->active_segment && usage.total > 0 &&
+            static_cast<double>(usage.total - usage.live) >= COMPACTION_GARBAGE_RATIO * static_cast<double>(usage.total))
+        {
+            victims.push_back(segment_id);
+        }
+    }
+    if (victims.empty())
+    {
+        return 0;
+    }
+
+    // Copy the live entries of those segments into the active segment
+    std::vector<unsigned char> buffer;
+    uint64_t moved_bytes = 0;
+    for (auto& [filename, entry] : segments->index)
+    {
+        if (std::find(victims.begin(), victims.end(), entry.segment_id) == victims.end())
+        {
+            continue;
+        }
+
+        std::ifstream ifs(segment_file_path(user_id, entry.segment_id), std::ios::binary);
+        buffer.resize(entry.length);
+        if (!ifs.seekg(static_cast<std::streamoff>(entry.offset)) ||
+            !ifs.read(reinterpret_cast<char*>(buffer.data()), entry.length))
+        {
+            return 0;
+        }
+
+        // The original checksum travels with the data, so damage that happened before the copy stays detectable
+        const auto moved = append(user_id, *segments, buffer.data(), entry.length, entry.checksum);
+        if (!moved)
+        {
+            return 0;
+        }
+        release(*segments, entry);
+        entry = *moved;
+        moved_bytes += entry.length;
+    }
+
+    // Publish the new locations before the old segments disappear, so a crash never loses data
+    if (!rewrite_index(user_id, *segments))
+    {
+        return 0;
+    }
+
+    uint64_t reclaimed = 0;
+    for (const uint32_t segment_id : victims)
+    {
+        std::error_code ec;
+        std::filesystem::remove(segment_file_path(user_id, segment_id), ec);
+        reclaimed += segments->usage[segment_id].total;
+        segments->usage.erase(segment_id);
+    }
+    return reclaimed - std::min(reclaimed, moved_bytes);
+}
+
+size_t SegmentStore::snapshot(const uint32_t user_id, const std::string& folder)
+{
+    std::filesystem::create_directories(folder);
+
+    const auto segments = user_segments(user_id);
+    std::unordered_map<std::string, SegmentEntry> index;
+    {
+        std::shared_lock lock(segments->mutex);
+        for (const auto& [segment_id, usage] : segments->usage)
+        {
+            if (usage.live > 0)
+            {
+                std::filesystem::create_hard_link(segment_file_path(user_id, segment_id),
+                                                  folder + segment_file_name(segment_id));
+            }
+        }
+        index = segments->index;
+    }
+
+    std::ofstream ofs(folder + INDEX_FILE, std::ios::binary);
+    for (const auto& [filename, entry] : index)
+    {
+        const auto record = encode_record(filename, entry);
+        ofs.write(reinterpret_cast<const char*>(record.data()), static_cast<std::streamsize>(record.size()));
+    }
+    if (!ofs.flush())
+    {
+        throw std::filesystem::filesystem_error("Error while writing the snapshot index", folder + INDEX_FILE,
+            std::make_error_code(std::errc::io_error));
+    }
+    return index.size();
+}
+
+bool SegmentStore::get_from_snapshot(const std::string& folder, const std::string& filename,
+                                     std::vector<unsigned char>& out_data, uint32_t* out_checksum)
+{
+    const auto index = read_index(folder + INDEX_FILE);
+    const auto it = index.find(filename);
+    if (it == index.end())
+    {
+        return false;
+    }
+
+    read_entry(folder + segment_file_name(it->second.segment_id), it->second, out_data);
+    if (out_checksum != nullptr)
+    {
+        *out_checksum = it->second.checksum;
+    }
+    return true;
+}
+
+std::shared_ptr<SegmentStore::UserSegments> SegmentStore::user_segments(const uint32_t user_id)
+{
+    std::lock_guard lock(users_mutex_);
+
+    auto& segments = users_[user_id];
+    if (!segments)
+    {
+        segments = std::make_shared<UserSegments>();
+        load(user_id, *segments);
+    }
+    return segments;
+}
+
+void SegmentStore::load(const uint32_t user_id, UserSegments& segments) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(segments_path(user_id), ec);
+
+    // Size every existing segment (this also counts bytes orphaned by a crash between a data and an index write)
+    for (const auto& p : std::filesystem::directory_iterator(segments_path(user_id), ec))
+    {
+        if (p.path().extension() != SEGMENT_EXTENSION)
+        {
+            continue;
+        }
+        const auto parsed = parse_segment_id(p.path().stem().string());
+        if (!parsed)
+        {
+            std::cerr << "Skipping " << p.path().string() << ": not a segment of user " << user_id << "\n";
+            continue;
+        }
+        const uint32_t segment_id = *parsed;
+        segments.usage[segment_id].total = std::filesystem::file_size(p.path(), ec);
+        segments.active_segment = std::max(segments.active_segment, segment_id);
+    }
+
+    // Replay the index log; only the entries that are still live count towards their segments
+    segments.index = read_index(index_file_path(user_id));
+    for (const auto& [filename, entry] : segments.index)
+    {
+        segments.usage[entry.segment_id].live += entry.length;
+    }
+}
+
+std::optional<SegmentEntry> SegmentStore::append(const uint32_t user_id, UserSegments& segments,
+                                                 const unsigned char* data, const uint32_t size,
+                                                 const uint32_t checksum) const
+{
+    // Roll over to a fresh segment once the active one is full
+    if (auto& usage = segments.usage[segments.active_segment]; usage.total > 0 && usage.total + size > MAX_SEGMENT_SIZE)
+    {
+        segments.active_out.close();
+        ++segments.active_segment;
+    }
+
+    const std::string path = segment_file_path(user_id, segments.active_segment);
+    if (!segments.active_out.is_open())
+    {
+        segments.active_out.open(path, std::ios::binary | std::ios::app);
+        if (!segments.active_out.is_open())
+        {
+            return std::nullopt;
+        }
+    }
+
+    SegmentUsage& usage = segments.usage[segments.active_segment];
+    SegmentEntry entry;
+    entry.segment_id = segments.active_segment;
+    entry.offset = usage.total;
+    entry.length = size;
+    entry.checksum = checksum;
+
+    segments.active_out.write(reinterpret_cast<const char*>(data), size);
+    segments.active_out.flush();
+    if (!segments.active_out)
+    {
+        // Resynchronize the accounting with whatever made it to disk
+        segments.active_out.close();
+        std::error_code ec;
+        usage.total = std::filesystem::file_size(path, ec);
+        return std::nullopt;
+    }
+
+    usage.total += size;
+    usage.live += size;
+    return entry;
+}
+
+bool SegmentStore::log_record(const uint32_t user_id, UserSegments& segments, const std::string& filename,
+                              const std::optional<SegmentEntry>& entry) const
+{
+    if (!segments.index_out.is_open())
+    {
+        segments.index_out.open(index_file_path(user_id), std::ios::binary | std::ios::app);
+    }
+
+    const auto record = encode_record(filename, entry);
+    segments.index_out.write(reinterpret_cast<const char*>(record.data()), static_cast<std::streamsize>(record.size()));
+    segments.index_out.flush();
+    if (!segments.index_out)
+    {
+        segments.index_out.close();
+        return false;
+    }
+    return true;
+}
+
+bool SegmentStore::rewrite_index(const uint32_t user_id, UserSegments& segments) const
+{
+    const std::string tmp_path = index_file_path(user_id) + ".tmp";
+    {
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        for (const auto& [filename, entry] : segments.index)
+        {
+            const auto record = encode_record(filename, entry);
+            ofs.write(reinterpret_cast<const char*>(record.data()), static_cast<std::streamsize>(record.size()));
+        }
+        if (!ofs.flush())
+        {
+            return false;
+        }
+    }
+
+    segments.index_out.close();
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, index_file_path(user_id), ec);
+    return !ec;
+}
+
+void SegmentStore::release(UserSegments& segments, const SegmentEntry& entry)
+{
+    if (const auto it = segments.usage.find(entry.segment_id); it != segments.usage.end())
+    {
+        it->second.live -= std::min<uint64_t>(it->second.live, entry.length);
+    }
+}
+
+void SegmentStore::compaction_loop()
+{
+    std::unique_lock lock(users_mutex_);
+    while (!stopping_)
+    {
+        stop_cv_.wait_for(lock, std::chrono::seconds(COMPACTION_INTERVAL_SECONDS));
+        if (stopping_)
+        {
+            break;
+        }
+
+        std::vector<uint32_t> user_ids;
+        user_ids.reserve(users_.size());
+        for (const auto& [user_id, segments] : users_)
+        {
+            user_ids.push_back(user_id);
+        }
+
+        lock.unlock();
+        for (const uint32_t user_id : user_ids)
+        {
+            try
+            {
+                if (const uint64_t reclaimed = compact(user_id); reclaimed > 0)
+                {
+                    std::cout << "Compacted segments of user " << user_id << ", reclaimed " << reclaimed << " bytes\n";
+                }
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Error compacting segments of user " << user_id << ": " << e.what() << "\n";
+            }
+        }
+        lock.lock();
+    }
+}
+
+std::string SegmentStore::segments_path(const uint32_t user_id) const
+{
+    return roots_->user_root(user_id) + std::to_string(user_id) + "/" + SEGMENTS_FOLDER;
+}
+
+std::string SegmentStore::segment_file_path(const uint32_t user_id, const uint32_t segment_id) const
+{
+    return segments_path(user_id) + segment_file_name(segment_id);
+}
+
+std::string SegmentStore::index_file_path(const uint32_t user_id) const
+{
+    return segments_path(user_id) + INDEX_FILE;
+}
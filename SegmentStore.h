@@ -0,0 +1,297 @@
+/**
+ * @file SegmentStore.h
+ * @brief SegmentStore class definition.
+ * @details This header file contains the SegmentStore class, a log-structured storage engine that packs small files
+ *          into large per-user segment files instead of storing each of them as its own file.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "StorageRoots.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+const std::string SEGMENTS_FOLDER = ".segments/";           // per-user folder holding the segment files and their index
+constexpr uint64_t MAX_SEGMENT_SIZE = 64ull * 1024 * 1024;    // a new segment is started once the active one reaches 64MB
+constexpr double COMPACTION_GARBAGE_RATIO = 0.5;              // a sealed segment is compacted once half of it is dead
+constexpr unsigned COMPACTION_INTERVAL_SECONDS = 30;          // how often the background compactor looks for work
+
+/**
+ * @struct SegmentEntry
+ * @brief Location of a single file inside a segment.
+ */
+struct SegmentEntry {
+    uint32_t segment_id = 0;  ///< The segment holding the data.
+    uint64_t offset = 0;      ///< Offset of the data inside the segment.
+    uint32_t length = 0;      ///< Length of the data.
+    uint32_t checksum = 0;    ///< CRC-32C of the data.
+};
+
+/**
+ * @class SegmentStore
+ * @brief Appends small files into per-user segment files and serves them with positioned reads.
+ * @details Each user folder gets a '.segments' folder with numbered segment files and an append-only index log
+ *          of (filename -> segment, offset, length, checksum) records. The index is replayed into memory the first time
+ *          a user is accessed. Overwritten and deleted entries leave dead bytes behind, which a background thread
+ *          reclaims by copying the live entries of mostly-dead segments into the active segment.
+ */
+class SegmentStore {
+public:
+    /**
+     * @brief Constructs a SegmentStore over the given storage roots and starts the background compactor.
+     * @param roots The storage roots holding the user folders.
+     */
+    explicit SegmentStore(std::shared_ptr<StorageRoots> roots);
+
+    /**
+     * @brief Stops the background compactor.
+     */
+    ~SegmentStore();
+
+    SegmentStore(const SegmentStore&) = delete;
+    SegmentStore& operator=(const SegmentStore&) = delete;
+
+    /**
+     * @brief Stops the background compactor, waiting for a compaction in progress to finish.
+     */
+    void stop_compaction();
+
+    /**
+     * @brief Starts the background compactor again after stop_compaction().
+     */
+    void resume_compaction();
+
+    /**
+     * @brief Appends a file to the user's active segment, replacing any previous version.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param data The file data.
+     * @param checksum The CRC-32C of the data.
+     * @return True on success; false on error.
+     */
+    bool put(uint32_t user_id, const std::string& filename, const std::vector<unsigned char>& data, uint32_t checksum);
+
+    /**
+     * @brief Reads a file from its segment.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @param out_data The vector to store the file data.
+     * @param out_checksum Optional output for the stored CRC-32C of the data.
+     * @return True if the file is stored in a segment; false otherwise.
+     * @throws std::filesystem::filesystem_error if the segment cannot be read.
+     */
+    bool get(uint32_t user_id, const std::string& filename, std::vector<unsigned char>& out_data,
+             uint32_t* out_checksum = nullptr);
+
+    /**
+     * @brief Looks up where a file is stored.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return The entry, or nothing if the file is not stored in a segment.
+     */
+    std::optional<SegmentEntry> find(uint32_t user_id, const std::string& filename);
+
+    /**
+     * @brief Removes a file from the index (its bytes are reclaimed by compaction).
+     * @param user_id The user ID.
+     * @param filename The filename.
+     * @return True if the file was stored in a segment; false otherwise.
+     */
+    bool remove(uint32_t user_id, const std::string& filename);
+
+    /**
+     * @brief Lists the files stored in the user's segments.
+     * @param user_id The user ID.
+     * @return The list of filenames.
+     */
+    std::vector<std::string> list(uint32_t user_id);
+
+    /**
+     * @brief Returns when a segment was last written, which is no earlier than any file it holds.
+     * @param user_id The user ID.
+     * @param segment_id The segment.
+     * @return The segment file's modification time, or nothing if it cannot be read.
+     */
+    std::optional<std::filesystem::file_time_type> segment_write_time(uint32_t user_id, uint32_t segment_id) const;
+
+    /**
+     * @brief Compacts every sealed segment of the user whose dead bytes exceed the garbage ratio.
+     * @param user_id The user ID.
+     * @return The number of bytes reclaimed.
+     */
+    uint64_t compact(uint32_t user_id);
+
+    /**
+     * @brief Captures the user's segment index in a snapshot folder without copying any data.
+     * @details The segments holding live entries are hard-linked into the folder under the shared lock, so reads go
+     *          on and saves only wait for the links to be made; the captured index is written after the lock is
+     *          released. Sealed segments are never modified and the active one only grows, so the links keep the
+     *          captured bytes even after compaction removes the originals.
+     * @param user_id The user ID.
+     * @param folder The snapshot's segments folder (created if missing).
+     * @return The number of files captured.
+     * @throws std::filesystem::filesystem_error if a segment cannot be linked or the index cannot be written.
+     */
+    size_t snapshot(uint32_t user_id, const std::string& folder);
+
+    /**
+     * @brief Reads a file from a folder written by snapshot().
+     * @param folder The snapshot's segments folder.
+     * @param filename The filename.
+     * @param out_data The vector to store the file data.
+     * @param out_checksum Optional output for the stored CRC-32C of the data.
+     * @return True if the snapshot holds the file; false otherwise.
+     * @throws std::filesystem::filesystem_error if the segment cannot be read.
+     */
+    static bool get_from_snapshot(const std::string& folder, const std::string& filename,
+                                  std::vector<unsigned char>& out_data, uint32_t* out_checksum = nullptr);
+
+private:
+    /**
+     * @struct SegmentUsage
+     * @brief Total and live byte counts of a segment.
+     */
+    struct SegmentUsage {
+        uint64_t total = 0;
+        uint64_t live = 0;
+    };
+
+    /**
+     * @struct UserSegments
+     * @brief In-memory state of one user's segments.
+     */
+    struct UserSegments {
+        std::shared_mutex mutex;                               ///< Shared for reads, exclusive for appends and compaction.
+        std::unordered_map<std::string, SegmentEntry> index;   ///< Live entries by filename.
+        std::map<uint32_t, SegmentUsage> usage;                ///< Byte accounting by segment id.
+        uint32_t active_segment = 1;                           ///< The segment new data is appended to.
+        std::ofstream active_out;                              ///< Kept open so appends cost no open/close.
+        std::ofstream index_out;                               ///< Kept open so index records cost no open/close.
+    };
+
+    /**
+     * @brief Returns the state of a user, replaying the index log the first time.
+     * @param user_id The user ID.
+     * @return The user's segments.
+     */
+    std::shared_ptr<UserSegments> user_segments(uint32_t user_id);
+
+    /**
+     * @brief Replays a user's index log.
+     * @param user_id The user ID.
+     * @param segments The state to fill.
+     */
+    void load(uint32_t user_id, UserSegments& segments) const;
+
+    /**
+     * @brief Appends data to the active segment (rolling over to a new one when full). Caller holds the exclusive lock.
+     * @param user_id The user ID.
+     * @param segments The user's segments.
+     * @param data The data to append.
+     * @param size The number of bytes.
+     * @param checksum The CRC-32C of the data.
+     * @return The entry describing the appended data, or nothing on error.
+     */
+    std::optional<SegmentEntry> append(uint32_t user_id, UserSegments& segments, const unsigned char* data,
+                                       uint32_t size, uint32_t checksum) const;
+
+    /**
+     * @brief Appends a record to the user's index log. Caller holds the exclusive lock.
+     * @param user_id The user ID.
+     * @param segments The user's segments.
+     * @param filename The filename.
+     * @param entry The entry to record, or nothing for a removal.
+     * @return True on success; false on error.
+     */
+    bool log_record(uint32_t user_id, UserSegments& segments, const std::string& filename,
+                    const std::optional<SegmentEntry>& entry) const;
+
+    /**
+     * @brief Rewrites the index log so it only holds the live entries. Caller holds the exclusive lock.
+     * @param user_id The user ID.
+     * @param segments The user's segments.
+     * @return True on success; false on error.
+     */
+    bool rewrite_index(uint32_t user_id, UserSegments& segments) const;
+
+    /**
+     * @brief Marks an entry's bytes as dead in its segment's accounting.
+     * @param segments The user's segments.
+     * @param entry The entry that is no longer live.
+     */
+    static void release(UserSegments& segments, const SegmentEntry& entry);
+
+    /**
+     * @brief Background loop that periodically compacts the loaded users.
+     */
+    void compaction_loop();
+
+    /**
+     * @brief Helper function to get the user's segments folder path.
+     * @param user_id The user ID.
+     * @return The segments folder path.
+     */
+    std::string segments_path(uint32_t user_id) const;
+
+    /**
+     * @brief Helper function to get the path of a segment file.
+     * @param user_id The user ID.
+     * @param segment_id The segment ID.
+     * @return The segment file path.
+     */
+    std::string segment_file_path(uint32_t user_id, uint32_t segment_id) const;
+
+    /**
+     * @brief Helper function to get the path of the user's index log.
+     * @param user_id The user ID.
+     * @return The index log path.
+     */
+    std::string index_file_path(uint32_t user_id) const;
+
+    /**
+     * @brief The storage roots holding the user folders.
+     */
+    std::shared_ptr<StorageRoots> roots_;
+
+    /**
+     * @brief Guards 'users_'.
+     */
+    std::mutex users_mutex_;
+
+    /**
+     * @brief The users whose index has been loaded.
+     */
+    std::unordered_map<uint32_t, std::shared_ptr<UserSegments>> users_;
+
+    /**
+     * @brief Wakes the compactor when the store is shutting down.
+     */
+    std::condition_variable stop_cv_;
+
+    /**
+     * @brief Set when the compactor must exit (guarded by 'users_mutex_').
+     */
+    bool stopping_ = false;
+
+    /**
+     * @brief The background compaction thread.
+     */
+    std::thread compactor_;
+};
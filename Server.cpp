@@ -1,7 +1,8 @@
 /**
  * @file Server.h
  * @brief Server class implementation.
- * @details This class manages the server operations, including accepting client connections and handling them.
+ * @details This class manages the server operations, including accepting client connections and handling them,
+ *          and the handoff of the listening socket between the server and the process replacing it.
  *
  * @version 1.0
  * @author Dmitriy Gorodov
@@ -10,18 +11,63 @@
  */
 
 #include "Server.h"
-#include "ClientSession.h"
+#include <future>
 #include <iostream>
+#include <set>
 
 using boost::asio::ip::tcp;
 
-Server::Server(boost::asio::io_context& io_context, const unsigned short port)
+namespace
+{
+    /**
+     * @brief Opens the listening socket, or adopts the one a predecessor handed over.
+     * @param io_context The io_context for asynchronous operations.
+     * @param port The port to listen on (without an inherited socket).
+     * @param inherited The inherited socket (-1: none).
+     * @return The acceptor.
+     */
+    tcp::acceptor open_acceptor(boost::asio::io_context& io_context, const unsigned short port, const int inherited)
+    {
+        if (inherited < 0)
+        {
+            return tcp::acceptor(io_context, tcp::endpoint(tcp::v4(), port));
+        }
+        return tcp::acceptor(io_context, tcp::v4(), inherited);
+    }
+}
+
+Server::Server(boost::asio::io_context& io_context, const ServerConfig& config)
     : io_context_(io_context),
-    acceptor_(io_context_, tcp::endpoint(tcp::v4(), port))
+    predecessor_(config.takeover_socket.empty() ? nullptr : HandoffChannel::connect(config.takeover_socket)),
+    inherited_(predecessor_ ? predecessor_->take_over() : HandoffState{}),
+    handoff_listener_(config.handoff_socket.empty() ? nullptr : std::make_unique<HandoffListener>(config.handoff_socket)),
+    acceptor_(open_acceptor(io_context_, config.port, inherited_.listener)),
+    core_(config),
+    drain_timeout_(config.drain_timeout)
 {
+    if (predecessor_)
+    {
+        take_over();
+    }
+    if (handoff_listener_)
+    {
+        handoff_thread_ = std::thread(&Server::wait_for_successor, this);
+    }
     start_accept();
 }
 
+Server::~Server()
+{
+    if (handoff_listener_)
+    {
+        handoff_listener_->close();
+    }
+    if (handoff_thread_.joinable())
+    {
+        handoff_thread_.join();
+    }
+}
+
 void Server::start_accept()
 {
     auto socket = std::make_shared<tcp::socket>(io_context_);
@@ -36,12 +82,241 @@ void Server::handle_accept(std::shared_ptr<tcp::socket> socket, const boost::sys
     if (!error)
     {
 	    std::cout << "Accepted connection from: " << socket->remote_endpoint() << "\n";
-        const auto session = std::make_shared<ClientSession>(std::move(socket));
-        session->start();
+        // Paced responses go out in several writes; none of them should wait for the client's delayed ACK
+        boost::system::error_code ec;
+        socket->set_option(tcp::no_delay(true), ec);
+        core_.serve(std::make_shared<TcpTransport>(std::move(socket)));
     }
-    else
+    else if (error != boost::asio::error::operation_aborted)
     {
 	    std::cerr << "Error accepting connection: " << error.message() << "\n";
     }
-    start_accept();
-}
\ No newline at end of file
+
+    // The successor accepts the connections once the listening socket is handed over
+    if (accepting_)
+    {
+        start_accept();
+    }
+}
+
+void Server::wait_for_successor()
+{
+    while (const auto channel = handoff_listener_->accept())
+    {
+        try
+        {
+            channel->accept_successor();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Ignoring a connection to the handoff socket: " << e.what() << "\n";
+            continue;
+        }
+        if (hand_over(channel))
+        {
+            return;
+        }
+    }
+}
+
+bool Server::hand_over(const std::shared_ptr<HandoffChannel>& channel)
+{
+    ServerContext* context = core_.context().get();
+
+    // Keeps io_context_.run() from returning while nothing is accepted and no session is open
+    const auto work = boost::asio::make_work_guard(io_context_);
+    {
+        std::lock_guard lock(handoff_mutex_);
+        HandoffState state;
+        try
+        {
+            // Stop accepting on the io_context's thread; the port stays open until the successor has the socket
+            std::promise<unsigned short> stopped;
+            boost::asio::post(io_context_, [this, &stopped]
+                {
+                    accepting_ = false;
+                    boost::system::error_code ec;
+                    acceptor_.cancel(ec);
+                    stopped.set_value(acceptor_.local_endpoint(ec).port());
+                });
+            const unsigned short port = stopped.get_future().get();
+
+            // Users with requests in progress stay here; the requests of all others go to the successor from now on
+            state.held_users = context->drain->start("127.0.0.1:" + std::to_string(port),
+                [this, channel, context](const uint32_t user_id)
+                {
+                    std::lock_guard release_lock(handoff_mutex_);
+                    if (!context->drain->draining())
+                    {
+                        return; // the handoff failed and was rolled back meanwhile
+                    }
+                    try
+                    {
+                        context->file_manager->flush_usage();
+                        channel->send_release(user_id,
+                            context->uploads->hand_over([user_id](const uint32_t owner) { return owner == user_id; }));
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::cerr << "Cannot release user " << user_id << " to the successor: " << e.what() << "\n";
+                    }
+                });
+            std::cout << "Handing over to a successor; " << state.held_users.size() << " users still busy.\n";
+
+            // Background work on the users' files stops here; the replication is kept until the successor has the state
+            context->scrubber->stop();
+            if (context->replicator)
+            {
+                context->replicator->hand_over();
+            }
+            context->file_manager->stop_maintenance();
+            context->file_manager->flush_usage();
+
+            const std::set<uint32_t> held(state.held_users.begin(), state.held_users.end());
+            state.uploads = context->uploads->hand_over([&held](const uint32_t user_id) { return held.count(user_id) == 0; });
+            state.warm_users = context->file_manager->cached_users();
+            state.listener = static_cast<int>(acceptor_.native_handle());
+            channel->send_state(state);
+        }
+        catch (const std::exception& e)
+        {
+            // The successor has nothing yet: everything goes back to how it was, and this process keeps serving
+            std::cerr << "Handoff failed; serving on: " << e.what() << "\n";
+            context->drain->abort();
+            for (const auto& upload : state.uploads)
+            {
+                if (!context->uploads->adopt(upload))
+                {
+                    std::cerr << "Cannot continue upload " << upload.upload_id << " of user " << upload.user_id << ".\n";
+                }
+            }
+            if (context->replicator)
+            {
+                context->replicator->resume();
+            }
+            context->file_manager->resume_maintenance();
+            context->scrubber->resume();
+            boost::asio::post(io_context_, [this]
+                {
+                    accepting_ = true;
+                    start_accept();
+                });
+            return false;
+        }
+
+        // The successor has the state: the replication continues there, and the port closes here
+        if (context->replicator)
+        {
+            context->replicator->forward_to([channel](const Command op_code, const uint32_t user_id,
+                                                      const std::string& filename)
+                {
+                    try
+                    {
+                        channel->send_replication(op_code, user_id, filename);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::cerr << "Cannot pass " << filename << " of user " << user_id
+                            << " to the successor's replication: " << e.what() << "\n";
+                    }
+                });
+        }
+        boost::asio::post(io_context_, [this]
+            {
+                boost::system::error_code ec;
+                acceptor_.close(ec);
+            });
+    }
+
+    // Sessions close as they finish; whatever is still held past the timeout is released by this process exiting
+    if (context->drain->wait(std::chrono::steady_clock::now() + drain_timeout_))
+    {
+        try
+        {
+            channel->send_done();
+        }
+        catch (const std::exception&)
+        {
+        }
+        std::cout << "Drained; exiting.\n";
+    }
+    else
+    {
+        std::cerr << "Requests still in progress after " << drain_timeout_.count() << "s; exiting anyway.\n";
+    }
+    io_context_.stop();
+    return true;
+}
+
+void Server::take_over()
+{
+    const std::shared_ptr<ServerContext> context = core_.context();
+    context->gate = std::make_shared<UserGate>(inherited_.held_users,
+                                               std::chrono::steady_clock::now() + drain_timeout_);
+    for (const auto& upload : inherited_.uploads)
+    {
+        if (!context->uploads->adopt(upload))
+        {
+            std::cerr << "Cannot continue upload " << upload.upload_id << " of user " << upload.user_id << ".\n";
+        }
+    }
+    std::cout << "Took over from the previous process; " << inherited_.held_users.size()
+        << " users still busy there.\n";
+
+    // The predecessor releases its users as their requests finish, then closes the connection
+    std::thread([context, channel = predecessor_]
+        {
+            while (const auto update = channel->receive_update())
+            {
+                if (update->type == HandoffUpdate::Type::DONE)
+                {
+                    break;
+                }
+                if (update->type == HandoffUpdate::Type::RELEASE)
+                {
+                    context->gate->release(update->user_id);
+                }
+                else if (update->type == HandoffUpdate::Type::UPLOAD && !context->uploads->adopt(update->upload))
+                {
+                    std::cerr << "Cannot continue upload " << update->upload.upload_id << " of user "
+                        << update->upload.user_id << ".\n";
+                }
+                else if (update->type == HandoffUpdate::Type::REPLICATE && context->replicator)
+                {
+                    context->replicator->record(update->op_code, update->user_id, update->filename);
+                }
+            }
+            context->gate->release_all();
+        }).detach();
+
+    // Load what the predecessor had in memory, the users already served here first
+    std::thread([context, warm = inherited_.warm_users]
+        {
+            std::vector<std::pair<uint32_t, bool>> held;
+            const auto warm_up = [&context](const uint32_t user_id, const bool with_index)
+            {
+                try
+                {
+                    context->file_manager->warm_up(user_id, with_index);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Cannot load user " << user_id << ": " << e.what() << "\n";
+                }
+            };
+            for (const auto& [user_id, with_index] : warm)
+            {
+                if (context->gate->holds(user_id))
+                {
+                    held.emplace_back(user_id, with_index);
+                    continue;
+                }
+                warm_up(user_id, with_index);
+            }
+            for (const auto& [user_id, with_index] : held)
+            {
+                context->gate->wait(user_id);
+                warm_up(user_id, with_index);
+            }
+        }).detach();
+}
@@ -1,7 +1,8 @@
 /**
  * @file Server.h
  * @brief Server class definition.
- * @details This header file contains the Server class definition for managing client connections and handling them asynchronously.
+ * @details This header file contains the Server class definition for managing client connections and handling them asynchronously,
+ *          and for handing the listening socket over to a process replacing the server.
  *
  * @version 1.0
  * @author Dmitriy Gorodov
@@ -11,21 +12,40 @@
 
 #pragma once
 
+#include "FileServer.h"
+#include "Handoff.h"
+#include "ServerConfig.h"
+
 #include <boost/asio.hpp>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 /**
  * @class Server
  * @brief Manages the server operations, including accepting client connections and handling them.
+ * @details Accepts TCP connections and hands each one to the embedded FileServer. With a handoff socket, a new
+ *          server process can take the listening socket over: this one drains (see SessionDrain) and exits, and the
+ *          successor, started with the takeover socket, serves every connection from then on.
  */
 class Server
 {
 public:
     /**
-     * @brief Constructs a Server with a given io_context and port.
+     * @brief Constructs a Server with a given io_context and configuration.
      * @param io_context The io_context for asynchronous operations.
-     * @param port The port on which the server listens for connections.
+     * @param config The server's settings (port, storage folder, replication peer).
      */
-    Server(boost::asio::io_context& io_context, unsigned short port);
+    Server(boost::asio::io_context& io_context, const ServerConfig& config);
+
+    /**
+     * @brief Stops waiting for a successor.
+     */
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
 
     /**
      * @brief Starts accepting client connections.
@@ -40,13 +60,69 @@ private:
      */
     void handle_accept(std::shared_ptr<boost::asio::ip::tcp::socket> socket, const boost::system::error_code& error);
 
+    /**
+     * @brief Waits on the handoff socket for a successor and hands over to the first one (on 'handoff_thread_').
+     */
+    void wait_for_successor();
+
+    /**
+     * @brief Hands the listening socket and the users to a successor, drains, and stops the io_context.
+     * @details Users with requests in progress stay here until their last one finishes; every other user, the
+     *          multipart uploads and the replication go to the successor at once. If the state cannot be sent,
+     *          the handoff is rolled back and this process keeps serving.
+     * @param channel The connection to the successor.
+     * @return True if the successor took over; false if the handoff was rolled back.
+     */
+    bool hand_over(const std::shared_ptr<HandoffChannel>& channel);
+
+    /**
+     * @brief Serves the state inherited from the predecessor: held users, uploads, and the users to load.
+     * @details Follows the predecessor's later messages, and warms the users it had in memory, on threads of their own.
+     */
+    void take_over();
+
 	/**
     * @brief The io_context for asynchronous operations.
     */
     boost::asio::io_context& io_context_;
 
+	/**
+    * @brief The connection to the process this one replaces (null unless started with a takeover socket).
+    */
+    std::shared_ptr<HandoffChannel> predecessor_;
+
+	/**
+    * @brief What the predecessor handed over (its listening socket, users and uploads).
+    */
+    HandoffState inherited_;
+
+	/**
+    * @brief Where a successor connects (null without a handoff socket).
+    * @details Bound before the storage opens and its threads start, as binding briefly changes the process-wide umask.
+    */
+    std::unique_ptr<HandoffListener> handoff_listener_;
+
 	/**
     * @brief The acceptor for client connections.
     */
     boost::asio::ip::tcp::acceptor acceptor_;
+
+	/**
+    * @brief The server core serving the accepted connections.
+    * @details Opened after the takeover, once the predecessor no longer writes the replication log.
+    */
+    FileServer core_;
+
+	/**
+    * @brief How long the users held on a handoff may take to be released.
+    */
+    std::chrono::seconds drain_timeout_;
+
+	/**
+    * @brief Orders the handoff state before the releases sent as held users finish.
+    */
+    std::mutex handoff_mutex_;
+
+    bool accepting_ = true;             ///< Cleared once the listening socket is handed over (io_context thread only).
+    std::thread handoff_thread_;        ///< Runs wait_for_successor().
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+/**
+ * @file ServerConfig.h
+ * @brief Defines the ServerConfig struct holding the server's settings.
+ * @details This file contains the definition of the ServerConfig struct and the defaults used when a setting is not given.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "IoPolicy.h"
+#include "SessionDrain.h"
+#include "UploadManager.h"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+constexpr unsigned short DEFAULT_PORT = 8080;
+const std::string STORAGE_FOLDER = "c:/backupsvr/";
+
+/**
+ * @struct ServerConfig
+ * @brief The server's settings.
+ */
+struct ServerConfig {
+    unsigned short port = DEFAULT_PORT;            ///< The port on which the server listens for connections.
+    std::vector<std::string> storage_folders = { STORAGE_FOLDER }; ///< The root folders of the stored files, one per disk (end with a slash).
+    std::string replication_peer_host;             ///< The peer receiving replicated saves and deletes (empty if none).
+    unsigned short replication_peer_port = 0;      ///< The peer's port.
+    std::string cluster_self;                      ///< This node's "host:port" in the cluster (cluster mode only).
+    std::vector<std::string> cluster_nodes;        ///< All nodes of the cluster (empty when not in cluster mode).
+    bool cluster_proxy = false;                    ///< Proxy requests for other nodes' users instead of redirecting.
+    bool fair_scheduling = true;                   ///< Share the disk between users with weighted fair queuing.
+    uint64_t user_bytes_per_second = 0;            ///< Bandwidth cap of each user (0 means unlimited).
+    std::map<uint32_t, double> user_weights;       ///< Scheduling weights of individual users (default 1).
+    IoPolicyConfig io_policy;                      ///< Preallocation, page cache hints and direct I/O of standalone files.
+    std::chrono::seconds upload_timeout = UPLOAD_TIMEOUT; ///< How long a multipart upload may go without activity.
+    QuotaConfig quota;                             ///< The users' byte and file quotas (none by default).
+    ErasureConfig erasure;                         ///< The erasure code of large files (none by default: stored whole).
+    std::string trace_path;                        ///< The file recording a trace of the requests served (empty: no trace).
+    std::string handoff_socket;                    ///< The Unix socket a replacing process takes this one over through (empty: none).
+    std::string takeover_socket;                   ///< The handoff socket of the running server to take over at startup (empty: none).
+    std::chrono::seconds drain_timeout = DEFAULT_DRAIN_TIMEOUT; ///< How long requests in progress may take to finish on a handoff.
+};
@@ -0,0 +1,45 @@
+/**
+ * @file ServerContext.h
+ * @brief Defines the ServerContext struct shared by the server and its client sessions.
+ * @details This file contains the definition of the ServerContext struct, which holds the long-lived services
+ *          (storage, background maintenance, replication, clustering, scheduling, uploads, load tracking, restarts) that every client session works with.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "FileManager.h"
+#include "StorageScrubber.h"
+#include "Replicator.h"
+#include "Cluster.h"
+#include "FairScheduler.h"
+#include "UploadManager.h"
+#include "TraceRecorder.h"
+#include "SessionDrain.h"
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @struct ServerContext
+ * @brief The services shared by all client sessions.
+ */
+struct ServerContext {
+    std::shared_ptr<FileManager> file_manager;     ///< Performs all file operations.
+    std::shared_ptr<StorageScrubber> scrubber;     ///< Verifies stored files in the background.
+    std::shared_ptr<Replicator> replicator;        ///< Replicates saves and deletes to a peer (null if none is configured).
+    std::shared_ptr<Cluster> cluster;              ///< Routes users to their owning node (null when not in cluster mode).
+    std::shared_ptr<FairScheduler> scheduler;      ///< Shares the disk and bandwidth between users (null when disabled).
+    std::shared_ptr<UploadManager> uploads;        ///< Receives multipart uploads.
+    std::shared_ptr<TraceRecorder> trace;          ///< Records every request served (null unless tracing).
+    std::shared_ptr<SessionDrain> drain;           ///< Drains the sessions for a process taking over (null without a handoff socket).
+    std::shared_ptr<UserGate> gate;                ///< Holds back users the previous process still works on (null unless it took over).
+    std::atomic<size_t> active_requests{ 0 };      ///< Number of client requests currently being processed.
+    std::atomic<uint64_t> probed_files{ 0 };       ///< Files asked about by PROBE_FILES requests.
+    std::atomic<uint64_t> unchanged_files{ 0 };    ///< Probed files found identical, so not sent again.
+    std::atomic<uint64_t> unchanged_bytes{ 0 };    ///< Size of the files found identical.
+};
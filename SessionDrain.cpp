@@ -0,0 +1,198 @@
+/**
+ * @file SessionDrain.cpp
+ * @brief SessionDrain and UserGate class implementation.
+ * @details This file contains the implementation of session draining in the old process and of the user gate in
+ *          its successor.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "SessionDrain.h"
+
+#include <iostream>
+#include <sstream>
+
+void SessionDrain::open_session()
+{
+    std::lock_guard lock(mutex_);
+    ++sessions_;
+}
+
+void SessionDrain::close_session()
+{
+    {
+        std::lock_guard lock(mutex_);
+        --sessions_;
+    }
+    drained_cv_.notify_all();
+}
+
+bool SessionDrain::begin_request(const uint32_t user_id)
+{
+    std::lock_guard lock(mutex_);
+    if (draining_ && held_.count(user_id) == 0)
+    {
+        ++forwarded_;
+        return false;
+    }
+    ++requests_[user_id];
+    return true;
+}
+
+void SessionDrain::end_request(const uint32_t user_id)
+{
+    ReleaseFn on_release;
+    {
+        std::lock_guard lock(mutex_);
+        const auto it = requests_.find(user_id);
+        if (it == requests_.end() || --it->second > 0)
+        {
+            return;
+        }
+        requests_.erase(it);
+        if (!draining_ || held_.erase(user_id) == 0)
+        {
+            return;
+        }
+        ++releasing_;
+        on_release = on_release_;
+    }
+
+    // The user's later requests are forwarded already; the successor holds them back until it hears of the release
+    on_release(user_id);
+    ++released_;
+    {
+        std::lock_guard lock(mutex_);
+        --releasing_;
+    }
+    drained_cv_.notify_all();
+}
+
+bool SessionDrain::serves(const uint32_t user_id) const
+{
+    std::lock_guard lock(mutex_);
+    return !draining_ || held_.count(user_id) > 0;
+}
+
+bool SessionDrain::draining() const
+{
+    return draining_;
+}
+
+std::string SessionDrain::successor() const
+{
+    std::lock_guard lock(mutex_);
+    return successor_;
+}
+
+std::vector<uint32_t> SessionDrain::start(std::string successor, ReleaseFn on_release)
+{
+    std::lock_guard lock(mutex_);
+    successor_ = std::move(successor);
+    on_release_ = std::move(on_release);
+    for (const auto& [user_id, requests] : requests_)
+    {
+        held_.insert(user_id);
+    }
+    draining_ = true;
+    return { held_.begin(), held_.end() };
+}
+
+bool SessionDrain::wait(const std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock lock(mutex_);
+    return drained_cv_.wait_until(lock, deadline,
+        [this] { return sessions_ == 0 && held_.empty() && releasing_ == 0; });
+}
+
+void SessionDrain::abort()
+{
+    {
+        std::lock_guard lock(mutex_);
+        draining_ = false;
+        successor_.clear();
+        on_release_ = nullptr;
+        held_.clear();
+    }
+    drained_cv_.notify_all();
+}
+
+std::string SessionDrain::report() const
+{
+    std::lock_guard lock(mutex_);
+    std::ostringstream out;
+    out << "handoff: " << (draining_ ? "draining to " + successor_ : std::string("ready")) << ", " << sessions_
+        << " sessions open, " << requests_.size() << " users busy, " << held_.size() << " held, " << released_
+        << " released, " << forwarded_ << " requests forwarded\n";
+    return out.str();
+}
+
+UserGate::UserGate(const std::vector<uint32_t>& held, const std::chrono::steady_clock::time_point deadline)
+    : held_(held.begin(), held.end()), deadline_(deadline), open_(held.empty())
+{
+}
+
+void UserGate::wait(const uint32_t user_id)
+{
+    if (open_)
+    {
+        return;
+    }
+
+    std::unique_lock lock(mutex_);
+    if (held_.count(user_id) == 0)
+    {
+        return;
+    }
+    ++waited_;
+    if (!released_cv_.wait_until(lock, deadline_, [this, user_id] { return held_.count(user_id) == 0; }))
+    {
+        std::cerr << "The previous process did not release its users in time; serving them anyway.\n";
+        held_.clear();
+        open_ = true;
+        lock.unlock();
+        released_cv_.notify_all();
+    }
+}
+
+bool UserGate::holds(const uint32_t user_id) const
+{
+    if (open_)
+    {
+        return false;
+    }
+    std::lock_guard lock(mutex_);
+    return held_.count(user_id) > 0;
+}
+
+void UserGate::release(const uint32_t user_id)
+{
+    {
+        std::lock_guard lock(mutex_);
+        held_.erase(user_id);
+        open_ = held_.empty();
+    }
+    released_cv_.notify_all();
+}
+
+void UserGate::release_all()
+{
+    {
+        std::lock_guard lock(mutex_);
+        held_.clear();
+        open_ = true;
+    }
+    released_cv_.notify_all();
+}
+
+std::string UserGate::report() const
+{
+    std::lock_guard lock(mutex_);
+    std::ostringstream out;
+    out << "takeover: " << held_.size() << " users still held by the previous process, " << waited_
+        << " requests waited for their user\n";
+    return out.str();
+}
@@ -0,0 +1,210 @@
+/**
+ * @file SessionDrain.h
+ * @brief SessionDrain and UserGate class definitions.
+ * @details This header file contains the two halves of a graceful restart: SessionDrain, which lets the old process
+ *          finish the requests it has started while handing every other user to its successor, and UserGate, which
+ *          keeps the successor away from the users the old process is still working on.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+constexpr std::chrono::seconds DEFAULT_DRAIN_TIMEOUT{ 60 };         // how long requests in progress may take to finish on a handoff
+constexpr std::chrono::milliseconds DRAIN_POLL_INTERVAL{ 250 };     // how often idle sessions check whether the server is draining
+
+/**
+ * @class SessionDrain
+ * @brief Tracks the open sessions and the users with requests in progress, and drains them for a successor process.
+ * @details Until start() is called every request is served here. start() holds on to the users with requests in
+ *          progress and hands all others to the successor at once: their requests are forwarded to it from then on.
+ *          A held user is released, and the successor told so through the release callback, when their last
+ *          request finishes; so at any moment exactly one process works on a user's files, usage counters and
+ *          segments. Sessions close as soon as they have nothing left to answer.
+ */
+class SessionDrain {
+public:
+    /**
+     * @brief Called once a held user's last request finished, before the user's requests go to the successor.
+     */
+    using ReleaseFn = std::function<void(uint32_t user_id)>;
+
+    /**
+     * @brief Counts a session as open.
+     */
+    void open_session();
+
+    /**
+     * @brief Counts a session as closed.
+     */
+    void close_session();
+
+    /**
+     * @brief Starts a request working on a user's files, unless the user was handed to the successor.
+     * @param user_id The user ID.
+     * @return True if the request is served here (end_request() must follow); false if it goes to the successor.
+     */
+    bool begin_request(uint32_t user_id);
+
+    /**
+     * @brief Ends a request started by begin_request(), releasing the user if it was the last one while draining.
+     * @param user_id The user ID.
+     */
+    void end_request(uint32_t user_id);
+
+    /**
+     * @brief Tells whether a user's requests are served here.
+     * @param user_id The user ID.
+     * @return False once the server drains and the user is not held.
+     */
+    bool serves(uint32_t user_id) const;
+
+    /**
+     * @brief Tells whether the server is draining.
+     * @return True once start() was called.
+     */
+    bool draining() const;
+
+    /**
+     * @brief Returns where the requests of the users handed over are forwarded.
+     * @return The successor's "host:port" (empty before start()).
+     */
+    std::string successor() const;
+
+    /**
+     * @brief Starts draining: holds the users with requests in progress and hands all others to the successor.
+     * @param successor The successor's "host:port".
+     * @param on_release Called as each held user is released (on the thread ending the user's last request).
+     * @return The users held.
+     */
+    std::vector<uint32_t> start(std::string successor, ReleaseFn on_release);
+
+    /**
+     * @brief Waits until every session closed and every held user was released.
+     * @param deadline When to give up.
+     * @return True if drained; false if the deadline passed first.
+     */
+    bool wait(std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief Stops draining before the successor got the state: every user is served here again.
+     */
+    void abort();
+
+    /**
+     * @brief Formats the sessions, held users and forwarded requests as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @brief Guards the members below.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief Signaled when a session closes or a held user is released.
+     */
+    std::condition_variable drained_cv_;
+
+    /**
+     * @brief Set by start() (written under 'mutex_').
+     */
+    std::atomic<bool> draining_{ false };
+
+    std::string successor_;                 ///< The successor's "host:port".
+    ReleaseFn on_release_;                  ///< Called as each held user is released (set by start()).
+    size_t sessions_ = 0;                   ///< Open sessions.
+    std::map<uint32_t, size_t> requests_;   ///< Requests in progress, by user.
+    std::set<uint32_t> held_;               ///< Users still served here while draining.
+    size_t releasing_ = 0;                  ///< Release callbacks running.
+
+    std::atomic<uint64_t> released_{ 0 };   ///< Held users released.
+    std::atomic<uint64_t> forwarded_{ 0 };  ///< Requests refused by begin_request() (forwarded to the successor).
+};
+
+/**
+ * @class UserGate
+ * @brief Holds back the requests for users the predecessor process is still working on, until it releases them.
+ * @details Every user not held is served at once. Held users wait for release(), or release_all() when the
+ *          predecessor has drained or gone away, or at the latest until the deadline, so a stuck predecessor
+ *          cannot stall the successor for good.
+ */
+class UserGate {
+public:
+    /**
+     * @brief Constructs the gate.
+     * @param held The users the predecessor still works on.
+     * @param deadline When to stop waiting for the predecessor.
+     */
+    UserGate(const std::vector<uint32_t>& held, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief Waits until a user may be served here.
+     * @param user_id The user ID.
+     */
+    void wait(uint32_t user_id);
+
+    /**
+     * @brief Tells whether a user is still held.
+     * @param user_id The user ID.
+     * @return True until the user is released.
+     */
+    bool holds(uint32_t user_id) const;
+
+    /**
+     * @brief Lets a user's requests through.
+     * @param user_id The user ID.
+     */
+    void release(uint32_t user_id);
+
+    /**
+     * @brief Lets every user's requests through.
+     */
+    void release_all();
+
+    /**
+     * @brief Formats the held users and the requests that waited as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @brief Guards 'held_'.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief Signaled when users are released.
+     */
+    std::condition_variable released_cv_;
+
+    /**
+     * @brief The users still held.
+     */
+    std::set<uint32_t> held_;
+
+    /**
+     * @brief When to stop waiting for the predecessor.
+     */
+    std::chrono::steady_clock::time_point deadline_;
+
+    std::atomic<bool> open_{ false };       ///< Set once no user is held, sparing requests the lock.
+    std::atomic<uint64_t> waited_{ 0 };     ///< Requests that waited for their user's release.
+};
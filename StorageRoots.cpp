@@ -0,0 +1,249 @@
+/**
+ * @file StorageRoots.cpp
+ * @brief StorageRoots class implementation.
+ * @details This file contains the implementation of the placement of users over several storage roots.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "StorageRoots.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using std::chrono::steady_clock;
+
+namespace
+{
+    /**
+     * @brief Hashes a (user, root) pair to a number in (0, 1).
+     */
+    double rendezvous_hash(const uint32_t user_id, const std::string& root)
+    {
+        // FNV-1a over the root path and the user ID, followed by a 64-bit finalizer
+        uint64_t h = 14695981039346656037ull;
+        for (const unsigned char c : root)
+        {
+            h = (h ^ c) * 1099511628211ull;
+        }
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            h = (h ^ ((user_id >> shift) & 0xff)) * 1099511628211ull;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb3f97a56e3fbull;
+        h ^= h >> 33;
+        return (static_cast<double>(h >> 11) + 0.5) / static_cast<double>(1ull << 53);
+    }
+
+    /**
+     * @brief Tells whether a folder name is a user ID.
+     */
+    bool is_user_folder(const std::string& name)
+    {
+        return !name.empty() && name.size() <= 10 && name.find_first_not_of("0123456789") == std::string::npos;
+    }
+}
+
+StorageRoots::StorageRoots(const std::vector<std::string>& paths)
+{
+    if (paths.empty())
+    {
+        throw std::invalid_argument("At least one storage root is required");
+    }
+
+    for (std::string path : paths)
+    {
+        if (path.back() != '/' && path.back() != '\\')
+        {
+            path += '/';
+        }
+        StorageRoot root;
+        root.path = std::move(path);
+        roots_.push_back(std::move(root));
+    }
+
+    // Count the users already stored on each root
+    for (auto& root : roots_)
+    {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(root.path, ec))
+        {
+            if (entry.is_directory(ec) && is_user_folder(entry.path().filename().string()))
+            {
+                ++root.users;
+            }
+        }
+    }
+
+    std::lock_guard lock(mutex_);
+    refresh_space();
+}
+
+void StorageRoots::create_directories() const
+{
+    for (const auto& path : paths())
+    {
+        std::filesystem::create_directories(path);
+    }
+}
+
+std::string StorageRoots::user_root(const uint32_t user_id)
+{
+    std::lock_guard lock(mutex_);
+    if (const auto it = placements_.find(user_id); it != placements_.end())
+    {
+        return roots_[it->second].path;
+    }
+
+    // A user keeps the root that already holds its folder, even if the roots' weights have changed since
+    const std::string folder = std::to_string(user_id);
+    size_t index = roots_.size();
+    for (size_t i = 0; i < roots_.size() && index == roots_.size(); ++i)
+    {
+        std::error_code ec;
+        if (std::filesystem::is_directory(roots_[i].path + folder, ec))
+        {
+            index = i;
+        }
+    }
+
+    if (index == roots_.size())
+    {
+        refresh_space();
+        index = place(user_id);
+        ++roots_[index].users;
+    }
+    placements_.emplace(user_id, index);
+    return roots_[index].path;
+}
+
+std::vector<std::string> StorageRoots::paths() const
+{
+    std::lock_guard lock(mutex_);
+    std::vector<std::string> paths;
+    for (const auto& root : roots_)
+    {
+        paths.push_back(root.path);
+    }
+    return paths;
+}
+
+void StorageRoots::record_io(const uint32_t user_id, const uint64_t bytes, const steady_clock::duration elapsed)
+{
+    const double units = std::max(1.0, static_cast<double>(bytes) / static_cast<double>(ROOT_LATENCY_UNIT));
+    const double sample = std::chrono::duration<double, std::micro>(elapsed).count() / units;
+
+    std::lock_guard lock(mutex_);
+    const auto it = placements_.find(user_id);
+    if (it == placements_.end())
+    {
+        return;
+    }
+    double& latency = roots_[it->second].latency_us;
+    latency = latency == 0 ? sample : latency + ROOT_LATENCY_SMOOTHING * (sample - latency);
+}
+
+std::string StorageRoots::report()
+{
+    std::lock_guard lock(mutex_);
+    refresh_space();
+
+    std::ostringstream out;
+    out << "storage: " << roots_.size() << (roots_.size() == 1 ? " root\n" : " roots\n");
+    for (const auto& root : roots_)
+    {
+        out << "  " << root.path << ": " << root.available / (1024 * 1024) << "/" << root.capacity / (1024 * 1024)
+            << " MB free, " << std::fixed << std::setprecision(1) << root.latency_us << " us per 64KB, "
+            << root.users << " users\n";
+    }
+    return out.str();
+}
+
+void StorageRoots::refresh_space()
+{
+    const auto now = steady_clock::now();
+    if (refreshed_at_ != steady_clock::time_point() && now - refreshed_at_ < std::chrono::seconds(ROOT_REFRESH_SECONDS))
+    {
+        return;
+    }
+
+    // A root that cannot be measured yet (e.g. not created) is measured again on the next call
+    bool measured = true;
+    for (auto& root : roots_)
+    {
+        std::error_code ec;
+        if (const auto space = std::filesystem::space(root.path, ec); !ec)
+        {
+            root.capacity = space.capacity;
+            root.available = space.available;
+        }
+        else
+        {
+            measured = false;
+        }
+    }
+    if (measured)
+    {
+        refreshed_at_ = now;
+    }
+}
+
+size_t StorageRoots::place(const uint32_t user_id) const
+{
+    // Slow roots are measured against the fastest one that has been measured at all
+    double fastest = std::numeric_limits<double>::max();
+    for (const auto& root : roots_)
+    {
+        if (root.latency_us > 0)
+        {
+            fastest = std::min(fastest, root.latency_us);
+        }
+    }
+
+    const auto score = [&](const StorageRoot& root, const bool only_roomy)
+    {
+        if (only_roomy && root.capacity > 0 &&
+            static_cast<double>(root.available) < ROOT_MIN_FREE_FRACTION * static_cast<double>(root.capacity))
+        {
+            return -std::numeric_limits<double>::infinity();
+        }
+        double weight = root.capacity > 0 ? static_cast<double>(root.capacity) : 1.0;
+        if (root.latency_us > ROOT_SLOW_FACTOR * fastest)
+        {
+            weight /= ROOT_SLOW_PENALTY;
+        }
+        // Weighted rendezvous hashing: -w / ln(h) makes each root win in proportion to its weight
+        return -weight / std::log(rendezvous_hash(user_id, root.path));
+    };
+
+    // Prefer the roots with room to spare; if all are nearly full, pick among all of them
+    for (const bool only_roomy : { true, false })
+    {
+        size_t best = roots_.size();
+        double best_score = -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < roots_.size(); ++i)
+        {
+            if (const double s = score(roots_[i], only_roomy); s > best_score)
+            {
+                best = i;
+                best_score = s;
+            }
+        }
+        if (best < roots_.size())
+        {
+            return best;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file StorageRoots.h
+ * @brief StorageRoots class definition.
+ * @details This header file contains the StorageRoots class, which spreads the users over several storage roots
+ *          (one per disk) and keeps track of each root's free space and latency.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+constexpr double ROOT_MIN_FREE_FRACTION = 0.05;      // roots with less free space than this take no new users
+constexpr double ROOT_SLOW_FACTOR = 3.0;             // roots this much slower than the fastest one are avoided
+constexpr double ROOT_SLOW_PENALTY = 4.0;            // weight divisor applied to slow roots
+constexpr double ROOT_LATENCY_SMOOTHING = 0.05;      // weight of a new sample in the latency moving average
+constexpr unsigned ROOT_REFRESH_SECONDS = 10;        // how often free space is re-read
+constexpr uint64_t ROOT_LATENCY_UNIT = 64 * 1024;    // latencies are normalized to the time per 64KB
+
+/**
+ * @struct StorageRoot
+ * @brief The state of one storage root.
+ */
+struct StorageRoot {
+    std::string path;                 ///< The root folder (ends with a slash).
+    uint64_t capacity = 0;            ///< Size of the volume holding the root, in bytes.
+    uint64_t available = 0;           ///< Free space on the volume, in bytes.
+    double latency_us = 0;            ///< Moving average of the I/O time per 64KB, in microseconds (0 until measured).
+    uint64_t users = 0;               ///< Users stored on this root.
+};
+
+/**
+ * @class StorageRoots
+ * @brief Places each user on one of several storage roots and tracks the roots' health.
+ * @details A user stays on the root that already holds its folder. New users are placed by weighted rendezvous
+ *          hashing: every root scores the user by a hash of (user, root) scaled by the root's capacity, and the
+ *          highest score wins. Roots that are nearly full take no new users and slow roots get a smaller weight,
+ *          so new writes move to the disks that can take them. A single root behaves like the old single folder.
+ */
+class StorageRoots {
+public:
+    /**
+     * @brief Constructs the set of storage roots.
+     * @param paths The root folders (a trailing slash is added if missing).
+     * @throws std::invalid_argument if no root is given.
+     */
+    explicit StorageRoots(const std::vector<std::string>& paths);
+
+    /**
+     * @brief Creates every root folder if it doesn't exist.
+     */
+    void create_directories() const;
+
+    /**
+     * @brief Returns the root holding (or receiving) a user's folder.
+     * @param user_id The user ID.
+     * @return The root folder (ends with a slash).
+     */
+    std::string user_root(uint32_t user_id);
+
+    /**
+     * @brief Returns all root folders.
+     * @return The root folders.
+     */
+    std::vector<std::string> paths() const;
+
+    /**
+     * @brief Records how long an I/O on a user's root took.
+     * @param user_id The user whose folder was accessed.
+     * @param bytes The bytes read or written.
+     * @param elapsed The time it took.
+     */
+    void record_io(uint32_t user_id, uint64_t bytes, std::chrono::steady_clock::duration elapsed);
+
+    /**
+     * @brief Formats each root's free space, latency and number of users as text.
+     * @return The report.
+     */
+    std::string report();
+
+private:
+    /**
+     * @brief Re-reads the roots' free space if it is older than ROOT_REFRESH_SECONDS. Must be called with 'mutex_' held.
+     */
+    void refresh_space();
+
+    /**
+     * @brief Picks the root for a new user. Must be called with 'mutex_' held.
+     * @param user_id The user ID.
+     * @return The index of the root.
+     */
+    size_t place(uint32_t user_id) const;
+
+    /**
+     * @brief Guards the roots and the placements.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief The roots.
+     */
+    std::vector<StorageRoot> roots_;
+
+    /**
+     * @brief The root index of each user accessed so far.
+     */
+    std::unordered_map<uint32_t, size_t> placements_;
+
+    /**
+     * @brief When the free space of every root was last read (unset until all of them could be).
+     */
+    std::chrono::steady_clock::time_point refreshed_at_;
+};
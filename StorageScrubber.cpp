@@ -0,0 +1,285 @@
+/**
+ * @file StorageScrubber.cpp
+ * @brief StorageScrubber class implementation.
+ * @details This file contains the implementation of the background scrubber that verifies stored files
+ *          against their checksums with a bounded, throttled worker pool.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "StorageScrubber.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    constexpr auto FOREGROUND_POLL_INTERVAL = std::chrono::milliseconds(10); // how often a paused worker re-checks the load
+    constexpr auto RECHECK_DELAY = std::chrono::seconds(1);                   // delay before re-verifying a damaged file
+}
+
+StorageScrubber::StorageScrubber(std::shared_ptr<FileManager> file_manager, std::function<size_t()> foreground_load,
+                                 const unsigned workers, const uint64_t bytes_per_second)
+    : file_manager_(std::move(file_manager)),
+    foreground_load_(std::move(foreground_load)),
+    workers_(std::max(1u, workers)),
+    throttle_(bytes_per_second, bytes_per_second / 10),
+    scheduler_(&StorageScrubber::scheduler_loop, this)
+{
+}
+
+StorageScrubber::~StorageScrubber()
+{
+    stop();
+}
+
+void StorageScrubber::stop()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    schedule_cv_.notify_all();
+    not_empty_cv_.notify_all();
+    not_full_cv_.notify_all();
+    if (scheduler_.joinable())
+    {
+        scheduler_.join();
+    }
+}
+
+void StorageScrubber::resume()
+{
+    std::lock_guard lock(mutex_);
+    if (!stopping_ || scheduler_.joinable())
+    {
+        return;
+    }
+    stopping_ = false;
+    scheduler_ = std::thread(&StorageScrubber::scheduler_loop, this);
+}
+
+bool StorageScrubber::start_pass()
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (running_ || pass_requested_ || stopping_)
+        {
+            return false;
+        }
+        pass_requested_ = true;
+    }
+    schedule_cv_.notify_all();
+    return true;
+}
+
+ScrubProgress StorageScrubber::progress() const
+{
+    ScrubProgress progress;
+    progress.passes_completed = passes_completed_;
+    progress.files_queued = files_queued_;
+    progress.files_scanned = files_scanned_;
+    progress.bytes_scanned = bytes_scanned_;
+    progress.files_corrupt = files_corrupt_;
+    progress.files_unverifiable = files_unverifiable_;
+
+    std::lock_guard lock(mutex_);
+    progress.running = running_;
+    progress.findings.assign(findings_.begin(), findings_.end());
+    return progress;
+}
+
+std::string StorageScrubber::report() const
+{
+    const ScrubProgress p = progress();
+
+    std::ostringstream out;
+    out << "scrubber: " << (p.running ? "running" : "idle") << ", passes completed " << p.passes_completed << "\n"
+        << "  files scanned " << p.files_scanned << "/" << p.files_queued << ", bytes scanned " << p.bytes_scanned
+        << ", corrupt " << p.files_corrupt << ", unverifiable " << p.files_unverifiable << "\n";
+    for (const auto& finding : p.findings)
+    {
+        out << "  damaged: user " << finding.user_id << " " << finding.filename
+            << (finding.quarantined ? " (quarantined)" : " (quarantine failed)") << "\n";
+    }
+    return out.str();
+}
+
+void StorageScrubber::scheduler_loop()
+{
+    std::unique_lock lock(mutex_);
+    while (!stopping_)
+    {
+        schedule_cv_.wait_for(lock, std::chrono::hours(SCRUB_INTERVAL_HOURS),
+            [this] { return pass_requested_ || stopping_; });
+        if (stopping_)
+        {
+            break;
+        }
+
+        pass_requested_ = false;
+        running_ = true;
+        lock.unlock();
+
+        try
+        {
+            run_pass();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error while scrubbing the storage: " << e.what() << "\n";
+        }
+
+        lock.lock();
+        running_ = false;
+    }
+}
+
+void StorageScrubber::run_pass()
+{
+    files_queued_ = 0;
+    files_scanned_ = 0;
+    bytes_scanned_ = 0;
+    files_unverifiable_ = 0;
+    {
+        std::lock_guard lock(mutex_);
+        queue_.clear();
+        enumeration_done_ = false;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(workers_);
+    for (unsigned i = 0; i < workers_; ++i)
+    {
+        workers.emplace_back(&StorageScrubber::worker_loop, this);
+    }
+
+    // Enumerate every user's files into the bounded queue
+    try
+    {
+        for (const uint32_t user_id : file_manager_->list_users())
+        {
+            if (stopping_)
+            {
+                break;
+            }
+            for (auto& filename : file_manager_->list_user_files(user_id))
+            {
+                std::unique_lock lock(mutex_);
+                not_full_cv_.wait(lock, [this] { return queue_.size() < SCRUB_QUEUE_CAPACITY || stopping_; });
+                if (stopping_)
+                {
+                    break;
+                }
+                queue_.emplace_back(user_id, std::move(filename));
+                ++files_queued_;
+                lock.unlock();
+                not_empty_cv_.notify_one();
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error enumerating files to scrub: " << e.what() << "\n";
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        enumeration_done_ = true;
+    }
+    not_empty_cv_.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    if (!stopping_)
+    {
+        ++passes_completed_;
+        std::cout << "Scrub pass finished: " << files_scanned_ << " files, " << files_corrupt_ << " corrupt in total\n";
+    }
+}
+
+void StorageScrubber::worker_loop()
+{
+    while (true)
+    {
+        std::pair<uint32_t, std::string> item;
+        {
+            std::unique_lock lock(mutex_);
+            not_empty_cv_.wait(lock, [this] { return !queue_.empty() || enumeration_done_ || stopping_; });
+            if (stopping_ || queue_.empty())
+            {
+                return;
+            }
+            item = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        not_full_cv_.notify_one();
+
+        try
+        {
+            scrub_file(item.first, item.second);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error scrubbing " << item.second << " of user " << item.first << ": " << e.what() << "\n";
+        }
+        ++files_scanned_;
+    }
+}
+
+void StorageScrubber::scrub_file(const uint32_t user_id, const std::string& filename)
+{
+    const auto before_chunk = [this](const size_t bytes)
+    {
+        wait_for_idle_foreground();
+        throttle_.consume(bytes);
+        bytes_scanned_ += bytes;
+    };
+
+    VerifyResult result = file_manager_->verify_file(user_id, filename, before_chunk);
+    if (result == VerifyResult::CORRUPT && !stopping_)
+    {
+        // The file may have been overwritten while it was read; only a second failure counts
+        std::this_thread::sleep_for(RECHECK_DELAY);
+        result = file_manager_->verify_file(user_id, filename, before_chunk);
+    }
+
+    if (result == VerifyResult::UNVERIFIABLE)
+    {
+        ++files_unverifiable_;
+    }
+    if (result != VerifyResult::CORRUPT)
+    {
+        return;
+    }
+
+    ++files_corrupt_;
+    ScrubFinding finding;
+    finding.user_id = user_id;
+    finding.filename = filename;
+    finding.quarantined = file_manager_->quarantine_file(user_id, filename);
+    std::cerr << "Scrubber found damaged file " << filename << " of user " << user_id
+        << (finding.quarantined ? ", moved to quarantine\n" : ", could not quarantine it\n");
+
+    std::lock_guard lock(mutex_);
+    findings_.push_back(std::move(finding));
+    if (findings_.size() > SCRUB_MAX_FINDINGS)
+    {
+        findings_.pop_front();
+    }
+}
+
+void StorageScrubber::wait_for_idle_foreground() const
+{
+    while (!stopping_ && foreground_load_ && foreground_load_() > 0)
+    {
+        std::this_thread::sleep_for(FOREGROUND_POLL_INTERVAL);
+    }
+}
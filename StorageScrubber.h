@@ -0,0 +1,228 @@
+/**
+ * @file StorageScrubber.h
+ * @brief StorageScrubber class definition.
+ * @details This header file contains the StorageScrubber class, which periodically re-reads every stored file,
+ *          verifies it against its stored checksum and quarantines damaged files before a user tries to restore them.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "FileManager.h"
+#include "TokenBucket.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+constexpr unsigned SCRUB_WORKERS = 4;                              // files verified in parallel
+constexpr uint64_t SCRUB_BYTES_PER_SECOND = 32ull * 1024 * 1024;    // I/O budget shared by all workers
+constexpr unsigned SCRUB_INTERVAL_HOURS = 24;                      // time between two automatic passes
+constexpr size_t SCRUB_QUEUE_CAPACITY = 1024;                      // files enumerated ahead of the workers
+constexpr size_t SCRUB_MAX_FINDINGS = 1000;                        // findings kept for status queries
+
+/**
+ * @struct ScrubFinding
+ * @brief A damaged or unverifiable file found by the scrubber.
+ */
+struct ScrubFinding {
+    uint32_t user_id = 0;       ///< The user owning the file.
+    std::string filename;       ///< The damaged file.
+    bool quarantined = false;   ///< Whether the file was moved to the quarantine folder.
+};
+
+/**
+ * @struct ScrubProgress
+ * @brief A snapshot of the scrubber's progress and findings.
+ */
+struct ScrubProgress {
+    bool running = false;                 ///< Whether a pass is in progress.
+    uint64_t passes_completed = 0;        ///< Number of passes finished since startup.
+    uint64_t files_queued = 0;            ///< Files enumerated in the current (or last) pass.
+    uint64_t files_scanned = 0;           ///< Files verified in the current (or last) pass.
+    uint64_t bytes_scanned = 0;           ///< Bytes read in the current (or last) pass.
+    uint64_t files_corrupt = 0;           ///< Damaged files found since startup.
+    uint64_t files_unverifiable = 0;      ///< Files without a stored checksum in the current (or last) pass.
+    std::vector<ScrubFinding> findings;   ///< The most recent damaged files.
+};
+
+/**
+ * @class StorageScrubber
+ * @brief Verifies all users' files in the background across a bounded worker pool.
+ * @details A pass enumerates every user's files into a bounded queue consumed by SCRUB_WORKERS threads.
+ *          The workers share a token bucket limiting the bytes read per second, and pause entirely while client
+ *          requests are being processed, so the scrub never competes with foreground traffic.
+ *          A file that fails verification is checked a second time before it is quarantined, since it may
+ *          have been overwritten while it was being read.
+ */
+class StorageScrubber {
+public:
+    /**
+     * @brief Constructs a StorageScrubber and starts its scheduling thread.
+     * @param file_manager The file manager owning the stored files.
+     * @param foreground_load Returns the number of client requests currently being processed.
+     * @param workers The number of files verified in parallel.
+     * @param bytes_per_second The I/O budget shared by all workers (0 means unlimited).
+     */
+    StorageScrubber(std::shared_ptr<FileManager> file_manager, std::function<size_t()> foreground_load,
+                    unsigned workers = SCRUB_WORKERS, uint64_t bytes_per_second = SCRUB_BYTES_PER_SECOND);
+
+    /**
+     * @brief Stops the current pass (if any) and the scheduling thread.
+     */
+    ~StorageScrubber();
+
+    StorageScrubber(const StorageScrubber&) = delete;
+    StorageScrubber& operator=(const StorageScrubber&) = delete;
+
+    /**
+     * @brief Stops the current pass (if any) and the scheduling thread; no further passes are started.
+     */
+    void stop();
+
+    /**
+     * @brief Starts the scheduling thread again after stop() (e.g. when a handoff to a successor failed).
+     */
+    void resume();
+
+    /**
+     * @brief Starts a pass now instead of waiting for the next scheduled one.
+     * @return True if a pass was started; false if one is already running or the scrubber was stopped.
+     */
+    bool start_pass();
+
+    /**
+     * @brief Returns a snapshot of the progress and findings (safe to call while a pass runs).
+     * @return The progress.
+     */
+    ScrubProgress progress() const;
+
+    /**
+     * @brief Formats the progress and findings as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @brief Waits for the next scheduled or requested pass and runs it.
+     */
+    void scheduler_loop();
+
+    /**
+     * @brief Runs a full pass: enumerates every file and waits for the workers to verify them.
+     */
+    void run_pass();
+
+    /**
+     * @brief Verifies queued files until the enumeration is done and the queue is empty.
+     */
+    void worker_loop();
+
+    /**
+     * @brief Verifies a single file and records (and quarantines) it if it is damaged.
+     * @param user_id The user ID.
+     * @param filename The filename.
+     */
+    void scrub_file(uint32_t user_id, const std::string& filename);
+
+    /**
+     * @brief Blocks while client requests are being processed.
+     */
+    void wait_for_idle_foreground() const;
+
+    /**
+     * @brief The file manager owning the stored files.
+     */
+    std::shared_ptr<FileManager> file_manager_;
+
+    /**
+     * @brief Returns the number of client requests currently being processed.
+     */
+    std::function<size_t()> foreground_load_;
+
+    /**
+     * @brief The number of files verified in parallel.
+     */
+    unsigned workers_;
+
+    /**
+     * @brief The I/O budget shared by all workers.
+     */
+    TokenBucket throttle_;
+
+    /**
+     * @brief Guards the queue, the pass flags and the findings.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief Signals a requested pass or shutdown to the scheduling thread.
+     */
+    std::condition_variable schedule_cv_;
+
+    /**
+     * @brief Signals the workers that the queue is not empty (or the enumeration is done).
+     */
+    std::condition_variable not_empty_cv_;
+
+    /**
+     * @brief Signals the enumeration that the queue is not full.
+     */
+    std::condition_variable not_full_cv_;
+
+    /**
+     * @brief Files waiting to be verified.
+     */
+    std::deque<std::pair<uint32_t, std::string>> queue_;
+
+    /**
+     * @brief Set when every file of the current pass has been queued.
+     */
+    bool enumeration_done_ = false;
+
+    /**
+     * @brief Set when a pass has been requested.
+     */
+    bool pass_requested_ = false;
+
+    /**
+     * @brief Set while a pass runs.
+     */
+    bool running_ = false;
+
+    /**
+     * @brief Set when the scrubber is shutting down.
+     */
+    std::atomic<bool> stopping_{ false };
+
+    /**
+     * @brief The most recent damaged files.
+     */
+    std::deque<ScrubFinding> findings_;
+
+    std::atomic<uint64_t> passes_completed_{ 0 };    ///< Number of passes finished since startup.
+    std::atomic<uint64_t> files_queued_{ 0 };        ///< Files enumerated in the current pass.
+    std::atomic<uint64_t> files_scanned_{ 0 };       ///< Files verified in the current pass.
+    std::atomic<uint64_t> bytes_scanned_{ 0 };       ///< Bytes read in the current pass.
+    std::atomic<uint64_t> files_corrupt_{ 0 };       ///< Damaged files found since startup.
+    std::atomic<uint64_t> files_unverifiable_{ 0 };  ///< Files without a stored checksum in the current pass.
+
+    /**
+     * @brief The scheduling thread.
+     */
+    std::thread scheduler_;
+};
@@ -0,0 +1,57 @@
+/**
+ * @file TokenBucket.cpp
+ * @brief TokenBucket class implementation.
+ * @details This file contains the implementation of the TokenBucket rate limiter.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "TokenBucket.h"
+
+#include <thread>
+
+using std::chrono::steady_clock;
+
+TokenBucket::TokenBucket(const uint64_t rate, const uint64_t burst)
+    : rate_(rate), burst_(burst), empty_at_(steady_clock::now())
+{
+}
+
+void TokenBucket::consume(const uint64_t tokens)
+{
+    if (const auto wait = reserve(tokens); wait > steady_clock::duration::zero())
+    {
+        std::this_thread::sleep_for(wait);
+    }
+}
+
+steady_clock::duration TokenBucket::reserve(const uint64_t tokens)
+{
+    std::lock_guard lock(mutex_);
+    if (rate_ == 0)
+    {
+        return steady_clock::duration::zero();
+    }
+
+    // Tokens accumulated while idle are capped at 'burst_'
+    const auto now = steady_clock::now();
+    const auto burst_time = std::chrono::duration_cast<steady_clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(burst_) / static_cast<double>(rate_)));
+    if (empty_at_ < now - burst_time)
+    {
+        empty_at_ = now - burst_time;
+    }
+
+    empty_at_ += std::chrono::duration_cast<steady_clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(tokens) / static_cast<double>(rate_)));
+    return empty_at_ > now ? empty_at_ - now : steady_clock::duration::zero();
+}
+
+void TokenBucket::set_rate(const uint64_t rate)
+{
+    std::lock_guard lock(mutex_);
+    rate_ = rate;
+}
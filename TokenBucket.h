@@ -0,0 +1,71 @@
+/**
+ * @file TokenBucket.h
+ * @brief TokenBucket class definition.
+ * @details This header file contains the TokenBucket class used to cap the rate (e.g. bytes per second) of a stream of work.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @class TokenBucket
+ * @brief Thread-safe token bucket: callers block until enough tokens have accumulated.
+ */
+class TokenBucket {
+public:
+    /**
+     * @brief Constructs a TokenBucket.
+     * @param rate Tokens added per second (0 means unlimited).
+     * @param burst Maximum number of tokens that can accumulate while idle.
+     */
+    TokenBucket(uint64_t rate, uint64_t burst);
+
+    /**
+     * @brief Takes 'tokens' from the bucket, sleeping until they are available.
+     * @param tokens The number of tokens to take.
+     */
+    void consume(uint64_t tokens);
+
+    /**
+     * @brief Computes how long a caller would have to wait for 'tokens' and takes them.
+     * @details Unlike consume() this does not sleep, so callers that schedule work can wait in their own way.
+     * @param tokens The number of tokens to take.
+     * @return How long to wait before the tokens may be used.
+     */
+    std::chrono::steady_clock::duration reserve(uint64_t tokens);
+
+    /**
+     * @brief Changes the rate.
+     * @param rate Tokens added per second (0 means unlimited).
+     */
+    void set_rate(uint64_t rate);
+
+private:
+    /**
+     * @brief Guards the bucket state.
+     */
+    std::mutex mutex_;
+
+    /**
+     * @brief Tokens added per second (0 means unlimited).
+     */
+    uint64_t rate_;
+
+    /**
+     * @brief Maximum number of tokens that can accumulate while idle.
+     */
+    uint64_t burst_;
+
+    /**
+     * @brief The time at which the bucket is empty again (may lie in the past when tokens are available).
+     */
+    std::chrono::steady_clock::time_point empty_at_;
+};
@@ -0,0 +1,161 @@
+/**
+ * @file TraceRecorder.cpp
+ * @brief TraceRecorder class implementation.
+ * @details This file contains the implementation of the request trace: recording, background writing and reading
+ *          back.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "TraceRecorder.h"
+#include "Checksum.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using std::chrono::steady_clock;
+
+TraceRecorder::TraceRecorder(const std::string& path)
+    : path_(path), file_(path, std::ios::binary | std::ios::trunc), started_(steady_clock::now())
+{
+    if (!file_.write(TRACE_MAGIC.data(), static_cast<std::streamsize>(TRACE_MAGIC.size())) || !file_.flush())
+    {
+        throw std::runtime_error("Cannot create trace file " + path);
+    }
+    buffer_.reserve(TRACE_BUFFER_SIZE);
+    writer_ = std::thread(&TraceRecorder::run_writer, this);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    writer_.join();
+}
+
+uint32_t TraceRecorder::open_session()
+{
+    return ++sessions_;
+}
+
+TraceRecord TraceRecorder::begin(const uint32_t session, const Request& request) const
+{
+    TraceRecord record;
+    record.start_us = static_cast<uint64_t>(std::max<int64_t>(0,
+        std::chrono::duration_cast<std::chrono::microseconds>(request.received - started_).count()));
+    record.session = session;
+    record.user_id = request.user_id;
+    record.version = request.version;
+    record.op_code = request.op_code;
+    record.name_length = static_cast<uint16_t>(request.filename.size());
+    record.name_hash = request.filename.empty() ? 0 : Crc32c::compute(
+        reinterpret_cast<const unsigned char*>(request.filename.data()), request.filename.size());
+    record.payload_size = request.payload_size;
+    return record;
+}
+
+void TraceRecorder::finish(TraceRecord record, const Response& response)
+{
+    if (failed_)
+    {
+        return;
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - started_).count();
+    record.duration_us = static_cast<uint32_t>(std::clamp<int64_t>(elapsed - static_cast<int64_t>(record.start_us), 0,
+        UINT32_MAX));
+    record.status = response.status;
+    record.response_size = static_cast<uint32_t>(response.payload.size());
+
+    const auto encoded = TraceRecordLayout::encode(record.start_us, record.session, record.user_id, record.version,
+        record.op_code, record.name_length, record.name_hash, record.payload_size, record.duration_us, record.status,
+        record.response_size);
+    bool full;
+    {
+        std::lock_guard lock(mutex_);
+        buffer_.insert(buffer_.end(), encoded.begin(), encoded.end());
+        full = buffer_.size() >= TRACE_BUFFER_SIZE;
+    }
+    ++recorded_;
+    if (full)
+    {
+        wake_.notify_one();
+    }
+}
+
+std::string TraceRecorder::report() const
+{
+    std::ostringstream out;
+    out << "trace: " << recorded_.load() << " requests of " << sessions_.load() << " sessions recorded to " << path_
+        << (failed_ ? " (stopped: write failed)" : "") << "\n";
+    return out.str();
+}
+
+std::vector<TraceRecord> TraceRecorder::read(const std::string& path)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    std::string magic(TRACE_MAGIC.size(), '\0');
+    if (!ifs.read(magic.data(), static_cast<std::streamsize>(magic.size())) || magic != TRACE_MAGIC)
+    {
+        throw std::runtime_error("Not a trace file: " + path);
+    }
+
+    // A trace cut short by a crash ends with a partial record, which is ignored
+    std::vector<TraceRecord> records;
+    TraceRecordLayout::Buffer buffer;
+    while (ifs.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())))
+    {
+        TraceRecord& record = records.emplace_back();
+        record.start_us = TraceRecordLayout::get<TraceStartField>(buffer);
+        record.session = TraceRecordLayout::get<SessionField>(buffer);
+        record.user_id = TraceRecordLayout::get<UserIdField>(buffer);
+        record.version = TraceRecordLayout::get<VersionField>(buffer);
+        record.op_code = TraceRecordLayout::get<OpCodeField>(buffer);
+        record.name_length = TraceRecordLayout::get<NameLengthField>(buffer);
+        record.name_hash = TraceRecordLayout::get<NameHashField>(buffer);
+        record.payload_size = TraceRecordLayout::get<PayloadSizeField>(buffer);
+        record.duration_us = TraceRecordLayout::get<DurationField>(buffer);
+        record.status = TraceRecordLayout::get<StatusField>(buffer);
+        record.response_size = TraceRecordLayout::get<ResponseSizeField>(buffer);
+    }
+    return records;
+}
+
+void TraceRecorder::run_writer()
+{
+    std::unique_lock lock(mutex_);
+    while (!stopping_)
+    {
+        wake_.wait_for(lock, TRACE_FLUSH_INTERVAL,
+            [this] { return stopping_ || buffer_.size() >= TRACE_BUFFER_SIZE; });
+        write_buffered(lock);
+    }
+}
+
+void TraceRecorder::write_buffered(std::unique_lock<std::mutex>& lock)
+{
+    if (buffer_.empty())
+    {
+        return;
+    }
+
+    // Requests keep appending to a fresh buffer while this one is written
+    std::vector<unsigned char> pending;
+    pending.reserve(TRACE_BUFFER_SIZE);
+    pending.swap(buffer_);
+    lock.unlock();
+    if (!failed_ && (!file_.write(reinterpret_cast<const char*>(pending.data()), static_cast<std::streamsize>(pending.size())) ||
+        !file_.flush()))
+    {
+        std::cerr << "Cannot write trace file " << path_ << ": recording stopped.\n";
+        failed_ = true;
+    }
+    lock.lock();
+}
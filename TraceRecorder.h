@@ -0,0 +1,180 @@
+/**
+ * @file TraceRecorder.h
+ * @brief TraceRecorder class definition.
+ * @details This header file contains the TraceRecorder class, which records the headers, timing and outcome of every
+ *          request served (never their payloads or filenames) in a compact binary trace, and the layout of that
+ *          trace, read back by tools/replay.cpp to regenerate equivalent traffic.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "Request.h"
+#include "Response.h"
+#include "WireFormat.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const std::string TRACE_MAGIC = "FSTRACE1";                 // first bytes of a trace file (the format's version)
+constexpr size_t TRACE_BUFFER_SIZE = 64 * 1024;             // records are written once this many bytes are buffered
+constexpr std::chrono::seconds TRACE_FLUSH_INTERVAL{ 1 };   // buffered records are written at least this often
+
+struct TraceStartField : WireField<uint64_t> {};    ///< When the request's header arrived, in microseconds since the trace started.
+struct SessionField : WireField<uint32_t> {};       ///< The connection the request came on, numbered from 1.
+struct NameHashField : WireField<uint32_t> {};      ///< The CRC-32C of the filename, which is not recorded itself.
+struct DurationField : WireField<uint32_t> {};      ///< Microseconds from the header's arrival until the response was sent.
+struct ResponseSizeField : WireField<uint32_t> {};  ///< The size of the response's payload.
+
+/**
+ * @brief One record of a trace: start(8) + session(4) + user_id(4) + version(1) + op_code(1) + name_len(2) +
+ *        name_hash(4) + payload size(4) + duration(4) + status(2) + response size(4).
+ */
+using TraceRecordLayout = WireLayout<TraceStartField, SessionField, UserIdField, VersionField, OpCodeField,
+    NameLengthField, NameHashField, PayloadSizeField, DurationField, StatusField, ResponseSizeField>;
+
+/**
+ * @struct TraceRecord
+ * @brief One request of a trace.
+ */
+struct TraceRecord {
+    uint64_t start_us = 0;                              ///< When the header arrived, in microseconds since the trace started.
+    uint32_t session = 0;                               ///< The connection, numbered from 1.
+    uint32_t user_id = 0;                               ///< The user.
+    uint8_t version = 0;                                ///< The protocol version.
+    Command op_code = static_cast<Command>(0);          ///< The command.
+    uint16_t name_length = 0;                           ///< The length of the filename.
+    uint32_t name_hash = 0;                             ///< The CRC-32C of the filename (0 if there is none).
+    uint32_t payload_size = 0;                          ///< The size of the request's payload.
+    uint32_t duration_us = 0;                           ///< Microseconds until the response was sent.
+    ServerStatus status = static_cast<ServerStatus>(0); ///< The response's status.
+    uint32_t response_size = 0;                         ///< The size of the response's payload.
+};
+
+/**
+ * @class TraceRecorder
+ * @brief Appends a TraceRecord per request served to a trace file.
+ * @details Records are encoded into a buffer under a mutex and written by a background thread every
+ *          TRACE_FLUSH_INTERVAL (or as soon as TRACE_BUFFER_SIZE bytes are waiting), so serving a request only costs
+ *          the encoding of its 38 bytes. Filenames are reduced to their length and checksum: enough for a replay to
+ *          send the same mix of names, not enough to learn them.
+ */
+class TraceRecorder {
+public:
+    /**
+     * @brief Creates (or truncates) the trace file and starts the thread writing it.
+     * @param path The trace file.
+     * @throws std::runtime_error if the file cannot be created.
+     */
+    explicit TraceRecorder(const std::string& path);
+
+    /**
+     * @brief Stops the background thread and writes the records still buffered.
+     */
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /**
+     * @brief Numbers a new connection.
+     * @return The session number to record its requests under.
+     */
+    uint32_t open_session();
+
+    /**
+     * @brief Starts the record of a request, before processing alters it (e.g. strips its filename).
+     * @param session The connection's session number.
+     * @param request The request as received.
+     * @return The record, completed by finish().
+     */
+    TraceRecord begin(uint32_t session, const Request& request) const;
+
+    /**
+     * @brief Completes a record with the response just sent and appends it to the trace.
+     * @param record The record returned by begin().
+     * @param response The response.
+     */
+    void finish(TraceRecord record, const Response& response);
+
+    /**
+     * @brief Formats the number of requests recorded as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+    /**
+     * @brief Reads a whole trace file.
+     * @param path The trace file.
+     * @return The records, in the order their responses were sent.
+     * @throws std::runtime_error if the file cannot be read or is not a trace.
+     */
+    static std::vector<TraceRecord> read(const std::string& path);
+
+private:
+    /**
+     * @brief The background thread: writes the buffered records periodically until stopped.
+     */
+    void run_writer();
+
+    /**
+     * @brief Writes the buffered records to the file.
+     * @param lock The held lock on 'mutex_', released while writing.
+     */
+    void write_buffered(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @brief The trace file's path.
+     */
+    std::string path_;
+
+    /**
+     * @brief The open trace file (used by the background thread only, and by the destructor).
+     */
+    std::ofstream file_;
+
+    /**
+     * @brief When the trace started: record times are relative to this.
+     */
+    std::chrono::steady_clock::time_point started_;
+
+    /**
+     * @brief Guards 'buffer_' and 'stopping_'.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief Encoded records waiting to be written.
+     */
+    std::vector<unsigned char> buffer_;
+
+    /**
+     * @brief Set to stop the background thread.
+     */
+    bool stopping_ = false;
+
+    /**
+     * @brief Wakes the background thread when the buffer is full or it must stop.
+     */
+    std::condition_variable wake_;
+
+    std::atomic<uint32_t> sessions_{ 0 };   ///< Sessions numbered.
+    std::atomic<uint64_t> recorded_{ 0 };   ///< Records appended.
+    std::atomic<bool> failed_{ false };     ///< Set once writing the file has failed (recording stops).
+
+    /**
+     * @brief The background thread.
+     */
+    std::thread writer_;
+};
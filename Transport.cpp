@@ -0,0 +1,227 @@
+/**
+ * @file Transport.cpp
+ * @brief Transport, TcpTransport and MemoryTransport class implementation.
+ * @details This file contains the implementation of the TCP and in-memory byte streams the protocol is spoken over.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "Transport.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+bool Transport::write_all(const std::vector<boost::asio::const_buffer>& buffers, boost::system::error_code& ec)
+{
+    for (const auto& buffer : buffers)
+    {
+        if (!write_exact(buffer.data(), buffer.size(), ec))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Transport::read_exact(void* buffer, const size_t size, boost::system::error_code& ec)
+{
+    auto* out = static_cast<unsigned char*>(buffer);
+    for (size_t total_read = 0; total_read < size;)
+    {
+        total_read += read_some(out + total_read, size - total_read, ec);
+        if (ec)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Transport::write_exact(const void* buffer, const size_t size, boost::system::error_code& ec)
+{
+    const auto* in = static_cast<const unsigned char*>(buffer);
+    for (size_t total_written = 0; total_written < size;)
+    {
+        total_written += write_some(in + total_written, size - total_written, ec);
+        if (ec)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TcpTransport::TcpTransport(std::shared_ptr<boost::asio::ip::tcp::socket> socket)
+    : socket_(std::move(socket))
+{
+}
+
+size_t TcpTransport::read_some(void* buffer, const size_t size, boost::system::error_code& ec)
+{
+    return socket_->read_some(boost::asio::buffer(buffer, size), ec);
+}
+
+size_t TcpTransport::write_some(const void* buffer, const size_t size, boost::system::error_code& ec)
+{
+    return socket_->write_some(boost::asio::buffer(buffer, size), ec);
+}
+
+bool TcpTransport::write_all(const std::vector<boost::asio::const_buffer>& buffers, boost::system::error_code& ec)
+{
+    // Gather-write, so a header and its payload leave in as few segments as possible
+    boost::asio::write(*socket_, buffers, ec);
+    return !ec;
+}
+
+bool TcpTransport::wait_readable(const std::chrono::milliseconds timeout)
+{
+    // Errors count as readable: the read that follows reports them
+#ifdef _WIN32
+    WSAPOLLFD descriptor{};
+    descriptor.fd = socket_->native_handle();
+    descriptor.events = POLLRDNORM;
+    return WSAPoll(&descriptor, 1, static_cast<INT>(timeout.count())) != 0;
+#else
+    pollfd descriptor{};
+    descriptor.fd = socket_->native_handle();
+    descriptor.events = POLLIN;
+    const int ready = ::poll(&descriptor, 1, static_cast<int>(timeout.count()));
+    return ready > 0 || (ready < 0 && errno != EINTR);
+#endif
+}
+
+bool TcpTransport::is_open() const
+{
+    return socket_->is_open();
+}
+
+void TcpTransport::close()
+{
+    boost::system::error_code ec;
+    socket_->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+    socket_->close(ec);
+}
+
+std::string TcpTransport::describe() const
+{
+    boost::system::error_code ec;
+    const auto endpoint = socket_->remote_endpoint(ec);
+    if (ec)
+    {
+        return "tcp (disconnected)";
+    }
+    std::ostringstream out;
+    out << endpoint;
+    return out.str();
+}
+
+MemoryTransport::MemoryTransport(std::shared_ptr<Channel> inbound, std::shared_ptr<Channel> outbound, std::string name)
+    : inbound_(std::move(inbound)), outbound_(std::move(outbound)), name_(std::move(name))
+{
+}
+
+MemoryTransport::~MemoryTransport()
+{
+    close();
+}
+
+std::pair<std::shared_ptr<Transport>, std::shared_ptr<Transport>> MemoryTransport::make_pipe(const size_t capacity)
+{
+    auto to_server = std::make_shared<Channel>();
+    auto to_client = std::make_shared<Channel>();
+    to_server->ring.resize(capacity);
+    to_client->ring.resize(capacity);
+    return {
+        std::make_shared<MemoryTransport>(to_client, to_server, "in-process server"),
+        std::make_shared<MemoryTransport>(to_server, to_client, "in-process client")
+    };
+}
+
+size_t MemoryTransport::read_some(void* buffer, const size_t size, boost::system::error_code& ec)
+{
+    Channel& c = *inbound_;
+    std::unique_lock lock(c.mutex);
+    c.changed.wait(lock, [&c] { return c.size > 0 || c.closed; });
+    if (c.size == 0)
+    {
+        // Like a socket, a closed pipe still delivers what was written before it was closed
+        ec = boost::asio::error::eof;
+        return 0;
+    }
+
+    const size_t n = std::min(size, c.size);
+    const size_t first = std::min(n, c.ring.size() - c.head);
+    std::memcpy(buffer, c.ring.data() + c.head, first);
+    std::memcpy(static_cast<unsigned char*>(buffer) + first, c.ring.data(), n - first);
+    c.head = (c.head + n) % c.ring.size();
+    c.size -= n;
+    lock.unlock();
+    c.changed.notify_all();
+    return n;
+}
+
+size_t MemoryTransport::write_some(const void* buffer, const size_t size, boost::system::error_code& ec)
+{
+    Channel& c = *outbound_;
+    std::unique_lock lock(c.mutex);
+    c.changed.wait(lock, [&c] { return c.size < c.ring.size() || c.closed; });
+    if (c.closed)
+    {
+        ec = boost::asio::error::broken_pipe;
+        return 0;
+    }
+
+    const size_t n = std::min(size, c.ring.size() - c.size);
+    const size_t tail = (c.head + c.size) % c.ring.size();
+    const size_t first = std::min(n, c.ring.size() - tail);
+    std::memcpy(c.ring.data() + tail, buffer, first);
+    std::memcpy(c.ring.data(), static_cast<const unsigned char*>(buffer) + first, n - first);
+    c.size += n;
+    lock.unlock();
+    c.changed.notify_all();
+    return n;
+}
+
+bool MemoryTransport::wait_readable(const std::chrono::milliseconds timeout)
+{
+    Channel& c = *inbound_;
+    std::unique_lock lock(c.mutex);
+    return c.changed.wait_for(lock, timeout, [&c] { return c.size > 0 || c.closed; });
+}
+
+bool MemoryTransport::is_open() const
+{
+    return open_;
+}
+
+void MemoryTransport::close()
+{
+    if (open_.exchange(false))
+    {
+        close_channel(*inbound_);
+        close_channel(*outbound_);
+    }
+}
+
+std::string MemoryTransport::describe() const
+{
+    return name_;
+}
+
+void MemoryTransport::close_channel(Channel& channel)
+{
+    {
+        std::lock_guard lock(channel.mutex);
+        channel.closed = true;
+    }
+    channel.changed.notify_all();
+}
@@ -0,0 +1,195 @@
+/**
+ * @file Transport.h
+ * @brief Transport, TcpTransport and MemoryTransport class definitions.
+ * @details This header file contains the byte stream abstraction the protocol is spoken over: a TCP socket, or one end
+ *          of an in-process pipe used to embed the server without going through the kernel's network stack.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr size_t MEMORY_PIPE_CAPACITY = 1024 * 1024; // bytes buffered in each direction of an in-memory pipe
+
+/**
+ * @class Transport
+ * @brief A bidirectional byte stream between a client and the server.
+ * @details Errors are reported with the same codes as a socket: reading from a stream the other side closed yields
+ *          boost::asio::error::eof once the buffered data is consumed, so sessions handle both kinds of stream alike.
+ *          Reads and writes may be called from different threads at the same time.
+ */
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    /**
+     * @brief Reads at least one byte, blocking until data arrives or the stream ends.
+     * @param buffer The buffer to read into.
+     * @param size The capacity of the buffer.
+     * @param ec Set if the stream ended or failed.
+     * @return The number of bytes read.
+     */
+    virtual size_t read_some(void* buffer, size_t size, boost::system::error_code& ec) = 0;
+
+    /**
+     * @brief Writes at least one byte, blocking while the stream cannot take more.
+     * @param buffer The bytes to write.
+     * @param size The number of bytes.
+     * @param ec Set if the stream is closed or failed.
+     * @return The number of bytes written.
+     */
+    virtual size_t write_some(const void* buffer, size_t size, boost::system::error_code& ec) = 0;
+
+    /**
+     * @brief Writes several buffers one after the other.
+     * @param buffers The buffers.
+     * @param ec Set if the stream is closed or failed.
+     * @return True if everything was written.
+     */
+    virtual bool write_all(const std::vector<boost::asio::const_buffer>& buffers, boost::system::error_code& ec);
+
+    /**
+     * @brief Waits until a read would not block (data arrived, or the stream ended or failed).
+     * @param timeout The longest wait (0: just check).
+     * @return True if a read would not block; false if the timeout passed first.
+     */
+    virtual bool wait_readable(std::chrono::milliseconds timeout) = 0;
+
+    /**
+     * @brief Tells whether this end of the stream is open.
+     * @return True until close() is called.
+     */
+    virtual bool is_open() const = 0;
+
+    /**
+     * @brief Closes the stream in both directions.
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief Describes the other end of the stream, for logging.
+     * @return The description.
+     */
+    virtual std::string describe() const = 0;
+
+    /**
+     * @brief Reads exactly the specified number of bytes.
+     * @param buffer The buffer to read into.
+     * @param size The number of bytes to read.
+     * @param ec Set if an error occurs.
+     * @return True if the read was successful, false otherwise.
+     */
+    bool read_exact(void* buffer, size_t size, boost::system::error_code& ec);
+
+    /**
+     * @brief Writes exactly the specified number of bytes.
+     * @param buffer The bytes to write.
+     * @param size The number of bytes to write.
+     * @param ec Set if an error occurs.
+     * @return True if the write was successful, false otherwise.
+     */
+    bool write_exact(const void* buffer, size_t size, boost::system::error_code& ec);
+};
+
+/**
+ * @class TcpTransport
+ * @brief A Transport over a connected TCP socket.
+ */
+class TcpTransport : public Transport {
+public:
+    /**
+     * @brief Wraps a connected socket.
+     * @param socket The socket.
+     */
+    explicit TcpTransport(std::shared_ptr<boost::asio::ip::tcp::socket> socket);
+
+    size_t read_some(void* buffer, size_t size, boost::system::error_code& ec) override;
+    size_t write_some(const void* buffer, size_t size, boost::system::error_code& ec) override;
+    bool write_all(const std::vector<boost::asio::const_buffer>& buffers, boost::system::error_code& ec) override;
+    bool wait_readable(std::chrono::milliseconds timeout) override;
+    bool is_open() const override;
+    void close() override;
+    std::string describe() const override;
+
+private:
+    /**
+     * @brief The socket.
+     */
+    std::shared_ptr<boost::asio::ip::tcp::socket> socket_;
+};
+
+/**
+ * @class MemoryTransport
+ * @brief One end of an in-process pipe; see make_pipe().
+ * @details Each direction is a bounded ring buffer, so a fast writer waits for the reader just as it would on a socket.
+ */
+class MemoryTransport : public Transport {
+    struct Channel;
+
+public:
+    /**
+     * @brief Constructs one end of a pipe from the channels it reads from and writes to.
+     * @param inbound The channel read from.
+     * @param outbound The channel written to.
+     * @param name The description of the other end.
+     */
+    MemoryTransport(std::shared_ptr<Channel> inbound, std::shared_ptr<Channel> outbound, std::string name);
+
+    /**
+     * @brief Closes the pipe.
+     */
+    ~MemoryTransport() override;
+
+    size_t read_some(void* buffer, size_t size, boost::system::error_code& ec) override;
+    size_t write_some(const void* buffer, size_t size, boost::system::error_code& ec) override;
+    bool wait_readable(std::chrono::milliseconds timeout) override;
+    bool is_open() const override;
+    void close() override;
+    std::string describe() const override;
+
+    /**
+     * @brief Creates a connected pair of in-memory transports.
+     * @param capacity The number of bytes buffered in each direction.
+     * @return The client's end and the server's end.
+     */
+    static std::pair<std::shared_ptr<Transport>, std::shared_ptr<Transport>> make_pipe(size_t capacity = MEMORY_PIPE_CAPACITY);
+
+private:
+    /**
+     * @struct Channel
+     * @brief One direction of the pipe.
+     */
+    struct Channel {
+        std::mutex mutex;                   ///< Guards the other members.
+        std::condition_variable changed;    ///< Signaled when data is added or removed, or the channel is closed.
+        std::vector<unsigned char> ring;    ///< The buffered bytes.
+        size_t head = 0;                    ///< Position of the oldest buffered byte.
+        size_t size = 0;                    ///< Number of buffered bytes.
+        bool closed = false;                ///< Set when either end closes the pipe.
+    };
+
+    /**
+     * @brief Marks a channel closed and wakes whoever waits on it.
+     * @param channel The channel.
+     */
+    static void close_channel(Channel& channel);
+
+    std::shared_ptr<Channel> inbound_;      ///< The channel read from.
+    std::shared_ptr<Channel> outbound_;     ///< The channel written to.
+    std::string name_;                      ///< The description of the other end.
+    std::atomic<bool> open_{ true };        ///< Cleared by close().
+};
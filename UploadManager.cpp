@@ -0,0 +1,390 @@
+/**
+ * @file UploadManager.cpp
+ * @brief UploadManager class implementation.
+ * @details This file contains the implementation of multipart uploads: parts written at their offsets, commit,
+ *          abort and the expiry of abandoned uploads.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "UploadManager.h"
+#include "Checksum.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using std::chrono::steady_clock;
+
+UploadManager::UploadManager(std::shared_ptr<FileManager> file_manager, const std::chrono::seconds timeout)
+    : file_manager_(std::move(file_manager)), timeout_(timeout)
+{
+    reaper_ = std::thread(&UploadManager::run_reaper, this);
+}
+
+UploadManager::~UploadManager()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    reaper_.join();
+}
+
+std::optional<std::string> UploadManager::initiate(const uint32_t user_id, const std::string& filename,
+                                                   const uint64_t total_size, const uint32_t part_size)
+{
+    if (filename.empty() || total_size == 0 || total_size > MAX_UPLOAD_SIZE || part_size == 0 ||
+        part_size > MAX_UPLOAD_PART_SIZE)
+    {
+        return std::nullopt;
+    }
+
+    auto upload = std::make_shared<Upload>();
+    upload->user_id = user_id;
+    upload->filename = filename;
+    upload->total_size = total_size;
+    upload->part_size = part_size;
+    upload->part_checksums.resize(static_cast<size_t>((total_size + part_size - 1) / part_size));
+    upload->last_activity = steady_clock::now();
+
+    std::string upload_id;
+    {
+        std::lock_guard lock(mutex_);
+        const auto in_progress = std::count_if(uploads_.begin(), uploads_.end(),
+            [user_id](const auto& entry) { return entry.second->user_id == user_id; });
+        if (static_cast<size_t>(in_progress) >= MAX_UPLOADS_PER_USER)
+        {
+            return std::nullopt;
+        }
+        do
+        {
+            upload_id = FileManager::generate_random_filename();
+        } while (uploads_.count(upload_id) > 0);
+        upload->path = file_manager_->upload_file_path(user_id, upload_id);
+
+        // Preallocate the whole file, so parts can be written at their offsets in any order
+        upload->file = std::make_unique<RandomAccessFile>(file_manager_->io_policy(), upload->path, total_size);
+        if (!upload->file->is_open())
+        {
+            throw std::runtime_error("Cannot create upload file " + upload->path);
+        }
+        uploads_[upload_id] = upload;
+    }
+    ++started_;
+    return upload_id;
+}
+
+UploadResult UploadManager::write_part(const uint32_t user_id, const std::string& upload_id, const uint32_t part_number,
+                                       const std::vector<unsigned char>& data, const uint32_t checksum,
+                                       const std::function<void(size_t)>& before_chunk)
+{
+    const auto upload = find(user_id, upload_id);
+    if (!upload)
+    {
+        return UploadResult::NOT_FOUND;
+    }
+
+    // Every part but the last is exactly the part size; the last one ends the file
+    const uint64_t offset = static_cast<uint64_t>(part_number) * upload->part_size;
+    if (part_number >= upload->part_checksums.size() ||
+        data.size() != std::min<uint64_t>(upload->part_size, upload->total_size - offset))
+    {
+        return UploadResult::INVALID;
+    }
+
+    {
+        std::unique_lock lock(upload->mutex);
+        upload->idle.wait(lock, [&upload, part_number]
+            {
+                return upload->closing || upload->parts_writing.count(part_number) == 0;
+            });
+        if (upload->closing)
+        {
+            return UploadResult::NOT_FOUND;
+        }
+        ++upload->writers;
+        upload->parts_writing.insert(part_number);
+        upload->part_checksums[part_number].reset();
+        upload->last_activity = steady_clock::now();
+    }
+
+    bool written = true;
+    for (size_t done = 0; written && done < data.size();)
+    {
+        const size_t to_write = std::min(IO_CHUNK_SIZE, data.size() - done);
+        if (before_chunk)
+        {
+            before_chunk(to_write);
+        }
+        written = upload->file->write_at(offset + done, data.data() + done, to_write);
+        done += to_write;
+    }
+
+    {
+        std::lock_guard lock(upload->mutex);
+        if (written)
+        {
+            upload->part_checksums[part_number] = checksum;
+        }
+        --upload->writers;
+        upload->parts_writing.erase(part_number);
+        upload->last_activity = steady_clock::now();
+    }
+    upload->idle.notify_all();
+    return written ? UploadResult::OK : UploadResult::FAILED;
+}
+
+UploadResult UploadManager::commit(const uint32_t user_id, const std::string& upload_id,
+                                   const std::optional<uint32_t> expected_checksum, std::string& out_filename)
+{
+    const auto upload = find(user_id, upload_id);
+    if (!upload)
+    {
+        return UploadResult::NOT_FOUND;
+    }
+
+    uint32_t checksum = 0;
+    {
+        std::unique_lock lock(upload->mutex);
+        if (upload->closing)
+        {
+            return UploadResult::NOT_FOUND;
+        }
+        upload->closing = true;
+        upload->idle.wait(lock, [&upload] { return upload->writers == 0; });
+
+        // The file's checksum follows from the parts' checksums and sizes
+        UploadResult result = UploadResult::OK;
+        for (size_t part = 0; part < upload->part_checksums.size(); ++part)
+        {
+            if (!upload->part_checksums[part])
+            {
+                result = UploadResult::INCOMPLETE;
+                break;
+            }
+            const uint64_t part_length = std::min<uint64_t>(upload->part_size, upload->total_size - part * upload->part_size);
+            checksum = Crc32c::combine(checksum, *upload->part_checksums[part], part_length);
+        }
+        if (result == UploadResult::OK && expected_checksum && *expected_checksum != checksum)
+        {
+            result = UploadResult::CHECKSUM_MISMATCH;
+        }
+        if (result != UploadResult::OK)
+        {
+            // Leave the upload open for the parts still to come (or to be sent again)
+            upload->closing = false;
+            upload->last_activity = steady_clock::now();
+            return result;
+        }
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        uploads_.erase(upload_id);
+    }
+    out_filename = upload->filename;
+    try
+    {
+        if (!upload->file->close() || !file_manager_->publish_file(user_id, upload->filename, upload->path, checksum))
+        {
+            std::error_code ec;
+            std::filesystem::remove(upload->path, ec);
+            return UploadResult::FAILED;
+        }
+    }
+    catch (const QuotaExceededError&)
+    {
+        return UploadResult::QUOTA_EXCEEDED;
+    }
+    ++committed_;
+    return UploadResult::OK;
+}
+
+bool UploadManager::abort(const uint32_t user_id, const std::string& upload_id)
+{
+    const auto upload = find(user_id, upload_id);
+    if (!upload)
+    {
+        return false;
+    }
+    {
+        std::lock_guard lock(upload->mutex);
+        if (upload->closing)
+        {
+            return false;
+        }
+        upload->closing = true;
+    }
+    discard(upload_id, upload);
+    ++aborted_;
+    return true;
+}
+
+std::vector<UploadState> UploadManager::hand_over(const std::function<bool(uint32_t)>& which)
+{
+    std::vector<std::pair<std::string, std::shared_ptr<Upload>>> selected;
+    {
+        std::lock_guard lock(mutex_);
+        for (const auto& [upload_id, upload] : uploads_)
+        {
+            std::lock_guard upload_lock(upload->mutex);
+            if (!upload->closing && which(upload->user_id))
+            {
+                upload->closing = true;
+                selected.emplace_back(upload_id, upload);
+            }
+        }
+    }
+
+    std::vector<UploadState> states;
+    for (const auto& [upload_id, upload] : selected)
+    {
+        {
+            std::unique_lock lock(upload->mutex);
+            upload->idle.wait(lock, [&upload] { return upload->writers == 0; });
+            states.push_back({ upload_id, upload->user_id, upload->filename, upload->total_size, upload->part_size,
+                upload->part_checksums });
+        }
+        {
+            std::lock_guard lock(mutex_);
+            uploads_.erase(upload_id);
+        }
+        upload->file->close();
+    }
+    return states;
+}
+
+bool UploadManager::adopt(const UploadState& state)
+{
+    const uint64_t parts = state.part_size == 0 ? 0 : (state.total_size + state.part_size - 1) / state.part_size;
+    if (state.part_checksums.size() != parts || parts == 0)
+    {
+        return false;
+    }
+
+    auto upload = std::make_shared<Upload>();
+    upload->user_id = state.user_id;
+    upload->filename = state.filename;
+    upload->path = file_manager_->upload_file_path(state.user_id, state.upload_id);
+    upload->total_size = state.total_size;
+    upload->part_size = state.part_size;
+    upload->part_checksums = state.part_checksums;
+    upload->last_activity = steady_clock::now();
+
+    // The file was sized when the upload was initiated; anything else is not the upload's file
+    std::error_code ec;
+    if (std::filesystem::file_size(upload->path, ec) != state.total_size || ec)
+    {
+        return false;
+    }
+    upload->file = std::make_unique<RandomAccessFile>(file_manager_->io_policy(), upload->path, state.total_size, true);
+    if (!upload->file->is_open())
+    {
+        return false;
+    }
+
+    std::lock_guard lock(mutex_);
+    return uploads_.emplace(state.upload_id, std::move(upload)).second;
+}
+
+std::string UploadManager::report() const
+{
+    size_t in_progress;
+    {
+        std::lock_guard lock(mutex_);
+        in_progress = uploads_.size();
+    }
+    std::ostringstream out;
+    out << "uploads: " << in_progress << " in progress, " << started_.load() << " started, " << committed_.load()
+        << " committed, " << aborted_.load() << " aborted, " << expired_.load() << " expired\n";
+    return out.str();
+}
+
+std::shared_ptr<UploadManager::Upload> UploadManager::find(const uint32_t user_id, const std::string& upload_id) const
+{
+    std::lock_guard lock(mutex_);
+    const auto it = uploads_.find(upload_id);
+    return it != uploads_.end() && it->second->user_id == user_id ? it->second : nullptr;
+}
+
+void UploadManager::discard(const std::string& upload_id, const std::shared_ptr<Upload>& upload)
+{
+    {
+        std::unique_lock lock(upload->mutex);
+        upload->idle.wait(lock, [&upload] { return upload->writers == 0; });
+    }
+    {
+        std::lock_guard lock(mutex_);
+        uploads_.erase(upload_id);
+    }
+    upload->file->close();
+    std::error_code ec;
+    std::filesystem::remove(upload->path, ec);
+}
+
+void UploadManager::run_reaper()
+{
+    try
+    {
+        remove_orphans();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Cannot remove abandoned upload files: " << e.what() << "\n";
+    }
+
+    const auto interval = std::min<std::chrono::seconds>(UPLOAD_SWEEP_INTERVAL, timeout_);
+    std::unique_lock lock(mutex_);
+    while (!stop_cv_.wait_for(lock, interval, [this] { return stopping_; }))
+    {
+        // Pick the idle uploads, then close them without holding the table's lock
+        std::vector<std::pair<std::string, std::shared_ptr<Upload>>> expired;
+        const auto now = steady_clock::now();
+        for (const auto& [upload_id, upload] : uploads_)
+        {
+            std::lock_guard upload_lock(upload->mutex);
+            if (!upload->closing && upload->writers == 0 && now - upload->last_activity >= timeout_)
+            {
+                upload->closing = true;
+                expired.emplace_back(upload_id, upload);
+            }
+        }
+
+        lock.unlock();
+        for (const auto& [upload_id, upload] : expired)
+        {
+            std::cout << "Upload " << upload_id << " of user " << upload->user_id << " (" << upload->filename
+                << ") expired.\n";
+            discard(upload_id, upload);
+            ++expired_;
+        }
+        lock.lock();
+    }
+}
+
+void UploadManager::remove_orphans() const
+{
+    // Uploads do not survive a restart: whatever a previous run left behind can go once it is old enough
+    const auto cutoff = std::filesystem::file_time_type::clock::now() - timeout_;
+    for (const uint32_t user_id : file_manager_->list_users())
+    {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(file_manager_->upload_file_path(user_id, ""), ec))
+        {
+            const std::string upload_id = entry.path().filename().string();
+            std::error_code entry_ec;
+            if (entry.is_regular_file(entry_ec) && entry.last_write_time(entry_ec) < cutoff && !entry_ec &&
+                !find(user_id, upload_id))
+            {
+                std::filesystem::remove(entry.path(), entry_ec);
+            }
+        }
+    }
+}
@@ -0,0 +1,246 @@
+/**
+ * @file UploadManager.h
+ * @brief UploadManager class definition.
+ * @details This header file contains the UploadManager class, which receives large files as numbered parts sent
+ *          concurrently over several connections, and publishes them once every part has arrived.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "FileManager.h"
+#include "IoPolicy.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr std::chrono::seconds UPLOAD_TIMEOUT{ 3600 };          // uploads without activity for this long are discarded
+constexpr std::chrono::seconds UPLOAD_SWEEP_INTERVAL{ 30 };     // how often abandoned uploads are looked for
+constexpr uint32_t MAX_UPLOAD_PART_SIZE = 64 * 1024 * 1024;     // parts are received in memory, so they are bounded
+constexpr uint64_t MAX_UPLOAD_SIZE = UINT32_MAX;                // restores carry a 32-bit size
+constexpr size_t MAX_UPLOADS_PER_USER = 16;                     // each upload holds its full size on disk
+
+/**
+ * @enum UploadResult
+ * @brief The outcome of a multipart upload operation.
+ */
+enum class UploadResult {
+    OK,                 ///< Done.
+    NOT_FOUND,          ///< No such upload for this user (never started, committed, aborted or expired).
+    INVALID,            ///< The part number or the part's size does not fit the upload.
+    INCOMPLETE,         ///< Some parts have not been received yet.
+    CHECKSUM_MISMATCH,  ///< The assembled file does not match the checksum given at commit.
+    QUOTA_EXCEEDED,     ///< Publishing the file would take the user beyond their quota (the upload is discarded).
+    FAILED              ///< The file could not be written or published.
+};
+
+/**
+ * @struct UploadState
+ * @brief An upload in progress, as handed from one server process to the next.
+ */
+struct UploadState {
+    std::string upload_id;                                  ///< The upload ID.
+    uint32_t user_id = 0;                                   ///< The user the upload belongs to.
+    std::string filename;                                   ///< The name the file is published as.
+    uint64_t total_size = 0;                                ///< The size of the file.
+    uint32_t part_size = 0;                                 ///< The size of every part but the last.
+    std::vector<std::optional<uint32_t>> part_checksums;    ///< The checksum of every part received, by number.
+};
+
+/**
+ * @class UploadManager
+ * @brief Multipart uploads: initiate, send numbered parts in any order and concurrently, then commit or abort.
+ * @details Initiating an upload creates its file in the user's UPLOADS_FOLDER with its full size preallocated, so each
+ *          part is written straight at its offset (part number x part size) by whichever connection carries it.
+ *          The CRC-32C of every part is recorded as it arrives; committing checks that every part is there, derives
+ *          the checksum of the whole file from the parts' checksums without reading it back, and renames the file
+ *          into place with that checksum. A background thread discards uploads left without activity for the timeout,
+ *          as well as upload files left behind by a previous run.
+ */
+class UploadManager {
+public:
+    /**
+     * @brief Constructs an UploadManager and starts the thread discarding abandoned uploads.
+     * @param file_manager The file manager the uploads are stored and published by.
+     * @param timeout How long an upload may go without activity before it is discarded.
+     */
+    UploadManager(std::shared_ptr<FileManager> file_manager, std::chrono::seconds timeout = UPLOAD_TIMEOUT);
+
+    /**
+     * @brief Stops the background thread; uploads in progress stay on disk until the next run removes them.
+     */
+    ~UploadManager();
+
+    UploadManager(const UploadManager&) = delete;
+    UploadManager& operator=(const UploadManager&) = delete;
+
+    /**
+     * @brief Starts an upload.
+     * @param user_id The user ID.
+     * @param filename The name the file will be published as.
+     * @param total_size The size of the file (at most MAX_UPLOAD_SIZE).
+     * @param part_size The size of every part but the last (at most MAX_UPLOAD_PART_SIZE).
+     * @return The upload ID, or nothing if the sizes are invalid or the user has too many uploads in progress.
+     * @throws std::runtime_error if the upload's file cannot be created.
+     */
+    std::optional<std::string> initiate(uint32_t user_id, const std::string& filename, uint64_t total_size,
+                                        uint32_t part_size);
+
+    /**
+     * @brief Writes one part at its offset; a part sent again replaces the earlier copy.
+     * @details A part sent again while the earlier copy is still being written waits for it, so the two never mix.
+     * @param user_id The user ID.
+     * @param upload_id The upload ID.
+     * @param part_number The part number, from 0.
+     * @param data The part's data (exactly the part size, except for the last part).
+     * @param checksum The CRC-32C of 'data'.
+     * @param before_chunk Optional callback invoked with the size of each chunk before it is written (e.g. to schedule the I/O).
+     * @return OK, NOT_FOUND, INVALID or FAILED.
+     */
+    UploadResult write_part(uint32_t user_id, const std::string& upload_id, uint32_t part_number,
+                            const std::vector<unsigned char>& data, uint32_t checksum,
+                            const std::function<void(size_t)>& before_chunk = nullptr);
+
+    /**
+     * @brief Publishes a complete upload under its filename.
+     * @details Waits for parts still being written. An incomplete upload, or one not matching 'expected_checksum',
+     *          stays open so the missing parts can still be sent.
+     * @param user_id The user ID.
+     * @param upload_id The upload ID.
+     * @param expected_checksum Optional CRC-32C of the whole file, as computed by the client.
+     * @param out_filename Receives the name the file was published as.
+     * @return OK, NOT_FOUND, INCOMPLETE, CHECKSUM_MISMATCH, QUOTA_EXCEEDED or FAILED.
+     */
+    UploadResult commit(uint32_t user_id, const std::string& upload_id, std::optional<uint32_t> expected_checksum,
+                        std::string& out_filename);
+
+    /**
+     * @brief Discards an upload and its file.
+     * @param user_id The user ID.
+     * @param upload_id The upload ID.
+     * @return True if the upload existed.
+     */
+    bool abort(uint32_t user_id, const std::string& upload_id);
+
+    /**
+     * @brief Gives up the uploads of some users, leaving their files in place for a successor process to adopt().
+     * @details Waits for parts still being written.
+     * @param which Selects the users whose uploads are given up.
+     * @return The uploads given up.
+     */
+    std::vector<UploadState> hand_over(const std::function<bool(uint32_t)>& which);
+
+    /**
+     * @brief Continues an upload given up by a predecessor process, reopening its file.
+     * @param state The upload.
+     * @return True if adopted; false if its file is gone or its ID is in use.
+     */
+    bool adopt(const UploadState& state);
+
+    /**
+     * @brief Formats the number of uploads in progress and the upload counters as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @struct Upload
+     * @brief One upload in progress.
+     */
+    struct Upload {
+        uint32_t user_id = 0;                               ///< The user the upload belongs to.
+        std::string filename;                               ///< The name the file is published as.
+        std::string path;                                   ///< The file receiving the parts.
+        uint64_t total_size = 0;                            ///< The size of the file.
+        uint32_t part_size = 0;                             ///< The size of every part but the last.
+        std::unique_ptr<RandomAccessFile> file;             ///< The open file.
+        std::mutex mutex;                                   ///< Guards the members below.
+        std::condition_variable idle;                       ///< Signaled when a part finishes writing.
+        std::vector<std::optional<uint32_t>> part_checksums; ///< The checksum of every part received, by number.
+        size_t writers = 0;                                 ///< Parts being written.
+        std::set<uint32_t> parts_writing;                   ///< The numbers of the parts being written.
+        bool closing = false;                               ///< Set while committing or aborting: no new parts.
+        std::chrono::steady_clock::time_point last_activity; ///< When a part was last started or finished.
+    };
+
+    /**
+     * @brief Finds an upload of a user.
+     * @param user_id The user ID.
+     * @param upload_id The upload ID.
+     * @return The upload, or null if there is none.
+     */
+    std::shared_ptr<Upload> find(uint32_t user_id, const std::string& upload_id) const;
+
+    /**
+     * @brief Removes an upload from the table and deletes its file, once its writers are done.
+     * @param upload_id The upload ID.
+     * @param upload The upload.
+     */
+    void discard(const std::string& upload_id, const std::shared_ptr<Upload>& upload);
+
+    /**
+     * @brief The background thread: removes leftovers of a previous run, then expires idle uploads periodically.
+     */
+    void run_reaper();
+
+    /**
+     * @brief Deletes upload files older than the timeout that belong to no upload in progress.
+     */
+    void remove_orphans() const;
+
+    /**
+     * @brief The file manager the uploads are stored and published by.
+     */
+    std::shared_ptr<FileManager> file_manager_;
+
+    /**
+     * @brief How long an upload may go without activity.
+     */
+    std::chrono::seconds timeout_;
+
+    /**
+     * @brief Guards 'uploads_' and 'stopping_'.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief The uploads in progress, by ID.
+     */
+    std::map<std::string, std::shared_ptr<Upload>> uploads_;
+
+    std::atomic<uint64_t> started_{ 0 };    ///< Uploads initiated.
+    std::atomic<uint64_t> committed_{ 0 };  ///< Uploads published.
+    std::atomic<uint64_t> aborted_{ 0 };    ///< Uploads aborted by their client.
+    std::atomic<uint64_t> expired_{ 0 };    ///< Uploads discarded after the timeout.
+
+    /**
+     * @brief Set to stop the background thread.
+     */
+    bool stopping_ = false;
+
+    /**
+     * @brief Wakes the background thread when it must stop.
+     */
+    std::condition_variable stop_cv_;
+
+    /**
+     * @brief The background thread.
+     */
+    std::thread reaper_;
+};
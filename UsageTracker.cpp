@@ -0,0 +1,269 @@
+/**
+ * @file UsageTracker.cpp
+ * @brief UsageTracker class implementation.
+ * @details This file contains the implementation of the per-user usage counters, their persistence and the quota checks.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "UsageTracker.h"
+#include "utility.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    /**
+     * @brief Adds a signed change to a counter, stopping at zero.
+     */
+    uint64_t add(const uint64_t value, const int64_t change)
+    {
+        if (change < 0 && static_cast<uint64_t>(-change) > value)
+        {
+            return 0;
+        }
+        return value + static_cast<uint64_t>(change);
+    }
+
+    /**
+     * @brief Tells whether a counter changed by 'change' stays within 'limit' (0 means unlimited).
+     */
+    bool within(const uint64_t value, const int64_t change, const uint64_t limit)
+    {
+        return limit == 0 || change <= 0 || add(value, change) <= limit;
+    }
+}
+
+UsageTracker::UsageTracker(QuotaConfig config, std::function<std::string(uint32_t)> user_folder)
+    : config_(std::move(config)), user_folder_(std::move(user_folder))
+{
+    flusher_ = std::thread(&UsageTracker::run_flusher, this);
+}
+
+UsageTracker::~UsageTracker()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    flusher_.join();
+    flush();
+}
+
+bool UsageTracker::loaded(const uint32_t user_id) const
+{
+    std::lock_guard lock(mutex_);
+    return users_.count(user_id) > 0;
+}
+
+std::vector<uint32_t> UsageTracker::users() const
+{
+    std::lock_guard lock(mutex_);
+    std::vector<uint32_t> user_ids;
+    user_ids.reserve(users_.size());
+    for (const auto& [user_id, entry] : users_)
+    {
+        user_ids.push_back(user_id);
+    }
+    return user_ids;
+}
+
+void UsageTracker::load(const uint32_t user_id, const std::function<UserUsage()>& recount)
+{
+    if (loaded(user_id))
+    {
+        return;
+    }
+
+    const std::string folder = user_folder_(user_id) + USAGE_FOLDER;
+    std::error_code ec;
+    Entry entry;
+    unsigned char counters[16];
+    std::ifstream ifs(folder + USAGE_COUNTERS_FILE, std::ios::binary);
+    if (!std::filesystem::exists(folder + USAGE_DIRTY_MARKER, ec) && !ec &&
+        ifs.read(reinterpret_cast<char*>(counters), sizeof(counters)))
+    {
+        entry.usage.bytes = read_uint_64_le(counters);
+        entry.usage.files = read_uint_64_le(counters + 8);
+    }
+    else
+    {
+        // Never counted, or changed after the counters were last written: count the files once
+        entry.usage = recount();
+        entry.dirty = true;
+        entry.marked = std::filesystem::exists(folder + USAGE_DIRTY_MARKER, ec);
+        ++recounted_;
+    }
+
+    std::lock_guard lock(mutex_);
+    users_.emplace(user_id, entry);
+}
+
+UserUsage UsageTracker::usage(const uint32_t user_id) const
+{
+    std::lock_guard lock(mutex_);
+    const auto it = users_.find(user_id);
+    return it != users_.end() ? it->second.usage : UserUsage{};
+}
+
+QuotaLimits UsageTracker::limits(const uint32_t user_id) const
+{
+    const auto it = config_.user_limits.find(user_id);
+    return it != config_.user_limits.end() ? it->second : config_.default_limits;
+}
+
+bool UsageTracker::fits(const uint32_t user_id, const int64_t bytes, const int64_t files) const
+{
+    std::lock_guard lock(mutex_);
+    const auto it = users_.find(user_id);
+    return it == users_.end() || fits_locked(user_id, it->second.usage, bytes, files);
+}
+
+bool UsageTracker::reserve(const uint32_t user_id, const int64_t bytes, const int64_t files)
+{
+    std::lock_guard lock(mutex_);
+    const auto it = users_.find(user_id);
+    if (it == users_.end())
+    {
+        // Not loaded: nothing to check against, but the next load must recount
+        create_marker(user_id);
+        return true;
+    }
+    if (!fits_locked(user_id, it->second.usage, bytes, files))
+    {
+        ++refused_;
+        return false;
+    }
+    apply_locked(user_id, it->second, bytes, files);
+    return true;
+}
+
+void UsageTracker::adjust(const uint32_t user_id, const int64_t bytes, const int64_t files)
+{
+    std::lock_guard lock(mutex_);
+    const auto it = users_.find(user_id);
+    if (it == users_.end())
+    {
+        create_marker(user_id);
+        return;
+    }
+    apply_locked(user_id, it->second, bytes, files);
+}
+
+void UsageTracker::flush()
+{
+    std::lock_guard flush_lock(flush_mutex_);
+
+    // Take the changed counters, then write them without holding the lock
+    std::vector<std::pair<uint32_t, UserUsage>> changed;
+    {
+        std::lock_guard lock(mutex_);
+        for (auto& [user_id, entry] : users_)
+        {
+            if (entry.dirty)
+            {
+                changed.emplace_back(user_id, entry.usage);
+                entry.dirty = false;
+            }
+        }
+    }
+
+    for (const auto& [user_id, usage] : changed)
+    {
+        const std::string folder = user_folder_(user_id) + USAGE_FOLDER;
+        std::vector<unsigned char> counters;
+        write_uint64_le(counters, usage.bytes);
+        write_uint64_le(counters, usage.files);
+
+        std::error_code ec;
+        bool written = false;
+        {
+            std::filesystem::create_directories(folder, ec);
+            std::ofstream ofs(folder + USAGE_COUNTERS_FILE + ".tmp", std::ios::binary);
+            written = ofs.write(reinterpret_cast<const char*>(counters.data()), static_cast<std::streamsize>(counters.size())) &&
+                ofs.flush();
+        }
+        if (written)
+        {
+            std::filesystem::rename(folder + USAGE_COUNTERS_FILE + ".tmp", folder + USAGE_COUNTERS_FILE, ec);
+            written = !ec;
+        }
+
+        // The marker goes only if nothing changed while writing; otherwise the next flush writes again
+        std::lock_guard lock(mutex_);
+        Entry& entry = users_[user_id];
+        if (!written)
+        {
+            entry.dirty = true;
+        }
+        else if (!entry.dirty && entry.marked)
+        {
+            std::filesystem::remove(folder + USAGE_DIRTY_MARKER, ec);
+            entry.marked = false;
+        }
+    }
+}
+
+std::string UsageTracker::report() const
+{
+    size_t loaded_users;
+    size_t dirty_users = 0;
+    {
+        std::lock_guard lock(mutex_);
+        loaded_users = users_.size();
+        for (const auto& [user_id, entry] : users_)
+        {
+            dirty_users += entry.dirty ? 1 : 0;
+        }
+    }
+    std::ostringstream out;
+    out << "usage: " << loaded_users << " users loaded (" << recounted_.load() << " recounted), " << dirty_users
+        << " not yet written, " << refused_.load() << " saves refused over quota\n";
+    return out.str();
+}
+
+bool UsageTracker::fits_locked(const uint32_t user_id, const UserUsage& usage, const int64_t bytes,
+                               const int64_t files) const
+{
+    const QuotaLimits quota = limits(user_id);
+    return within(usage.bytes, bytes, quota.bytes) && within(usage.files, files, quota.files);
+}
+
+void UsageTracker::apply_locked(const uint32_t user_id, Entry& entry, const int64_t bytes, const int64_t files)
+{
+    // The marker must be on disk before the change is, or a crash would leave stale counters trusted
+    if (!entry.marked)
+    {
+        entry.marked = create_marker(user_id);
+    }
+    entry.usage.bytes = add(entry.usage.bytes, bytes);
+    entry.usage.files = add(entry.usage.files, files);
+    entry.dirty = true;
+}
+
+bool UsageTracker::create_marker(const uint32_t user_id) const
+{
+    const std::string folder = user_folder_(user_id) + USAGE_FOLDER;
+    std::error_code ec;
+    std::filesystem::create_directories(folder, ec);
+    std::ofstream marker(folder + USAGE_DIRTY_MARKER, std::ios::binary | std::ios::app);
+    return marker.is_open();
+}
+
+void UsageTracker::run_flusher()
+{
+    std::unique_lock lock(mutex_);
+    while (!stop_cv_.wait_for(lock, USAGE_FLUSH_INTERVAL, [this] { return stopping_; }))
+    {
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
@@ -0,0 +1,231 @@
+/**
+ * @file UsageTracker.h
+ * @brief UsageTracker class definition.
+ * @details This header file contains the UsageTracker class, which keeps the number of bytes and files each user
+ *          stores up to date as files are saved, replaced and deleted, persists those counters, and enforces the
+ *          users' quotas.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr std::chrono::seconds USAGE_FLUSH_INTERVAL{ 5 };   // how often changed counters are written to disk
+const std::string USAGE_FOLDER = ".usage/";                 // per-user folder holding the persisted counters
+const std::string USAGE_COUNTERS_FILE = "counters";         // bytes(8) + files(8), little-endian
+const std::string USAGE_DIRTY_MARKER = "dirty";             // exists while the counters on disk may be behind
+
+/**
+ * @struct UserUsage
+ * @brief What a user stores.
+ */
+struct UserUsage {
+    uint64_t bytes = 0;     ///< Total size of the user's files.
+    uint64_t files = 0;     ///< Number of the user's files.
+};
+
+/**
+ * @struct QuotaLimits
+ * @brief How much a user may store (0 means unlimited).
+ */
+struct QuotaLimits {
+    uint64_t bytes = 0;     ///< Maximum total size of the user's files.
+    uint64_t files = 0;     ///< Maximum number of the user's files.
+};
+
+/**
+ * @struct QuotaConfig
+ * @brief The quotas of all users.
+ */
+struct QuotaConfig {
+    QuotaLimits default_limits;                     ///< The quota of users without one of their own.
+    std::map<uint32_t, QuotaLimits> user_limits;    ///< The quotas of individual users.
+};
+
+/**
+ * @class UsageTracker
+ * @brief Per-user byte and file counters, maintained incrementally and enforced against quotas.
+ * @details Counters live in memory and are updated under one mutex by every save, replacement and delete, so
+ *          concurrent sessions of a user can neither lose an update nor jointly exceed the quota. A user's counters
+ *          are loaded the first time the user is seen, from their USAGE_FOLDER, and written back by a background
+ *          thread every USAGE_FLUSH_INTERVAL. A dirty marker is created before the first unsaved change and removed
+ *          once the counters are written, so after a crash only the users caught with unsaved changes are recounted.
+ */
+class UsageTracker {
+public:
+    /**
+     * @brief Constructs a UsageTracker and starts the thread writing changed counters to disk.
+     * @param config The users' quotas.
+     * @param user_folder Returns the folder of a user (ending with a slash).
+     */
+    UsageTracker(QuotaConfig config, std::function<std::string(uint32_t)> user_folder);
+
+    /**
+     * @brief Stops the background thread and writes the changed counters.
+     */
+    ~UsageTracker();
+
+    UsageTracker(const UsageTracker&) = delete;
+    UsageTracker& operator=(const UsageTracker&) = delete;
+
+    /**
+     * @brief Tells whether a user's counters are in memory.
+     * @param user_id The user ID.
+     * @return True once load() was called for the user.
+     */
+    bool loaded(uint32_t user_id) const;
+
+    /**
+     * @brief Lists the users whose counters are in memory.
+     * @return The user IDs.
+     */
+    std::vector<uint32_t> users() const;
+
+    /**
+     * @brief Brings a user's counters into memory, from disk or by recounting the user's files.
+     * @details The caller must keep the user's files from changing meanwhile (e.g. hold the user's exclusive lock).
+     * @param user_id The user ID.
+     * @param recount Counts the user's files, for users without persisted counters or with a dirty marker.
+     */
+    void load(uint32_t user_id, const std::function<UserUsage()>& recount);
+
+    /**
+     * @brief Returns what a user stores.
+     * @param user_id The user ID.
+     * @return The counters (zero for users not loaded).
+     */
+    UserUsage usage(uint32_t user_id) const;
+
+    /**
+     * @brief Returns a user's quota.
+     * @param user_id The user ID.
+     * @return The limits.
+     */
+    QuotaLimits limits(uint32_t user_id) const;
+
+    /**
+     * @brief Tells whether a change would keep a user within the quota, without applying it.
+     * @param user_id The user ID.
+     * @param bytes The change in bytes.
+     * @param files The change in files.
+     * @return True if the change fits.
+     */
+    bool fits(uint32_t user_id, int64_t bytes, int64_t files) const;
+
+    /**
+     * @brief Applies a change if it keeps the user within the quota (changes that shrink usage always apply).
+     * @param user_id The user ID.
+     * @param bytes The change in bytes.
+     * @param files The change in files.
+     * @return True if applied; false if it would exceed the quota.
+     */
+    bool reserve(uint32_t user_id, int64_t bytes, int64_t files);
+
+    /**
+     * @brief Applies a change unconditionally (deletes, and undoing a reservation whose operation failed).
+     * @param user_id The user ID.
+     * @param bytes The change in bytes.
+     * @param files The change in files.
+     */
+    void adjust(uint32_t user_id, int64_t bytes, int64_t files);
+
+    /**
+     * @brief Writes the changed counters to disk now.
+     */
+    void flush();
+
+    /**
+     * @brief Formats the tracked users and refused changes as text.
+     * @return The report.
+     */
+    std::string report() const;
+
+private:
+    /**
+     * @struct Entry
+     * @brief The counters of one user.
+     */
+    struct Entry {
+        UserUsage usage;        ///< What the user stores.
+        bool dirty = false;     ///< Changed since the counters were last written.
+        bool marked = false;    ///< The dirty marker exists on disk.
+    };
+
+    /**
+     * @brief Tells whether a change fits a user's quota (the caller holds 'mutex_').
+     */
+    bool fits_locked(uint32_t user_id, const UserUsage& usage, int64_t bytes, int64_t files) const;
+
+    /**
+     * @brief Applies a change to a loaded user, creating the dirty marker first (the caller holds 'mutex_').
+     */
+    void apply_locked(uint32_t user_id, Entry& entry, int64_t bytes, int64_t files);
+
+    /**
+     * @brief Creates a user's dirty marker, so the next load recounts the user.
+     * @return True if the marker exists.
+     */
+    bool create_marker(uint32_t user_id) const;
+
+    /**
+     * @brief The background thread: writes the changed counters every USAGE_FLUSH_INTERVAL.
+     */
+    void run_flusher();
+
+    /**
+     * @brief The users' quotas.
+     */
+    QuotaConfig config_;
+
+    /**
+     * @brief Returns the folder of a user.
+     */
+    std::function<std::string(uint32_t)> user_folder_;
+
+    /**
+     * @brief Guards 'users_' and 'stopping_'.
+     */
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief The counters of the users loaded so far.
+     */
+    std::map<uint32_t, Entry> users_;
+
+    /**
+     * @brief Serializes flushes (the background thread's and explicit ones).
+     */
+    std::mutex flush_mutex_;
+
+    std::atomic<uint64_t> recounted_{ 0 };  ///< Users whose files were counted instead of loaded.
+    std::atomic<uint64_t> refused_{ 0 };    ///< Changes refused for exceeding a quota.
+
+    /**
+     * @brief Set to stop the background thread.
+     */
+    bool stopping_ = false;
+
+    /**
+     * @brief Wakes the background thread when it must stop.
+     */
+    std::condition_variable stop_cv_;
+
+    /**
+     * @brief The background thread.
+     */
+    std::thread flusher_;
+};
@@ -0,0 +1,274 @@
+/**
+ * @file WireFormat.h
+ * @brief Wire layouts of the protocol's requests and responses.
+ * @details This header file contains the fixed-size parts of every protocol message, described with WireSchema.h,
+ *          and the ProtocolSchema traits selecting the parts a given protocol version sends. The server and every
+ *          client encode and decode their headers, the entry lists of PROBE_FILES requests and the pages of LIST_PAGE
+ *          responses from these definitions only.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include "protocols.h"
+#include "WireSchema.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+constexpr uint8_t CHECKSUM_PROTOCOL_VERSION = 2; // first protocol version carrying checksums
+constexpr uint8_t MULTIPLEX_PROTOCOL_VERSION = 3; // first protocol version carrying request IDs and framed responses
+constexpr uint8_t LATEST_PROTOCOL_VERSION = MULTIPLEX_PROTOCOL_VERSION; // newest layout; later versions are read as this one
+
+/**
+ * @enum FrameType
+ * @brief The kinds of frames a version 3 response is made of.
+ */
+enum class FrameType : uint8_t {
+    RESPONSE_HEADER = 0,  ///< status(2) + name_len(2) + name [+ payload size(4) [+ crc32c(4) for status 210]].
+    RESPONSE_DATA = 1     ///< The next chunk of the response's payload.
+};
+
+struct UserIdField : WireField<uint32_t> {};        ///< The user the request acts for.
+struct VersionField : WireField<uint8_t> {};        ///< The protocol version of the message.
+struct OpCodeField : WireField<Command> {};         ///< The requested operation.
+struct NameLengthField : WireField<uint16_t> {};    ///< The length of the filename that follows the header.
+struct RequestIdField : WireField<uint32_t> {};     ///< The client's number for the request (version 3).
+struct PayloadSizeField : WireField<uint32_t> {};   ///< The length of the payload.
+struct ChecksumField : WireField<uint32_t> {};      ///< The CRC-32C of the payload (version 2 and later).
+struct StatusField : WireField<ServerStatus> {};    ///< The status of a response.
+struct FrameTypeField : WireField<FrameType> {};    ///< The kind of a version 3 frame.
+struct BodyLengthField : WireField<uint32_t> {};    ///< The length of a version 3 frame's body.
+struct TotalSizeField : WireField<uint64_t> {};     ///< The size of the file a multipart upload assembles.
+struct PartSizeField : WireField<uint32_t> {};      ///< The size of every part of a multipart upload but the last.
+struct FileSizeField : WireField<uint64_t> {};      ///< The size of a file the client has.
+struct UsedBytesField : WireField<uint64_t> {};     ///< The total size of a user's files.
+struct UsedFilesField : WireField<uint64_t> {};     ///< The number of a user's files.
+struct QuotaBytesField : WireField<uint64_t> {};    ///< The user's byte quota (0: unlimited).
+struct QuotaFilesField : WireField<uint64_t> {};    ///< The user's file quota (0: unlimited).
+struct PageSizeField : WireField<uint32_t> {};      ///< The most files a page of a listing may hold (0: the server's default).
+struct ModifiedTimeField : WireField<uint64_t> {};  ///< When a file was last written, in seconds since the epoch.
+
+/**
+ * @brief The header every request starts with: user_id(4) + version(1) + op_code(1) + name_len(2).
+ */
+using RequestHeader = WireLayout<UserIdField, VersionField, OpCodeField, NameLengthField>;
+
+/**
+ * @brief The header of a lockstep (version 1 and 2) response: version(1) + status(2) + name_len(2).
+ */
+using ResponseHeader = WireLayout<VersionField, StatusField, NameLengthField>;
+
+/**
+ * @brief The header of every version 3 frame: version(1) + request_id(4) + type(1) + body length(4).
+ */
+using FrameHeader = WireLayout<VersionField, RequestIdField, FrameTypeField, BodyLengthField>;
+
+/**
+ * @brief The start of a RESPONSE_HEADER frame's body: status(2) + name_len(2).
+ */
+using FramedResponseHeader = WireLayout<StatusField, NameLengthField>;
+
+/**
+ * @brief The payload of an UPLOAD_INITIATE request: total size(8) + part size(4).
+ */
+using UploadInitiateBody = WireLayout<TotalSizeField, PartSizeField>;
+
+/**
+ * @brief The optional payload of an UPLOAD_COMMIT request: the CRC-32C of the whole file(4).
+ */
+using UploadCommitBody = WireLayout<ChecksumField>;
+
+/**
+ * @brief The payload of a SUCCESS_USAGE response: bytes(8) + files(8) + byte quota(8) + file quota(8).
+ */
+using UsageBody = WireLayout<UsedBytesField, UsedFilesField, QuotaBytesField, QuotaFilesField>;
+
+/**
+ * @brief The start of a LIST_PAGE request's payload: page size(4), then the cursor (the previous page's, if any).
+ */
+using ListPageBody = WireLayout<PageSizeField>;
+
+/**
+ * @brief The start of every entry of a SUCCESS_FILE_PAGE payload: name_len(2) + size(8) + mtime(8), then the name.
+ */
+using ListEntryHeader = WireLayout<NameLengthField, FileSizeField, ModifiedTimeField>;
+
+/**
+ * @brief The start of every entry of a PROBE_FILES payload: name_len(2) + size(8) + crc32c(4), then the name.
+ */
+using ProbeEntryHeader = WireLayout<NameLengthField, FileSizeField, ChecksumField>;
+
+/**
+ * @enum ProbeVerdict
+ * @brief The server's answer for one probed file (one byte each in the SUCCESS_PROBE_RESULT payload).
+ */
+enum class ProbeVerdict : uint8_t {
+    IDENTICAL = 0,  ///< The server holds the file with the same size and checksum: no need to send it.
+    SEND = 1        ///< The file is missing or different: send it.
+};
+
+/**
+ * @struct ProbeEntry
+ * @brief One file of a PROBE_FILES request.
+ */
+struct ProbeEntry {
+    std::string filename;   ///< The filename.
+    uint64_t size = 0;      ///< The size of the client's copy.
+    uint32_t checksum = 0;  ///< The CRC-32C of the client's copy.
+};
+
+/**
+ * @brief Encodes the payload of a PROBE_FILES request.
+ * @param entries The files to probe.
+ * @return The payload.
+ */
+inline std::vector<unsigned char> encode_probe_entries(const std::vector<ProbeEntry>& entries)
+{
+    std::vector<unsigned char> payload;
+    for (const auto& entry : entries)
+    {
+        const auto header = ProbeEntryHeader::encode(static_cast<uint16_t>(entry.filename.size()), entry.size,
+            entry.checksum);
+        payload.insert(payload.end(), header.begin(), header.end());
+        payload.insert(payload.end(), entry.filename.begin(), entry.filename.end());
+    }
+    return payload;
+}
+
+/**
+ * @brief Decodes the payload of a PROBE_FILES request.
+ * @param payload The payload.
+ * @return The files to probe, or nothing if the payload is malformed.
+ */
+inline std::optional<std::vector<ProbeEntry>> decode_probe_entries(const std::vector<unsigned char>& payload)
+{
+    std::vector<ProbeEntry> entries;
+    for (size_t offset = 0; offset < payload.size();)
+    {
+        if (payload.size() - offset < ProbeEntryHeader::size)
+        {
+            return std::nullopt;
+        }
+        ProbeEntryHeader::Buffer header;
+        std::copy_n(payload.begin() + static_cast<std::ptrdiff_t>(offset), header.size(), header.begin());
+        offset += ProbeEntryHeader::size;
+
+        const size_t name_length = ProbeEntryHeader::get<NameLengthField>(header);
+        if (payload.size() - offset < name_length)
+        {
+            return std::nullopt;
+        }
+        ProbeEntry& entry = entries.emplace_back();
+        entry.filename.assign(payload.begin() + static_cast<std::ptrdiff_t>(offset),
+            payload.begin() + static_cast<std::ptrdiff_t>(offset + name_length));
+        entry.size = ProbeEntryHeader::get<FileSizeField>(header);
+        entry.checksum = ProbeEntryHeader::get<ChecksumField>(header);
+        offset += name_length;
+    }
+    return entries;
+}
+
+/**
+ * @struct ListEntry
+ * @brief One file of a SUCCESS_FILE_PAGE response.
+ */
+struct ListEntry {
+    std::string filename;   ///< The filename.
+    uint64_t size = 0;      ///< The file's size.
+    uint64_t modified = 0;  ///< When the file was last written, in seconds since the epoch.
+};
+
+/**
+ * @brief Encodes the payload of a SUCCESS_FILE_PAGE response.
+ * @param entries The files of the page.
+ * @return The payload.
+ */
+inline std::vector<unsigned char> encode_list_entries(const std::vector<ListEntry>& entries)
+{
+    std::vector<unsigned char> payload;
+    for (const auto& entry : entries)
+    {
+        const auto header = ListEntryHeader::encode(static_cast<uint16_t>(entry.filename.size()), entry.size,
+            entry.modified);
+        payload.insert(payload.end(), header.begin(), header.end());
+        payload.insert(payload.end(), entry.filename.begin(), entry.filename.end());
+    }
+    return payload;
+}
+
+/**
+ * @brief Decodes the payload of a SUCCESS_FILE_PAGE response.
+ * @param payload The payload.
+ * @return The files of the page, or nothing if the payload is malformed.
+ */
+inline std::optional<std::vector<ListEntry>> decode_list_entries(const std::vector<unsigned char>& payload)
+{
+    std::vector<ListEntry> entries;
+    for (size_t offset = 0; offset < payload.size();)
+    {
+        if (payload.size() - offset < ListEntryHeader::size)
+        {
+            return std::nullopt;
+        }
+        ListEntryHeader::Buffer header;
+        std::copy_n(payload.begin() + static_cast<std::ptrdiff_t>(offset), header.size(), header.begin());
+        offset += ListEntryHeader::size;
+
+        const size_t name_length = ListEntryHeader::get<NameLengthField>(header);
+        if (payload.size() - offset < name_length)
+        {
+            return std::nullopt;
+        }
+        ListEntry& entry = entries.emplace_back();
+        entry.filename.assign(payload.begin() + static_cast<std::ptrdiff_t>(offset),
+            payload.begin() + static_cast<std::ptrdiff_t>(offset + name_length));
+        entry.size = ListEntryHeader::get<FileSizeField>(header);
+        entry.modified = ListEntryHeader::get<ModifiedTimeField>(header);
+        offset += name_length;
+    }
+    return entries;
+}
+
+/**
+ * @struct ProtocolSchema
+ * @brief The optional parts a given protocol version adds around the filename and the payload.
+ * @details Each version resolves to its own layouts at compile time, so the code reading or writing a message is
+ *          generated once per version and branches on the version only once, to pick that code.
+ */
+template <uint8_t Version>
+struct ProtocolSchema {
+    static constexpr bool has_checksum = Version >= CHECKSUM_PROTOCOL_VERSION;   ///< Payload checksums are exchanged.
+    static constexpr bool is_multiplexed = Version >= MULTIPLEX_PROTOCOL_VERSION; ///< Requests are numbered, responses framed.
+
+    /**
+     * @brief What follows the request header (before the filename).
+     */
+    using RequestPrefix = std::conditional_t<is_multiplexed, WireLayout<RequestIdField>, WireLayout<>>;
+
+    /**
+     * @brief What follows the filename of a request carrying a payload (before the payload).
+     */
+    using RequestTrailer = std::conditional_t<has_checksum,
+        WireLayout<PayloadSizeField, ChecksumField>, WireLayout<PayloadSizeField>>;
+
+    /**
+     * @brief What precedes the payload of a response with status 210 (SUCCESS_FOUND).
+     */
+    using FoundTrailer = RequestTrailer;
+
+    /**
+     * @brief What precedes the payload of the other responses carrying one (211, 213-216 and 300).
+     */
+    using PayloadTrailer = WireLayout<PayloadSizeField>;
+};
+
+static_assert(RequestHeader::size == 8 && ResponseHeader::size == 5 && FrameHeader::size == 10,
+    "the protocol's header sizes are fixed");
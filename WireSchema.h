@@ -0,0 +1,177 @@
+/**
+ * @file WireSchema.h
+ * @brief WireField and WireLayout template definitions.
+ * @details This header file contains the compile-time machinery describing fixed-size binary records as an ordered
+ *          list of fields, from which their encoders and decoders are generated: each field's offset and the record's
+ *          size are constants, and every access is bounds checked by the compiler.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+constexpr bool WIRE_HOST_LITTLE_ENDIAN = true;  // integers are stored in wire order, so fields are copied as is
+#else
+constexpr bool WIRE_HOST_LITTLE_ENDIAN = false; // integers are assembled byte by byte
+#endif
+
+/**
+ * @brief The integer type a field of type T is stored as (the underlying type of an enum).
+ */
+template <typename T, bool = std::is_enum_v<T>>
+struct WireInteger {
+    using type = T;
+};
+
+template <typename T>
+struct WireInteger<T, true> {
+    using type = std::underlying_type_t<T>;
+};
+
+/**
+ * @brief Loads a little-endian integer (or enum) from memory.
+ * @param data The first byte of the value.
+ * @return The value.
+ */
+template <typename T>
+T load_le(const unsigned char* data)
+{
+    using Integer = typename WireInteger<T>::type;
+    static_assert(std::is_unsigned_v<Integer>, "wire fields are unsigned integers");
+
+    Integer value = 0;
+    if constexpr (WIRE_HOST_LITTLE_ENDIAN || sizeof(Integer) == 1)
+    {
+        std::memcpy(&value, data, sizeof(Integer));
+    }
+    else
+    {
+        for (size_t i = 0; i < sizeof(Integer); ++i)
+        {
+            value = static_cast<Integer>(value | static_cast<Integer>(data[i]) << (8 * i));
+        }
+    }
+    return static_cast<T>(value);
+}
+
+/**
+ * @brief Stores an integer (or enum) to memory in little-endian order.
+ * @param data The first byte of the value.
+ * @param value The value.
+ */
+template <typename T>
+void store_le(unsigned char* data, const T value)
+{
+    using Integer = typename WireInteger<T>::type;
+    static_assert(std::is_unsigned_v<Integer>, "wire fields are unsigned integers");
+
+    const auto integer = static_cast<Integer>(value);
+    if constexpr (WIRE_HOST_LITTLE_ENDIAN || sizeof(Integer) == 1)
+    {
+        std::memcpy(data, &integer, sizeof(Integer));
+    }
+    else
+    {
+        for (size_t i = 0; i < sizeof(Integer); ++i)
+        {
+            data[i] = static_cast<unsigned char>(integer >> (8 * i));
+        }
+    }
+}
+
+/**
+ * @struct WireField
+ * @brief Describes one field of a record: its type on the host and its size on the wire.
+ * @details Fields are declared as distinct types deriving from WireField, so layouts are indexed by name:
+ *          @code struct UserIdField : WireField<uint32_t> {}; @endcode
+ */
+template <typename T>
+struct WireField {
+    using type = T;                                                     ///< The field's type on the host.
+    static constexpr size_t size = sizeof(typename WireInteger<T>::type); ///< The field's size on the wire.
+};
+
+/**
+ * @class WireLayout
+ * @brief A fixed-size record made of the given fields, in order, without padding.
+ * @details Offsets are computed at compile time, so reading or writing a field is a single load or store at a
+ *          constant position of a buffer whose size is part of its type. Naming a field that is not in the layout
+ *          does not compile.
+ */
+template <typename... Fields>
+class WireLayout {
+public:
+    /**
+     * @brief The size of the record on the wire.
+     */
+    static constexpr size_t size = (size_t{ 0 } + ... + Fields::size);
+
+    /**
+     * @brief A buffer holding exactly one record.
+     */
+    using Buffer = std::array<unsigned char, size>;
+
+    /**
+     * @brief Returns the offset of a field within the record.
+     * @return The offset in bytes.
+     */
+    template <typename Field>
+    static constexpr size_t offset_of()
+    {
+        static_assert((std::is_same_v<Field, Fields> || ...), "field is not part of this layout");
+        constexpr bool matches[] = { std::is_same_v<Field, Fields>..., false };
+        constexpr size_t sizes[] = { Fields::size..., 0 };
+        size_t offset = 0;
+        for (size_t i = 0; !matches[i]; ++i)
+        {
+            offset += sizes[i];
+        }
+        return offset;
+    }
+
+    /**
+     * @brief Reads a field of a record.
+     * @param buffer The record.
+     * @return The field's value.
+     */
+    template <typename Field>
+    static typename Field::type get(const Buffer& buffer)
+    {
+        static_assert(offset_of<Field>() + Field::size <= size);
+        return load_le<typename Field::type>(buffer.data() + offset_of<Field>());
+    }
+
+    /**
+     * @brief Writes a field of a record.
+     * @param buffer The record.
+     * @param value The field's value.
+     */
+    template <typename Field>
+    static void put(Buffer& buffer, const typename Field::type value)
+    {
+        static_assert(offset_of<Field>() + Field::size <= size);
+        store_le(buffer.data() + offset_of<Field>(), value);
+    }
+
+    /**
+     * @brief Builds a record from the values of all its fields, in layout order.
+     * @param values The values.
+     * @return The record.
+     */
+    static Buffer encode(const typename Fields::type... values)
+    {
+        Buffer buffer{};
+        (put<Fields>(buffer, values), ...);
+        return buffer;
+    }
+};
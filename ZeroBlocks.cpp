@@ -0,0 +1,112 @@
+/**
+ * @file ZeroBlocks.cpp
+ * @brief Zero block detection implementation.
+ * @details This file contains the portable, SSE2 and AVX2 implementations of the all-zero check, selected once at
+ *          runtime based on the CPU features.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "ZeroBlocks.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ZERO_BLOCKS_HAS_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+    constexpr size_t PROBE_SIZE = 64; // bytes checked before the rest of the block; data rarely starts with as many zeros
+
+    bool is_zero_portable(const unsigned char* data, size_t size)
+    {
+        uint64_t bits = 0;
+        for (; size >= 8; data += 8, size -= 8)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, data, 8);
+            bits |= word;
+        }
+        while (size-- > 0)
+        {
+            bits |= *data++;
+        }
+        return bits == 0;
+    }
+
+#ifdef ZERO_BLOCKS_HAS_SIMD
+    bool is_zero_sse2(const unsigned char* data, size_t size)
+    {
+        __m128i bits = _mm_setzero_si128();
+        for (; size >= 64; data += 64, size -= 64)
+        {
+            bits = _mm_or_si128(bits, _mm_or_si128(
+                _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16))),
+                _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)))));
+        }
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(bits, _mm_setzero_si128())) == 0xFFFF &&
+            is_zero_portable(data, size);
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("avx2")))
+#endif
+    bool is_zero_avx2(const unsigned char* data, size_t size)
+    {
+        __m256i bits = _mm256_setzero_si256();
+        for (; size >= 128; data += 128, size -= 128)
+        {
+            bits = _mm256_or_si256(bits, _mm256_or_si256(
+                _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)),
+                                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32))),
+                _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 64)),
+                                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 96)))));
+        }
+        return _mm256_testz_si256(bits, bits) != 0 && is_zero_portable(data, size);
+    }
+
+    bool cpu_has_avx2()
+    {
+#ifdef _MSC_VER
+        int info[4] = {};
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    using IsZeroFn = bool(*)(const unsigned char*, size_t);
+
+    IsZeroFn select_is_zero()
+    {
+#ifdef ZERO_BLOCKS_HAS_SIMD
+        return cpu_has_avx2() ? is_zero_avx2 : is_zero_sse2;
+#else
+        return is_zero_portable;
+#endif
+    }
+
+    const IsZeroFn IS_ZERO = select_is_zero();
+}
+
+bool is_zero_block(const unsigned char* data, const size_t size)
+{
+    if (size <= PROBE_SIZE)
+    {
+        return is_zero_portable(data, size);
+    }
+    return is_zero_portable(data, PROBE_SIZE) && IS_ZERO(data + PROBE_SIZE, size - PROBE_SIZE);
+}
@@ -0,0 +1,25 @@
+/**
+ * @file ZeroBlocks.h
+ * @brief Detection of all-zero blocks.
+ * @details This header file contains the function telling whether a block of data is all zeros, used to leave holes
+ *          in sparse files (VM images, database files) instead of writing their zero blocks to disk.
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Tells whether a block of data is all zeros.
+ * @details Uses AVX2 when the CPU supports it (detected once at runtime), SSE2 on other x86-64 CPUs and 64-bit words
+ *          elsewhere. Blocks holding data are usually told apart by their first bytes, so those are checked first.
+ * @param data The data.
+ * @param size The number of bytes.
+ * @return True if every byte is zero.
+ */
+bool is_zero_block(const unsigned char* data, size_t size);
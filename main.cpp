@@ -10,21 +10,308 @@
  */
 
 #include "Server.h"
+#include "utility.h"
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
-constexpr unsigned short PORT = 8080;
+/**
+ * @brief Builds the server configuration from the command line.
+ * @details Supported options:
+ *   --port <port>            port to listen on (default 8080)
+ *   --storage <folder,..>    root folders of the stored files, one per disk (default c:/backupsvr/)
+ *   --peer <host:port>       replicate saves and deletes to this server
+ *   --node <host:port>       this node's address in the cluster
+ *   --cluster <host:port,..> all nodes of the cluster (enables cluster mode, requires --node)
+ *   --cluster-mode <mode>    'redirect' (default) or 'proxy' requests for users owned by other nodes
+ *   --scheduler <mode>       'fair' (default) or 'off': weighted fair sharing of the disk between users
+ *   --user-bandwidth <bytes> bandwidth cap of each user in bytes per second (default unlimited)
+ *   --user-weight <id:w>     scheduling weight of a user (default 1; may be repeated)
+ *   --preallocate <on|off>   reserve the full size of large files before writing them (default on)
+ *   --fadvise <on|off>       page cache hints; keeps files of 8MB or more out of the cache (default on)
+ *   --direct-io <bytes>      write and read files at least this large with O_DIRECT (default 0: off)
+ *   --sparse <on|off>        leave holes instead of writing all-zero blocks of standalone files (default on)
+ *   --upload-timeout <secs>  discard multipart uploads without activity for this long (default 3600)
+ *   --quota-bytes <bytes>    total size of the files each user may store (default 0: unlimited)
+ *   --quota-files <count>    number of files each user may store (default 0: unlimited)
+ *   --user-quota <id:b[:f]>  byte and file quota of a user, replacing the defaults (no file count: no file limit; repeatable)
+ *   --trace <file>           record the headers and timing of every request served (no payloads) for tools/replay
+ *   --erasure <k+m>          store large files as k data + m parity shards on k + m storage roots (default off)
+ *   --handoff-socket <path>  Unix socket on which a new server process may take this one over (default off)
+ *   --takeover <path>        take over the listening socket and users of the server listening on this handoff socket
+ *   --drain-timeout <secs>   how long requests in progress may take to finish on a handoff (default 60)
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return The configuration.
+ * @throws std::invalid_argument if an option is unknown or malformed.
+ */
+ServerConfig parse_command_line(const int argc, char* argv[])
+{
+	ServerConfig config;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string option = argv[i];
+		if (i + 1 >= argc)
+		{
+			throw std::invalid_argument("Missing value for " + option);
+		}
+		const std::string value = argv[++i];
+
+		if (option == "--port")
+		{
+			std::string host;
+			if (!parse_endpoint("localhost:" + value, host, config.port))
+			{
+				throw std::invalid_argument("Invalid port: " + value);
+			}
+		}
+		else if (option == "--storage")
+		{
+			config.storage_folders.clear();
+			std::stringstream folders(value);
+			for (std::string folder; std::getline(folders, folder, ',');)
+			{
+				if (folder.empty())
+				{
+					continue;
+				}
+				if (folder.back() != '/' && folder.back() != '\\')
+				{
+					folder += '/';
+				}
+				config.storage_folders.push_back(folder);
+			}
+			if (config.storage_folders.empty())
+			{
+				throw std::invalid_argument("Invalid storage folders: " + value);
+			}
+		}
+		else if (option == "--peer")
+		{
+			if (!parse_endpoint(value, config.replication_peer_host, config.replication_peer_port))
+			{
+				throw std::invalid_argument("Invalid peer address (expected host:port): " + value);
+			}
+		}
+		else if (option == "--node")
+		{
+			config.cluster_self = value;
+		}
+		else if (option == "--cluster")
+		{
+			std::stringstream nodes(value);
+			for (std::string node; std::getline(nodes, node, ',');)
+			{
+				std::string host;
+				unsigned short port = 0;
+				if (!parse_endpoint(node, host, port))
+				{
+					throw std::invalid_argument("Invalid cluster node address (expected host:port): " + node);
+				}
+				config.cluster_nodes.push_back(node);
+			}
+		}
+		else if (option == "--cluster-mode")
+		{
+			if (value != "redirect" && value != "proxy")
+			{
+				throw std::invalid_argument("Invalid cluster mode (expected redirect or proxy): " + value);
+			}
+			config.cluster_proxy = value == "proxy";
+		}
+		else if (option == "--scheduler")
+		{
+			if (value != "fair" && value != "off")
+			{
+				throw std::invalid_argument("Invalid scheduler (expected fair or off): " + value);
+			}
+			config.fair_scheduling = value == "fair";
+		}
+		else if (option == "--user-bandwidth")
+		{
+			try
+			{
+				config.user_bytes_per_second = std::stoull(value);
+			}
+			catch (const std::exception&)
+			{
+				throw std::invalid_argument("Invalid bandwidth: " + value);
+			}
+		}
+		else if (option == "--user-weight")
+		{
+			try
+			{
+				const size_t colon = value.find(':');
+				const double weight = std::stod(value.substr(colon + 1));
+				if (colon == std::string::npos || weight <= 0)
+				{
+					throw std::invalid_argument(value);
+				}
+				config.user_weights[static_cast<uint32_t>(std::stoul(value.substr(0, colon)))] = weight;
+			}
+			catch (const std::exception&)
+			{
+				throw std::invalid_argument("Invalid user weight (expected id:weight): " + value);
+			}
+		}
+		else if (option == "--preallocate" || option == "--fadvise" || option == "--sparse")
+		{
+			if (value != "on" && value != "off")
+			{
+				throw std::invalid_argument("Invalid value for " + option + " (expected on or off): " + value);
+			}
+			bool& setting = option == "--preallocate" ? config.io_policy.preallocate
+				: option == "--fadvise" ? config.io_policy.fadvise : config.io_policy.sparse;
+			setting = value == "on";
+		}
+		else if (option == "--direct-io")
+		{
+			try
+			{
+				config.io_policy.direct_io_threshold = std::stoull(value);
+			}
+			catch (const std::exception&)
+			{
+				throw std::invalid_argument("Invalid direct I/O threshold: " + value);
+			}
+		}
+		else if (option == "--upload-timeout")
+		{
+			try
+			{
+				config.upload_timeout = std::chrono::seconds(std::stoul(value));
+			}
+			catch (const std::exception&)
+			{
+				throw std::invalid_argument("Invalid upload timeout: " + value);
+			}
+			if (config.upload_timeout.count() == 0)
+			{
+				throw std::invalid_argument("Invalid upload timeout: " + value);
+			}
+		}
+		else if (option == "--quota-bytes" || option == "--quota-files")
+		{
+			try
+			{
+				uint64_t& limit = option == "--quota-bytes" ? config.quota.default_limits.bytes
+					: config.quota.default_limits.files;
+				limit = std::stoull(value);
+			}
+			catch (const std::exception&)
+			{
+				throw std::invalid_argument("Invalid value for " + option + ": " + value);
+			}
+		}
+		else if (option == "--user-quota")
+		{
+			try
+			{
+				const size_t colon = value.find(':');
+				if (colon == std::string::npos)
+				{
+					throw std::invalid_argument(value);
+				}
+				const size_t second_colon = value.find(':', colon + 1);
+				QuotaLimits limits;
+				limits.bytes = std::stoull(value.substr(colon + 1, second_colon - colon - 1));
+				if (second_colon != std::string::npos)
+				{
+					limits.files = std::stoull(value.substr(second_colon + 1));
+				}
+				config.quota.user_limits[static_cast<uint32_t>(std::stoul(value.substr(0, colon)))] = limits;
+			}
+			catch (const std::exception&)
+			{
+				throw std::invalid_argument("Invalid user quota (expected id:bytes[:files]): " + value);
+			}
+		}
+		else if (option == "--trace")
+		{
+			config.trace_path = value;
+		}
+		else if (option == "--erasure")
+		{
+			try
+			{
+				const size_t plus = value.find('+');
+				if (plus == std::string::npos)
+				{
+					throw std::invalid_argument(value);
+				}
+				config.erasure.data_shards = static_cast<unsigned>(std::stoul(value.substr(0, plus)));
+				config.erasure.parity_shards = static_cast<unsigned>(std::stoul(value.substr(plus + 1)));
+				if (config.erasure.data_shards == 0 || config.erasure.parity_shards == 0)
+				{
+					throw std::invalid_argument(value);
+				}
+			}
+			catch (const std::exception&)
+			{
+				throw std::invalid_argument("Invalid erasure code (expected k+m, e.g. 4+2): " + value);
+			}
+		}
+		else if (option == "--handoff-socket")
+		{
+			config.handoff_socket = value;
+		}
+		else if (option == "--takeover")
+		{
+			config.takeover_socket = value;
+		}
+		else if (option == "--drain-timeout")
+		{
+			try
+			{
+				config.drain_timeout = std::chrono::seconds(std::stoul(value));
+			}
+			catch (const std::exception&)
+			{
+				throw std::invalid_argument("Invalid drain timeout: " + value);
+			}
+			if (config.drain_timeout.count() == 0)
+			{
+				throw std::invalid_argument("Invalid drain timeout: " + value);
+			}
+		}
+		else
+		{
+			throw std::invalid_argument("Unknown option: " + option);
+		}
+	}
+
+	if (!config.cluster_nodes.empty() &&
+		std::find(config.cluster_nodes.begin(), config.cluster_nodes.end(), config.cluster_self) == config.cluster_nodes.end())
+	{
+		throw std::invalid_argument("--node must be one of the --cluster nodes");
+	}
+	return config;
+}
 
 /**
  * @brief The main function that initializes and runs the server.
+ * @param argc The number of arguments.
+ * @param argv The arguments (see parse_command_line).
  * @return 0 on successful execution, non-zero on error.
  */
-int main()
+int main(const int argc, char* argv[])
 {
 	try
 	{
+		const ServerConfig config = parse_command_line(argc, argv);
 		boost::asio::io_context io_context;
-		Server server(io_context, PORT);
-		std::cout << "Listening on port " << PORT << "...\n";
+		Server server(io_context, config);
+		std::cout << "Listening on port " << config.port << "...\n";
+		if (!config.replication_peer_host.empty())
+		{
+			std::cout << "Replicating to " << config.replication_peer_host << ":" << config.replication_peer_port << "\n";
+		}
+		if (!config.cluster_nodes.empty())
+		{
+			std::cout << "Cluster node " << config.cluster_self << " of " << config.cluster_nodes.size() << "\n";
+		}
 		io_context.run();
 	}
 	catch (const std::exception& e)
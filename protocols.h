@@ -21,7 +21,21 @@ enum class Command : uint8_t {
 	SAVE_FILE = 100,      ///< Command to save a file.
 	DELETE_FILE = 201,    ///< Command to delete a file.
 	LIST_FILES = 202,     ///< Command to list all files.
-	RESTORE_FILES = 200   ///< Command to restore a file.
+	RESTORE_FILES = 200,  ///< Command to restore a file.
+	SERVER_STATUS = 203,  ///< Command to get a text report of the server's background activity.
+	SCRUB_STORAGE = 204,  ///< Command to start a storage scrub pass now.
+	REBALANCE = 205,      ///< Command to move the users this node no longer owns to their owners (cluster mode).
+	SNAPSHOT_CREATE = 206,  ///< Command to snapshot the user's files; the filename names the snapshot (empty: a timestamp).
+	SNAPSHOT_LIST = 207,    ///< Command to list the user's snapshots.
+	SNAPSHOT_RESTORE = 208, ///< Command to restore a file from a snapshot; the filename is "<snapshot>/<filename>".
+	UPLOAD_INITIATE = 209,  ///< Command to start a multipart upload of the named file; the payload holds its total and part sizes.
+	UPLOAD_PART = 210,      ///< Command to send one part of an upload; the filename is "<upload_id>/<part_number>".
+	UPLOAD_COMMIT = 211,    ///< Command to publish a complete upload; the payload optionally holds the file's CRC-32C.
+	UPLOAD_ABORT = 212,     ///< Command to discard an upload.
+	PROBE_FILES = 213,      ///< Command to ask which of a batch of files (name, size, CRC-32C in the payload) must be sent.
+	GET_USAGE = 214,        ///< Command to get the bytes and files the user stores and the user's quota.
+	LIST_PAGE = 215,        ///< Command to list one page of the user's files in name order (prefix as filename, page size and cursor as payload).
+	SAVE_IF_ABSENT = 216    ///< Command to save a file unless the user has one by that name or deleted one lately (used by rebalancing).
 };
 
 /**
@@ -32,7 +46,16 @@ enum class ServerStatus : uint16_t {
     SUCCESS_FOUND = 210,       ///< Status indicating the file was found and returned.
     SUCCESS_FILE_LIST = 211,   ///< Status indicating the file list was returned.
     SUCCESS_NO_PAYLOAD = 212,  ///< Status indicating the operation was successful with no payload.
+    SUCCESS_STATUS_REPORT = 213, ///< Status indicating the server status report was returned.
+    SUCCESS_PROBE_RESULT = 214, ///< Status indicating the probe verdicts were returned, one byte per probed file.
+    SUCCESS_USAGE = 215,       ///< Status indicating the user's usage and quota were returned.
+    SUCCESS_FILE_PAGE = 216,   ///< Status indicating a page of files was returned (the next page's cursor as filename).
+    REDIRECT = 300,            ///< Status indicating another node owns the user; the payload holds its "host:port".
     ERR_FILE_NOT_FOUND = 1001, ///< Error status indicating the file was not found.
     ERR_NO_FILES = 1002,       ///< Error status indicating there are no files for the specific client.
-    ERR_GENERAL = 1003         ///< General error status indicating an error occurred with the server.
+    ERR_GENERAL = 1003,        ///< General error status indicating an error occurred with the server.
+    ERR_CHECKSUM_MISMATCH = 1004, ///< Error status indicating the data does not match its CRC-32C checksum.
+    ERR_UPLOAD_INCOMPLETE = 1005, ///< Error status indicating a multipart upload was committed before all its parts arrived.
+    ERR_QUOTA_EXCEEDED = 1006, ///< Error status indicating the file would take the user beyond their quota.
+    ERR_FILE_EXISTS = 1007     ///< Error status indicating a SAVE_IF_ABSENT found the file, or found it was deleted lately.
 };
\ No newline at end of file
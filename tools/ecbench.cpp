@@ -0,0 +1,271 @@
+/**
+ * @file ecbench.cpp
+ * @brief Benchmark of the erasure-coded storage.
+ * @details Measures, for every GF(2^8) kernel the CPU supports, how fast a stripe is encoded and how fast data
+ *          shards lost to m failed roots are rebuilt, in memory. Then writes and reads back a set of files plainly
+ *          (one file each, as the server stores them without erasure coding) and as k + m shards on k + m roots
+ *          (as ErasureStore does), and reads the shards again with m data shards removed, so the cost of the code
+ *          can be weighed against the disk writes it replaces. The roots are folders under --dir; put them on
+ *          different disks by symlinking them before the run.
+ *
+ *          Build (from the repository root):
+ *            g++ -std=c++17 -O2 -I. -o ecbench tools/ecbench.cpp ErasureStore.cpp ReedSolomon.cpp StorageRoots.cpp Checksum.cpp -lpthread
+ *
+ *          Usage:
+ *            ./ecbench [--dir folder] [--code k+m] [--files N] [--size bytes]
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "Checksum.h"
+#include "ErasureStore.h"
+#include "ReedSolomon.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::chrono::steady_clock;
+
+namespace
+{
+    constexpr uint32_t BENCH_USER = 1;          // the user the benchmark's files are stored for
+    constexpr size_t CODEC_STRIPES = 256;       // stripes encoded per kernel in the in-memory run
+
+    /**
+     * @brief The benchmark's settings.
+     */
+    struct Settings {
+        std::string dir = "ecbench.tmp";    ///< Folder receiving the roots (one subfolder per root).
+        unsigned data_shards = 4;           ///< k.
+        unsigned parity_shards = 2;         ///< m.
+        unsigned files = 4;                 ///< Number of files written each way.
+        uint64_t size = 64ull << 20;        ///< Size of each file.
+    };
+
+    /**
+     * @brief Parses the command line.
+     */
+    Settings parse_command_line(const int argc, char* argv[])
+    {
+        Settings settings;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const std::string option = argv[i];
+            const std::string value = argv[i + 1];
+            if (option == "--dir") settings.dir = value;
+            else if (option == "--files") settings.files = static_cast<unsigned>(std::stoul(value));
+            else if (option == "--size") settings.size = std::stoull(value);
+            else if (option == "--code")
+            {
+                const size_t plus = value.find('+');
+                if (plus == std::string::npos)
+                {
+                    throw std::invalid_argument("Invalid code (expected k+m): " + value);
+                }
+                settings.data_shards = static_cast<unsigned>(std::stoul(value.substr(0, plus)));
+                settings.parity_shards = static_cast<unsigned>(std::stoul(value.substr(plus + 1)));
+            }
+            else throw std::invalid_argument("Unknown option: " + option);
+        }
+        return settings;
+    }
+
+    /**
+     * @brief Returns the seconds elapsed since 'started'.
+     */
+    double seconds_since(const steady_clock::time_point started)
+    {
+        return std::chrono::duration<double>(steady_clock::now() - started).count();
+    }
+
+    /**
+     * @brief Prints one result row.
+     */
+    void print_row(const std::string& name, const double megabytes, const double seconds)
+    {
+        std::cout << "  " << std::left << std::setw(34) << name << std::right << std::setw(10) << std::fixed
+            << std::setprecision(0) << megabytes / seconds << " MB/s\n";
+    }
+
+    /**
+     * @brief Measures encoding and reconstruction in memory, for every kernel.
+     */
+    void run_codec(const Settings& settings)
+    {
+        const unsigned k = settings.data_shards;
+        const unsigned total = k + settings.parity_shards;
+        const size_t shard_size = CODEC_STRIPES * ERASURE_BLOCK_SIZE;
+        std::vector<std::vector<unsigned char>> shards(total, std::vector<unsigned char>(shard_size));
+        for (unsigned i = 0; i < k; ++i)
+        {
+            for (size_t b = 0; b < shard_size; ++b)
+            {
+                shards[i][b] = static_cast<unsigned char>(b * 131 + i * 29 + (b >> 11));
+            }
+        }
+        std::vector<unsigned char*> pointers;
+        for (auto& shard : shards)
+        {
+            pointers.push_back(shard.data());
+        }
+        const std::vector<unsigned char> reference = shards[0];
+
+        // Rebuilding is measured with the worst loss the code survives: m data shards
+        std::vector<bool> present(total, true);
+        for (unsigned i = 0; i < std::min(k, settings.parity_shards); ++i)
+        {
+            present[i] = false;
+        }
+
+        const double data_mb = static_cast<double>(shard_size) * k / (1024.0 * 1024.0);
+        std::cout << "codec " << k << "+" << settings.parity_shards << ", " << data_mb << " MB of data in memory:\n";
+        for (const auto& kernel : gf_kernels())
+        {
+            const ReedSolomon code(k, settings.parity_shards, kernel);
+            auto started = steady_clock::now();
+            code.encode(pointers.data(), pointers.data() + k, shard_size);
+            print_row(std::string(kernel.name) + " encode", data_mb, seconds_since(started));
+
+            started = steady_clock::now();
+            code.reconstruct(pointers.data(), present, shard_size, true);
+            print_row(std::string(kernel.name) + " rebuild", data_mb, seconds_since(started));
+            if (shards[0] != reference)
+            {
+                throw std::runtime_error(std::string("Rebuilt data differs with kernel ") + kernel.name);
+            }
+        }
+    }
+
+    /**
+     * @brief Measures plain and erasure-coded writes and reads on disk.
+     */
+    void run_storage(const Settings& settings)
+    {
+        const unsigned total = settings.data_shards + settings.parity_shards;
+        std::vector<std::string> roots;
+        for (unsigned r = 0; r < total; ++r)
+        {
+            roots.push_back(settings.dir + "/root" + std::to_string(r) + "/");
+            std::filesystem::create_directories(roots.back() + std::to_string(BENCH_USER));
+        }
+        ErasureStore store(std::make_shared<StorageRoots>(roots),
+                           ErasureConfig{ settings.data_shards, settings.parity_shards });
+
+        std::vector<unsigned char> data(static_cast<size_t>(settings.size));
+        for (size_t b = 0; b < data.size(); ++b)
+        {
+            data[b] = static_cast<unsigned char>(b * 131 + 7 + (b >> 13));
+        }
+        const uint32_t checksum = Crc32c::compute(data.data(), data.size());
+        const double total_mb = static_cast<double>(settings.size) * settings.files / (1024.0 * 1024.0);
+        std::cout << settings.files << " files of " << settings.size / (1024.0 * 1024.0) << " MB on " << total
+            << " roots (" << total_mb << " MB; shards store " << total_mb * total / settings.data_shards << " MB):\n";
+
+        // Plain files, written in the server's chunk size
+        auto started = steady_clock::now();
+        for (unsigned f = 0; f < settings.files; ++f)
+        {
+            std::ofstream out(roots[f % total] + "plain." + std::to_string(f), std::ios::binary | std::ios::trunc);
+            for (size_t written = 0; written < data.size(); written += ERASURE_BLOCK_SIZE)
+            {
+                out.write(reinterpret_cast<const char*>(data.data() + written),
+                          static_cast<std::streamsize>(std::min(ERASURE_BLOCK_SIZE, data.size() - written)));
+            }
+            if (!out.flush())
+            {
+                throw std::runtime_error("Plain write failed");
+            }
+        }
+        print_row("plain write", total_mb, seconds_since(started));
+
+        started = steady_clock::now();
+        std::vector<unsigned char> buffer(data.size());
+        for (unsigned f = 0; f < settings.files; ++f)
+        {
+            std::ifstream in(roots[f % total] + "plain." + std::to_string(f), std::ios::binary);
+            if (!in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())))
+            {
+                throw std::runtime_error("Plain read failed");
+            }
+        }
+        print_row("plain read", total_mb, seconds_since(started));
+
+        // Erasure-coded files, encoded and written by the store
+        std::vector<ErasureManifest> manifests;
+        started = steady_clock::now();
+        for (unsigned f = 0; f < settings.files; ++f)
+        {
+            size_t offset = 0;
+            const auto manifest = store.write(BENCH_USER, "coded." + std::to_string(f), data.size(), checksum,
+                [&data, &offset](unsigned char* out, const size_t size)
+                {
+                    std::copy_n(data.data() + offset, size, out);
+                    offset += size;
+                    return true;
+                }, nullptr);
+            if (!manifest || !store.commit(BENCH_USER, "coded." + std::to_string(f), *manifest))
+            {
+                throw std::runtime_error("Erasure-coded write failed");
+            }
+            manifests.push_back(*manifest);
+        }
+        print_row(std::string("erasure write (") + gf_fastest_kernel().name + ")", total_mb, seconds_since(started));
+
+        started = steady_clock::now();
+        for (const auto& manifest : manifests)
+        {
+            if (!store.read(manifest, buffer) || buffer != data)
+            {
+                throw std::runtime_error("Erasure-coded read failed");
+            }
+        }
+        print_row("erasure read", total_mb, seconds_since(started));
+
+        for (const auto& manifest : manifests)
+        {
+            for (unsigned i = 0; i < std::min(settings.data_shards, settings.parity_shards); ++i)
+            {
+                std::filesystem::remove(manifest.shard_paths[i]);
+            }
+        }
+        started = steady_clock::now();
+        for (const auto& manifest : manifests)
+        {
+            if (!store.read(manifest, buffer) || buffer != data)
+            {
+                throw std::runtime_error("Degraded read failed");
+            }
+        }
+        print_row("erasure read, " + std::to_string(settings.parity_shards) + " roots lost", total_mb,
+                  seconds_since(started));
+    }
+}
+
+int main(const int argc, char* argv[])
+{
+    try
+    {
+        const Settings settings = parse_command_line(argc, argv);
+        run_codec(settings);
+        run_storage(settings);
+        std::filesystem::remove_all(settings.dir);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
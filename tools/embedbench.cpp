@@ -0,0 +1,212 @@
+/**
+ * @file embedbench.cpp
+ * @brief Request handling benchmark of the embedded server.
+ * @details Links the server core (FileServer) into the benchmark process and runs the same small-file workload
+ *          (save, restore, list) over in-process pipes and over TCP loopback. The in-process run measures request
+ *          handling alone; the difference between the two is the cost of the kernel's network stack.
+ *
+ *          Build (from the repository root; every source file except main.cpp):
+ *            g++ -std=c++17 -O2 -I. -o embedbench tools/embedbench.cpp $(ls *.cpp | grep -v main.cpp) -lpthread
+ *
+ *          Usage:
+ *            ./embedbench [--storage folder] [--clients N] [--requests N] [--size bytes] [--port port]
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "Checksum.h"
+#include "FileServer.h"
+#include "PeerClient.h"
+#include "Server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::chrono::steady_clock;
+
+namespace
+{
+    constexpr uint32_t USER_BASE = 300000; // user IDs of the benchmark's clients start here
+
+    /**
+     * @brief The benchmark's settings.
+     */
+    struct Settings {
+        std::string storage = "embedbench.tmp/";    ///< Storage folder of the embedded server.
+        unsigned clients = 4;                       ///< Concurrent clients.
+        unsigned requests = 5000;                   ///< Requests per client and transport.
+        size_t size = 1024;                         ///< Size of each saved file.
+        unsigned short port = 18080;                ///< Loopback port of the TCP run (0 skips it).
+    };
+
+    /**
+     * @brief Parses the command line.
+     */
+    Settings parse_command_line(const int argc, char* argv[])
+    {
+        Settings settings;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const std::string option = argv[i];
+            const std::string value = argv[i + 1];
+            if (option == "--storage") settings.storage = value.back() == '/' ? value : value + "/";
+            else if (option == "--clients") settings.clients = static_cast<unsigned>(std::stoul(value));
+            else if (option == "--requests") settings.requests = static_cast<unsigned>(std::stoul(value));
+            else if (option == "--size") settings.size = std::stoull(value);
+            else if (option == "--port") settings.port = static_cast<unsigned short>(std::stoul(value));
+            else throw std::invalid_argument("Unknown option: " + option);
+        }
+        return settings;
+    }
+
+    /**
+     * @brief Returns the given percentile of sorted samples.
+     */
+    double percentile(const std::vector<double>& sorted, const double fraction)
+    {
+        return sorted.empty() ? 0 : sorted[static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1))];
+    }
+
+    /**
+     * @brief Runs the workload with one client per thread and prints its throughput and latency percentiles.
+     * @param label The name of the run.
+     * @param settings The benchmark's settings.
+     * @param make_client Creates a connected client.
+     */
+    void run(const char* label, const Settings& settings, const std::function<std::unique_ptr<PeerClient>()>& make_client)
+    {
+        std::atomic<uint64_t> errors{ 0 };
+        std::mutex latencies_mutex;
+        std::vector<double> latencies_us;
+
+        const auto started = steady_clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < settings.clients; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                const std::vector<unsigned char> data(settings.size, static_cast<unsigned char>('a' + i % 26));
+                std::vector<double> samples;
+                samples.reserve(settings.requests);
+                try
+                {
+                    const auto client = make_client();
+                    for (unsigned n = 0; n < settings.requests; ++n)
+                    {
+                        // Save, restore and list in turn
+                        Request request;
+                        request.user_id = USER_BASE + i;
+                        request.filename = "file" + std::to_string(n / 3 % 16) + ".bin";
+                        ServerStatus expected = ServerStatus::SUCCESS_NO_PAYLOAD;
+                        switch (n % 3)
+                        {
+                        case 0:
+                            request.op_code = Command::SAVE_FILE;
+                            request.file_data = data;
+                            request.payload_checksum = Crc32c::compute(data.data(), data.size());
+                            break;
+                        case 1:
+                            request.op_code = Command::RESTORE_FILES;
+                            expected = ServerStatus::SUCCESS_FOUND;
+                            break;
+                        default:
+                            request.op_code = Command::LIST_FILES;
+                            request.filename.clear();
+                            expected = ServerStatus::SUCCESS_FILE_LIST;
+                            break;
+                        }
+
+                        const auto start = steady_clock::now();
+                        client->send_request(request);
+                        if (client->read_response().status != expected)
+                        {
+                            ++errors;
+                        }
+                        samples.push_back(std::chrono::duration<double, std::micro>(steady_clock::now() - start).count());
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << label << " client " << i << ": " << e.what() << "\n";
+                    ++errors;
+                }
+
+                std::lock_guard lock(latencies_mutex);
+                latencies_us.insert(latencies_us.end(), samples.begin(), samples.end());
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        const double seconds = std::chrono::duration<double>(steady_clock::now() - started).count();
+
+        std::sort(latencies_us.begin(), latencies_us.end());
+        std::cout << std::left << std::setw(10) << label << std::right << std::fixed << std::setprecision(0)
+            << std::setw(12) << static_cast<double>(latencies_us.size()) / seconds << std::setprecision(1)
+            << std::setw(10) << percentile(latencies_us, 0.5) << std::setw(10) << percentile(latencies_us, 0.99)
+            << std::setw(10) << percentile(latencies_us, 1.0) << std::setw(8) << errors.load() << "\n";
+    }
+}
+
+/**
+ * @brief Runs the workload over both transports.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return 0 on success, 1 on error.
+ */
+int main(const int argc, char* argv[])
+{
+    try
+    {
+        const Settings settings = parse_command_line(argc, argv);
+        ServerConfig config;
+        config.storage_folders = { settings.storage };
+        config.port = settings.port;
+
+        std::cout << std::left << std::setw(10) << "transport" << std::right << std::setw(12) << "requests/s"
+            << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(10) << "max us" << std::setw(8)
+            << "errors" << "\n";
+        {
+            const FileServer server(config);
+            run("memory", settings, [&server] { return std::make_unique<PeerClient>(server.connect()); });
+        }
+
+        if (settings.port != 0)
+        {
+            boost::asio::io_context io_context;
+            Server server(io_context, config);
+            std::thread network([&io_context] { io_context.run(); });
+            run("tcp", settings, [&settings]
+            {
+                auto client = std::make_unique<PeerClient>("127.0.0.1", settings.port);
+                client->connect();
+                return client;
+            });
+            io_context.stop();
+            network.join();
+        }
+
+        std::filesystem::remove_all(settings.storage);
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << "\n";
+        return 1;
+    }
+}
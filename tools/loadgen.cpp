@@ -0,0 +1,211 @@
+/**
+ * @file loadgen.cpp
+ * @brief Mixed-workload load generator for the server.
+ * @details Runs a few "heavy" users streaming large backups next to many "light" users doing small saves and
+ *          listings, and reports the latency percentiles of the light users' requests. Comparing a server started
+ *          with '--scheduler fair' against one started with '--scheduler off' shows the effect of fair scheduling.
+ *
+ *          Build (from the repository root):
+ *            g++ -std=c++17 -O2 -I. -o loadgen tools/loadgen.cpp PeerClient.cpp Transport.cpp Checksum.cpp utility.cpp -lpthread
+ *
+ *          Usage:
+ *            ./loadgen [--server host:port] [--heavy N] [--light N] [--seconds S] [--heavy-size bytes] [--light-size bytes]
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "PeerClient.h"
+#include "Checksum.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::chrono::steady_clock;
+
+namespace
+{
+    constexpr uint32_t HEAVY_USER_BASE = 100000; // user IDs of the heavy users start here
+    constexpr uint32_t LIGHT_USER_BASE = 200000; // user IDs of the light users start here
+
+    /**
+     * @brief The load generator's settings.
+     */
+    struct Settings {
+        std::string host = "127.0.0.1";     ///< The server's host.
+        unsigned short port = 8080;         ///< The server's port.
+        unsigned heavy = 4;                 ///< Users streaming large files.
+        unsigned light = 32;                ///< Users doing small saves and listings.
+        unsigned seconds = 20;              ///< Duration of the run.
+        size_t heavy_size = 64 << 20;       ///< Size of each large file.
+        size_t light_size = 4 << 10;        ///< Size of each small file.
+    };
+
+    /**
+     * @brief Parses the command line.
+     */
+    Settings parse_command_line(const int argc, char* argv[])
+    {
+        Settings settings;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const std::string option = argv[i];
+            const std::string value = argv[i + 1];
+            if (option == "--server")
+            {
+                if (!parse_endpoint(value, settings.host, settings.port))
+                {
+                    throw std::invalid_argument("Invalid server address: " + value);
+                }
+            }
+            else if (option == "--heavy") settings.heavy = static_cast<unsigned>(std::stoul(value));
+            else if (option == "--light") settings.light = static_cast<unsigned>(std::stoul(value));
+            else if (option == "--seconds") settings.seconds = static_cast<unsigned>(std::stoul(value));
+            else if (option == "--heavy-size") settings.heavy_size = std::stoull(value);
+            else if (option == "--light-size") settings.light_size = std::stoull(value);
+            else throw std::invalid_argument("Unknown option: " + option);
+        }
+        return settings;
+    }
+
+    /**
+     * @brief Builds a SAVE_FILE request for the given content.
+     */
+    Request make_save(const uint32_t user_id, const std::string& filename, const std::vector<unsigned char>& data)
+    {
+        Request request;
+        request.user_id = user_id;
+        request.op_code = Command::SAVE_FILE;
+        request.filename = filename;
+        request.file_data = data;
+        request.payload_checksum = Crc32c::compute(data.data(), data.size());
+        return request;
+    }
+
+    /**
+     * @brief Returns the given percentile of sorted samples.
+     */
+    double percentile(const std::vector<double>& sorted, const double fraction)
+    {
+        return sorted.empty() ? 0 : sorted[static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1))];
+    }
+}
+
+/**
+ * @brief Runs the mixed workload and prints the light users' latency percentiles.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return 0 on success, 1 on error.
+ */
+int main(const int argc, char* argv[])
+{
+    try
+    {
+        const Settings settings = parse_command_line(argc, argv);
+        const auto deadline = steady_clock::now() + std::chrono::seconds(settings.seconds);
+
+        std::atomic<uint64_t> heavy_bytes{ 0 };
+        std::atomic<uint64_t> errors{ 0 };
+        std::mutex latencies_mutex;
+        std::vector<double> latencies_ms;
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < settings.heavy; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                const std::vector<unsigned char> data(settings.heavy_size, static_cast<unsigned char>('A' + i % 26));
+                const Request request = make_save(HEAVY_USER_BASE + i, "backup.bin", data);
+                try
+                {
+                    PeerClient client(settings.host, settings.port);
+                    client.connect();
+                    while (steady_clock::now() < deadline)
+                    {
+                        client.send_request(request);
+                        if (client.read_response().status != ServerStatus::SUCCESS_NO_PAYLOAD)
+                        {
+                            ++errors;
+                        }
+                        heavy_bytes += data.size();
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Heavy user " << i << ": " << e.what() << "\n";
+                    ++errors;
+                }
+            });
+        }
+
+        for (unsigned i = 0; i < settings.light; ++i)
+        {
+            threads.emplace_back([&, i]
+            {
+                const std::vector<unsigned char> data(settings.light_size, static_cast<unsigned char>('a' + i % 26));
+                std::vector<double> samples;
+                try
+                {
+                    PeerClient client(settings.host, settings.port);
+                    client.connect();
+                    for (unsigned n = 0; steady_clock::now() < deadline; ++n)
+                    {
+                        // Alternate small saves with listings
+                        Request request = make_save(LIGHT_USER_BASE + i, "note" + std::to_string(n % 16) + ".txt", data);
+                        if (n % 2 == 1)
+                        {
+                            request.op_code = Command::LIST_FILES;
+                            request.filename.clear();
+                            request.file_data.clear();
+                        }
+
+                        const auto start = steady_clock::now();
+                        client.send_request(request);
+                        if (const Response response = client.read_response();
+                            response.status != ServerStatus::SUCCESS_NO_PAYLOAD && response.status != ServerStatus::SUCCESS_FILE_LIST)
+                        {
+                            ++errors;
+                        }
+                        samples.push_back(std::chrono::duration<double, std::milli>(steady_clock::now() - start).count());
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Light user " << i << ": " << e.what() << "\n";
+                    ++errors;
+                }
+
+                std::lock_guard lock(latencies_mutex);
+                latencies_ms.insert(latencies_ms.end(), samples.begin(), samples.end());
+            });
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::sort(latencies_ms.begin(), latencies_ms.end());
+        std::cout << "light requests: " << latencies_ms.size() << ", latency ms p50 " << percentile(latencies_ms, 0.5)
+            << " p99 " << percentile(latencies_ms, 0.99) << " max " << percentile(latencies_ms, 1.0) << "\n"
+            << "heavy throughput: " << heavy_bytes / (1024.0 * 1024.0) / settings.seconds << " MB/s\n"
+            << "errors: " << errors << "\n";
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << "\n";
+        return 1;
+    }
+}
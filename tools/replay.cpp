@@ -0,0 +1,443 @@
+/**
+ * @file replay.cpp
+ * @brief Replays a recorded request trace against a server.
+ * @details Reads a trace written by a server started with '--trace', and sends the same requests again on as many
+ *          connections as were recorded, at the recorded times (or faster, with '--speed'). Payloads are synthetic:
+ *          saves send the recorded size of generated bytes, and names are rebuilt from their recorded length and
+ *          checksum, so a file saved and later restored in the trace is saved and restored under the same synthetic
+ *          name. Files restored without having been saved in the trace are created first, at their recorded size.
+ *          Commands whose payload or name cannot be regenerated (uploads, probes, snapshot restores) and
+ *          administrative ones (scrub, rebalance) are skipped.
+ *
+ *          The latency percentiles of each command are printed next to the recorded ones; '--results' saves them
+ *          and '--baseline' compares them with those saved by an earlier run, e.g. against another build.
+ *
+ *          Build (from the repository root):
+ *            g++ -std=c++17 -O2 -I. -o replay tools/replay.cpp TraceRecorder.cpp PeerClient.cpp Transport.cpp Checksum.cpp utility.cpp -lpthread
+ *
+ *          Usage:
+ *            ./replay --trace file [--server host:port] [--speed factor] [--user-offset N] [--results file] [--baseline file]
+ *
+ * @version 1.0
+ * @author Dmitriy Gorodov
+ * @id 342725405
+ * @date 18/10/2026
+ */
+
+#include "Checksum.h"
+#include "PeerClient.h"
+#include "TraceRecorder.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using std::chrono::steady_clock;
+
+namespace
+{
+    /**
+     * @brief The replay's settings.
+     */
+    struct Settings {
+        std::string trace;                  ///< The trace file.
+        std::string host = "127.0.0.1";     ///< The server's host.
+        unsigned short port = 8080;         ///< The server's port.
+        double speed = 1;                   ///< How many times faster than recorded to send the requests.
+        uint32_t user_offset = 0;           ///< Added to every user ID (to keep the replay's files apart).
+        std::string results;                ///< Where to save the latency percentiles (empty: not saved).
+        std::string baseline;               ///< Percentiles saved by an earlier run to compare with (empty: none).
+    };
+
+    /**
+     * @brief The latencies of one command.
+     */
+    struct Samples {
+        std::vector<double> recorded_us;    ///< As recorded by the server.
+        std::vector<double> replayed_us;    ///< As measured by the replay.
+        uint64_t status_changed = 0;        ///< Responses whose status differs from the recorded one.
+    };
+
+    /**
+     * @brief Parses the command line.
+     */
+    Settings parse_command_line(const int argc, char* argv[])
+    {
+        Settings settings;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const std::string option = argv[i];
+            const std::string value = argv[i + 1];
+            if (option == "--trace") settings.trace = value;
+            else if (option == "--server")
+            {
+                if (!parse_endpoint(value, settings.host, settings.port))
+                {
+                    throw std::invalid_argument("Invalid server address: " + value);
+                }
+            }
+            else if (option == "--speed") settings.speed = std::stod(value);
+            else if (option == "--user-offset") settings.user_offset = static_cast<uint32_t>(std::stoul(value));
+            else if (option == "--results") settings.results = value;
+            else if (option == "--baseline") settings.baseline = value;
+            else throw std::invalid_argument("Unknown option: " + option);
+        }
+        if (settings.trace.empty() || settings.speed <= 0)
+        {
+            throw std::invalid_argument("Usage: replay --trace file [--server host:port] [--speed factor] "
+                "[--user-offset N] [--results file] [--baseline file]");
+        }
+        return settings;
+    }
+
+    /**
+     * @brief Returns the name of a command, as printed in the results.
+     */
+    std::string command_name(const Command op_code)
+    {
+        switch (op_code)
+        {
+        case Command::SAVE_FILE: return "SAVE_FILE";
+        case Command::RESTORE_FILES: return "RESTORE_FILES";
+        case Command::DELETE_FILE: return "DELETE_FILE";
+        case Command::LIST_FILES: return "LIST_FILES";
+        case Command::SERVER_STATUS: return "SERVER_STATUS";
+        case Command::SCRUB_STORAGE: return "SCRUB_STORAGE";
+        case Command::REBALANCE: return "REBALANCE";
+        case Command::SNAPSHOT_CREATE: return "SNAPSHOT_CREATE";
+        case Command::SNAPSHOT_LIST: return "SNAPSHOT_LIST";
+        case Command::SNAPSHOT_RESTORE: return "SNAPSHOT_RESTORE";
+        case Command::UPLOAD_INITIATE: return "UPLOAD_INITIATE";
+        case Command::UPLOAD_PART: return "UPLOAD_PART";
+        case Command::UPLOAD_COMMIT: return "UPLOAD_COMMIT";
+        case Command::UPLOAD_ABORT: return "UPLOAD_ABORT";
+        case Command::PROBE_FILES: return "PROBE_FILES";
+        case Command::GET_USAGE: return "GET_USAGE";
+        case Command::LIST_PAGE: return "LIST_PAGE";
+        case Command::SAVE_IF_ABSENT: return "SAVE_IF_ABSENT";
+        }
+        return "OP_" + std::to_string(static_cast<unsigned>(op_code));
+    }
+
+    /**
+     * @brief Tells whether a recorded request can be sent again with a synthetic name and payload.
+     */
+    bool replayable(const Command op_code)
+    {
+        return op_code == Command::SAVE_FILE || op_code == Command::RESTORE_FILES || op_code == Command::DELETE_FILE ||
+            op_code == Command::LIST_FILES || op_code == Command::SERVER_STATUS || op_code == Command::SNAPSHOT_CREATE ||
+            op_code == Command::SNAPSHOT_LIST || op_code == Command::GET_USAGE || op_code == Command::LIST_PAGE;
+    }
+
+    /**
+     * @brief Rebuilds a name of the recorded length from its checksum: equal names stay equal, different ones differ.
+     */
+    std::string synthetic_name(const TraceRecord& record)
+    {
+        if (record.name_length == 0)
+        {
+            return "";
+        }
+        std::ostringstream name;
+        name << std::hex << std::setw(8) << std::setfill('0') << record.name_hash;
+        std::string result = name.str();
+        result.resize(std::max<size_t>(result.size(), record.name_length), 'x');
+        return result;
+    }
+
+    /**
+     * @brief Builds the request to send for a recorded one.
+     */
+    Request make_request(const TraceRecord& record, const Settings& settings)
+    {
+        Request request;
+        request.user_id = record.user_id + settings.user_offset;
+        request.version = record.version;
+        request.op_code = record.op_code;
+        request.filename = synthetic_name(record);
+        if (record.op_code == Command::SAVE_FILE)
+        {
+            // Content derived from the name, so a restore of the replayed file reads what was saved under it
+            request.file_data.resize(record.payload_size);
+            for (size_t i = 0; i < request.file_data.size(); ++i)
+            {
+                request.file_data[i] = static_cast<unsigned char>((record.name_hash >> (8 * (i % 4))) + i / 4096);
+            }
+            request.payload_checksum = Crc32c::compute(request.file_data.data(), request.file_data.size());
+        }
+        else if (record.op_code == Command::LIST_PAGE)
+        {
+            // The page size and cursor are not recorded: the server's default page, from the start
+            const auto body = ListPageBody::encode(0);
+            request.file_data.assign(body.begin(), body.end());
+        }
+        return request;
+    }
+
+    /**
+     * @brief Returns the given percentile of sorted samples.
+     */
+    double percentile(const std::vector<double>& sorted, const double fraction)
+    {
+        return sorted.empty() ? 0 : sorted[static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1))];
+    }
+
+    /**
+     * @brief Creates the files the trace restores without saving them first, at their recorded size.
+     * @return The number of files created.
+     */
+    size_t prepare(const std::vector<TraceRecord>& records, const Settings& settings)
+    {
+        PeerClient client(settings.host, settings.port);
+        client.connect();
+        std::set<std::pair<uint32_t, uint32_t>> seen;
+        size_t created = 0;
+        for (const auto& record : records)
+        {
+            if (!seen.insert({ record.user_id, record.name_hash }).second || record.op_code != Command::RESTORE_FILES ||
+                record.status != ServerStatus::SUCCESS_FOUND)
+            {
+                continue;
+            }
+            TraceRecord save = record;
+            save.op_code = Command::SAVE_FILE;
+            save.payload_size = record.response_size;
+            client.send_request(make_request(save, settings));
+            if (client.read_response().status == ServerStatus::SUCCESS_NO_PAYLOAD)
+            {
+                ++created;
+            }
+        }
+        return created;
+    }
+
+    /**
+     * @brief Replays the requests of one recorded connection at their recorded times (divided by the speed).
+     * @details Version 3 connections send each request on time whatever is still in flight, and a second thread
+     *          collects the responses; older ones wait for each response before sending the next request.
+     */
+    void replay_session(const std::vector<const TraceRecord*>& records, const Settings& settings,
+                        const steady_clock::time_point started, std::map<Command, Samples>& samples,
+                        std::mutex& samples_mutex, std::atomic<uint64_t>& errors)
+    {
+        const auto due = [&](const TraceRecord& record)
+        {
+            return started + std::chrono::duration_cast<steady_clock::duration>(
+                std::chrono::duration<double, std::micro>(static_cast<double>(record.start_us) / settings.speed));
+        };
+        const auto account = [&](const TraceRecord& record, const Response& response, const steady_clock::duration latency)
+        {
+            std::lock_guard lock(samples_mutex);
+            Samples& command = samples[record.op_code];
+            command.recorded_us.push_back(record.duration_us);
+            command.replayed_us.push_back(std::chrono::duration<double, std::micro>(latency).count());
+            if (response.status != record.status)
+            {
+                ++command.status_changed;
+            }
+        };
+
+        try
+        {
+            const uint8_t version = records.front()->version;
+            PeerClient client(settings.host, settings.port, version);
+            client.connect();
+            if (version < MULTIPLEX_PROTOCOL_VERSION)
+            {
+                for (const TraceRecord* record : records)
+                {
+                    std::this_thread::sleep_until(due(*record));
+                    const auto sent = steady_clock::now();
+                    client.send_request(make_request(*record, settings));
+                    const Response response = client.read_response();
+                    account(*record, response, steady_clock::now() - sent);
+                }
+                return;
+            }
+
+            std::mutex sent_mutex;
+            std::map<uint32_t, steady_clock::time_point> sent;
+            std::thread receiver([&]
+            {
+                try
+                {
+                    for (size_t received = 0; received < records.size(); ++received)
+                    {
+                        const Response response = client.read_response();
+                        const auto now = steady_clock::now();
+                        steady_clock::time_point sent_at;
+                        {
+                            std::lock_guard lock(sent_mutex);
+                            sent_at = sent.at(response.request_id);
+                        }
+                        account(*records.at(response.request_id), response, now - sent_at);
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Session " << records.front()->session << ": " << e.what() << "\n";
+                    ++errors;
+                }
+            });
+            for (uint32_t i = 0; i < records.size(); ++i)
+            {
+                std::this_thread::sleep_until(due(*records[i]));
+                Request request = make_request(*records[i], settings);
+                request.request_id = i;
+                {
+                    std::lock_guard lock(sent_mutex);
+                    sent[i] = steady_clock::now();
+                }
+                client.send_request(request);
+            }
+            receiver.join();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Session " << records.front()->session << ": " << e.what() << "\n";
+            ++errors;
+        }
+    }
+
+    /**
+     * @brief Reads the percentiles saved by an earlier run ("command p50 p99" per line).
+     */
+    std::map<std::string, std::pair<double, double>> read_baseline(const std::string& path)
+    {
+        std::ifstream ifs(path);
+        if (!ifs)
+        {
+            throw std::runtime_error("Cannot read baseline " + path);
+        }
+        std::map<std::string, std::pair<double, double>> baseline;
+        std::string command;
+        double p50;
+        double p99;
+        while (ifs >> command >> p50 >> p99)
+        {
+            baseline[command] = { p50, p99 };
+        }
+        return baseline;
+    }
+
+    /**
+     * @brief Formats the change from 'before' to 'after' as a percentage.
+     */
+    std::string delta(const double before, const double after)
+    {
+        std::ostringstream out;
+        out << std::showpos << std::fixed << std::setprecision(1) << (before > 0 ? (after - before) * 100 / before : 0)
+            << "%";
+        return out.str();
+    }
+}
+
+/**
+ * @brief Replays the trace and prints the latencies per command.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return 0 on success, 1 on error.
+ */
+int main(const int argc, char* argv[])
+{
+    try
+    {
+        const Settings settings = parse_command_line(argc, argv);
+        std::vector<TraceRecord> records = TraceRecorder::read(settings.trace);
+        std::sort(records.begin(), records.end(),
+            [](const TraceRecord& a, const TraceRecord& b) { return a.start_us < b.start_us; });
+
+        // One connection per recorded session, each with its requests in the order they arrived
+        std::map<uint32_t, std::vector<const TraceRecord*>> sessions;
+        std::map<Command, uint64_t> skipped;
+        for (const auto& record : records)
+        {
+            if (replayable(record.op_code))
+            {
+                sessions[record.session].push_back(&record);
+            }
+            else
+            {
+                ++skipped[record.op_code];
+            }
+        }
+        std::cout << records.size() << " requests in " << sessions.size() << " sessions, "
+            << prepare(records, settings) << " files created first\n";
+        for (const auto& [op_code, count] : skipped)
+        {
+            std::cout << "skipped " << count << " " << command_name(op_code) << "\n";
+        }
+
+        std::map<Command, Samples> samples;
+        std::mutex samples_mutex;
+        std::atomic<uint64_t> errors{ 0 };
+        const auto started = steady_clock::now();
+        std::vector<std::thread> threads;
+        for (const auto& [session, session_records] : sessions)
+        {
+            threads.emplace_back(replay_session, std::cref(session_records), std::cref(settings), started,
+                std::ref(samples), std::ref(samples_mutex), std::ref(errors));
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        const double seconds = std::chrono::duration<double>(steady_clock::now() - started).count();
+        const double recorded_seconds = records.empty() ? 0 : static_cast<double>(records.back().start_us) / 1e6;
+
+        const auto baseline = settings.baseline.empty() ? std::map<std::string, std::pair<double, double>>{}
+                                                        : read_baseline(settings.baseline);
+        std::ofstream results;
+        if (!settings.results.empty())
+        {
+            results.open(settings.results);
+        }
+
+        std::cout << "replayed in " << std::fixed << std::setprecision(1) << seconds << "s (recorded over "
+            << recorded_seconds << "s), " << errors.load() << " errors\n";
+        std::cout << std::left << std::setw(16) << "command" << std::right << std::setw(8) << "count" << std::setw(12)
+            << "rec p50 us" << std::setw(12) << "rec p99 us" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+            << std::setw(9) << "changed" << (baseline.empty() ? "" : "   vs baseline p50 / p99") << "\n";
+        for (auto& [op_code, command] : samples)
+        {
+            std::sort(command.recorded_us.begin(), command.recorded_us.end());
+            std::sort(command.replayed_us.begin(), command.replayed_us.end());
+            const std::string name = command_name(op_code);
+            const double p50 = percentile(command.replayed_us, 0.5);
+            const double p99 = percentile(command.replayed_us, 0.99);
+            std::cout << std::left << std::setw(16) << name << std::right << std::setw(8) << command.replayed_us.size()
+                << std::setprecision(0) << std::setw(12) << percentile(command.recorded_us, 0.5) << std::setw(12)
+                << percentile(command.recorded_us, 0.99) << std::setw(12) << p50 << std::setw(12) << p99
+                << std::setw(9) << command.status_changed;
+            if (const auto base = baseline.find(name); base != baseline.end())
+            {
+                std::cout << "   " << delta(base->second.first, p50) << " / " << delta(base->second.second, p99);
+            }
+            std::cout << "\n";
+            if (results.is_open())
+            {
+                results << name << " " << p50 << " " << p99 << "\n";
+            }
+        }
+        return errors == 0 ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << "\n";
+        return 1;
+    }
+}
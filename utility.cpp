@@ -23,6 +23,11 @@ uint32_t read_uint_32_le(const unsigned char* data) {
         ((static_cast<uint32_t>(data[3]) << 24));
 }
 
+uint64_t read_uint_64_le(const unsigned char* data) {
+    return static_cast<uint64_t>(read_uint_32_le(data)) |
+        (static_cast<uint64_t>(read_uint_32_le(data + 4)) << 32);
+}
+
 void write_uint8(std::vector<unsigned char>& buffer, const uint8_t value)
 {
     buffer.push_back(value);
@@ -40,4 +45,35 @@ void write_uint32_le(std::vector<unsigned char>& buffer, const uint32_t value)
     buffer.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
     buffer.push_back(static_cast<unsigned char>((value >> 16) & 0xFF));
     buffer.push_back(static_cast<unsigned char>((value >> 24) & 0xFF));
+}
+
+void write_uint64_le(std::vector<unsigned char>& buffer, const uint64_t value)
+{
+    write_uint32_le(buffer, static_cast<uint32_t>(value & 0xFFFFFFFF));
+    write_uint32_le(buffer, static_cast<uint32_t>(value >> 32));
+}
+
+bool parse_endpoint(const std::string& endpoint, std::string& host, unsigned short& port)
+{
+    const auto colon = endpoint.find_last_of(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == endpoint.size())
+    {
+        return false;
+    }
+
+    const std::string port_part = endpoint.substr(colon + 1);
+    if (port_part.find_first_not_of("0123456789") != std::string::npos || port_part.size() > 5)
+    {
+        return false;
+    }
+
+    const unsigned long value = std::stoul(port_part);
+    if (value == 0 || value > 65535)
+    {
+        return false;
+    }
+
+    host = endpoint.substr(0, colon);
+    port = static_cast<unsigned short>(value);
+    return true;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 
 #include <boost/asio.hpp>
 #include <filesystem>
+#include <string>
 
 /**
  * @brief Reads a 16-bit unsigned integer from the given data in little-endian format.
@@ -30,6 +31,13 @@ uint16_t read_uint_16_le(const unsigned char* data, short start = 0, short end =
  */
 uint32_t read_uint_32_le(const unsigned char* data);
 
+/**
+ * @brief Reads a 64-bit unsigned integer from the given data in little-endian format.
+ * @param data The data to read from.
+ * @return The 64-bit unsigned integer read from the data.
+ */
+uint64_t read_uint_64_le(const unsigned char* data);
+
 /**
  * @brief Writes an 8-bit unsigned integer to the given buffer.
  * @param buffer The buffer to write to.
@@ -49,4 +57,20 @@ void write_uint16_le(std::vector<unsigned char>& buffer, uint16_t value);
  * @param buffer The buffer to write to.
  * @param value The 32-bit unsigned integer to write.
  */
-void write_uint32_le(std::vector<unsigned char>& buffer, uint32_t value);
\ No newline at end of file
+void write_uint32_le(std::vector<unsigned char>& buffer, uint32_t value);
+
+/**
+ * @brief Writes a 64-bit unsigned integer to the given buffer in little-endian format.
+ * @param buffer The buffer to write to.
+ * @param value The 64-bit unsigned integer to write.
+ */
+void write_uint64_le(std::vector<unsigned char>& buffer, uint64_t value);
+
+/**
+ * @brief Splits a "host:port" string.
+ * @param endpoint The string to split.
+ * @param host The host part.
+ * @param port The port part.
+ * @return True if the string is a valid "host:port"; false otherwise.
+ */
+bool parse_endpoint(const std::string& endpoint, std::string& host, unsigned short& port);
\ No newline at end of file